@@ -190,6 +190,29 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision. If a body was hit, CollisionReport::plink1 contains the hit link pointer.
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /// \brief Check collision of many rays, gives the same results as calling \ref CheckCollision(const RAY&,CollisionReportPtr) for every ray.
+    ///
+    /// Checkers can override this to prepare the scene and the ray query only once for all the rays.
+    /// \param rays the rays to check. The length of a ray is the length of its direction.
+    /// \param pbody if not empty, only collide the rays with this body like \ref CheckCollision(const RAY&,KinBodyConstPtr,CollisionReportPtr), otherwise collide with the whole environment.
+    /// \param[out] vhitlinks for every ray the link it hit, empty if the ray does not hit anything
+    /// \param[out] vcontacts for every ray the contact of the hit, if the checker reports contacts
+    /// \return true if any ray hit something
+    virtual bool CheckCollisionRays(const std::vector<RAY>& rays, KinBodyConstPtr pbody, std::vector<KinBody::LinkConstPtr>& vhitlinks, std::vector<CollisionReport::CONTACT>& vcontacts)
+    {
+        vhitlinks.resize(rays.size());
+        vcontacts.resize(rays.size());
+        CollisionReportPtr report(new CollisionReport());
+        bool bCollision = false;
+        for(size_t i = 0; i < rays.size(); ++i) {
+            bool bHit = !!pbody ? CheckCollision(rays[i], pbody, report) : CheckCollision(rays[i], report);
+            vhitlinks[i] = bHit ? report->plink1 : KinBody::LinkConstPtr();
+            vcontacts[i] = bHit && report->contacts.size() > 0 ? report->contacts[0] : CollisionReport::CONTACT();
+            bCollision |= bHit;
+        }
+        return bCollision;
+    }
+
     /// \brief Checks self collision only with the links of the passed in body.
     ///
     /// Only checks KinBody::GetNonAdjacentLinks(), Links that are joined together are ignored.
@@ -203,6 +226,20 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision.
     virtual bool CheckStandaloneSelfCollision(KinBody::LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /// \brief checks collision of a body and a scene along the whole straight line motion between two DOF configurations of the body.
+    ///
+    /// The DOF values are linearly interpolated and the base transform of the body stays fixed. Attached bodies are respected. If CO_ActiveDOFs is set, will only check affected links of the body. The state of the body is restored before returning.
+    /// \param vdofvalues0 the DOF values of the body at the start of the motion, size is KinBody::GetDOF()
+    /// \param vdofvalues1 the DOF values of the body at the end of the motion, size is KinBody::GetDOF()
+    /// \param[out] fTimeOfContact if in collision, the interpolation parameter in [0,1] of the earliest colliding configuration that was found
+    /// \param[out] report [optional] collision report to be filled with data about the collision at fTimeOfContact.
+    virtual bool CheckContinuousCollision(KinBodyConstPtr pbody, const std::vector<dReal>& vdofvalues0, const std::vector<dReal>& vdofvalues1, dReal& fTimeOfContact, CollisionReportPtr report = CollisionReportPtr()) OPENRAVE_DUMMY_IMPLEMENTATION;
+
+    /// \brief checks self collision of a body along the whole straight line motion between two DOF configurations of the body.
+    ///
+    /// Only checks KinBody::GetNonAdjacentLinks(). The parameters are the same as \ref CheckContinuousCollision.
+    virtual bool CheckContinuousStandaloneSelfCollision(KinBodyConstPtr pbody, const std::vector<dReal>& vdofvalues0, const std::vector<dReal>& vdofvalues1, dReal& fTimeOfContact, CollisionReportPtr report = CollisionReportPtr()) OPENRAVE_DUMMY_IMPLEMENTATION;
+
     /// \deprecated (13/04/09)
     virtual bool CheckSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr()) RAVE_DEPRECATED
     {
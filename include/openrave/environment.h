@@ -26,6 +26,41 @@ namespace OpenRAVE {
 
 typedef boost::recursive_try_mutex EnvironmentMutex;
 
+/** \brief Log of the bodies of an environment whose state changed, lets collision checkers synchronize incrementally.
+
+    Every time the update stamp of a body increments, the body records its environment id in the journal. Each body is
+    recorded at most once per journal stamp, and the stamp advances every time the journal is read. Together with
+    \ref KinBody::Link::GetUpdateStamp, a consumer only has to update the links that changed in the bodies that changed
+    since its last read. All calls require the environment lock.
+ */
+class OPENRAVE_API EnvironmentChangeJournal
+{
+public:
+    EnvironmentChangeJournal();
+    virtual ~EnvironmentChangeJournal() {
+    }
+
+    /// \brief the stamp new changes are recorded at
+    inline int GetStamp() const {
+        return _nStamp;
+    }
+
+    /// \brief Gets the environment ids of the bodies that changed since the previous read of the caller and advances the stamp.
+    ///
+    /// \param[inout] nstamp the stamp set by the previous read, initialize with -1. Is set to the stamp to pass to the next read.
+    /// \param[out] vbodyids environment ids of the bodies that moved, changed, were added, or removed. Can contain duplicates.
+    /// \return false if the changes since nstamp were trimmed from the journal, in which case the caller has to treat all bodies as changed
+    bool GetChangedBodies(int& nstamp, std::vector<int>& vbodyids);
+
+    /// \brief records that the body with the environment id changed, called by KinBody and the environment
+    void RecordChange(int environmentid);
+
+protected:
+    std::vector< std::pair<int, int> > _vchanges; ///< (stamp, environment id) of every recorded change, sorted by stamp
+    int _nStamp; ///< \see GetStamp
+    int _nFirstStamp; ///< all changes before this stamp were trimmed
+};
+
 /** \brief Maintains a world state, which serves as the gateway to all functions offered through %OpenRAVE. See \ref arch_environment.
  */
 class OPENRAVE_API EnvironmentBase : public boost::enable_shared_from_this<EnvironmentBase>
@@ -128,6 +163,29 @@ public:
         return CheckStandaloneSelfCollision(pbody, report);
     }
 
+    /// \brief bits of the per-configuration results of \ref CheckConfigurations
+    enum ConfigurationCheckResult
+    {
+        CCR_EnvironmentCollision = 1, ///< the body collides with the rest of the environment
+        CCR_SelfCollision = 2, ///< the body collides with itself
+        CCR_OutOfLimits = 4, ///< a value is outside the dof limits. When set, the collisions of the configuration are not checked
+    };
+
+    /** \brief Checks a batch of configurations of a body and returns a result bitmask for each of them.
+
+        The forward kinematics of every worker are computed once for its whole share of the batch with \ref KinBody::ComputeLinkTransformations,
+        then each configuration is set and checked with \ref CheckCollision(KinBodyConstPtr,CollisionReportPtr) and \ref KinBody::CheckSelfCollision.
+        When several threads are used, each extra thread works on its own clone of the environment that is kept between calls
+        and only resynchronized with \ref Clone, so the checker state of the clones can be reused. The body state is restored before returning.
+        \param pbody the body to check, has to be in the environment
+        \param dofindices the dof indices the configurations set. The rest of the dofs keep their current values. If empty, all the dofs are set.
+        \param vconfigs flat array of numconfigs*dofstride values where dofstride is dofindices.size(), or GetDOF() if dofindices is empty
+        \param[out] vresults resized to numconfigs. Each entry is a combination of \ref ConfigurationCheckResult values, 0 if the configuration is valid
+        \param checkoptions combination of \ref ConfigurationCheckResult values specifying the checks to perform
+        \param numthreads maximum number of threads to use. If 0, uses the number of hardware threads. Small batches use less threads.
+     */
+    virtual void CheckConfigurations(KinBodyConstPtr pbody, const std::vector<int>& dofindices, const std::vector<dReal>& vconfigs, std::vector<uint8_t>& vresults, int checkoptions=CCR_EnvironmentCollision|CCR_SelfCollision|CCR_OutOfLimits, int numthreads=0) = 0;
+
     typedef boost::function<CollisionAction(CollisionReportPtr,bool)> CollisionCallbackFn;
 
     /// Register a collision callback.
@@ -449,6 +507,18 @@ public:
     /// \throw openrave_exception with ORE_Timeout error code
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout=0) = 0;
 
+    /// \brief Retrieve only the published bodies that changed since a version the caller has already seen. <b>[multi-thread safe]</b>
+    ///
+    /// A separate **interface mutex** is locked for reading the bodies. States of bodies whose update stamp did not change
+    /// are not copied, so polling an idle scene is cheap.
+    /// \param[out] vbodies the states of the bodies that were added or changed after publishedversion
+    /// \param[out] vremovedbodyids the environment ids of the bodies that were removed after publishedversion. Apply them before vbodies, the same id can be removed and added back.
+    /// \param[inout] publishedversion the version returned by the previous call, 0 for a new client. Set to the current version on return.
+    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
+    /// \return true if vbodies and vremovedbodyids hold the changes. false if the changes since publishedversion are no longer known, in which case vbodies holds all published bodies and any other body should be dropped.
+    /// \throw openrave_exception with ORE_Timeout error code
+    virtual bool GetPublishedBodiesChanged(std::vector<KinBody::BodyState>& vbodies, std::vector<int>& vremovedbodyids, uint64_t& publishedversion, uint64_t timeout=0) = 0;
+
     /// \brief Updates the published bodies that viewers and other programs listening in on the environment see.
     ///
     /// For example, calling this function inside a planning loop allows the viewer to update the environment
@@ -640,6 +710,11 @@ public:
     inline int GetId() const {
         return __nUniqueId;
     }
+
+    /// \brief returns the journal of the bodies that changed, see \ref EnvironmentChangeJournal
+    inline EnvironmentChangeJournalPtr GetChangeJournal() const {
+        return __pChangeJournal;
+    }
     
 protected:
     virtual const char* GetHash() const {
@@ -649,6 +724,7 @@ protected:
 private:
     UserDataPtr __pUserData;         ///< \see GetUserData
     int __nUniqueId;         ///< \see RaveGetEnvironmentId
+    EnvironmentChangeJournalPtr __pChangeJournal; ///< \see GetChangeJournal
 };
 
 } // end namespace OpenRAVE
@@ -35,6 +35,82 @@ enum GeometryType {
     GT_Cylinder = 3, ///< oriented towards z-axis
     GT_TriMesh = 4,
     GT_Container=5, ///< a container shaped geometry that has inner and outer extents. container opens on +Z.
+    GT_Octree=6, ///< occupancy octree of cubic voxels that can be updated from point clouds, see \ref OctreeOccupancy
+};
+
+/// \brief Occupied leaf voxels of a \ref GT_Octree geometry.
+///
+/// Voxel (i,j,k) is the cube [i,i+1)x[j,j+1)x[k,k+1) scaled by the resolution in the geometry coordinate system.
+/// The voxels are kept as a sorted array of keys so that a whole point cloud is merged in one pass. Every modification
+/// is recorded in a change log so that collision checkers can keep their own octree in sync without rebuilding it.
+class OPENRAVE_API OctreeOccupancy
+{
+public:
+    OctreeOccupancy(dReal resolution=0.01);
+    OctreeOccupancy(const OctreeOccupancy& r);
+    OctreeOccupancy& operator=(const OctreeOccupancy& r);
+
+    inline dReal GetResolution() const {
+        return _resolution;
+    }
+
+    /// \brief sets the voxel edge length and removes all voxels
+    void SetResolution(dReal resolution);
+
+    inline size_t GetNumOccupied() const {
+        return _vkeys.size();
+    }
+
+    /// \brief unique id of the voxel data, a copy gets a new id.
+    inline uint64_t GetId() const {
+        return _id;
+    }
+
+    /// \brief incremented every time the occupancy changes
+    inline uint64_t GetRevision() const {
+        return _revision;
+    }
+
+    /// \brief marks the voxels containing the points as occupied or free
+    ///
+    /// \param vpoints points in the geometry coordinate system. Non-finite points and points outside of the +-2^20 voxel range are ignored.
+    /// \return the number of voxels whose occupancy changed
+    int Update(const std::vector<Vector>& vpoints, bool occupied);
+
+    /// \brief removes all voxels
+    void Clear();
+
+    /// \brief returns true if the voxel containing the point is occupied
+    bool IsOccupied(const Vector& point) const;
+
+    /// \brief returns the centers of all occupied voxels
+    void GetOccupiedCenters(std::vector<Vector>& vcenters) const;
+
+    /// \brief returns the centers of the voxels that became occupied or free after revision
+    ///
+    /// A voxel that changed several times is only returned in its final state.
+    /// \return false if the change log does not reach back to revision, then the caller has to rebuild from \ref GetOccupiedCenters
+    bool GetChangesSince(uint64_t revision, std::vector<Vector>& voccupied, std::vector<Vector>& vfreed) const;
+
+    /// \brief returns the bounding box of the occupied voxels in the geometry coordinate system
+    AABB ComputeAABB() const;
+
+    /// \brief appends the voxel faces that separate occupied from free space
+    void AppendTriangulation(TriMesh& trimesh) const;
+
+    /// \brief writes the resolution and the occupied voxels. The id and the change log are not written so that equal occupancies serialize the same.
+    void serialize(std::ostream& o, int options=0) const;
+
+private:
+    bool _GetKey(const Vector& point, uint64_t& key) const;
+    Vector _GetCenter(uint64_t key) const;
+    void _TrimChangeLog();
+
+    dReal _resolution;
+    std::vector<uint64_t> _vkeys; ///< sorted keys of the occupied voxels
+    std::vector< std::pair<uint64_t, uint64_t> > _vchangelog; ///< (revision, key) of every change in increasing revision. The top bit of the key is set if the voxel became occupied.
+    uint64_t _id, _revision;
+    uint64_t _changelogstartrevision; ///< all changes after this revision are in _vchangelog
 };
 
 /// \brief holds parameters for an electric motor
@@ -91,11 +167,11 @@ public:
         Prop_LinkDraw=0x40,     ///< toggle link geometries rendering
         Prop_LinkGeometry=0x80,     ///< the geometry of the link changed
         Prop_LinkTransforms=0x100, ///< if any of the link transforms changed, this implies the DOF values of the robot changed
-        // 0x200
+        Prop_LinkOctree=0x200,     ///< the voxels of a GT_Octree geometry changed. The collision meshes are triangulated again when they are next requested, and Prop_LinkGeometry is not called so that checkers with native octrees can update them in place.
         Prop_LinkStatic=0x400,     ///< static property of link changed
         Prop_LinkEnable=0x800,     ///< enable property of link changed
         Prop_LinkDynamics=0x1000,     ///< mass/inertia properties of link changed
-        Prop_Links=Prop_LinkDraw|Prop_LinkGeometry|Prop_LinkStatic|Prop_LinkEnable|Prop_LinkDynamics,     ///< all properties of all links
+        Prop_Links=Prop_LinkDraw|Prop_LinkGeometry|Prop_LinkOctree|Prop_LinkStatic|Prop_LinkEnable|Prop_LinkDynamics,     ///< all properties of all links
         Prop_JointCustomParameters = 0x2000, ///< when Joint::SetFloatParameters(), Joint::SetIntParameters(), and Joint::SetStringParameters() are called
         Prop_LinkCustomParameters = 0x4000, ///< when Link::SetFloatParameters(), Link::SetIntParameters(), Link::SetStringParameters() are called
         Prop_BodyAttached=0x8000, ///< if attached bodies changed
@@ -153,6 +229,7 @@ public:
         Vector _vGeomData; ///< for boxes, first 3 values are half extents. For containers, the first 3 values are the full outer extents.
         Vector _vGeomData2; ///< For containers, the first 3 values are the full inner extents.
         Vector _vGeomData3; ///< For containers, the first 3 values is the bottom cross XY full extents and Z height from bottom face.
+        OctreeOccupancy _octree; ///< For octrees, the resolution and the occupied voxels.
         
         ///< for sphere it is radius
         ///< for cylinder, first 2 values are radius and height
@@ -311,6 +388,9 @@ public:
             inline const Vector& GetContainerBottomCross() const {
                 return _info._vGeomData3;
             }
+            inline const OctreeOccupancy& GetOctree() const {
+                return _info._octree;
+            }
             inline const RaveVector<float>& GetDiffuseColor() const {
                 return _info._vDiffuseColor;
             }
@@ -319,11 +399,19 @@ public:
             }
 
             /// \brief returns the local collision mesh
+            ///
+            /// For \ref GT_Octree geometries the mesh is triangulated from the voxels the first time it is requested after they changed.
             inline const TriMesh& GetCollisionMesh() const {
+                if( _bCollisionMeshOutdated ) {
+                    _UpdateCollisionMesh();
+                }
                 return _info._meshcollision;
             }
 
             inline const KinBody::GeometryInfo& GetInfo() const {
+                if( _bCollisionMeshOutdated ) {
+                    _UpdateCollisionMesh();
+                }
                 return _info;
             }
 
@@ -335,6 +423,16 @@ public:
 
             /// \brief sets a new collision mesh and notifies every registered callback about it
             virtual void SetCollisionMesh(const TriMesh& mesh);
+
+            /// \brief marks the octree voxels containing the points as occupied or free and notifies the Prop_LinkOctree callbacks about it
+            ///
+            /// Only valid for \ref GT_Octree geometries.
+            /// \param vpoints points in the world coordinate system, for example from a depth sensor
+            /// \return the number of voxels that changed. If 0, the callbacks are not called.
+            virtual int UpdateOctree(const std::vector<Vector>& vpoints, bool occupied);
+
+            /// \brief removes all octree voxels and notifies the Prop_LinkOctree callbacks about it
+            virtual void ClearOctree();
             /// \brief sets visible flag. if changed, notifies every registered callback about it.
             ///
             /// \return true if changed
@@ -361,8 +459,12 @@ public:
             virtual void SetRenderFilename(const std::string& renderfilename);
 
 protected:
+            /// \brief triangulates the octree voxels into _info._meshcollision
+            void _UpdateCollisionMesh() const;
+
             boost::weak_ptr<Link> _parent;
             KinBody::GeometryInfo _info; ///< geometry info
+            mutable bool _bCollisionMeshOutdated; ///< true if the octree voxels changed after _info._meshcollision was triangulated. Declared as mutable since data is cached.
 #ifdef RAVE_PRIVATE
 #ifdef _MSC_VER
             friend class OpenRAVEXMLParser::LinkXMLReader;
@@ -427,6 +529,9 @@ protected:
             return _index;
         }
         inline const TriMesh& GetCollisionData() const {
+            if( _bCollisionOutdated ) {
+                _UpdateCollisionData();
+            }
             return _collision;
         }
 
@@ -517,6 +622,13 @@ protected:
         /// \param[in] t the new transformation
         virtual void SetTransform(const Transform& transform);
 
+        /// \brief The parent's \ref KinBody::GetUpdateStamp at the last time the transform of the link changed or the link was enabled/disabled.
+        ///
+        /// Collision checkers can compare it with the body stamp of their last synchronization and only update the links that changed.
+        inline int GetUpdateStamp() const {
+            return _nUpdateStampId;
+        }
+
         /// adds an external force at pos (absolute coords)
         /// \param[in] force the direction and magnitude of the force
         /// \param[in] pos in the world where the force is getting applied
@@ -648,6 +760,9 @@ protected:
         /// \param parameterschanged if true, will
         virtual void _Update(bool parameterschanged=true);
 
+        /// \brief rebuilds _collision from the geometries after an octree geometry changed
+        void _UpdateCollisionData() const;
+
         std::vector<GeometryPtr> _vGeometries;         ///< \see GetGeometries
 
         LinkInfo _info; ///< parameter information of the link
@@ -658,10 +773,12 @@ private:
         //@{
         int _index;                  ///< \see GetIndex
         KinBodyWeakPtr _parent;         ///< \see GetParent
+        int _nUpdateStampId;         ///< \see GetUpdateStamp
         std::vector<int> _vParentLinks;         ///< \see GetParentLinks, IsParentLink
         std::vector<int> _vRigidlyAttachedLinks;         ///< \see IsRigidlyAttached, GetRigidlyAttachedLinks
         TriMesh _collision; ///< triangles for collision checking, triangles are always the triangulation
                             ///< of the body when it is at the identity transformation
+        mutable bool _bCollisionOutdated; ///< true if _collision has to be rebuilt from the geometries. Declared as mutable since data is cached.
         //@}
 #ifdef RAVE_PRIVATE
 #ifdef _MSC_VER
@@ -1657,6 +1774,34 @@ private:
         GetLinkTransformations(transforms);
     }
 
+    /** \brief Computes the link transformations for a batch of configurations without modifying the body.
+
+        The forward kinematics are evaluated with the same rules as \ref SetDOFValues with CLA_Nothing, except that the
+        link transforms are written into the output buffer instead of the links. No change callbacks are triggered and grabbed
+        bodies are not touched, so the body state remains exactly the same. The base link keeps its current transform.
+        Because no body state is written, several threads can call this function at the same time as long as the body
+        structure does not change. Mimic equations are evaluated through a shared function parser, so bodies with mimic joints should
+        not be queried concurrently.
+        \param[out] transforms resized to numconfigs*GetLinks().size(). The link transforms of the ith configuration start at i*GetLinks().size()
+        \param[in] dofvalues flat array of numconfigs*dofstride values where dofstride is dofindices.size(), or GetDOF() if dofindices is empty
+        \param[in] dofindices the dof indices the values correspond to. The rest of the dofs use the current body values. If empty, all dofs are specified.
+     */
+    virtual void ComputeLinkTransformations(std::vector<Transform>& transforms, const std::vector<dReal>& dofvalues, const std::vector<int>& dofindices=std::vector<int>()) const;
+
+    /** \brief Computes the link transformations and the jacobians of one link for a batch of configurations without modifying the body.
+
+        \param[out] transforms see \ref ComputeLinkTransformations
+        \param[out] jacobians resized to numconfigs*6*dofstride. For every configuration, a 3xdofstride translation jacobian (same layout as \ref ComputeJacobianTranslation)
+        is followed by a 3xdofstride axis-angle jacobian (same layout as \ref ComputeJacobianAxisAngle).
+        \param[in] linkindex the link to compute the jacobians for
+        \param[in] localposition the position in the coordinate system of the link to compute the translation jacobian for
+        \param[in] dofvalues flat array of numconfigs*dofstride values
+        \param[in] dofindices the dof indices the values and jacobian columns correspond to. If empty, all dofs are used.
+
+        The partial derivatives of mimic joints are evaluated at the current body configuration, so they are only exact for linear mimic equations.
+     */
+    virtual void ComputeLinkTransformations(std::vector<Transform>& transforms, std::vector<dReal>& jacobians, int linkindex, const Vector& localposition, const std::vector<dReal>& dofvalues, const std::vector<int>& dofindices=std::vector<int>()) const;
+
     /// \brief gets the enable states of all links
     virtual void GetLinkEnableStates(std::vector<uint8_t>& enablestates) const;
 
@@ -1916,6 +2061,19 @@ private:
      */
     virtual void ComputeInverseDynamics(boost::array< std::vector<dReal>, 3>& doftorquecomponents, const std::vector<dReal>& dofaccelerations, const ForceTorqueMap& externalforcetorque=ForceTorqueMap()) const;
 
+    /** \brief Computes the inverse dynamics (torques) for a batch of states without modifying the body.
+
+        Uses the same Recursive Newton Euler formulation as \ref ComputeInverseDynamics, but the link transformations are computed with \ref ComputeLinkTransformations
+        and the work buffers are shared by all the states, so it is much faster than setting every state on the body. The base link stays at its current transform and velocity.
+        Only single-axis revolute and prismatic joints are supported, passive joints can mimic active dofs.
+        \param[out] doftorques resized to numstates*GetDOF() torques
+        \param[in] dofvalues flat array of numstates*GetDOF() dof values
+        \param[in] dofvelocities flat array of numstates*GetDOF() dof velocities
+        \param[in] dofaccelerations flat array of numstates*GetDOF() dof accelerations
+        \throw openrave_exception ORE_NotImplemented if the body has joints that are not supported
+     */
+    virtual void ComputeInverseDynamics(std::vector<dReal>& doftorques, const std::vector<dReal>& dofvalues, const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations) const;
+
     /// \brief sets a self-collision checker to be used whenever \ref CheckSelfCollision is called
     ///
     /// This function allows self-collisions to use a different, un-padded geometry for self-collisions
@@ -2119,6 +2277,19 @@ protected:
     /// \param[in] externalaccelerations [optional] The external accelerations to add to each link. When doing inverse dynamics, should set the base link's acceleration to -gravity.
     virtual void _ComputeLinkAccelerations(const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations, const std::vector< std::pair<Vector, Vector> >& linkvelocities, std::vector<std::pair<Vector,Vector> >& linkaccelerations, AccelerationMapConstPtr externalaccelerations=AccelerationMapConstPtr()) const;
 
+    /// \brief gets the values of the passive joints clamped to their limits. The values of passive mimic joints are left empty and are filled by \ref _ComputeLinkTransformations.
+    void _GetPassiveJointValues(std::vector< std::vector<dReal> >& passivejointvalues) const;
+
+    /// \brief Computes the forward kinematics of one configuration into a transform buffer. \see SetDOFValues, ComputeLinkTransformations
+    ///
+    /// \param[inout] transforms GetLinks().size() link transforms. The links that are not reached by a joint, including the base link, keep their values.
+    /// \param[in] dofvalues the values of all the dofs
+    /// \param[inout] passivejointvalues initialized by \ref _GetPassiveJointValues, the values of the passive mimic joints are filled in
+    /// \param[out] linkscomputed non-zero for the links whose transforms were computed
+    /// \param checklimits how mimic joint values outside of the limits are handled, see \ref CheckLimitsAction
+    /// \param setlastvalues if true, records the dof values in the joints like \ref SetDOFValues does
+    void _ComputeLinkTransformations(Transform* transforms, const dReal* dofvalues, std::vector< std::vector<dReal> >& passivejointvalues, std::vector<uint8_t>& linkscomputed, uint32_t checklimits, bool setlastvalues) const;
+
     /// \brief Called to notify the body that certain groups of parameters have been changed.
     ///
     /// This function in calls every registers calledback that is tracking the changes. It also
@@ -2139,6 +2310,12 @@ protected:
     /// \brief resets cached information dependent on the collision checker (usually called when the collision checker is switched or some big mode is set.
     virtual void _ResetInternalCollisionCache();
 
+    /// \brief records the body in the environment change journal, at most once per journal stamp
+    void _RecordChange() const;
+
+    /// \brief increments the update stamp and marks all links as changed. Used when link transforms are written without Link::SetTransform.
+    void _UpdateStampAllLinks() const;
+
     std::string _name; ///< name of body
     std::vector<JointPtr> _vecjoints; ///< \see GetJoints
     std::vector<JointPtr> _vTopologicallySortedJoints; ///< \see GetDependencyOrderedJoints
@@ -2168,6 +2345,8 @@ protected:
 
     int _environmentid; ///< \see GetEnvironmentId
     mutable int _nUpdateStampId; ///< \see GetUpdateStamp
+    EnvironmentChangeJournalPtr _pchangejournal; ///< journal of the environment the body is added to, set by the environment
+    mutable int _nChangeJournalStamp; ///< journal stamp the body was last recorded at
     uint32_t _nParametersChanged; ///< set of parameters that changed and need callbacks
     ManageDataPtr _pManageData;
     uint32_t _nHierarchyComputed; ///< true if the joint heirarchy and other cached information is computed
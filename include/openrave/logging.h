@@ -142,12 +142,43 @@ inline const char* RaveGetSourceFilename(const char* pfilename)
     return p+1;
 }
 
+/// \brief how the RAVELOG macros output their messages, see \ref RaveSetLogMode
+enum LogMode {
+    LM_Direct=0, ///< format and print every message in the calling thread
+    LM_Async=1, ///< copy every message into a buffer of the calling thread, a background thread adds the headers and prints them
+};
+
+/// \brief Sets how log messages are output, a value of \ref LogMode. The default can be set with the OPENRAVE_LOG_MODE environment variable ("direct" or "async").
+///
+/// In \ref LM_Async mode every thread has a fixed size buffer, messages that do not fit into it are dropped and counted. Messages logged with the wide char
+/// macros and with log4cxx are always printed directly.
+/// \return false if the mode is not supported, in which case the mode does not change
+OPENRAVE_API bool RaveSetLogMode(int mode);
+
+/// \brief Returns the current \ref LogMode
+OPENRAVE_API int RaveGetLogMode();
+
+/// \brief Prints all the messages that were logged asynchronously before the call.
+OPENRAVE_API void RaveFlushLog();
+
+/// \brief Returns the number of asynchronous messages dropped because the buffer of their thread was full.
+OPENRAVE_API uint64_t RaveGetLogDropCount();
+
+/// \brief Queues a message to the buffer of the calling thread, used by the RAVELOG macros in \ref LM_Async mode.
+///
+/// \param filename, function have to be string literals, if filename is NULL, the message is printed without a header
+/// \return the length of the message or -1 if it was dropped
+OPENRAVE_API int RaveLogAsync(int level, const char* filename, int line, const char* function, const std::string& s);
+
+/// \brief Queues a printf formatted message, see \ref RaveLogAsync
+OPENRAVE_API int RaveLogAsync(int level, const char* filename, int line, const char* function, const char* fmt, ...);
+
 #define RAVEPRINTHEADER(LEVEL) OpenRAVE::RavePrintfA ## LEVEL("[%s:%d %s] ", OpenRAVE::RaveGetSourceFilename(__FILE__), __LINE__,  __FUNCTION__)
 
 // different logging levels. The higher the suffix number, the less important the information is.
 // 0 log level logs all the time. OpenRAVE starts up with a log level of 0.
 #define RAVELOG_LEVELW(LEVEL,level,...) do { if (int(OpenRAVE::RaveGetDebugLevel()&OpenRAVE::Level_OutputMask)>=int(level)) { RAVEPRINTHEADER(LEVEL); OpenRAVE::RavePrintfW ## LEVEL(__VA_ARGS__); } } while (0)
-#define RAVELOG_LEVELA(LEVEL,level,...) do { if (int(OpenRAVE::RaveGetDebugLevel()&OpenRAVE::Level_OutputMask)>=int(level)) { RAVEPRINTHEADER(LEVEL); OpenRAVE::RavePrintfA ## LEVEL(__VA_ARGS__); } } while (0)
+#define RAVELOG_LEVELA(LEVEL,level,...) do { if (int(OpenRAVE::RaveGetDebugLevel()&OpenRAVE::Level_OutputMask)>=int(level)) { if( OpenRAVE::RaveGetLogMode() == OpenRAVE::LM_Async ) { OpenRAVE::RaveLogAsync(int(level), __FILE__, __LINE__, __FUNCTION__, __VA_ARGS__); } else { RAVEPRINTHEADER(LEVEL); OpenRAVE::RavePrintfA ## LEVEL(__VA_ARGS__); } } } while (0)
 
 
 #if OPENRAVE_LOG4CXX
@@ -361,6 +392,9 @@ inline int RavePrintfA(const std::string& s, uint32_t level)
 
 inline int RavePrintfA(const std::string& s, uint32_t level)
 {
+    if( RaveGetLogMode() == LM_Async ) {
+        return RaveLogAsync(level, NULL, 0, NULL, s);
+    }
     if((s.size() == 0)||(s[s.size()-1] != '\n')) { // automatically add a new line
         printf("%s\n", s.c_str());
     }
@@ -442,6 +476,9 @@ inline int RavePrintfA_INFOLEVEL(const char *fmt, ...)
 inline int RavePrintfA(const std::string& s, uint32_t level)
 {
     if( (RaveGetDebugLevel()&Level_OutputMask)>=level ) {
+        if( RaveGetLogMode() == LM_Async ) {
+            return RaveLogAsync(level, NULL, 0, NULL, s);
+        }
         int color = 0;
         switch(level&Level_OutputMask) {
         case Level_Fatal: color = OPENRAVECOLOR_FATALLEVEL; break;
@@ -100,6 +100,7 @@ namespace OpenRAVE {
 }
 
 #include <openrave/logging.h>
+#include <openrave/profiling.h>
 
 namespace OpenRAVE {
 
@@ -315,6 +316,7 @@ class PlannerBase;
 class RobotBase;
 class ModuleBase;
 class EnvironmentBase;
+class EnvironmentChangeJournal;
 class KinBody;
 class SensorSystemBase;
 class PhysicsEngineBase;
@@ -373,6 +375,7 @@ typedef boost::weak_ptr<SpaceSamplerBase> SpaceSamplerBaseWeakPtr;
 typedef boost::shared_ptr<EnvironmentBase> EnvironmentBasePtr;
 typedef boost::shared_ptr<EnvironmentBase const> EnvironmentBaseConstPtr;
 typedef boost::weak_ptr<EnvironmentBase> EnvironmentBaseWeakPtr;
+typedef boost::shared_ptr<EnvironmentChangeJournal> EnvironmentChangeJournalPtr;
 
 typedef boost::shared_ptr<IkReturn> IkReturnPtr;
 typedef boost::shared_ptr<IkReturn const> IkReturnConstPtr;
@@ -537,7 +537,7 @@ typedef boost::shared_ptr<TrajectoryTimingParameters const> TrajectoryTimingPara
 class OPENRAVE_API ConstraintTrajectoryTimingParameters : public TrajectoryTimingParameters
 {
 public:
-    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), fSearchVelAccelMult(0.8), _bCProcessing(false) {
+    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), nshortcutthreads(1), fSearchVelAccelMult(0.8), _bCProcessing(false) {
         _vXMLParameters.push_back("maxlinkspeed");
         _vXMLParameters.push_back("maxlinkaccel");
         _vXMLParameters.push_back("manipname");
@@ -551,6 +551,7 @@ public:
         _vXMLParameters.push_back("maxmergeiterations");
         _vXMLParameters.push_back("minswitchtime");
         _vXMLParameters.push_back("nshortcutcycles");
+        _vXMLParameters.push_back("nshortcutthreads");
         _vXMLParameters.push_back("searchvelaccelmult");
     }
 
@@ -572,6 +573,11 @@ public:
     int maxmergeiterations; ///< when merging several ramps together, the order that they are merged in depends. This parameters pecifies how many permutations to test before giving up.
     dReal minswitchtime; ///< the minimum time between switching accelerations of any joint (waypoints).
     int nshortcutcycles; ///< number of times the shortcut cycle is repeted.
+    /// \brief number of threads that speculatively check shortcut candidates in parallel, each on its own cloned environment. 1 (default) checks the shortcuts serially.
+    ///
+    /// The workers bind their state functions to the cloned bodies with SetConfigurationSpecification, so only set this when the
+    /// functions of the parameters are the default ones. Custom functions and DynamicsCollisionConstraint::SetUserCheckFunction are not seen by the workers.
+    int nshortcutthreads;
 
     dReal fSearchVelAccelMult; ///< a number in [0.0001,0.99999] that is the multipler of the velocity/acceleration limits when time-based constraints are invalidated (manip speed and/or dynamics). The closer to 1 it is, the more optimal the trajectory will be, but it will take more time to compute. A value around 0.5-0.8 is best.
 
@@ -595,6 +601,7 @@ protected:
         O << "<maxmergeiterations>" << maxmergeiterations << "</maxmergeiterations>" << std::endl;
         O << "<minswitchtime>" << minswitchtime << "</minswitchtime>" << std::endl;
         O << "<nshortcutcycles>" << nshortcutcycles << "</nshortcutcycles>" << std::endl;
+        O << "<nshortcutthreads>" << nshortcutthreads << "</nshortcutthreads>" << std::endl;
         O << "<searchvelaccelmult>" << fSearchVelAccelMult << "</searchvelaccelmult>" << std::endl;
         if( !(options & 1) ) {
             O << _sExtraParameters << std::endl;
@@ -613,7 +620,7 @@ protected:
         case PE_Support: return PE_Support;
         case PE_Ignore: return PE_Ignore;
         }
-        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult";
+        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="nshortcutthreads" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult";
         return _bCProcessing ? PE_Support : PE_Pass;
     }
 
@@ -650,6 +657,9 @@ protected:
             else if( name == "nshortcutcycles") {
                 _ss >> nshortcutcycles;
             }
+            else if( name == "nshortcutthreads") {
+                _ss >> nshortcutthreads;
+            }
             else if( name == "searchvelaccelmult") {
                 _ss >> fSearchVelAccelMult;
             }
@@ -427,6 +427,13 @@ public:
     ///
     /// \param torquelimitmode 1 if should use instantaneous max torque, 0 if should use nominal torque
     virtual void SetTorqueLimitMode(int torquelimitmode);
+
+    /// \brief sets whether the environment and self-collisions of linear segments are checked with one continuous collision query per body instead of at every step.
+    ///
+    /// Uses CollisionCheckerBase::CheckContinuousCollision and CollisionCheckerBase::CheckContinuousStandaloneSelfCollision, so the segment has to be linear in the DOF values of the bodies.
+    /// Quadratic segments, perturbations, moving base transforms, grabbed bodies with self-collisions, and several moving bodies are still discretized.
+    /// If the collision checker does not support continuous queries, the mode is turned off.
+    virtual void SetContinuousCollisionChecking(bool bContinuousCollisionChecking);
     
     /// \brief set user check fucntions
     ///
@@ -455,6 +462,36 @@ protected:
     virtual int _SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn);
     virtual void _PrintOnFailure(const std::string& prefix);
 
+    /// \brief fills _vtorquevalues with the dofs of pbody that have torque limits
+    virtual void _GetTorqueLimits(KinBodyPtr pbody);
+
+    /// \brief checks the segment like \ref Check
+    ///
+    /// If _bRecordSegmentStates is set, the states are only set and recorded with \ref _AddSegmentTorqueState without being checked.
+    virtual int _CheckSegment(const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, IntervalType interval, int options, ConstraintFilterReturnPtr filterreturn);
+
+    /// \brief returns false if the torque limits of a body depend on its speed, so they have to be checked at every state
+    virtual bool _CanBatchSegmentTorqueLimits();
+
+    /// \brief records the state that was just set, its torque limits are checked by \ref _CheckSegmentTorqueLimits before the states are checked for collisions
+    ///
+    /// The time of the state is _fSegmentStateTime.
+    virtual void _AddSegmentTorqueState(const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels);
+
+    /// \brief checks the torque limits of the recorded states with one batch inverse dynamics call per body
+    ///
+    /// \param[out] iInvalidState if the limits are violated, the index of the earliest violating state
+    /// \return 0 if the limits are satisfied or CFO_CheckTimeBasedConstraints if violated
+    virtual int _CheckSegmentTorqueLimits(size_t& iInvalidState);
+
+    /// \brief checks the environment and self-collisions of the linear segment q0+t*dQ for t in [fStartTime, fEndTime] with continuous collision queries
+    ///
+    /// The state is set back to q0 before returning.
+    /// \param options should already be masked with _filtermask
+    /// \param[out] fTimeWhenInvalid if in collision, the interpolation parameter t of the colliding configuration
+    /// \return 0 if the segment is free, the violated \ref ConstraintFilterOptions, or -1 if the segment cannot be checked continuously and has to be discretized
+    virtual int _CheckContinuousCollisions(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& dQ, dReal fStartTime, dReal fEndTime, int options, dReal& fTimeWhenInvalid);
+
     PlannerBase::PlannerParametersWeakConstPtr _parameters;
     std::vector<dReal> _vtempconfig, _vtempvelconfig, dQ, _vtempveldelta, _vtempaccelconfig, _vperturbedvalues, _vcoeff2, _vcoeff1, _vprevtempconfig, _vprevtempvelconfig; ///< in configuration space
     CollisionReportPtr _report;
@@ -462,6 +499,7 @@ protected:
     int _filtermask;
     int _torquelimitmode; ///< 1 if should use instantaneous max torque, 0 if should use nominal torque
     dReal _perturbation;
+    bool _bContinuousCollisionChecking; ///< if true, checks the collisions of linear segments with continuous collision queries
     boost::array< boost::function<bool() >, 2> _usercheckfns;
 
     // for dynamics
@@ -469,6 +507,17 @@ protected:
     std::vector< std::pair<int, std::pair<dReal, dReal> > > _vtorquevalues; ///< cache for dof indices and the torque limits that the current torque should be in
     std::vector< int > _vdofindices;
     std::vector<dReal> _doftorques, _dofaccelerations; ///< in body DOF space
+    std::vector< std::vector<dReal> > _vsegmentdofvalues, _vsegmentdofvelocities, _vsegmentdofaccelerations; ///< recorded states of every body of _listCheckBodies in body DOF space, reused across segments
+    std::vector<dReal> _vsegmentdoftorques, _vcurdofvalues; ///< in body DOF space
+    std::vector<dReal> _vsegmenttimes; ///< times of the recorded states
+    dReal _fSegmentStateTime; ///< time of the state that is checked next in the segment
+    std::vector<dReal> _vcontinuousconfig; ///< configuration at one end of a continuously checked segment
+    std::vector< std::vector<dReal> > _vcontinuousdofvalues; ///< DOF values of every body at the start and end of a segment
+    std::vector<Transform> _vcontinuoustransforms; ///< base transforms of every body at the start and end of a segment
+    size_t _nSegmentStateIndex; ///< index of the state that _SetAndCheckState checks next in the segment
+    size_t _nSegmentInvalidStateIndex; ///< index of the earliest recorded state that violates the torque limits, or the number of recorded states
+    bool _bBatchSegmentTorques; ///< if true, the torque limits of the states of the segment were checked in one batch, so _CheckState skips them
+    bool _bRecordSegmentStates; ///< if true, _SetAndCheckState only sets and records the states of the segment
     boost::shared_ptr<ConfigurationSpecification::SetConfigurationStateFn> _setvelstatefn;
 };
 
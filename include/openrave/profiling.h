@@ -0,0 +1,85 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2006-2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/** \file profiling.h
+    \brief Defines the optional profiling counters of hot code paths. This file is automatically included by openrave.h.
+
+    Sections are only compiled in when OpenRAVE is configured with OPT_PROFILING, which sets OPENRAVE_PROFILING to 1.
+    Otherwise \ref OPENRAVE_PROFILE_SCOPE expands to nothing and there is no overhead.
+ */
+#ifndef OPENRAVE_PROFILING_H
+#define OPENRAVE_PROFILING_H
+
+namespace OpenRAVE {
+
+/// \brief Statistics of a profiling section summed over all threads.
+class ProfileStatistics
+{
+public:
+    ProfileStatistics() : count(0), totaltime(0), maxtime(0) {
+    }
+    std::string name; ///< name the section was registered with
+    uint64_t count; ///< number of times the section was run
+    uint64_t totaltime; ///< total time spent in the section in nanoseconds
+    uint64_t maxtime; ///< longest single run in nanoseconds
+    std::vector<uint64_t> vhistogram; ///< vhistogram[i] is the number of runs that took less than 2^(i+1) nanoseconds and were not counted in a lower bin
+};
+
+/// \brief Registers a profiling section and returns its id. Registering the same name again returns the same id. <b>[multi-thread safe]</b>
+OPENRAVE_API int RaveRegisterProfileSection(const std::string& name);
+
+/// \brief Adds one run of a section to the counters of the calling thread. <b>[multi-thread safe]</b>
+///
+/// \param sectionid the id returned by \ref RaveRegisterProfileSection
+/// \param duration the time the run took in nanoseconds
+OPENRAVE_API void RaveAddProfileSample(int sectionid, uint64_t duration);
+
+/// \brief Returns the current time in nanoseconds used for timing profiling sections.
+OPENRAVE_API uint64_t RaveGetProfileTime();
+
+/// \brief Sums the counters of all threads, including the threads that already exited. <b>[multi-thread safe]</b>
+///
+/// Sections that were never run are not returned.
+OPENRAVE_API void RaveGetProfileStatistics(std::vector<ProfileStatistics>& vstatistics);
+
+/// \brief Zeros the counters of all threads. <b>[multi-thread safe]</b>
+OPENRAVE_API void RaveResetProfileStatistics();
+
+/// \brief Times the scope it is declared in and adds the run to a profiling section. Use through \ref OPENRAVE_PROFILE_SCOPE.
+class ProfileScope
+{
+public:
+    ProfileScope(int sectionid) : _sectionid(sectionid), _starttime(RaveGetProfileTime()) {
+    }
+    ~ProfileScope() {
+        RaveAddProfileSample(_sectionid, RaveGetProfileTime()-_starttime);
+    }
+
+private:
+    int _sectionid;
+    uint64_t _starttime;
+};
+
+} // end namespace OpenRAVE
+
+#if OPENRAVE_PROFILING
+/// \brief Profiles the rest of the enclosing scope under the given section name. Compiled out unless OPENRAVE_PROFILING is 1.
+#define OPENRAVE_PROFILE_SCOPE(name) static const int _openrave_profile_sectionid = OpenRAVE::RaveRegisterProfileSection(name); OpenRAVE::ProfileScope _openrave_profile_scope(_openrave_profile_sectionid)
+#else
+#define OPENRAVE_PROFILE_SCOPE(name)
+#endif
+
+#endif
@@ -28,11 +28,20 @@ If \ref ControllerBase::SetPath is called and the trajectory finishes, then the
 1. ControllerBase::SetPath is called.\n\n\
 2. ControllerBase::SetDesired is called.\n\n\
 3. ControllerBase::Reset is called resetting everything\n\n\
-If SetDesired is called, only joint values will be set at every timestep leaving the transformation alone.\n";
+If SetDesired is called, only joint values will be set at every timestep leaving the transformation alone.\n\n\
+For fixed-rate simulations, **SetPrecomputedSampling** resamples every trajectory into a dense time-indexed buffer when it is set so that each simulation step only copies values, and **SetCheckCollisionPeriod** limits how often the collision checks run. **GetTickStatistics** returns the time spent in the simulation steps.\n";
         RegisterCommand("Pause",boost::bind(&IdealController::_Pause,this,_1,_2),
                         "pauses the controller from reacting to commands ");
         RegisterCommand("SetCheckCollisions",boost::bind(&IdealController::_SetCheckCollisions,this,_1,_2),
                         "If set, will check if the robot gets into a collision during movement");
+        RegisterCommand("SetCheckCollisionPeriod",boost::bind(&IdealController::_SetCheckCollisionPeriod,this,_1,_2),
+                        "Minimum simulation time between two collision checks while moving. The first and the last configurations of a trajectory are always checked. 0 (default) checks at every step. Format is:\n\n  [period]");
+        RegisterCommand("SetPrecomputedSampling",boost::bind(&IdealController::_SetPrecomputedSampling,this,_1,_2),
+                        "If the time step is > 0, every trajectory passed to SetPath is resampled at that time step into a buffer and the simulation step uses the sample closest to the current time. The simulation time step should be a multiple of it. 0 (default) samples the trajectory at every step. Format is:\n\n  [timestep]");
+        RegisterCommand("GetTickStatistics",boost::bind(&IdealController::_GetTickStatistics,this,_1,_2),
+                        "Returns the statistics of the simulation steps since the last reset in seconds:\n\n  [numsteps] [mean time] [max time] [last time] [numcollisionchecks]");
+        RegisterCommand("ResetTickStatistics",boost::bind(&IdealController::_ResetTickStatistics,this,_1,_2),
+                        "Resets the statistics returned by GetTickStatistics");
         RegisterCommand("SetThrowExceptions",boost::bind(&IdealController::_SetThrowExceptions,this,_1,_2),
                         "If set, will throw exceptions instead of print warnings. Format is:\n\n  [0/1]");
         RegisterCommand("SetEnableLogging",boost::bind(&IdealController::_SetEnableLogging,this,_1,_2),
@@ -40,6 +49,10 @@ If SetDesired is called, only joint values will be set at every timestep leaving
         _fCommandTime = 0;
         _fSpeed = 1;
         _nControlTransformation = 0;
+        _fCheckCollisionPeriod = 0;
+        _fLastCollisionCheckTime = -1;
+        _fPrecomputedTimeStep = 0;
+        _ResetTickStatistics();
     }
     virtual ~IdealController() {
     }
@@ -94,6 +107,7 @@ If SetDesired is called, only joint values will be set at every timestep leaving
     virtual void Reset(int options)
     {
         _ptraj.reset();
+        _ClearPrecomputedSamples();
         _vecdesired.resize(0);
         if( flog.is_open() ) {
             flog.close();
@@ -114,7 +128,9 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             throw openrave_exception(str(boost::format("wrong desired dimensions %d!=%d")%values.size()%_dofindices.size()),ORE_InvalidArguments);
         }
         _fCommandTime = 0;
+        _fLastCollisionCheckTime = -1;
         _ptraj.reset();
+        _ClearPrecomputedSamples();
         // do not set done to true here! let it be picked up by the simulation thread.
         // this will also let it have consistent mechanics as SetPath
         // (there's a race condition we're avoiding where a user calls SetDesired and then state savers revert the robot)
@@ -145,13 +161,16 @@ If SetDesired is called, only joint values will be set at every timestep leaving
         if( _bPause ) {
             RAVELOG_DEBUG("IdealController cannot start trajectories when paused\n");
             _ptraj.reset();
+            _ClearPrecomputedSamples();
             _bIsDone = true;
             return false;
         }
         _fCommandTime = 0;
+        _fLastCollisionCheckTime = -1;
         _bIsDone = true;
         _vecdesired.resize(0);
         _ptraj.reset();
+        _ClearPrecomputedSamples();
 
         if( !!ptraj ) {
             _samplespec._vgroups.resize(0);
@@ -244,6 +263,9 @@ If SetDesired is called, only joint values will be set at every timestep leaving
 
             _ptraj = RaveCreateTrajectory(GetEnv(),ptraj->GetXMLId());
             _ptraj->Clone(ptraj,0);
+            if( _fPrecomputedTimeStep > 0 ) {
+                _PrecomputeSamples();
+            }
             _bIsDone = false;
         }
 
@@ -255,11 +277,21 @@ If SetDesired is called, only joint values will be set at every timestep leaving
         if( _bPause ) {
             return;
         }
+        uint64_t starttime = utils::GetNanoPerformanceTime();
         boost::mutex::scoped_lock lock(_mutex);
         TrajectoryBaseConstPtr ptraj = _ptraj; // because of multi-threading setting issues
         if( !!ptraj ) {
-            vector<dReal> sampledata;
-            ptraj->Sample(sampledata,_fCommandTime,_samplespec);
+            std::vector<dReal>& sampledata = _vsampledata;
+            int nprecomputedindex = -1;
+            if( _vprecomputedtimes.size() > 0 ) {
+                nprecomputedindex = min((int)_vprecomputedtimes.size()-1, (int)(_fCommandTime/_fPrecomputedTimeStep+0.5));
+                int dof = _samplespec.GetDOF();
+                sampledata.resize(dof);
+                std::copy(_vprecomputeddata.begin()+nprecomputedindex*dof, _vprecomputeddata.begin()+(nprecomputedindex+1)*dof, sampledata.begin());
+            }
+            else {
+                ptraj->Sample(sampledata,_fCommandTime,_samplespec);
+            }
 
             // already sampled, so change the command times before before setting values
             // incase the below functions fail
@@ -267,6 +299,8 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             if( _fCommandTime > ptraj->GetDuration() ) {
                 _fCommandTime = ptraj->GetDuration();
                 bIsDone = true;
+                // always check the final configuration
+                _fLastCollisionCheckTime = -1;
             }
             else {
                 _fCommandTime += _fSpeed * fTimeElapsed;
@@ -319,15 +353,26 @@ If SetDesired is called, only joint values will be set at every timestep leaving
                 }
             }
 
-            vector<dReal> vdofvalues;
+            std::vector<dReal>& vdofvalues = _vdofvalues;
+            vdofvalues.resize(0);
             if( _bTrajHasJoints && _dofindices.size() > 0 ) {
                 vdofvalues.resize(_dofindices.size());
-                _samplespec.ExtractJointValues(vdofvalues.begin(),sampledata.begin(), _probot, _dofindices, 0);
+                if( nprecomputedindex >= 0 ) {
+                    std::copy(_vprecomputeddofvalues.begin()+nprecomputedindex*_dofindices.size(), _vprecomputeddofvalues.begin()+(nprecomputedindex+1)*_dofindices.size(), vdofvalues.begin());
+                }
+                else {
+                    _samplespec.ExtractJointValues(vdofvalues.begin(),sampledata.begin(), _probot, _dofindices, 0);
+                }
             }
 
             Transform t;
             if( _bTrajHasTransform && _nControlTransformation ) {
-                _samplespec.ExtractTransform(t,sampledata.begin(),_probot);
+                if( nprecomputedindex >= 0 ) {
+                    t = _vprecomputedtransforms.at(nprecomputedindex);
+                }
+                else {
+                    _samplespec.ExtractTransform(t,sampledata.begin(),_probot);
+                }
                 if( vdofvalues.size() > 0 ) {
                     _SetDOFValues(vdofvalues,t, _fCommandTime > 0 ? fTimeElapsed : 0);
                 }
@@ -359,6 +404,7 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             if( bIsDone ) {
                 // trajectory is done, so reset it so that the controller doesn't continously set the dof values (which can get annoying)
                 _ptraj.reset();
+                _ClearPrecomputedSamples();
             }
         }
 
@@ -373,6 +419,12 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             // don't need to set it anymore
             _vecdesired.resize(0);
         }
+
+        uint64_t ticktime = utils::GetNanoPerformanceTime()-starttime;
+        _nTickCount++;
+        _nTickTotalTime += ticktime;
+        _nTickMaxTime = max(_nTickMaxTime, ticktime);
+        _nTickLastTime = ticktime;
     }
 
     virtual bool IsDone() {
@@ -399,6 +451,45 @@ private:
         }
         return !!is;
     }
+    virtual bool _SetCheckCollisionPeriod(std::ostream& os, std::istream& is)
+    {
+        dReal period = 0;
+        is >> period;
+        if( !is ) {
+            return false;
+        }
+        _fCheckCollisionPeriod = period;
+        return true;
+    }
+    virtual bool _SetPrecomputedSampling(std::ostream& os, std::istream& is)
+    {
+        dReal timestep = 0;
+        is >> timestep;
+        if( !is ) {
+            return false;
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        _fPrecomputedTimeStep = timestep;
+        if( _fPrecomputedTimeStep > 0 && !!_ptraj ) {
+            _PrecomputeSamples();
+        }
+        else {
+            _ClearPrecomputedSamples();
+        }
+        return true;
+    }
+    virtual bool _GetTickStatistics(std::ostream& os, std::istream& is)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        os << _nTickCount << " " << (_nTickCount > 0 ? 1e-9*_nTickTotalTime/_nTickCount : 0) << " " << 1e-9*_nTickMaxTime << " " << 1e-9*_nTickLastTime << " " << _nCollisionChecks;
+        return true;
+    }
+    virtual bool _ResetTickStatistics(std::ostream& os, std::istream& is)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _ResetTickStatistics();
+        return true;
+    }
     virtual bool _SetThrowExceptions(std::ostream& os, std::istream& is)
     {
         is >> _bThrowExceptions;
@@ -420,6 +511,49 @@ private:
         return shared_controller();
     }
 
+    void _ResetTickStatistics()
+    {
+        _nTickCount = 0;
+        _nTickTotalTime = 0;
+        _nTickMaxTime = 0;
+        _nTickLastTime = 0;
+        _nCollisionChecks = 0;
+    }
+
+    /// \brief resamples _ptraj every _fPrecomputedTimeStep seconds, the last sample is always at the end of the trajectory
+    void _PrecomputeSamples()
+    {
+        size_t numsamples = (size_t)std::ceil(_ptraj->GetDuration()/_fPrecomputedTimeStep)+1;
+        _vprecomputedtimes.resize(numsamples);
+        for(size_t i = 0; i < numsamples; ++i) {
+            _vprecomputedtimes[i] = min(_ptraj->GetDuration(), i*_fPrecomputedTimeStep);
+        }
+        _ptraj->SamplePoints(_vprecomputeddata, _vprecomputedtimes, _samplespec);
+        int dof = _samplespec.GetDOF();
+        _vprecomputeddofvalues.resize(0);
+        if( _bTrajHasJoints && _dofindices.size() > 0 ) {
+            _vprecomputeddofvalues.resize(numsamples*_dofindices.size());
+            for(size_t i = 0; i < numsamples; ++i) {
+                _samplespec.ExtractJointValues(_vprecomputeddofvalues.begin()+i*_dofindices.size(), _vprecomputeddata.begin()+i*dof, _probot, _dofindices, 0);
+            }
+        }
+        _vprecomputedtransforms.resize(0);
+        if( _bTrajHasTransform && _nControlTransformation ) {
+            _vprecomputedtransforms.resize(numsamples);
+            for(size_t i = 0; i < numsamples; ++i) {
+                _samplespec.ExtractTransform(_vprecomputedtransforms[i], _vprecomputeddata.begin()+i*dof, _probot);
+            }
+        }
+    }
+
+    void _ClearPrecomputedSamples()
+    {
+        _vprecomputedtimes.resize(0);
+        _vprecomputeddata.resize(0);
+        _vprecomputeddofvalues.resize(0);
+        _vprecomputedtransforms.resize(0);
+    }
+
     virtual void _SetJointLimits()
     {
         if( !!_probot ) {
@@ -431,7 +565,7 @@ private:
 
     virtual void _SetDOFValues(const std::vector<dReal>&values, dReal timeelapsed)
     {
-        vector<dReal> prevvalues, curvalues, curvel;
+        std::vector<dReal>& prevvalues = _vprevvalues, &curvalues = _vcurvalues, &curvel = _vcurvel;
         _probot->GetDOFValues(prevvalues);
         curvalues = prevvalues;
         _probot->GetDOFVelocities(curvel);
@@ -450,7 +584,7 @@ private:
     virtual void _SetDOFValues(const std::vector<dReal>&values, const Transform &t, dReal timeelapsed)
     {
         BOOST_ASSERT(_nControlTransformation);
-        vector<dReal> prevvalues, curvalues, curvel;
+        std::vector<dReal>& prevvalues = _vprevvalues, &curvalues = _vcurvalues, &curvel = _vcurvel;
         _probot->GetDOFValues(prevvalues);
         curvalues = prevvalues;
         _probot->GetDOFVelocities(curvel);
@@ -478,7 +612,8 @@ private:
             }
         }
         if( timeelapsed > 0 ) {
-            vector<dReal> vdiff = curvalues;
+            std::vector<dReal>& vdiff = _vdiff;
+            vdiff = curvalues;
             _probot->SubtractDOFValues(vdiff,prevvalues);
             for(size_t i = 0; i < _vupper[1].size(); ++i) {
                 dReal maxallowed = timeelapsed * _vupper[1][i]+1e-6;
@@ -492,6 +627,11 @@ private:
     void _CheckConfiguration()
     {
         if( _bCheckCollision ) {
+            if( _fCheckCollisionPeriod > 0 && _fLastCollisionCheckTime >= 0 && _fCommandTime < _fLastCollisionCheckTime+_fCheckCollisionPeriod ) {
+                return;
+            }
+            _fLastCollisionCheckTime = _fCommandTime;
+            _nCollisionChecks++;
             if( GetEnv()->CheckCollision(KinBodyConstPtr(_probot),_report) ) {
                 _ReportError(str(boost::format("collsion in trajectory: %s, time=%f\n")%_report->__str__()%_fCommandTime));
             }
@@ -554,6 +694,20 @@ private:
     ConfigurationSpecification _samplespec;
     boost::shared_ptr<ConfigurationSpecification::Group> _gjointvalues, _gtransform;
     boost::mutex _mutex;
+
+    dReal _fCheckCollisionPeriod; ///< minimum simulation time between collision checks, 0 checks at every step
+    dReal _fLastCollisionCheckTime; ///< command time of the last collision check, -1 forces the next check
+
+    dReal _fPrecomputedTimeStep; ///< if > 0, time step of the precomputed samples
+    std::vector<dReal> _vprecomputedtimes; ///< times of the precomputed samples of _ptraj
+    std::vector<dReal> _vprecomputeddata; ///< precomputed samples of _ptraj in _samplespec
+    std::vector<dReal> _vprecomputeddofvalues; ///< precomputed values of _dofindices for every sample
+    std::vector<Transform> _vprecomputedtransforms; ///< precomputed robot transforms for every sample
+
+    std::vector<dReal> _vsampledata, _vdofvalues, _vprevvalues, _vcurvalues, _vcurvel, _vdiff; ///< cache so that the simulation steps do not allocate
+
+    uint64_t _nTickCount, _nTickTotalTime, _nTickMaxTime, _nTickLastTime; ///< statistics of SimulationStep, times in nanoseconds
+    uint64_t _nCollisionChecks;
 };
 
 ControllerBasePtr CreateIdealController(EnvironmentBasePtr penv, std::istream& sinput)
@@ -19,6 +19,20 @@ using namespace std;
 
 #include "halton.h"
 
+/// \brief adds the next digit of every index to its radical inverse and removes it from the index
+///
+/// The base is a template parameter for the first primes so that the division turns into a multiplication.
+template <int B>
+static inline void AccumulateHaltonDigit(int n, int* seed, dReal* r, dReal base_inv)
+{
+    for ( int j = 0; j < n; j++ )
+    {
+        int digit = seed[j] % B;
+        r[j] = r[j] + ( ( dReal ) digit ) * base_inv;
+        seed[j] = seed[j] / B;
+    }
+}
+
 char HaltonSampler::digit_to_ch ( int i )
 
 //****************************************************************************80
@@ -1123,35 +1137,60 @@ void HaltonSampler::i4_to_halton_sequence ( int dim_num, int n, int step, int se
     //
     //  Calculate the data.
     //
-    seed2 = new int[n];
+    //  Each dimension is computed for the whole batch at once, one digit position at a time,
+    //  so the inner loops run over contiguous arrays with a fixed trip count. Once an index has
+    //  no more digits it only adds zeros, so the values are identical to converting each index separately.
+    //
+    _vhaltonseeds.resize(n);
+    _vhaltonvalues.resize(n);
+    seed2 = &_vhaltonseeds[0];
+    dReal* r2 = &_vhaltonvalues[0];
 
     for ( i = 0; i < dim_num; i++ )
     {
         for ( j = 0; j < n; j++ )
         {
             seed2[j] = seed[i] + ( step + j ) * leap[i];
+            r2[j] = 0.0;
         }
 
-        for ( j = 0; j < n; j++ )
+        int ndigits = 0;
+        for ( int maxseed = seed2[n-1]; maxseed != 0; maxseed /= base[i] )
         {
-            r[i+j*dim_num] = 0.0;
+            ndigits++;
         }
 
-        for ( j = 0; j < n; j++ )
+        const int b = base[i];
+        base_inv = 1.0 / ( ( dReal ) b );
+        for ( int idigit = 0; idigit < ndigits; idigit++ )
         {
-            base_inv = 1.0 / ( ( dReal ) base[i] );
-
-            while ( seed2[j] != 0 )
+            switch ( b )
             {
-                digit = seed2[j] % base[i];
-                r[i+j*dim_num] = r[i+j*dim_num] + ( ( dReal ) digit ) * base_inv;
-                base_inv = base_inv / ( ( dReal ) base[i] );
-                seed2[j] = seed2[j] / base[i];
+            case 2: AccumulateHaltonDigit<2>(n, seed2, r2, base_inv); break;
+            case 3: AccumulateHaltonDigit<3>(n, seed2, r2, base_inv); break;
+            case 5: AccumulateHaltonDigit<5>(n, seed2, r2, base_inv); break;
+            case 7: AccumulateHaltonDigit<7>(n, seed2, r2, base_inv); break;
+            case 11: AccumulateHaltonDigit<11>(n, seed2, r2, base_inv); break;
+            case 13: AccumulateHaltonDigit<13>(n, seed2, r2, base_inv); break;
+            case 17: AccumulateHaltonDigit<17>(n, seed2, r2, base_inv); break;
+            case 19: AccumulateHaltonDigit<19>(n, seed2, r2, base_inv); break;
+            default:
+                for ( j = 0; j < n; j++ )
+                {
+                    digit = seed2[j] % b;
+                    r2[j] = r2[j] + ( ( dReal ) digit ) * base_inv;
+                    seed2[j] = seed2[j] / b;
+                }
+                break;
             }
+            base_inv = base_inv / ( ( dReal ) b );
         }
-    }
 
-    delete [] seed2;
+        for ( j = 0; j < n; j++ )
+        {
+            r[i+j*dim_num] = r2[j];
+        }
+    }
 
     return;
 }
@@ -120,6 +120,9 @@ protected:
     int halton_DIM_NUM;
     int *halton_SEED;
     int halton_STEP;
+
+    std::vector<int> _vhaltonseeds; ///< cache of the remaining digits of every index in a batch
+    std::vector<dReal> _vhaltonvalues; ///< cache of the radical inverses of one dimension of a batch
 };
 
 #endif
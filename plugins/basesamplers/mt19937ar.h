@@ -49,7 +49,8 @@
 using namespace OpenRAVE;
 using namespace std;
 
-// eventually replace with http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/SFMT/index-jp.html
+// samples are generated in blocks of the state vector, which keeps the exact MT19937 sequence for a seed.
+// SFMT (http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/SFMT/index-jp.html) would be faster, but produces a different sequence.
 class MT19937Sampler : public SpaceSamplerBase
 {
 public:
@@ -101,25 +102,34 @@ Mersenne twister sampling algorithm that is based on matrix linear recurrence ov
     int SampleSequence(std::vector<dReal>& samples, size_t num=1,IntervalType interval=IT_Closed)
     {
         samples.resize(_dof*num);
+        if( samples.size() == 0 ) {
+            return (int)num;
+        }
+        // generate all the integers in one pass and then convert them with a tight loop the compiler can vectorize
+        _vtempsamples.resize(samples.size());
+        genrand_int32_block(&_vtempsamples[0], _vtempsamples.size());
+        const uint32_t* pin = &_vtempsamples[0];
+        dReal* pout = &samples[0];
+        const size_t n = samples.size();
         switch(interval) {
         case IT_Open:
-            for(size_t i = 0; i < samples.size(); ++i) {
-                samples[i] = (((dReal)genrand_int32()) + 0.5f)*(1.0f/4294967296.0f);
+            for(size_t i = 0; i < n; ++i) {
+                pout[i] = (((dReal)pin[i]) + 0.5f)*(1.0f/4294967296.0f);
             }
             break;
         case IT_OpenStart:
-            for(size_t i = 0; i < samples.size(); ++i) {
-                samples[i] = (((dReal)genrand_int32()) + 1.0f)*(1.0f/4294967296.0f);
+            for(size_t i = 0; i < n; ++i) {
+                pout[i] = (((dReal)pin[i]) + 1.0f)*(1.0f/4294967296.0f);
             }
             break;
         case IT_OpenEnd:
-            for(size_t i = 0; i < samples.size(); ++i) {
-                samples[i] = (dReal)genrand_int32()*(1.0f/4294967296.0f);
+            for(size_t i = 0; i < n; ++i) {
+                pout[i] = (dReal)pin[i]*(1.0f/4294967296.0f);
             }
             break;
         case IT_Closed:
-            for(size_t i = 0; i < samples.size(); ++i) {
-                samples[i] = (dReal)genrand_int32()*(1.0f/4294967295.0f);
+            for(size_t i = 0; i < n; ++i) {
+                pout[i] = (dReal)pin[i]*(1.0f/4294967295.0f);
             }
             break;
         default:
@@ -149,8 +159,8 @@ Mersenne twister sampling algorithm that is based on matrix linear recurrence ov
     int SampleSequence(std::vector<uint32_t>& samples, size_t num)
     {
         samples.resize(_dof*num);
-        for(size_t i = 0; i < samples.size(); ++i) {
-            samples[i] = genrand_int32();
+        if( samples.size() > 0 ) {
+            genrand_int32_block(&samples[0], samples.size());
         }
         return (int)num;
     }
@@ -210,30 +220,37 @@ private:
         mt[0] = 0x80000000UL;     /* MSB is 1; assuring non-zero initial array */
     }
 
-    /* generates a random number on [0,0xffffffff]-interval */
-    uint32_t genrand_int32(void)
+    /* generates N words at one time */
+    void next_state(void)
     {
         uint32_t y;
+        int kk;
         /* mag01[x] = x * MATRIX_A  for x=0,1 */
 
-        if (mti >= N) {     /* generate N words at one time */
-            int kk;
+        if (mti == N+1)     /* if init_genrand() has not been called, */
+            init_genrand(5489UL);     /* a default initial seed is used */
 
-            if (mti == N+1)                                                                                                                                                                                                                                                                                           /* if init_genrand() has not been called, */
-                init_genrand(5489UL);                                                                                                                                                                                                                                                                                                                                                                                                      /* a default initial seed is used */
+        for (kk=0; kk<N-M; kk++) {
+            y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
+            mt[kk] = mt[kk+M] ^ (y >> 1) ^ mag01[y & 0x1UL];
+        }
+        for (; kk<N-1; kk++) {
+            y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
+            mt[kk] = mt[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+        }
+        y = (mt[N-1]&UPPER_MASK)|(mt[0]&LOWER_MASK);
+        mt[N-1] = mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
 
-            for (kk=0; kk<N-M; kk++) {
-                y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
-                mt[kk] = mt[kk+M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-            }
-            for (; kk<N-1; kk++) {
-                y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
-                mt[kk] = mt[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-            }
-            y = (mt[N-1]&UPPER_MASK)|(mt[0]&LOWER_MASK);
-            mt[N-1] = mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+        mti = 0;
+    }
 
-            mti = 0;
+    /* generates a random number on [0,0xffffffff]-interval */
+    uint32_t genrand_int32(void)
+    {
+        uint32_t y;
+
+        if (mti >= N) {
+            next_state();
         }
 
         y = mt[mti++];
@@ -247,6 +264,30 @@ private:
         return y;
     }
 
+    /* fills out[0..n-1] with the same numbers that n consecutive calls to genrand_int32 would return.
+       The state is tempered a contiguous run at a time so that the loop has no branches and can be vectorized. */
+    void genrand_int32_block(uint32_t* out, size_t n)
+    {
+        while(n > 0) {
+            if (mti >= N) {
+                next_state();
+            }
+            size_t k = std::min(n, (size_t)(N-mti));
+            const uint32_t* pstate = &mt[mti];
+            for(size_t i = 0; i < k; ++i) {
+                uint32_t y = pstate[i];
+                y ^= (y >> 11);
+                y ^= (y << 7) & 0x9d2c5680UL;
+                y ^= (y << 15) & 0xefc60000UL;
+                y ^= (y >> 18);
+                out[i] = y;
+            }
+            mti += (int)k;
+            out += k;
+            n -= k;
+        }
+    }
+
     /* generates a random number on [0,0x7fffffff]-interval */
     long genrand_int31(void)
     {
@@ -291,6 +332,7 @@ private:
     int mti;     /* mti==N+1 means mt[N] is not initialized */
     uint32_t mag01[2];
     int _dof;
+    std::vector<uint32_t> _vtempsamples; ///< cache for converting bulk integer samples to reals
 };
 
 #endif
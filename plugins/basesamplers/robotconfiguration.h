@@ -77,30 +77,34 @@ If the robot active DOFs change, can use the 'TrackActiveSpace' command to autom
     int SampleSequence(std::vector<dReal>& samples, size_t num=1,IntervalType interval=IT_Closed)
     {
         _psampler->SampleSequence(samples,num,interval);
-        for (size_t inum = 0; inum < num*_lower.size(); inum += _lower.size()) {
-            for (size_t i = 0; i < _lower.size(); i++) {
-                if( _viscircular[i] || (int)i == _affinerotaxis ) {
-                    samples[inum+i] = -PI + 2*PI*samples[inum+i];
-                }
-                else if( _affinerot3d >= 0 && (int)i >= _affinerot3d && (int)i < _affinerot3d+3 ) {
-                    if( (int)i == _affinerot3d ) {
-                        Vector axisangle = axisAngleFromQuat(_SampleQuaternion());
-                        samples[inum+i+0] = axisangle[0];
-                        samples[inum+i+1] = axisangle[1];
-                        samples[inum+i+2] = axisangle[2];
-                    }
-                }
-                else if( _affinequat >= 0 && (int)i >= _affinequat && (int)i < _affinequat+3 ) {
-                    if( (int)i == _affinequat ) {
-                        Vector quat = _SampleQuaternion();
-                        samples[inum+i+0] = quat[0];
-                        samples[inum+i+1] = quat[1];
-                        samples[inum+i+2] = quat[2];
-                        samples[inum+i+3] = quat[3];
-                    }
+        const size_t dof = _lower.size();
+        if( dof == 0 || num == 0 ) {
+            return (int)num;
+        }
+        // map all the values with a single affine transform per dof, rotations are overwritten afterwards
+        const dReal* poffset = &_voffset[0];
+        const dReal* pscale = &_vscale[0];
+        dReal* psamples = &samples[0];
+        for (size_t inum = 0; inum < num*dof; inum += dof) {
+            for (size_t i = 0; i < dof; i++) {
+                psamples[inum+i] = poffset[i] + psamples[inum+i]*pscale[i];
+            }
+        }
+        if( _affinerot3d >= 0 || _affinequat >= 0 ) {
+            _SampleQuaternions(num, _vtempquats);
+            for (size_t isample = 0; isample < num; ++isample) {
+                const Vector& quat = _vtempquats[isample];
+                if( _affinerot3d >= 0 ) {
+                    Vector axisangle = axisAngleFromQuat(quat);
+                    samples[isample*dof+_affinerot3d+0] = axisangle[0];
+                    samples[isample*dof+_affinerot3d+1] = axisangle[1];
+                    samples[isample*dof+_affinerot3d+2] = axisangle[2];
                 }
                 else {
-                    samples[inum+i] = _lower[i] + samples[inum+i]*_range[i];
+                    samples[isample*dof+_affinequat+0] = quat[0];
+                    samples[isample*dof+_affinequat+1] = quat[1];
+                    samples[isample*dof+_affinequat+2] = quat[2];
+                    samples[isample*dof+_affinequat+3] = quat[3];
                 }
             }
         }
@@ -128,24 +132,27 @@ protected:
         return true;
     }
 
-    Vector _SampleQuaternion()
+    /// \brief samples num uniformly distributed unit quaternions by rejection sampling the 4D unit ball
+    ///
+    /// All the candidates are drawn from the underlying sampler with one bulk call per round.
+    void _SampleQuaternions(size_t num, std::vector<Vector>& vquats)
     {
-        _tempsamples.resize(4);
-        Vector v;
-        while(1) {
-            _psampler->SampleSequence(_tempsamples,4,IT_Closed);
-            v.x = 2*_tempsamples.at(0)-1;
-            v.y = 2*_tempsamples.at(0)-1;
-            v.z = 2*_tempsamples.at(0)-1;
-            v.w = 2*_tempsamples.at(0)-1;
-            dReal flen = v.lengthsqr4();
-            if( flen > 1 ) {
-                continue;
+        vquats.resize(0);
+        vquats.reserve(num);
+        const size_t dof = _lower.size();
+        while(vquats.size() < num) {
+            // about 31% of the candidates fall inside the ball
+            size_t numvalues = 16*(num-vquats.size());
+            _psampler->SampleSequence(_tempsamples,(numvalues+dof-1)/dof,IT_Closed);
+            for(size_t i = 0; i+4 <= _tempsamples.size() && vquats.size() < num; i += 4) {
+                Vector v(2*_tempsamples[i]-1, 2*_tempsamples[i+1]-1, 2*_tempsamples[i+2]-1, 2*_tempsamples[i+3]-1);
+                dReal flen = v.lengthsqr4();
+                if( flen > 1 || flen <= g_fEpsilon ) {
+                    continue;
+                }
+                vquats.push_back(v*(1.0f/RaveSqrt(flen)));
             }
-            flen = 1.0f/RaveSqrt(flen);
-            return v*(1.0f/RaveSqrt(flen));
         }
-        return Vector();
     }
 
     void _UpdateDOFs()
@@ -175,6 +182,19 @@ protected:
             _affinequat = _probot->GetActiveDOFIndices().size()+RaveGetIndexFromAffineDOF(_probot->GetAffineDOF(),DOF_RotationQuat);
         }
 
+        _voffset = _lower;
+        _vscale = _range;
+        for(size_t i = 0; i < _lower.size(); ++i) {
+            if( _viscircular[i] || (int)i == _affinerotaxis ) {
+                _voffset[i] = -PI;
+                _vscale[i] = 2*PI;
+            }
+            else if( (_affinerot3d >= 0 && (int)i >= _affinerot3d && (int)i < _affinerot3d+3) || (_affinequat >= 0 && (int)i >= _affinequat && (int)i < _affinequat+4) ) {
+                _voffset[i] = 0;
+                _vscale[i] = 1;
+            }
+        }
+
         if( _lower.size() > 0 ) {
             _psampler->SetSpaceDOF(_lower.size());
         }
@@ -183,8 +203,10 @@ protected:
     SpaceSamplerBasePtr _psampler;
     RobotBasePtr _probot;
     UserDataPtr _updatedofscallback;
-    std::vector<dReal> _lower, _upper, _range, _rangescaled;
+    std::vector<dReal> _lower, _upper, _range;
+    std::vector<dReal> _voffset, _vscale; ///< sample = offset + value*scale for every dof that is not a 3D rotation
     std::vector<dReal> _tempsamples;
+    std::vector<Vector> _vtempquats;
     std::vector<uint8_t> _viscircular;
     int _affinerotaxis, _affinerot3d, _affinequat;
 };
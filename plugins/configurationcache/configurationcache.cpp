@@ -20,6 +20,7 @@ namespace configurationcache
 {
 CollisionCheckerBasePtr CreateCacheCollisionChecker(EnvironmentBasePtr penv, std::istream& sinput);
 SpaceSamplerBasePtr CreateConfigurationJitterer(EnvironmentBasePtr penv, std::istream& sinput);
+ModuleBasePtr CreateDistanceFieldModule(EnvironmentBasePtr penv, std::istream& sinput);
 }
 
 InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string& interfacename, std::istream& sinput, EnvironmentBasePtr penv)
@@ -35,6 +36,11 @@ InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string&
             return configurationcache::CreateConfigurationJitterer(penv,sinput);
         }
         break;
+    case PT_Module:
+        if( interfacename == "distancefield" ) {
+            return configurationcache::CreateDistanceFieldModule(penv,sinput);
+        }
+        break;
     default:
         break;
     }
@@ -45,6 +51,7 @@ void GetPluginAttributesValidated(PLUGININFO& info)
 {
     info.interfacenames[PT_CollisionChecker].push_back("CacheChecker");
     info.interfacenames[PT_SpaceSampler].push_back("ConfigurationJitterer");
+    info.interfacenames[PT_Module].push_back("DistanceField");
 }
 
 OPENRAVE_PLUGIN_API void DestroyPlugin()
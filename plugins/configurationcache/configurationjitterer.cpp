@@ -24,6 +24,7 @@
 #endif
 
 #include "configurationcachetree.h"
+#include "distancefield.h"
 
 namespace configurationcache {
 
@@ -82,6 +83,11 @@ By default will sample the robot's active DOFs. Parameters part of the interface
     bias_dir is the workspace direction to bias the sampling in.\n\
     nullsampleprob, nullbiassampleprob, and deltasampleprob are in [0,1]\n\
  //");
+        RegisterCommand("SetDistanceField",boost::bind(&ConfigurationJitterer::SetDistanceFieldCommand,this,_1,_2),
+                        "Before sampling randomly, pushes the robot links away from the static bodies along the gradient of the DistanceField module of the environment::\n\n\
+  numsteps [clearance] [sphereresolution]\n\n\
+numsteps is the number of gradient samples to try, 0 disables them. Links are pushed until their sphere approximation is clearance away from the obstacles (default is 0.01). \
+sphereresolution is the size of the link spheres, by default it is twice the field resolution.");
 
         bool bUseCache = false;
         std::string robotname, samplername = "MT19937";
@@ -143,11 +149,16 @@ By default will sample the robot's active DOFs. Parameters part of the interface
         _linkdistthresh=0.02;
         _linkdistthresh2 = _linkdistthresh*_linkdistthresh;
         _neighdistthresh = 1;
+        _nGradientSteps = 0;
+        _fGradientClearance = 0.01;
+        _fSphereResolution = 0;
 
         _UpdateLimits();
         _limitscallback = _probot->RegisterChangeCallback(RobotBase::Prop_JointLimits, boost::bind(&ConfigurationJitterer::_UpdateLimits,this));
         _UpdateGrabbed();
         _grabbedcallback = _probot->RegisterChangeCallback(RobotBase::Prop_RobotGrabbed, boost::bind(&ConfigurationJitterer::_UpdateGrabbed,this));
+        _fLinkSpheresResolution = 0;
+        _linkgeometrycallback = _probot->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkOctree, boost::bind(&ConfigurationJitterer::_ResetLinkSpheres,this));
 
         if( !!_cache ) {
             _SetCacheMaxDistance();
@@ -283,6 +294,36 @@ By default will sample the robot's active DOFs. Parameters part of the interface
         return true;
     }
 
+    bool SetDistanceFieldCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int numsteps = 0;
+        dReal clearance = 0.01, sphereresolution = 0;
+        sinput >> numsteps >> clearance >> sphereresolution;
+        if( numsteps <= 0 ) {
+            _distancefieldmodule.reset();
+            _nGradientSteps = 0;
+            return true;
+        }
+        std::list<ModuleBasePtr> listmodules;
+        GetEnv()->GetModules(listmodules);
+        DistanceFieldModulePtr pdistancefieldmodule;
+        FOREACH(itmodule, listmodules) {
+            pdistancefieldmodule = boost::dynamic_pointer_cast<DistanceFieldModule>(*itmodule);
+            if( !!pdistancefieldmodule ) {
+                break;
+            }
+        }
+        if( !pdistancefieldmodule ) {
+            RAVELOG_WARN("no DistanceField module is loaded in the environment\n");
+            return false;
+        }
+        _distancefieldmodule = pdistancefieldmodule;
+        _nGradientSteps = numsteps;
+        _fGradientClearance = clearance;
+        _fSphereResolution = sphereresolution;
+        return true;
+    }
+
     virtual int SampleSequence(std::vector<dReal>& samples, size_t num=1,IntervalType interval=IT_Closed)
     {
         samples.resize(0);
@@ -444,18 +485,31 @@ By default will sample the robot's active DOFs. Parameters part of the interface
             fBias = RaveSqrt(fBias);
         }
 
+        int nGradientSteps = 0;
+        if( !!_distancefieldmodule && !!_distancefieldmodule->GetDistanceField() && !_distancefieldmodule->GetDistanceField()->IsEmpty() ) {
+            _InitLinkSpheres(*_distancefieldmodule->GetDistanceField());
+            _vgradientdof = _curdof;
+            nGradientSteps = _nGradientSteps;
+        }
+
         uint64_t starttime = utils::GetNanoPerformanceTime();
         for(int iter = 0; iter < _maxiterations; ++iter) {
             if( (iter%10) == 0 ) { // not sure what a good rate is...
                 _CallStatusFunctions(iter);
             }
-            if( busebiasing && iter < (int)rayincs.size() ) {
+            bool bGradientSample = iter < nGradientSteps && _SampleGradient(*_distancefieldmodule->GetDistanceField(), vnewdof);
+            if( !bGradientSample && iter < nGradientSteps ) {
+                // the distance field does not see any obstacles close to the links anymore, so continue with regular sampling
+                nGradientSteps = iter;
+            }
+            // gradient samples already set vnewdof one step further along the clearance gradient
+            if( !bGradientSample && busebiasing && iter-nGradientSteps < (int)rayincs.size() ) {
                 // start by checking samples directly above the current configuration
                 for (size_t j = 0; j < vnewdof.size(); ++j) {
-                    vnewdof[j] = _curdof[j] + (rayincs[iter] * _vbiasdofdirection.at(j));
+                    vnewdof[j] = _curdof[j] + (rayincs[iter-nGradientSteps] * _vbiasdofdirection.at(j));
                 }
             }
-            else {
+            else if( !bGradientSample ) {
                 // ramp of the jitter as iterations increase
                 dReal jitter = _maxjitter;
                 if( iter < nMaxIterRadiusThresh ) {
@@ -809,6 +863,72 @@ protected:
         }
     }
 
+    /// \brief approximates the robot links with spheres for the distance field queries. Grabbed bodies are not pushed.
+    ///
+    /// The spheres are only recomputed when the resolution changes or the link geometry changed since the last call.
+    void _InitLinkSpheres(const DistanceField& distancefield)
+    {
+        dReal sphereresolution = _fSphereResolution > 0 ? _fSphereResolution : 2*distancefield.GetResolution();
+        if( _fLinkSpheresResolution == sphereresolution && _vLinkSpheres.size() == _probot->GetLinks().size() ) {
+            return;
+        }
+        _vLinkSpheres.resize(_probot->GetLinks().size());
+        for(size_t i = 0; i < _vLinkSpheres.size(); ++i) {
+            ComputeLinkSpheres(_probot->GetLinks()[i], sphereresolution, _vLinkSpheres[i]);
+        }
+        _fLinkSpheresResolution = sphereresolution;
+    }
+
+    void _ResetLinkSpheres()
+    {
+        _fLinkSpheresResolution = 0;
+    }
+
+    /// \brief moves _vgradientdof so that the links closer than _fGradientClearance to the obstacles move away from them
+    ///
+    /// Every step moves a dof at most a quarter of the max jitter, and never further than the max jitter from the original configuration.
+    /// \return false if no link is closer than _fGradientClearance
+    bool _SampleGradient(const DistanceField& distancefield, std::vector<dReal>& vnewdof)
+    {
+        _probot->SetActiveDOFValues(_vgradientdof);
+        _vgradientdelta.resize(_vgradientdof.size());
+        std::fill(_vgradientdelta.begin(), _vgradientdelta.end(), dReal(0));
+        const size_t dof = _vgradientdelta.size();
+        bool bPush = false;
+        Vector vgradient, vpoint;
+        for(size_t ilink = 0; ilink < _vLinkSpheres.size(); ++ilink) {
+            KinBody::LinkPtr plink = _probot->GetLinks()[ilink];
+            dReal fclearance = DistanceFieldModule::ComputeClearance(distancefield, plink->GetTransform(), _vLinkSpheres[ilink], vgradient, vpoint);
+            if( fclearance >= _fGradientClearance ) {
+                continue;
+            }
+            // transpose of the jacobian maps the push on the closest sphere to the dofs
+            Vector vpush = vgradient*(_fGradientClearance - fclearance);
+            _probot->CalculateActiveJacobian(plink->GetIndex(), vpoint, _vgradientjacobian);
+            for(size_t j = 0; j < dof; ++j) {
+                _vgradientdelta[j] += _vgradientjacobian[j]*vpush.x + _vgradientjacobian[dof+j]*vpush.y + _vgradientjacobian[2*dof+j]*vpush.z;
+            }
+            bPush = true;
+        }
+        if( !bPush ) {
+            return false;
+        }
+        dReal fmaxdelta = 0;
+        for(size_t j = 0; j < dof; ++j) {
+            fmaxdelta = max(fmaxdelta, RaveFabs(_vgradientdelta[j]));
+        }
+        if( fmaxdelta <= g_fEpsilon ) {
+            return false;
+        }
+        dReal fscale = min(dReal(1), 0.25*_maxjitter/fmaxdelta);
+        for(size_t j = 0; j < dof; ++j) {
+            dReal f = _vgradientdof[j] + _vgradientdelta[j]*fscale;
+            _vgradientdof[j] = max(_curdof[j]-_maxjitter, min(_curdof[j]+_maxjitter, f));
+        }
+        vnewdof = _vgradientdof;
+        return true;
+    }
+
     void _UpdateGrabbed()
     {
         vector<KinBodyPtr> vgrabbedbodies;
@@ -869,7 +989,7 @@ protected:
     boost::function<bool (std::vector<dReal>&,const std::vector<dReal>&, int)> _neighstatefn; ///< if initialized, then use this function to get nearest neighbor
     ///< Advantage of using neightstatefn is that user constraints can be met like maintaining a certain orientation of the gripper.
 
-    UserDataPtr _limitscallback, _grabbedcallback; ///< limits,grabbed change handles
+    UserDataPtr _limitscallback, _grabbedcallback, _linkgeometrycallback; ///< limits,grabbed,link geometry change handles
 
     /// \return Return 0 if jitter failed and constraints are not satisfied. -1 if constraints are originally satisfied. 1 if jitter succeeded, configuration is different, and constraints are satisfied.
 
@@ -898,6 +1018,15 @@ protected:
 
     ManipDirectionThreshPtr _pConstraintToolDirection;
 
+    // for following the gradient of the distance field
+    DistanceFieldModulePtr _distancefieldmodule; ///< if set, use its distance field before random sampling
+    int _nGradientSteps; ///< max number of gradient samples
+    dReal _fGradientClearance; ///< push the links until they are this far from the obstacles
+    dReal _fSphereResolution; ///< resolution of the link spheres, if 0 twice the field resolution
+    std::vector< std::vector<Vector> > _vLinkSpheres; ///< sphere approximation of every robot link, see ComputeLinkSpheres
+    dReal _fLinkSpheresResolution; ///< resolution _vLinkSpheres were computed with, 0 if they have to be recomputed
+    std::vector<dReal> _vgradientdof, _vgradientdelta, _vgradientjacobian;
+
     bool _bSetResultOnRobot; ///< if true, will set the final result on the robot DOF values
     bool _busebiasing; ///< if true will bias the end effector along a certain direction using the jacobian and nullspace.
 };
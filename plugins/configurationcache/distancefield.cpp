@@ -0,0 +1,532 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "distancefield.h"
+
+#include <boost/thread.hpp>
+#include <cstdio>
+#include <deque>
+
+namespace configurationcache {
+
+static const int s_nDistanceFieldFileVersion = 1;
+static const uint64_t s_nMaxDistanceFieldVoxels = 1<<27;
+static const float s_fDistanceTransformInf = 1e20f; ///< squared distance of voxels that have not reached anything yet
+
+DistanceField::DistanceField() : _resolution(0), _fiResolution(0)
+{
+    _dims[0] = _dims[1] = _dims[2] = 0;
+}
+
+void DistanceField::Build(const TriMesh& trimesh, const AABB& ab, dReal resolution, int numthreads)
+{
+    OPENRAVE_ASSERT_OP(resolution,>,0);
+    _resolution = resolution;
+    _fiResolution = 1/resolution;
+    _vorigin = ab.pos - ab.extents;
+    _vdistances.resize(0);
+    uint64_t numvoxels = 1;
+    for(int j = 0; j < 3; ++j) {
+        _dims[j] = max(2, (int)ceil(2*ab.extents[j]*_fiResolution)+1);
+        numvoxels *= _dims[j];
+    }
+    OPENRAVE_ASSERT_FORMAT(numvoxels <= s_nMaxDistanceFieldVoxels, "distance field of %dx%dx%d voxels is too big, increase the resolution", _dims[0]%_dims[1]%_dims[2], ORE_InvalidArguments);
+
+    // mark the voxels that the triangles pass through by sampling every triangle at half the resolution
+    std::vector<uint8_t> vstate(numvoxels, 0); // 0 is enclosed, 1 is on a surface, 2 is free
+    bool bOccupied = false;
+    for(size_t itri = 0; itri+2 < trimesh.indices.size(); itri += 3) {
+        const Vector& v0 = trimesh.vertices.at(trimesh.indices[itri]);
+        Vector e1 = trimesh.vertices.at(trimesh.indices[itri+1]) - v0, e2 = trimesh.vertices.at(trimesh.indices[itri+2]) - v0;
+        dReal fmaxedge = RaveSqrt(max(max(e1.lengthsqr3(), e2.lengthsqr3()), (e2-e1).lengthsqr3()));
+        int numsteps = max(1, (int)ceil(2*fmaxedge*_fiResolution));
+        dReal fistep = dReal(1)/numsteps;
+        for(int a = 0; a <= numsteps; ++a) {
+            for(int b = 0; a+b <= numsteps; ++b) {
+                Vector p = v0 + e1*(a*fistep) + e2*(b*fistep) - _vorigin;
+                int ix = (int)floor(p.x*_fiResolution+0.5), iy = (int)floor(p.y*_fiResolution+0.5), iz = (int)floor(p.z*_fiResolution+0.5);
+                if( ix >= 0 && ix < _dims[0] && iy >= 0 && iy < _dims[1] && iz >= 0 && iz < _dims[2] ) {
+                    vstate[_GetIndex(ix,iy,iz)] = 1;
+                    bOccupied = true;
+                }
+            }
+        }
+    }
+    if( !bOccupied ) {
+        return;
+    }
+
+    // flood fill the free space from the grid boundary, whatever is not reached is enclosed by the surfaces
+    const int strides[3] = {_dims[1]*_dims[2], _dims[2], 1};
+    std::deque<int> queue;
+    for(int ix = 0; ix < _dims[0]; ++ix) {
+        for(int iy = 0; iy < _dims[1]; ++iy) {
+            for(int iz = 0; iz < _dims[2]; ++iz) {
+                if( ix == 0 || iy == 0 || iz == 0 || ix == _dims[0]-1 || iy == _dims[1]-1 || iz == _dims[2]-1 ) {
+                    int index = _GetIndex(ix,iy,iz);
+                    if( vstate[index] == 0 ) {
+                        vstate[index] = 2;
+                        queue.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+    while(queue.size() > 0) {
+        int index = queue.front();
+        queue.pop_front();
+        int vindices[3] = {index/strides[0], (index/strides[1])%_dims[1], index%_dims[2]};
+        for(int axis = 0; axis < 3; ++axis) {
+            if( vindices[axis] > 0 && vstate[index-strides[axis]] == 0 ) {
+                vstate[index-strides[axis]] = 2;
+                queue.push_back(index-strides[axis]);
+            }
+            if( vindices[axis]+1 < _dims[axis] && vstate[index+strides[axis]] == 0 ) {
+                vstate[index+strides[axis]] = 2;
+                queue.push_back(index+strides[axis]);
+            }
+        }
+    }
+
+    // squared voxel distance of the free voxels to the closest surface or enclosed voxel, and of the enclosed voxels to the closest surface voxel
+    std::vector<float> vfree(numvoxels), venclosed(numvoxels);
+    for(size_t i = 0; i < vstate.size(); ++i) {
+        vfree[i] = vstate[i] == 2 ? s_fDistanceTransformInf : 0;
+        venclosed[i] = vstate[i] == 0 ? s_fDistanceTransformInf : 0;
+    }
+    numthreads = max(1, numthreads);
+    for(int axis = 0; axis < 3; ++axis) {
+        int numlines = (int)(numvoxels/_dims[axis]);
+        if( numthreads == 1 ) {
+            _TransformLines(vfree, axis, 0, numlines);
+            _TransformLines(venclosed, axis, 0, numlines);
+        }
+        else {
+            boost::thread_group threads;
+            int linesperthread = (numlines+numthreads-1)/numthreads;
+            for(int linestart = 0; linestart < numlines; linestart += linesperthread) {
+                int lineend = min(numlines, linestart+linesperthread);
+                threads.create_thread(boost::bind(&DistanceField::_TransformLines, this, boost::ref(vfree), axis, linestart, lineend));
+                threads.create_thread(boost::bind(&DistanceField::_TransformLines, this, boost::ref(venclosed), axis, linestart, lineend));
+            }
+            threads.join_all();
+        }
+    }
+
+    // the surface voxels have zero distance
+    _vdistances.resize(numvoxels);
+    for(size_t i = 0; i < vstate.size(); ++i) {
+        _vdistances[i] = (RaveSqrt(dReal(vfree[i])) - RaveSqrt(dReal(venclosed[i])))*_resolution;
+    }
+}
+
+void DistanceField::_TransformLines(std::vector<float>& vgrid, int axis, int linestart, int lineend) const
+{
+    // lower envelope of parabolas, see Felzenszwalb and Huttenlocher "Distance Transforms of Sampled Functions"
+    const int strides[3] = {_dims[1]*_dims[2], _dims[2], 1};
+    const int b = (axis+1)%3, c = (axis+2)%3;
+    const int n = _dims[axis], stride = strides[axis];
+    std::vector<double> f(n), z(n+1);
+    std::vector<int> v(n);
+    for(int line = linestart; line < lineend; ++line) {
+        int start = (line/_dims[c])*strides[b] + (line%_dims[c])*strides[c];
+        bool bFinite = false;
+        for(int q = 0; q < n; ++q) {
+            f[q] = vgrid[start+q*stride];
+            bFinite |= f[q] < s_fDistanceTransformInf;
+        }
+        if( !bFinite ) {
+            continue;
+        }
+        int k = 0;
+        v[0] = 0;
+        z[0] = -std::numeric_limits<double>::infinity();
+        z[1] = std::numeric_limits<double>::infinity();
+        for(int q = 1; q < n; ++q) {
+            double s = ((f[q]+double(q)*q) - (f[v[k]]+double(v[k])*v[k]))/(2*(q-v[k]));
+            while( s <= z[k] ) {
+                --k;
+                s = ((f[q]+double(q)*q) - (f[v[k]]+double(v[k])*v[k]))/(2*(q-v[k]));
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k+1] = std::numeric_limits<double>::infinity();
+        }
+        k = 0;
+        for(int q = 0; q < n; ++q) {
+            while( z[k+1] < q ) {
+                ++k;
+            }
+            vgrid[start+q*stride] = (float)min(double(s_fDistanceTransformInf), double(q-v[k])*(q-v[k]) + f[v[k]]);
+        }
+    }
+}
+
+bool DistanceField::Save(const std::string& filename) const
+{
+    FILE* pfile = fopen(filename.c_str(), "wb");
+    if( !pfile ) {
+        return false;
+    }
+    double vheader[4] = {_vorigin.x, _vorigin.y, _vorigin.z, _resolution};
+    uint64_t numvoxels = _vdistances.size();
+    bool bSuccess = fwrite(&s_nDistanceFieldFileVersion, sizeof(s_nDistanceFieldFileVersion), 1, pfile) == 1;
+    bSuccess &= fwrite(_dims, sizeof(_dims), 1, pfile) == 1;
+    bSuccess &= fwrite(vheader, sizeof(vheader), 1, pfile) == 1;
+    bSuccess &= fwrite(&numvoxels, sizeof(numvoxels), 1, pfile) == 1;
+    if( numvoxels > 0 ) {
+        bSuccess &= fwrite(&_vdistances[0], sizeof(_vdistances[0])*numvoxels, 1, pfile) == 1;
+    }
+    fclose(pfile);
+    return bSuccess;
+}
+
+bool DistanceField::Load(const std::string& filename)
+{
+    FILE* pfile = fopen(filename.c_str(), "rb");
+    if( !pfile ) {
+        return false;
+    }
+    int version = 0, dims[3] = {0,0,0};
+    double vheader[4] = {0,0,0,0};
+    uint64_t numvoxels = 0;
+    bool bSuccess = fread(&version, sizeof(version), 1, pfile) == 1 && version == s_nDistanceFieldFileVersion;
+    bSuccess = bSuccess && fread(dims, sizeof(dims), 1, pfile) == 1 && fread(vheader, sizeof(vheader), 1, pfile) == 1 && fread(&numvoxels, sizeof(numvoxels), 1, pfile) == 1;
+    bSuccess = bSuccess && vheader[3] > 0 && (numvoxels == 0 || numvoxels == uint64_t(dims[0])*dims[1]*dims[2]) && numvoxels <= s_nMaxDistanceFieldVoxels;
+    std::vector<float> vdistances;
+    if( bSuccess && numvoxels > 0 ) {
+        vdistances.resize(numvoxels);
+        bSuccess = fread(&vdistances[0], sizeof(vdistances[0])*numvoxels, 1, pfile) == 1;
+    }
+    fclose(pfile);
+    if( !bSuccess ) {
+        return false;
+    }
+    std::copy(dims, dims+3, _dims);
+    _vorigin = Vector(vheader[0], vheader[1], vheader[2]);
+    _resolution = vheader[3];
+    _fiResolution = 1/_resolution;
+    _vdistances.swap(vdistances);
+    return true;
+}
+
+AABB DistanceField::GetBounds() const
+{
+    Vector vextents(0.5*_resolution*(_dims[0]-1), 0.5*_resolution*(_dims[1]-1), 0.5*_resolution*(_dims[2]-1));
+    return AABB(_vorigin+vextents, vextents);
+}
+
+void DistanceField::_GetCell(const Vector& point, int cell[3], dReal weights[3], Vector& voutside) const
+{
+    voutside = Vector();
+    for(int j = 0; j < 3; ++j) {
+        dReal f = (point[j]-_vorigin[j])*_fiResolution;
+        if( f < 0 ) {
+            voutside[j] = point[j] - _vorigin[j];
+            f = 0;
+        }
+        else if( f > _dims[j]-1 ) {
+            voutside[j] = point[j] - (_vorigin[j] + (_dims[j]-1)*_resolution);
+            f = _dims[j]-1;
+        }
+        cell[j] = min((int)f, _dims[j]-2);
+        weights[j] = f - cell[j];
+    }
+}
+
+dReal DistanceField::GetDistance(const Vector& point) const
+{
+    Vector vgradient;
+    return GetDistanceAndGradient(point, vgradient);
+}
+
+dReal DistanceField::GetDistanceAndGradient(const Vector& point, Vector& vgradient) const
+{
+    vgradient = Vector();
+    if( _vdistances.size() == 0 ) {
+        return std::numeric_limits<dReal>::infinity();
+    }
+    int cell[3];
+    dReal w[3];
+    Vector voutside;
+    _GetCell(point, cell, w, voutside);
+    const int index = _GetIndex(cell[0], cell[1], cell[2]);
+    const int dx = _dims[1]*_dims[2], dy = _dims[2];
+    dReal c000 = _vdistances[index], c001 = _vdistances[index+1], c010 = _vdistances[index+dy], c011 = _vdistances[index+dy+1];
+    dReal c100 = _vdistances[index+dx], c101 = _vdistances[index+dx+1], c110 = _vdistances[index+dx+dy], c111 = _vdistances[index+dx+dy+1];
+    dReal c00 = c000 + (c001-c000)*w[2], c01 = c010 + (c011-c010)*w[2], c10 = c100 + (c101-c100)*w[2], c11 = c110 + (c111-c110)*w[2];
+    dReal c0 = c00 + (c01-c00)*w[1], c1 = c10 + (c11-c10)*w[1];
+    dReal fdist = c0 + (c1-c0)*w[0];
+
+    dReal foutside = voutside.lengthsqr3();
+    if( foutside > 0 ) {
+        foutside = RaveSqrt(foutside);
+        vgradient = voutside*(1/foutside);
+        return fdist + foutside;
+    }
+    vgradient.x = (c1-c0)*_fiResolution;
+    vgradient.y = ((c01-c00)*(1-w[0]) + (c11-c10)*w[0])*_fiResolution;
+    dReal d0 = (c001-c000)*(1-w[1]) + (c011-c010)*w[1], d1 = (c101-c100)*(1-w[1]) + (c111-c110)*w[1];
+    vgradient.z = (d0*(1-w[0]) + d1*w[0])*_fiResolution;
+    return fdist;
+}
+
+void ComputeLinkSpheres(KinBody::LinkConstPtr plink, dReal resolution, std::vector<Vector>& vspheres)
+{
+    OPENRAVE_ASSERT_OP(resolution,>,0);
+    vspheres.resize(0);
+    const TriMesh& trimesh = plink->GetCollisionData();
+    const dReal fstep = 0.25*resolution, fiResolution = 1/resolution;
+    // sample the surface and group the samples by cell
+    std::vector< std::pair<uint64_t, Vector> > vsamples;
+    for(size_t itri = 0; itri+2 < trimesh.indices.size(); itri += 3) {
+        const Vector& v0 = trimesh.vertices.at(trimesh.indices[itri]);
+        Vector e1 = trimesh.vertices.at(trimesh.indices[itri+1]) - v0, e2 = trimesh.vertices.at(trimesh.indices[itri+2]) - v0;
+        dReal fmaxedge = RaveSqrt(max(max(e1.lengthsqr3(), e2.lengthsqr3()), (e2-e1).lengthsqr3()));
+        int numsteps = max(1, (int)ceil(fmaxedge/fstep));
+        dReal fistep = dReal(1)/numsteps;
+        for(int a = 0; a <= numsteps; ++a) {
+            for(int b = 0; a+b <= numsteps; ++b) {
+                Vector p = v0 + e1*(a*fistep) + e2*(b*fistep);
+                uint64_t key = 0;
+                for(int j = 0; j < 3; ++j) {
+                    key = (key<<21) | (uint64_t)(((int64_t)floor(p[j]*fiResolution) + (1<<20)) & ((1<<21)-1));
+                }
+                vsamples.push_back(std::make_pair(key, p));
+            }
+        }
+    }
+    std::sort(vsamples.begin(), vsamples.end(), boost::bind(&std::pair<uint64_t, Vector>::first, _1) < boost::bind(&std::pair<uint64_t, Vector>::first, _2));
+    // one sphere around the samples of every cell, inflated by the largest distance of the surface to the samples
+    const dReal fsamplegap = fstep*0.71;
+    size_t istart = 0;
+    while(istart < vsamples.size()) {
+        size_t iend = istart+1;
+        Vector vcenter = vsamples[istart].second;
+        while(iend < vsamples.size() && vsamples[iend].first == vsamples[istart].first) {
+            vcenter += vsamples[iend].second;
+            ++iend;
+        }
+        vcenter *= dReal(1)/(iend-istart);
+        dReal fradius2 = 0;
+        for(size_t i = istart; i < iend; ++i) {
+            fradius2 = max(fradius2, (vsamples[i].second-vcenter).lengthsqr3());
+        }
+        vcenter.w = RaveSqrt(fradius2) + fsamplegap;
+        vspheres.push_back(vcenter);
+        istart = iend;
+    }
+}
+
+DistanceFieldModule::DistanceFieldModule(EnvironmentBasePtr penv, std::istream& sinput) : ModuleBase(penv)
+{
+    __description = ":Interface Author: Rosen Diankov\n\n\
+Voxelizes the static bodies of the environment into a signed distance field so that the clearance of points and links can be queried in constant time. \
+The field is saved to the database under the hash of the geometry and poses of the bodies, so it is only computed once for the same scene. \
+It is not updated automatically, **Build** has to be called again when the static bodies change.";
+    RegisterCommand("Build",boost::bind(&DistanceFieldModule::_BuildCommand,this,_1,_2),
+                    "Builds the field unless the static bodies did not change::\n\n  resolution [margin] [numthreads]\n\n\
+margin is the distance computed around the bodies (default is 0.1). If numthreads is 0, uses the number of processors.");
+    RegisterCommand("SetBodies",boost::bind(&DistanceFieldModule::_SetBodiesCommand,this,_1,_2),
+                    "Sets the names of the static bodies. Without names, all enabled bodies that are not robots or grabbed by robots are used.");
+    RegisterCommand("GetDistance",boost::bind(&DistanceFieldModule::_GetDistanceCommand,this,_1,_2),
+                    "Returns the signed distance and its gradient at the points::\n\n  x1 y1 z1 x2 y2 z2 ...\n\nReturns one line of 'distance gx gy gz' for every point.");
+    RegisterCommand("GetLinkClearances",boost::bind(&DistanceFieldModule::_GetLinkClearancesCommand,this,_1,_2),
+                    "Returns the clearance of every link of a body approximated by a set of spheres::\n\n  bodyname [sphereresolution]\n\n\
+Returns one line of 'clearance gx gy gz' for every link. sphereresolution defaults to twice the field resolution.");
+}
+
+void DistanceFieldModule::Build(dReal resolution, dReal margin, int numthreads)
+{
+    OPENRAVE_ASSERT_OP(resolution,>,0);
+    EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+    std::vector<KinBodyPtr> vbodies;
+    _GetStaticBodies(vbodies);
+    std::string hash = _ComputeHash(vbodies, resolution, margin);
+    if( !!_distancefield && hash == _hash ) {
+        return;
+    }
+
+    DistanceFieldPtr distancefield(new DistanceField());
+    std::string filename = RaveFindDatabaseFile(std::string("distancefield.")+hash, true);
+    if( filename.size() > 0 && distancefield->Load(filename) ) {
+        RAVELOG_DEBUG_FORMAT("loaded distance field from %s", filename);
+    }
+    else {
+        TriMesh trimesh;
+        AABB ab;
+        bool bInitAABB = false;
+        FOREACH(itbody, vbodies) {
+            GetEnv()->Triangulate(trimesh, *itbody);
+            AABB abbody = (*itbody)->ComputeAABB();
+            if( !bInitAABB ) {
+                ab = abbody;
+                bInitAABB = true;
+            }
+            else {
+                Vector vmin = ab.pos - ab.extents, vmax = ab.pos + ab.extents;
+                for(int j = 0; j < 3; ++j) {
+                    vmin[j] = min(vmin[j], abbody.pos[j]-abbody.extents[j]);
+                    vmax[j] = max(vmax[j], abbody.pos[j]+abbody.extents[j]);
+                }
+                ab.pos = 0.5*(vmin+vmax);
+                ab.extents = 0.5*(vmax-vmin);
+            }
+        }
+        ab.extents += Vector(margin, margin, margin);
+        if( numthreads <= 0 ) {
+            numthreads = max(1, (int)boost::thread::hardware_concurrency());
+        }
+        uint64_t starttime = utils::GetMicroTime();
+        distancefield->Build(trimesh, ab, resolution, numthreads);
+        RAVELOG_DEBUG_FORMAT("built distance field of %d bodies with %d triangles in %fs", vbodies.size()%(trimesh.indices.size()/3)%(1e-6*(utils::GetMicroTime()-starttime)));
+        filename = RaveFindDatabaseFile(std::string("distancefield.")+hash, false);
+        if( filename.size() > 0 && !distancefield->Save(filename) ) {
+            RAVELOG_WARN_FORMAT("failed to save distance field to %s", filename);
+        }
+    }
+    _distancefield = distancefield;
+    _hash = hash;
+}
+
+dReal DistanceFieldModule::ComputeClearance(const DistanceField& field, const Transform& tlink, const std::vector<Vector>& vspheres, Vector& vgradient, Vector& vpoint)
+{
+    dReal fclearance = std::numeric_limits<dReal>::infinity();
+    Vector vspheregradient;
+    FOREACHC(itsphere, vspheres) {
+        Vector vcenter = tlink*(*itsphere);
+        dReal f = field.GetDistanceAndGradient(vcenter, vspheregradient) - itsphere->w;
+        if( f < fclearance ) {
+            fclearance = f;
+            vgradient = vspheregradient;
+            vpoint = vcenter;
+        }
+    }
+    return fclearance;
+}
+
+bool DistanceFieldModule::_BuildCommand(std::ostream& sout, std::istream& sinput)
+{
+    dReal resolution = 0, margin = 0.1;
+    int numthreads = 0;
+    sinput >> resolution;
+    if( !sinput || resolution <= 0 ) {
+        return false;
+    }
+    sinput >> margin >> numthreads;
+    Build(resolution, margin, numthreads);
+    return true;
+}
+
+bool DistanceFieldModule::_SetBodiesCommand(std::ostream& sout, std::istream& sinput)
+{
+    _vbodynames.resize(0);
+    std::string name;
+    while(sinput >> name) {
+        _vbodynames.push_back(name);
+    }
+    return true;
+}
+
+bool DistanceFieldModule::_GetDistanceCommand(std::ostream& sout, std::istream& sinput)
+{
+    if( !_distancefield ) {
+        return false;
+    }
+    sout << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+    Vector vpoint, vgradient;
+    while(sinput >> vpoint.x >> vpoint.y >> vpoint.z) {
+        dReal fdist = _distancefield->GetDistanceAndGradient(vpoint, vgradient);
+        sout << fdist << " " << vgradient.x << " " << vgradient.y << " " << vgradient.z << std::endl;
+    }
+    return true;
+}
+
+bool DistanceFieldModule::_GetLinkClearancesCommand(std::ostream& sout, std::istream& sinput)
+{
+    if( !_distancefield ) {
+        return false;
+    }
+    std::string bodyname;
+    dReal sphereresolution = 2*_distancefield->GetResolution();
+    sinput >> bodyname >> sphereresolution;
+    KinBodyPtr pbody = GetEnv()->GetKinBody(bodyname);
+    if( !pbody || sphereresolution <= 0 ) {
+        return false;
+    }
+    sout << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+    std::vector<Vector> vspheres;
+    Vector vgradient, vpoint;
+    FOREACHC(itlink, pbody->GetLinks()) {
+        ComputeLinkSpheres(*itlink, sphereresolution, vspheres);
+        dReal fclearance = ComputeClearance(*_distancefield, (*itlink)->GetTransform(), vspheres, vgradient, vpoint);
+        sout << fclearance << " " << vgradient.x << " " << vgradient.y << " " << vgradient.z << std::endl;
+    }
+    return true;
+}
+
+void DistanceFieldModule::_GetStaticBodies(std::vector<KinBodyPtr>& vbodies)
+{
+    vbodies.resize(0);
+    if( _vbodynames.size() > 0 ) {
+        FOREACHC(itname, _vbodynames) {
+            KinBodyPtr pbody = GetEnv()->GetKinBody(*itname);
+            if( !pbody ) {
+                RAVELOG_WARN_FORMAT("distance field body %s does not exist", *itname);
+                continue;
+            }
+            vbodies.push_back(pbody);
+        }
+        return;
+    }
+    std::vector<KinBodyPtr> vallbodies, vgrabbed;
+    std::set<KinBodyPtr> setgrabbed;
+    GetEnv()->GetBodies(vallbodies);
+    FOREACHC(itbody, vallbodies) {
+        if( (*itbody)->IsRobot() ) {
+            RaveInterfaceCast<RobotBase>(*itbody)->GetGrabbed(vgrabbed);
+            setgrabbed.insert(vgrabbed.begin(), vgrabbed.end());
+        }
+    }
+    FOREACHC(itbody, vallbodies) {
+        if( !(*itbody)->IsRobot() && (*itbody)->IsEnabled() && setgrabbed.find(*itbody) == setgrabbed.end() ) {
+            vbodies.push_back(*itbody);
+        }
+    }
+}
+
+std::string DistanceFieldModule::_ComputeHash(const std::vector<KinBodyPtr>& vbodies, dReal resolution, dReal margin) const
+{
+    std::vector<KinBodyPtr> vsortedbodies = vbodies;
+    std::sort(vsortedbodies.begin(), vsortedbodies.end(), boost::bind(&KinBody::GetName, _1) < boost::bind(&KinBody::GetName, _2));
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+    ss << s_nDistanceFieldFileVersion << " " << resolution << " " << margin << " ";
+    std::vector<Transform> vtransforms;
+    FOREACHC(itbody, vsortedbodies) {
+        ss << (*itbody)->GetName() << " " << (*itbody)->GetKinematicsGeometryHash() << " ";
+        (*itbody)->GetLinkTransformations(vtransforms);
+        FOREACHC(ittrans, vtransforms) {
+            ss << *ittrans << " ";
+        }
+    }
+    return utils::GetMD5HashString(ss.str());
+}
+
+ModuleBasePtr CreateDistanceFieldModule(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return ModuleBasePtr(new DistanceFieldModule(penv, sinput));
+}
+
+}
@@ -0,0 +1,135 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef OPENRAVE_DISTANCEFIELD_H
+#define OPENRAVE_DISTANCEFIELD_H
+
+#include "openraveplugindefs.h"
+
+namespace configurationcache {
+
+using namespace OpenRAVE;
+
+/// \brief signed distance to a set of closed triangle meshes sampled on a regular grid
+///
+/// Voxels enclosed by the triangles have negative distances. Queries interpolate trilinearly, so they take constant time.
+class DistanceField
+{
+public:
+    DistanceField();
+
+    /// \brief voxelizes the triangles and computes the distance transform of the grid
+    ///
+    /// \param trimesh triangles in world coordinates. Surfaces that do not enclose a volume are treated as one voxel thick.
+    /// \param ab the region to sample, it should have some margin around the triangles
+    /// \param numthreads number of threads used for the distance transform
+    void Build(const TriMesh& trimesh, const AABB& ab, dReal resolution, int numthreads);
+
+    /// \return false if the file could not be written
+    bool Save(const std::string& filename) const;
+
+    /// \return false if the file does not exist or is not a distance field
+    bool Load(const std::string& filename);
+
+    /// \brief returns the signed distance at the point. Points outside of the grid get the distance at the closest grid point plus the distance to it.
+    ///
+    /// If nothing was voxelized, returns infinity.
+    dReal GetDistance(const Vector& point) const;
+
+    /// \brief returns the signed distance and its gradient, which points away from the closest obstacle
+    dReal GetDistanceAndGradient(const Vector& point, Vector& vgradient) const;
+
+    inline dReal GetResolution() const {
+        return _resolution;
+    }
+
+    /// \brief returns the region covered by the voxel centers
+    AABB GetBounds() const;
+
+    inline bool IsEmpty() const {
+        return _vdistances.size() == 0;
+    }
+
+private:
+    /// \brief computes the squared euclidean distance transform of the lines [linestart,lineend) along axis
+    void _TransformLines(std::vector<float>& vgrid, int axis, int linestart, int lineend) const;
+
+    /// \brief returns the clamped cell of the point, its interpolation weights, and the offset outside of the grid
+    void _GetCell(const Vector& point, int cell[3], dReal weights[3], Vector& voutside) const;
+
+    inline int _GetIndex(int ix, int iy, int iz) const {
+        return (ix*_dims[1]+iy)*_dims[2]+iz;
+    }
+
+    Vector _vorigin; ///< center of voxel (0,0,0)
+    dReal _resolution, _fiResolution;
+    int _dims[3];
+    std::vector<float> _vdistances; ///< signed distance at every voxel center, indexed with _GetIndex
+};
+
+typedef boost::shared_ptr<DistanceField> DistanceFieldPtr;
+typedef boost::shared_ptr<DistanceField const> DistanceFieldConstPtr;
+
+/// \brief approximates the collision geometry of a link with spheres that cover its surface
+///
+/// \param resolution the size of the cells the surface is split into, the radius of every sphere is at most resolution*sqrt(3)/2
+/// \param vspheres the center of every sphere in link coordinates in xyz and its radius in w
+void ComputeLinkSpheres(KinBody::LinkConstPtr plink, dReal resolution, std::vector<Vector>& vspheres);
+
+/// \brief keeps a distance field of the static bodies of the environment, see ConfigurationJitterer::SetDistanceField
+class DistanceFieldModule : public ModuleBase
+{
+public:
+    DistanceFieldModule(EnvironmentBasePtr penv, std::istream& sinput);
+
+    /// \brief voxelizes the static bodies unless the field of the same bodies, poses and parameters was already built or saved to the database
+    ///
+    /// \param resolution the voxel size
+    /// \param margin the distance computed around the bodies
+    /// \param numthreads if 0, uses the number of processors
+    void Build(dReal resolution, dReal margin, int numthreads);
+
+    /// \brief returns the field that was last built, or an empty pointer
+    inline DistanceFieldConstPtr GetDistanceField() const {
+        return _distancefield;
+    }
+
+    /// \brief returns the smallest clearance of the sphere set of the link
+    ///
+    /// \param vspheres the output of \ref ComputeLinkSpheres
+    /// \param vgradient the distance gradient at the sphere with the smallest clearance
+    /// \param vpoint the world position of that sphere
+    static dReal ComputeClearance(const DistanceField& field, const Transform& tlink, const std::vector<Vector>& vspheres, Vector& vgradient, Vector& vpoint);
+
+protected:
+    bool _BuildCommand(std::ostream& sout, std::istream& sinput);
+    bool _SetBodiesCommand(std::ostream& sout, std::istream& sinput);
+    bool _GetDistanceCommand(std::ostream& sout, std::istream& sinput);
+    bool _GetLinkClearancesCommand(std::ostream& sout, std::istream& sinput);
+
+    /// \brief returns the bodies that are voxelized
+    void _GetStaticBodies(std::vector<KinBodyPtr>& vbodies);
+
+    /// \brief hashes the geometry and link poses of the bodies along with the parameters
+    std::string _ComputeHash(const std::vector<KinBodyPtr>& vbodies, dReal resolution, dReal margin) const;
+
+    std::vector<std::string> _vbodynames; ///< if not empty, the names of the static bodies. Otherwise all bodies that are not robots.
+    DistanceFieldPtr _distancefield;
+    std::string _hash; ///< hash of _distancefield
+};
+
+typedef boost::shared_ptr<DistanceFieldModule> DistanceFieldModulePtr;
+
+}
+
+#endif
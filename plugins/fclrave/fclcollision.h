@@ -18,7 +18,7 @@ public:
     class CollisionCallbackData
     {
     public:
-        CollisionCallbackData(boost::shared_ptr<FCLCollisionChecker> pchecker, CollisionReportPtr report) : _pchecker(pchecker), _report(report), bselfCollision(false), _bStopChecking(false), _bCollision(false)
+        CollisionCallbackData(boost::shared_ptr<FCLCollisionChecker> pchecker, CollisionReportPtr report) : _pchecker(pchecker), _report(report), _minDistance(std::numeric_limits<OpenRAVE::dReal>::max()), _distanceThreshold(pchecker->GetDistanceThreshold()), bselfCollision(false), _bStopChecking(false), _bCollision(false)
         {
             _bHasCallbacks = pchecker->GetEnv()->HasRegisteredCollisionCallbacks();
             if( _bHasCallbacks && !_report ) {
@@ -38,6 +38,7 @@ public:
             if( !!_report ) {
                 _report->Reset(_pchecker->GetCollisionOptions());
             }
+            _distanceRequest.enable_nearest_points = !!_report;
         }
 
         const std::list<EnvironmentBase::CollisionCallbackFn>& GetCallbacks() {
@@ -50,7 +51,11 @@ public:
         boost::shared_ptr<FCLCollisionChecker> _pchecker;
         fcl::CollisionRequest _request;
         fcl::CollisionResult _result;
+        fcl::DistanceRequest _distanceRequest;
+        fcl::DistanceResult _distanceResult;
         CollisionReportPtr _report;
+        OpenRAVE::dReal _minDistance; ///< minimum distance found so far by a distance query
+        OpenRAVE::dReal _distanceThreshold; ///< a distance query stops once _minDistance is below this threshold
 
         bool bselfCollision; ///< true if currently checking for self collision.
         bool _bStopChecking; ///< if true, then stop the collision checking loop
@@ -126,6 +131,13 @@ public:
             envManager->collide(_manager.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
         }
 
+        void Distance(CollisionCallbackData& query) {
+            BroadPhaseCollisionManagerPtr envManager = _pfclspace->GetEnvManager();
+            _manager->setup();
+            envManager->setup();
+            envManager->distance(_manager.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseDistance);
+        }
+
         BroadPhaseCollisionManagerPtr GetManager() {
             return _manager;
         }
@@ -169,6 +181,12 @@ public:
             _manager1->collide(_manager2.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
         }
 
+        void Distance(CollisionCallbackData& query) {
+            _manager1->setup();
+            _manager2->setup();
+            _manager1->distance(_manager2.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseDistance);
+        }
+
         BroadPhaseCollisionManagerPtr GetManager(bool firstManager) {
             return (firstManager ? _manager1 : _manager2);
         }
@@ -188,12 +206,16 @@ private:
         _fclspace.reset(new FCLSpace(penv, _userdatakey));
         _options = 0;
         _numMaxContacts = std::numeric_limits<int>::max(); // TODO
+        _distanceThreshold = 0;
+        _continuousTolerance = 0.001;
         __description = ":Interface Author: Kenji Maillard\n\nFlexible Collision Library collision checker";
 
         RegisterCommand("SetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::_SetBroadphaseAlgorithm, this, _1, _2), "sets the broadphase algorithm (Naive, SaP, SSaP, IntervalTree, DynamicAABBTree, DynamicAABBTree_Array)");
 
         RegisterCommand("SetBVHRepresentation", boost::bind(&FCLCollisionChecker::_SetBVHRepresentation, this, _1, _2), "sets the Bouding Volume Hierarchy representation for meshes (AABB, OBB, OBBRSS, RSS, kIDS)");
         // TODO : check that the coordinate are in the right order
+        RegisterCommand("SetDistanceThreshold", boost::bind(&FCLCollisionChecker::_SetDistanceThreshold, this, _1, _2), "sets the distance under which CO_Distance queries stop looking for closer objects (default is 0, so they only stop on collision)");
+        RegisterCommand("SetContinuousTolerance", boost::bind(&FCLCollisionChecker::_SetContinuousTolerance, this, _1, _2), "sets how far the links can travel between two configurations that continuous collision queries do not subdivide anymore (default is 0.001)");
         RegisterCommand("SetSpatialHashingBroadPhaseAlgorithm", boost::bind(&FCLCollisionChecker::SetSpatialHashingBroadPhaseAlgorithm, this, _1, _2), "sets the broadphase algorithm to spatial hashing with (cell size) (scene min x) (scene min y) (scene min z) (scene max x) (scene max y) (scene max z)");
         RAVELOG_VERBOSE_FORMAT("FCLCollisionChecker %s created in env %d", _userdatakey%penv->GetId());
 
@@ -233,6 +255,8 @@ private:
         // don't need to clone _bIsSelfCollisionChecker?
         _options = r->_options;
         _numMaxContacts = r->_numMaxContacts;
+        _distanceThreshold = r->_distanceThreshold;
+        _continuousTolerance = r->_continuousTolerance;
         RAVELOG_VERBOSE(str(boost::format("FCL User data cloning env %d into env %d") % r->GetEnv()->GetId() % GetEnv()->GetId()));
     }
 
@@ -248,6 +272,22 @@ private:
         _numMaxContacts = numMaxContacts;
     }
 
+    OpenRAVE::dReal GetDistanceThreshold() const {
+        return _distanceThreshold;
+    }
+
+    void SetDistanceThreshold(OpenRAVE::dReal distanceThreshold) {
+        _distanceThreshold = distanceThreshold;
+    }
+
+    OpenRAVE::dReal GetContinuousTolerance() const {
+        return _continuousTolerance;
+    }
+
+    void SetContinuousTolerance(OpenRAVE::dReal continuousTolerance) {
+        _continuousTolerance = continuousTolerance;
+    }
+
     void SetGeometryGroup(const std::string& groupname)
     {
         _fclspace->SetGeometryGroup(groupname);
@@ -263,9 +303,13 @@ private:
     {
         _options = collision_options;
 
-        // TODO : remove when distance is implemented
         if( _options & OpenRAVE::CO_Distance ) {
-            return false;
+            // fcl only computes mesh distances for these bounding volumes
+            const std::string& bvhRepresentation = GetBVHRepresentation();
+            if( bvhRepresentation != "RSS" && bvhRepresentation != "OBBRSS" && bvhRepresentation != "kIOS" ) {
+                RAVELOG_WARN_FORMAT("fcl cannot compute distances with the %s BVH representation, call SetBVHRepresentation with RSS, OBBRSS, or kIOS before initializing the environment", bvhRepresentation);
+                return false;
+            }
         }
 
         if( _options & OpenRAVE::CO_RayAnyHit ) {
@@ -315,6 +359,31 @@ private:
         return !!sinput;
     }
 
+    /// Sets the distance threshold of CO_Distance queries. Once two objects closer than the threshold are found, the query stops without looking for the exact minimum distance.
+    /// e.g. "SetDistanceThreshold 0.01"
+    bool _SetDistanceThreshold(ostream& sout, istream& sinput)
+    {
+        OpenRAVE::dReal distanceThreshold = 0;
+        sinput >> distanceThreshold;
+        if( !!sinput ) {
+            _distanceThreshold = distanceThreshold;
+        }
+        return !!sinput;
+    }
+
+    /// Sets the tolerance of continuous collision queries. Once the links cannot travel more than the tolerance in an interval of the motion, the interval is not subdivided anymore and is only checked at its middle.
+    /// e.g. "SetContinuousTolerance 0.001"
+    bool _SetContinuousTolerance(ostream& sout, istream& sinput)
+    {
+        OpenRAVE::dReal continuousTolerance = 0;
+        sinput >> continuousTolerance;
+        if( !!sinput && continuousTolerance > 0 ) {
+            _continuousTolerance = continuousTolerance;
+            return true;
+        }
+        return false;
+    }
+
     /// Sets the spatial hashing data and switch to the spatial hashing broadphase algorithm
     /// e.g. SetSpatialHashingBroadPhaseAlgorithm cell_size scene_min_x scene_min_y scene_min_z scene_max_x scene_max_y scene_max_z
     bool SetSpatialHashingBroadPhaseAlgorithm(ostream& sout, istream& sinput)
@@ -392,14 +461,13 @@ private:
         FillTemporaryManagerWithBody(pbody1, tmpManagerBody1Body2, !!(_options & OpenRAVE::CO_ActiveDOFs), true);
         FillTemporaryManagerWithBody(pbody2, tmpManagerBody1Body2, !!(_options & OpenRAVE::CO_ActiveDOFs), false);
 
+        CollisionCallbackData query(shared_checker(), report);
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; //TODO
+            tmpManagerBody1Body2.Distance(query);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
             tmpManagerBody1Body2.Collide(query);
-            return query._bCollision;
         }
+        return query._bCollision;
     }
 
     virtual bool CheckCollision(LinkConstPtr plink,CollisionReportPtr report = CollisionReportPtr())
@@ -424,15 +492,15 @@ private:
 
         CollisionObjectPtr pcollLink1 = _fclspace->GetLinkBV(plink1), pcollLink2 = _fclspace->GetLinkBV(plink2);
 
+        CollisionCallbackData query(shared_checker(), report);
+        query.bselfCollision = true;
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; // TODO
+            fcl::FCL_REAL dist = std::numeric_limits<fcl::FCL_REAL>::max();
+            CheckNarrowPhaseDistance(pcollLink1.get(), pcollLink2.get(), &query, dist);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
-            query.bselfCollision = true;
             CheckNarrowPhaseCollision(pcollLink1.get(), pcollLink2.get(), &query);
-            return query._bCollision;
         }
+        return query._bCollision;
     }
 
     virtual bool CheckCollision(LinkConstPtr plink, KinBodyConstPtr pbody,CollisionReportPtr report = CollisionReportPtr())
@@ -470,14 +538,13 @@ private:
         }
         tmpManagerBodyLink.Register(plink, false);
 
+        CollisionCallbackData query(shared_checker(), report);
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; // TODO
+            tmpManagerBodyLink.Distance(query);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
             tmpManagerBodyLink.Collide(query);
-            return query._bCollision;
         }
+        return query._bCollision;
     }
 
     virtual bool CheckCollision(LinkConstPtr plink, std::vector<KinBodyConstPtr> const &vbodyexcluded, std::vector<LinkConstPtr> const &vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())
@@ -527,13 +594,13 @@ private:
         }
 
 
+        CollisionCallbackData query(shared_checker(), report);
         if( _options & OpenRAVE::CO_Distance ) {
-            return false;
+            tmpManagerLinkAgainstEnv.Distance(query);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
             tmpManagerLinkAgainstEnv.Collide(query);
-            return query._bCollision;
         }
+        return query._bCollision;
     }
 
     virtual bool CheckCollision(KinBodyConstPtr pbody, std::vector<KinBodyConstPtr> const &vbodyexcluded, std::vector<LinkConstPtr> const &vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())
@@ -553,14 +620,13 @@ private:
         FillTemporaryManagerAgainstEnvWithBody(pbody, tmpManagerBodyAgainstEnv, !!(_options & OpenRAVE::CO_ActiveDOFs), vbodyexcluded, vlinkexcluded);
 
 
+        CollisionCallbackData query(shared_checker(), report);
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; // TODO
+            tmpManagerBodyAgainstEnv.Distance(query);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
             tmpManagerBodyAgainstEnv.Collide(query);
-            return query._bCollision;
         }
+        return query._bCollision;
     }
 
     virtual bool CheckCollision(RAY const &ray, LinkConstPtr plink,CollisionReportPtr report = CollisionReportPtr())
@@ -596,23 +662,35 @@ private:
             adjacentOptions |= KinBody::AO_ActiveDOFs;
         }
 
-        const std::set<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentOptions);
         _fclspace->Synchronize(pbody);
 
 
         std::vector< CollisionGroup > vlinkCollisionGroups(pbody->GetLinks().size());
 
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; // TODO
-        } else {
             CollisionCallbackData query(shared_checker(), report);
             query.bselfCollision = true;
-
+            const std::set<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentOptions);
             FOREACH(itset, nonadjacent) {
                 size_t index1 = *itset&0xffff, index2 = *itset>>16;
-                LinkConstPtr plink1(pbody->GetLinks().at(index1)), plink2(pbody->GetLinks().at(index2));
-                BOOST_ASSERT( plink1->IsEnabled() && plink2->IsEnabled() ); // should only get enabled links since got adjancency information with AO_Enabled
+                BroadPhaseCollisionManagerPtr plink1Manager = _fclspace->GetLinkManager(pbody, index1), plink2Manager = _fclspace->GetLinkManager(pbody, index2);
+                plink1Manager->setup();
+                plink2Manager->setup();
+                // the callback lowers the pruning distance to the current minimum, so far away link pairs are rejected by their AABBs
+                plink1Manager->distance(plink2Manager.get(), &query, &CheckNarrowPhaseGeomDistance);
+                if( query._bStopChecking ) {
+                    break;
+                }
+            }
+            return query._bCollision;
+        } else {
+            CollisionCallbackData query(shared_checker(), report);
+            query.bselfCollision = true;
+
+            const FCLSpace::KinBodyInfo::SelfCollisionPairs& pairs = _fclspace->GetSelfCollisionPairs(pbody, adjacentOptions);
+            _PruneSelfCollisionPairs(pbody, pairs, -1);
+            FOREACHC(itindex, _vselfcollisionpairindices) {
+                size_t index1 = pairs.vlinkindices1[*itindex], index2 = pairs.vlinkindices2[*itindex];
                 if( vlinkCollisionGroups.at(index1).empty() ) {
                     _fclspace->GetLinkManager(pbody, index1)->getObjects(vlinkCollisionGroups[index1]);
                 }
@@ -622,7 +700,10 @@ private:
 
                 FOREACH(ito1, vlinkCollisionGroups[index1]) {
                     FOREACH(ito2, vlinkCollisionGroups[index2]) {
-                        // TODO : consider using the link BV
+                        // the geometries of links with several geometries can still be far apart
+                        if( !(*ito1)->getAABB().overlap((*ito2)->getAABB()) ) {
+                            continue;
+                        }
                         CheckNarrowPhaseGeomCollision(*ito1, *ito2, &query);
                         if( query._bStopChecking ) {
                             return query._bCollision;
@@ -646,20 +727,30 @@ private:
             adjacentOptions |= KinBody::AO_ActiveDOFs;
         }
 
-        const std::set<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentOptions);
-
         _fclspace->Synchronize(pbody);
 
         CollisionGroup bodyGroup;
 
-        FOREACH(itset, nonadjacent) {
-            KinBody::LinkConstPtr plink1(pbody->GetLinks().at(*itset&0xffff)), plink2(pbody->GetLinks().at(*itset>>16));
-            if( plink == plink1 ) {
-                _fclspace->GetCollisionObjects(plink2, bodyGroup);
-            } else if( plink == plink2 ) {
-                _fclspace->GetCollisionObjects(plink1, bodyGroup);
+        const FCLSpace::KinBodyInfo::SelfCollisionPairs& pairs = _fclspace->GetSelfCollisionPairs(pbody, adjacentOptions);
+        // distance queries need all the pairs
+        if( _options & OpenRAVE::CO_Distance ) {
+            _vselfcollisionpairindices.resize(0);
+            for(size_t i = 0; i < pairs.vlinkindices1.size(); ++i) {
+                if( pairs.vlinkindices1[i] == plink->GetIndex() || pairs.vlinkindices2[i] == plink->GetIndex() ) {
+                    _vselfcollisionpairindices.push_back(i);
+                }
             }
         }
+        else {
+            _PruneSelfCollisionPairs(pbody, pairs, plink->GetIndex());
+        }
+        FOREACHC(itindex, _vselfcollisionpairindices) {
+            int index1 = pairs.vlinkindices1[*itindex], index2 = pairs.vlinkindices2[*itindex];
+            _fclspace->GetCollisionObjects(pbody->GetLinks().at(index1 == plink->GetIndex() ? index2 : index1), bodyGroup);
+        }
+        if( bodyGroup.empty() ) {
+            return false;
+        }
 
         BroadPhaseCollisionManagerPtr linkManager = _fclspace->GetLinkManager(plink), bodyManager = _fclspace->CreateManager();
         bodyManager->registerObjects(bodyGroup);
@@ -667,16 +758,25 @@ private:
         linkManager->setup();
         bodyManager->setup();
 
+        CollisionCallbackData query(shared_checker(), report);
+        query.bselfCollision = true;
         if( _options & OpenRAVE::CO_Distance ) {
-            RAVELOG_WARN("fcl doesn't support CO_Distance yet\n");
-            return false; //TODO
+            linkManager->distance(bodyManager.get(), &query, &CheckNarrowPhaseGeomDistance);
         } else {
-            CollisionCallbackData query(shared_checker(), report);
-            query.bselfCollision = true;
             // TODO : consider using the link BV
             linkManager->collide(bodyManager.get(), &query, &CheckNarrowPhaseGeomCollision);
-            return query._bCollision;
         }
+        return query._bCollision;
+    }
+
+    virtual bool CheckContinuousCollision(KinBodyConstPtr pbody, const std::vector<OpenRAVE::dReal>& vdofvalues0, const std::vector<OpenRAVE::dReal>& vdofvalues1, OpenRAVE::dReal& fTimeOfContact, CollisionReportPtr report = CollisionReportPtr())
+    {
+        return _CheckContinuousCollision(pbody, vdofvalues0, vdofvalues1, false, fTimeOfContact, report);
+    }
+
+    virtual bool CheckContinuousStandaloneSelfCollision(KinBodyConstPtr pbody, const std::vector<OpenRAVE::dReal>& vdofvalues0, const std::vector<OpenRAVE::dReal>& vdofvalues1, OpenRAVE::dReal& fTimeOfContact, CollisionReportPtr report = CollisionReportPtr())
+    {
+        return _CheckContinuousCollision(pbody, vdofvalues0, vdofvalues1, true, fTimeOfContact, report);
     }
 
 private:
@@ -684,12 +784,334 @@ private:
         return boost::dynamic_pointer_cast<FCLCollisionChecker>(shared_from_this());
     }
 
+    /// \brief fills _vselfcollisionpairindices with the pairs whose link bounding volumes have overlapping world AABBs
+    ///
+    /// The AABBs of the links are gathered into contiguous arrays and all the pairs are tested in one loop. The body has to be synchronized.
+    /// \param linkindex if >= 0, only keep the pairs containing this link
+    void _PruneSelfCollisionPairs(KinBodyConstPtr pbody, const FCLSpace::KinBodyInfo::SelfCollisionPairs& pairs, int linkindex)
+    {
+        size_t numpairs = pairs.vlinkindices1.size();
+        _vselfcollisionpairindices.resize(0);
+        if( numpairs == 0 ) {
+            return;
+        }
+        size_t numlinks = pbody->GetLinks().size();
+        for(int j = 0; j < 6; ++j) {
+            _vlinkaabbs[j].resize(numlinks);
+        }
+        for(size_t i = 0; i < numlinks; ++i) {
+            CollisionObjectPtr pcoll = _fclspace->GetLinkBV(pbody, i);
+            if( !!pcoll ) {
+                const fcl::AABB& aabb = pcoll->getAABB();
+                for(int j = 0; j < 3; ++j) {
+                    _vlinkaabbs[j][i] = aabb.min_[j];
+                    _vlinkaabbs[3+j][i] = aabb.max_[j];
+                }
+            }
+            else {
+                // never overlaps
+                for(int j = 0; j < 3; ++j) {
+                    _vlinkaabbs[j][i] = std::numeric_limits<fcl::FCL_REAL>::max();
+                    _vlinkaabbs[3+j][i] = -std::numeric_limits<fcl::FCL_REAL>::max();
+                }
+            }
+        }
+
+        const int* pindices1 = &pairs.vlinkindices1[0];
+        const int* pindices2 = &pairs.vlinkindices2[0];
+        _vselfcollisionpairmask.resize(numpairs);
+        uint8_t* pmask = &_vselfcollisionpairmask[0];
+        if( linkindex >= 0 ) {
+            for(size_t i = 0; i < numpairs; ++i) {
+                pmask[i] = pindices1[i] == linkindex || pindices2[i] == linkindex;
+            }
+        }
+        else {
+            std::fill(pmask, pmask+numpairs, 1);
+        }
+        for(int j = 0; j < 3; ++j) {
+            const fcl::FCL_REAL* pmin = &_vlinkaabbs[j][0], *pmax = &_vlinkaabbs[3+j][0];
+            for(size_t i = 0; i < numpairs; ++i) {
+                int index1 = pindices1[i], index2 = pindices2[i];
+                pmask[i] &= pmin[index1] <= pmax[index2] && pmin[index2] <= pmax[index1];
+            }
+        }
+        for(size_t i = 0; i < numpairs; ++i) {
+            if( pmask[i] ) {
+                _vselfcollisionpairindices.push_back(i);
+            }
+        }
+    }
+
+    /// \brief bounds on the motion of the links of a body when its DOF values are linearly interpolated between two configurations
+    class ContinuousSweepInfo
+    {
+public:
+        std::vector<Vector> vanchors[2]; ///< world anchors of the joints followed by the passive joints at both configurations
+        std::vector<OpenRAVE::dReal> vjointdeltas; ///< how much each joint moves, 0 if it does not move
+        std::vector<Transform> vlinktransforms[2]; ///< link transforms at both configurations
+        std::vector<Vector> vlinkcenters; ///< center of the bounding sphere of each link in the link frame
+        std::vector<OpenRAVE::dReal> vlinkradii; ///< radius of the bounding sphere of each link
+        std::vector<OpenRAVE::dReal> vlinkgrabbedradii; ///< radius of the bounding sphere of each link and the bodies it grabs
+    };
+
+    /// \brief checks pbody against the environment or against itself along the linear motion from vdofvalues0 to vdofvalues1
+    ///
+    /// Uses conservative advancement: the middle of an interval of the motion is checked with a distance query, and the whole interval is free if that distance is larger than how far the links can travel in half of the interval.
+    /// Otherwise the interval is subdivided, earliest half first, until the links cannot travel more than _continuousTolerance in it.
+    /// \param bSelfCollision if true, checks the non-adjacent links of pbody against each other, otherwise checks pbody against the environment
+    bool _CheckContinuousCollision(KinBodyConstPtr pbody, const std::vector<OpenRAVE::dReal>& vdofvalues0, const std::vector<OpenRAVE::dReal>& vdofvalues1, bool bSelfCollision, OpenRAVE::dReal& fTimeOfContact, CollisionReportPtr report)
+    {
+        if( !!report ) {
+            report->Reset(_options);
+        }
+        fTimeOfContact = -1;
+
+        const std::string& bvhRepresentation = GetBVHRepresentation();
+        if( bvhRepresentation != "RSS" && bvhRepresentation != "OBBRSS" && bvhRepresentation != "kIOS" ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("fcl continuous collision queries need distances, which cannot be computed with the %s BVH representation", bvhRepresentation, OpenRAVE::ORE_NotImplemented);
+        }
+        OPENRAVE_ASSERT_OP((int)vdofvalues0.size(),==,pbody->GetDOF());
+        OPENRAVE_ASSERT_OP((int)vdofvalues1.size(),==,pbody->GetDOF());
+        if( pbody->GetLinks().size() == 0 || !pbody->IsEnabled() || (bSelfCollision && pbody->GetLinks().size() <= 1) ) {
+            return false;
+        }
+
+        KinBodyPtr pnonconstbody = GetEnv()->GetBodyFromEnvironmentId(pbody->GetEnvironmentId());
+        KinBody::KinBodyStateSaver saver(pnonconstbody, KinBody::Save_LinkTransformation);
+        ContinuousSweepInfo info;
+        _ComputeContinuousSweepInfo(pnonconstbody, vdofvalues0, vdofvalues1, info);
+
+        // bound how far the checked objects travel relative to each other over the whole motion
+        OpenRAVE::dReal fMaxSweep = 0;
+        std::vector< std::pair<int, OpenRAVE::dReal> > vpairsweeps;
+        if( bSelfCollision ) {
+            int adjacentOptions = KinBody::AO_Enabled;
+            if( (_options & OpenRAVE::CO_ActiveDOFs) && pbody->IsRobot() ) {
+                adjacentOptions |= KinBody::AO_ActiveDOFs;
+            }
+            const std::set<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentOptions);
+            vpairsweeps.reserve(nonadjacent.size());
+            FOREACHC(itset, nonadjacent) {
+                int index1 = *itset&0xffff, index2 = *itset>>16;
+                // both bound the motion of one link relative to the other, so take the tighter one
+                OpenRAVE::dReal fsweep = std::min(_ComputeLinkSweep(pnonconstbody, info, index1, index2, info.vlinkradii[index2]), _ComputeLinkSweep(pnonconstbody, info, index2, index1, info.vlinkradii[index1]));
+                vpairsweeps.push_back(std::make_pair(*itset, fsweep));
+                fMaxSweep = std::max(fMaxSweep, fsweep);
+            }
+        }
+        else {
+            for(size_t ilink = 0; ilink < pbody->GetLinks().size(); ++ilink) {
+                fMaxSweep = std::max(fMaxSweep, _ComputeLinkSweep(pnonconstbody, info, 0, ilink, info.vlinkgrabbedradii[ilink]));
+            }
+        }
+
+        std::vector<OpenRAVE::dReal> vdofvalues(vdofvalues0.size());
+        std::vector< std::pair<OpenRAVE::dReal, OpenRAVE::dReal> > vintervals; // intervals left to check, the earliest one is at the back
+        if( fMaxSweep > 0 ) {
+            vintervals.push_back(std::make_pair(OpenRAVE::dReal(0), OpenRAVE::dReal(1)));
+        }
+        else {
+            // nothing moves relative to the checked objects, so one configuration is enough
+            vintervals.push_back(std::make_pair(OpenRAVE::dReal(0), OpenRAVE::dReal(0)));
+        }
+        while( vintervals.size() > 0 ) {
+            OpenRAVE::dReal ta = vintervals.back().first, tb = vintervals.back().second;
+            vintervals.pop_back();
+            OpenRAVE::dReal tm = 0.5*(ta+tb), fHalfInterval = 0.5*(tb-ta);
+            for(size_t i = 0; i < vdofvalues.size(); ++i) {
+                vdofvalues[i] = vdofvalues0[i] + tm*(vdofvalues1[i]-vdofvalues0[i]);
+            }
+            pnonconstbody->SetDOFValues(vdofvalues, KinBody::CLA_Nothing);
+
+            bool bSubdivide = fHalfInterval*fMaxSweep > _continuousTolerance;
+            int nret = bSelfCollision ? _CheckContinuousSelfDistances(pbody, vpairsweeps, fHalfInterval) : _CheckContinuousEnvDistance(pbody, fHalfInterval*fMaxSweep);
+            if( nret == 1 && !bSubdivide ) {
+                // the interval is too small to subdivide, so only check the middle
+                nret = (bSelfCollision ? CheckStandaloneSelfCollision(pbody) : CheckCollision(pbody)) ? 2 : 0;
+            }
+            if( nret == 2 ) {
+                // all the intervals left are later than tm, so only the first half can have an earlier contact
+                fTimeOfContact = tm;
+                vintervals.clear();
+                if( bSubdivide ) {
+                    vintervals.push_back(std::make_pair(ta, tm));
+                }
+            }
+            else if( nret == 1 ) {
+                vintervals.push_back(std::make_pair(tm, tb));
+                vintervals.push_back(std::make_pair(ta, tm));
+            }
+        }
+
+        if( fTimeOfContact < 0 ) {
+            return false;
+        }
+        if( !!report ) {
+            for(size_t i = 0; i < vdofvalues.size(); ++i) {
+                vdofvalues[i] = vdofvalues0[i] + fTimeOfContact*(vdofvalues1[i]-vdofvalues0[i]);
+            }
+            pnonconstbody->SetDOFValues(vdofvalues, KinBody::CLA_Nothing);
+            if( bSelfCollision ) {
+                CheckStandaloneSelfCollision(pbody, report);
+            }
+            else {
+                CheckCollision(pbody, report);
+            }
+        }
+        return true;
+    }
+
+    /// \brief computes the distance between pbody and the environment, stops as soon as it is below fThreshold
+    ///
+    /// \return 2 if in collision, 1 if closer than fThreshold, 0 otherwise
+    int _CheckContinuousEnvDistance(KinBodyConstPtr pbody, OpenRAVE::dReal fThreshold)
+    {
+        _fclspace->Synchronize();
+        TemporaryManagerAgainstEnv tmpManagerBodyAgainstEnv(_fclspace);
+        FillTemporaryManagerAgainstEnvWithBody(pbody, tmpManagerBodyAgainstEnv, !!(_options & OpenRAVE::CO_ActiveDOFs), std::vector<KinBodyConstPtr>(), std::vector<LinkConstPtr>());
+        CollisionCallbackData query(shared_checker(), CollisionReportPtr());
+        query._distanceThreshold = fThreshold;
+        tmpManagerBodyAgainstEnv.Distance(query);
+        if( query._bCollision ) {
+            return 2;
+        }
+        return query._minDistance <= fThreshold ? 1 : 0;
+    }
+
+    /// \brief computes the distances between the link pairs of pbody, stops at the first pair closer than fHalfInterval times how far its links travel relative to each other
+    ///
+    /// \param vpairsweeps the link pairs (encoded like KinBody::GetNonAdjacentLinks) and how far their links travel relative to each other over the whole motion
+    /// \return 2 if that pair is in collision, 1 if it is not, 0 if no pair is close
+    int _CheckContinuousSelfDistances(KinBodyConstPtr pbody, const std::vector< std::pair<int, OpenRAVE::dReal> >& vpairsweeps, OpenRAVE::dReal fHalfInterval)
+    {
+        _fclspace->Synchronize(pbody);
+        CollisionCallbackData query(shared_checker(), CollisionReportPtr());
+        query.bselfCollision = true;
+        FOREACHC(itpair, vpairsweeps) {
+            size_t index1 = itpair->first&0xffff, index2 = itpair->first>>16;
+            BroadPhaseCollisionManagerPtr plink1Manager = _fclspace->GetLinkManager(pbody, index1), plink2Manager = _fclspace->GetLinkManager(pbody, index2);
+            plink1Manager->setup();
+            plink2Manager->setup();
+            query._minDistance = std::numeric_limits<OpenRAVE::dReal>::max();
+            query._distanceThreshold = fHalfInterval*itpair->second;
+            query._bStopChecking = false;
+            plink1Manager->distance(plink2Manager.get(), &query, &CheckNarrowPhaseGeomDistance);
+            if( query._bCollision ) {
+                return 2;
+            }
+            if( query._minDistance <= query._distanceThreshold ) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /// \brief gathers the joint anchors and link transforms of pbody at vdofvalues0 and vdofvalues1, and the bounding spheres of its links
+    void _ComputeContinuousSweepInfo(KinBodyPtr pbody, const std::vector<OpenRAVE::dReal>& vdofvalues0, const std::vector<OpenRAVE::dReal>& vdofvalues1, ContinuousSweepInfo& info)
+    {
+        const std::vector<KinBody::JointPtr>& vjoints = pbody->GetJoints(), &vpassivejoints = pbody->GetPassiveJoints();
+        size_t numjoints = vjoints.size() + vpassivejoints.size();
+        std::vector<OpenRAVE::dReal> vjointvalues[2];
+        for(int istate = 0; istate < 2; ++istate) {
+            pbody->SetDOFValues(istate == 0 ? vdofvalues0 : vdofvalues1, KinBody::CLA_Nothing);
+            info.vanchors[istate].resize(numjoints);
+            vjointvalues[istate].resize(numjoints, 0);
+            for(size_t ijoint = 0; ijoint < numjoints; ++ijoint) {
+                KinBody::JointPtr pjoint = ijoint < vjoints.size() ? vjoints[ijoint] : vpassivejoints[ijoint-vjoints.size()];
+                info.vanchors[istate][ijoint] = pjoint->GetAnchor();
+                if( pjoint->GetDOF() > 0 ) {
+                    vjointvalues[istate][ijoint] = pjoint->GetValue(0);
+                }
+            }
+            pbody->GetLinkTransformations(info.vlinktransforms[istate]);
+            if( istate == 0 ) {
+                // the spheres are fixed in the link frames, so computing them once is enough
+                const std::vector<KinBody::LinkPtr>& vlinks = pbody->GetLinks();
+                info.vlinkcenters.resize(vlinks.size());
+                info.vlinkradii.resize(vlinks.size());
+                for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+                    OpenRAVE::AABB ab = vlinks[ilink]->ComputeAABB();
+                    info.vlinkcenters[ilink] = info.vlinktransforms[0][ilink].inverse()*ab.pos;
+                    info.vlinkradii[ilink] = OpenRAVE::RaveSqrt(ab.extents.lengthsqr3());
+                }
+                info.vlinkgrabbedradii = info.vlinkradii;
+                if( pbody->IsRobot() ) {
+                    RobotBasePtr probot = OpenRAVE::RaveInterfaceCast<RobotBase>(pbody);
+                    std::vector<KinBodyPtr> vgrabbed;
+                    probot->GetGrabbed(vgrabbed);
+                    FOREACHC(itgrabbed, vgrabbed) {
+                        KinBody::LinkPtr pgrabbinglink = probot->IsGrabbing(*itgrabbed);
+                        if( !!pgrabbinglink ) {
+                            int ilink = pgrabbinglink->GetIndex();
+                            OpenRAVE::AABB ab = (*itgrabbed)->ComputeAABB();
+                            OpenRAVE::dReal fradius = OpenRAVE::RaveSqrt((ab.pos - info.vlinktransforms[0][ilink]*info.vlinkcenters[ilink]).lengthsqr3()) + OpenRAVE::RaveSqrt(ab.extents.lengthsqr3());
+                            info.vlinkgrabbedradii[ilink] = std::max(info.vlinkgrabbedradii[ilink], fradius);
+                        }
+                    }
+                }
+            }
+        }
+
+        info.vjointdeltas.resize(numjoints);
+        for(size_t ijoint = 0; ijoint < numjoints; ++ijoint) {
+            KinBody::JointPtr pjoint = ijoint < vjoints.size() ? vjoints[ijoint] : vpassivejoints[ijoint-vjoints.size()];
+            OpenRAVE::dReal fdelta = 0;
+            if( pjoint->GetDOF() > 0 ) {
+                if( pjoint->IsMimic() ) {
+                    // assumes that the mimic equation is close to linear over the motion
+                    fdelta = RaveFabs(vjointvalues[1][ijoint] - vjointvalues[0][ijoint]);
+                }
+                else if( pjoint->GetDOFIndex() >= 0 ) {
+                    for(int idof = 0; idof < pjoint->GetDOF(); ++idof) {
+                        fdelta += RaveFabs(vdofvalues1.at(pjoint->GetDOFIndex()+idof) - vdofvalues0.at(pjoint->GetDOFIndex()+idof));
+                    }
+                }
+            }
+            if( fdelta > 0 && (pjoint->GetDOF() != 1 || (pjoint->GetType() != KinBody::JointRevolute && pjoint->GetType() != KinBody::JointPrismatic)) ) {
+                throw OPENRAVE_EXCEPTION_FORMAT("fcl continuous collision queries only support moving revolute and prismatic joints, joint %s of body %s has type 0x%x", pjoint->GetName()%pbody->GetName()%pjoint->GetType(), OpenRAVE::ORE_NotImplemented);
+            }
+            info.vjointdeltas[ijoint] = fdelta;
+        }
+    }
+
+    /// \brief bounds how far any point of the bounding sphere of link ilink travels relative to link ibaselink over the whole motion
+    ///
+    /// A joint that rotates by delta moves the points at distance r from its anchor by at most delta*r, and a prismatic joint moves them by delta.
+    /// The distances between the anchors of the chain are bounded with their maximum at both ends of the motion, which is exact for revolute joints and an upper bound for prismatic ones since the distances are convex in the interpolation.
+    OpenRAVE::dReal _ComputeLinkSweep(KinBodyPtr pbody, const ContinuousSweepInfo& info, int ibaselink, int ilink, OpenRAVE::dReal fradius)
+    {
+        std::vector<KinBody::JointPtr> vchain;
+        if( ibaselink == ilink || !pbody->GetChain(ibaselink, ilink, vchain) ) {
+            return 0;
+        }
+        OpenRAVE::dReal fsweep = 0, freach = -1;
+        int iprevjoint = -1;
+        for(std::vector<KinBody::JointPtr>::reverse_iterator itjoint = vchain.rbegin(); itjoint != vchain.rend(); ++itjoint) {
+            int ijoint = (*itjoint)->GetJointIndex();
+            if( ijoint < 0 ) {
+                ijoint = pbody->GetJoints().size() + (find(pbody->GetPassiveJoints().begin(), pbody->GetPassiveJoints().end(), *itjoint) - pbody->GetPassiveJoints().begin());
+            }
+            if( info.vjointdeltas.at(ijoint) <= 0 ) {
+                continue;
+            }
+            OpenRAVE::dReal fincrement = 0;
+            for(int istate = 0; istate < 2; ++istate) {
+                Vector vdelta = freach < 0 ? info.vlinktransforms[istate][ilink]*info.vlinkcenters[ilink] - info.vanchors[istate][ijoint] : info.vanchors[istate][iprevjoint] - info.vanchors[istate][ijoint];
+                fincrement = std::max(fincrement, OpenRAVE::RaveSqrt(vdelta.lengthsqr3()));
+            }
+            freach = freach < 0 ? fincrement + fradius : freach + fincrement;
+            if( (*itjoint)->GetType() == KinBody::JointPrismatic ) {
+                fsweep += info.vjointdeltas[ijoint];
+            }
+            else {
+                fsweep += info.vjointdeltas[ijoint]*freach;
+            }
+            iprevjoint = ijoint;
+        }
+        return fsweep;
+    }
 
-//    boost::shared_ptr<CollisionCallbackData> SetupDistanceQuery(CollisionReportPtr report)
-//    {
-//        // TODO
-//        return boost::make_shared<CollisionCallbackData>(shared_checker(), report);
-//    }
 
     /// \param pbody KinBody whose collision objects are collected
     /// \param tmpManagerBodyAgainstEnv temporary manager to be filled with the collision objects
@@ -986,10 +1408,116 @@ private:
         return false; // keep checking collision
     }
 
-    static bool CheckNarrowPhaseDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data)
+    static bool CheckNarrowPhaseDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data, fcl::FCL_REAL& dist) {
+        CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
+        return pcb->_pchecker->CheckNarrowPhaseDistance(o1, o2, pcb, dist);
+    }
+
+    /// \brief distance callback of the broadphase managers between link objects
+    ///
+    /// \param[inout] dist the minimum distance found so far, the broadphase managers do not test the pairs whose bounding volumes are further apart
+    bool CheckNarrowPhaseDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb, fcl::FCL_REAL& dist)
     {
-        // TODO
-        return false;
+        if( pcb->_bStopChecking ) {
+            return true;     // don't test anymore
+        }
+
+        LinkConstPtr plink1 = GetCollisionLink(*o1), plink2 = GetCollisionLink(*o2);
+
+        if( !plink1 || !plink2 ) {
+            return false;
+        }
+
+        if( !plink1->IsEnabled() || !plink2->IsEnabled() ) {
+            return false;
+        }
+
+        if( !pcb->bselfCollision && plink1->GetParent()->IsAttached(KinBodyConstPtr(plink2->GetParent())) ) {
+            return false;
+        }
+
+        if( _fclspace->HasMultipleGeometries(plink1) ) {
+            BroadPhaseCollisionManagerPtr plink1Manager = _fclspace->GetLinkManager(plink1);
+            plink1Manager->setup();
+            if( _fclspace->HasMultipleGeometries(plink2) ) {
+                BroadPhaseCollisionManagerPtr plink2Manager = _fclspace->GetLinkManager(plink2);
+                plink2Manager->setup();
+                plink1Manager->distance(plink2Manager.get(), pcb, &FCLCollisionChecker::CheckNarrowPhaseGeomDistance);
+            } else {
+                plink1Manager->distance(o2, pcb, &FCLCollisionChecker::CheckNarrowPhaseGeomDistance);
+            }
+        } else {
+            if( _fclspace->HasMultipleGeometries(plink2) ) {
+                BroadPhaseCollisionManagerPtr plink2Manager = _fclspace->GetLinkManager(plink2);
+                plink2Manager->setup();
+                plink2Manager->distance(o1, pcb, &FCLCollisionChecker::CheckNarrowPhaseGeomDistance);
+            } else {
+                CheckNarrowPhaseGeomDistance(o1, o2, pcb, dist);
+            }
+        }
+
+        dist = std::min(dist, (fcl::FCL_REAL)pcb->_minDistance);
+        return pcb->_bStopChecking;
+    }
+
+    static bool CheckNarrowPhaseGeomDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data, fcl::FCL_REAL& dist) {
+        CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
+        return pcb->_pchecker->CheckNarrowPhaseGeomDistance(o1, o2, pcb, dist);
+    }
+
+    bool CheckNarrowPhaseGeomDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb, fcl::FCL_REAL& dist)
+    {
+        if( pcb->_bStopChecking ) {
+            return true;     // don't test anymore
+        }
+
+        LinkConstPtr plink1 = GetCollisionLink(*o1), plink2 = GetCollisionLink(*o2);
+
+        if( !plink1 || !plink2 ) {
+            return false;
+        }
+
+        if( !plink1->IsEnabled() || !plink2->IsEnabled() ) {
+            return false;
+        }
+
+        if( !pcb->bselfCollision && plink1->GetParent()->IsAttached(KinBodyConstPtr(plink2->GetParent())) ) {
+            return false;
+        }
+
+        pcb->_distanceResult.clear();
+        OpenRAVE::dReal fdistance = fcl::distance(o1, o2, pcb->_distanceRequest, pcb->_distanceResult);
+        if( fdistance <= 0 ) {
+            // fcl returns 0 or a negative value for penetrating objects
+            fdistance = 0;
+            pcb->_bCollision = true;
+        }
+
+        if( fdistance < pcb->_minDistance ) {
+            pcb->_minDistance = fdistance;
+            if( !!pcb->_report ) {
+                // same convention as pqp, the contact is on plink1 and the normal points to plink2
+                pcb->_report->minDistance = fdistance;
+                pcb->_report->plink1 = plink1;
+                pcb->_report->plink2 = plink2;
+                Vector p1 = ConvertVectorFromFCL(pcb->_distanceResult.nearest_points[0]), p2 = ConvertVectorFromFCL(pcb->_distanceResult.nearest_points[1]);
+                pcb->_report->contacts.resize(1);
+                pcb->_report->contacts[0].pos = p1;
+                pcb->_report->contacts[0].depth = -fdistance;
+                if( fdistance > 0 ) {
+                    pcb->_report->contacts[0].norm = (p2-p1)*(1/fdistance);
+                }
+                else {
+                    pcb->_report->contacts[0].norm = Vector(0,0,0);
+                }
+            }
+        }
+
+        if( pcb->_minDistance <= pcb->_distanceThreshold ) {
+            pcb->_bStopChecking = true;
+        }
+        dist = std::min(dist, (fcl::FCL_REAL)pcb->_minDistance);
+        return pcb->_bStopChecking;
     }
 
     static LinkPair MakeLinkPair(LinkConstPtr plink1, LinkConstPtr plink2)
@@ -1020,9 +1548,15 @@ private:
     int _options;
     boost::shared_ptr<FCLSpace> _fclspace;
     int _numMaxContacts;
+    OpenRAVE::dReal _distanceThreshold; ///< CO_Distance queries stop once two objects are closer than this distance
+    OpenRAVE::dReal _continuousTolerance; ///< continuous collision queries stop subdividing an interval of the motion once the links cannot travel more than this distance in it
     std::string _userdatakey;
     bool _bIsSelfCollisionChecker; ///< if true, then this collision checker will be solely used for self collision checking. a collision checker is environment if InitEnvironment is called.
     CollisionReport _reportcache; ///< cache the report
+
+    std::vector<int> _vselfcollisionpairindices; ///< indices of the self-collision pairs that passed _PruneSelfCollisionPairs
+    std::vector<uint8_t> _vselfcollisionpairmask;
+    boost::array<std::vector<fcl::FCL_REAL>, 6> _vlinkaabbs; ///< min x,y,z and max x,y,z of the world AABBs of the links of the body being checked
 };
 
 
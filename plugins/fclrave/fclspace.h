@@ -82,6 +82,20 @@ public:
 
 
 
+    /// \brief fcl octree built from the OctreeOccupancy of a GT_Octree geometry
+    ///
+    /// Kept across the resets of the body so that only the voxels that changed since _revision are applied.
+    struct OctreeCache
+    {
+        uint64_t _id; ///< OctreeOccupancy::GetId
+        uint64_t _revision; ///< OctreeOccupancy::GetRevision that _octomap is synchronized to
+#if FCL_HAVE_OCTOMAP
+        std::shared_ptr<octomap::OcTree> _octomap;
+#endif
+        CollisionGeometryPtr _pfclgeom; ///< the fcl octree of the last InitKinBody, empty if there were no voxels
+    };
+    typedef boost::shared_ptr<OctreeCache> OctreeCachePtr;
+
     // corresponds to FCLUserData
     class KinBodyInfo : public boost::enable_shared_from_this<KinBodyInfo>, public OpenRAVE::UserData
     {
@@ -113,6 +127,7 @@ public:
                     (*itgeompair).second.reset();
                 }
                 vgeoms.resize(0);
+                voctreecaches.resize(0);
             }
 
             KinBody::LinkPtr GetLink() {
@@ -125,9 +140,20 @@ public:
             BroadPhaseCollisionManagerPtr _envManager, _bodyManager, _linkManager;
             boost::shared_ptr<TransformCollisionPair> plinkBV;
             std::vector<TransformCollisionPair> vgeoms; // fcl variant of ODE dBodyID
+            std::vector<OctreeCachePtr> voctreecaches; ///< octrees of the GT_Octree geometries
             std::string bodylinkname; // for debugging purposes
         };
 
+        /// \brief compact copy of KinBody::GetNonAdjacentLinks for one set of adjacent options
+        struct SelfCollisionPairs
+        {
+            SelfCollisionPairs() : psetnonadjacent(NULL), nsetsize(0) {
+            }
+            const std::set<int>* psetnonadjacent; ///< the set the pairs were copied from, NULL if invalid
+            size_t nsetsize; ///< size of the set when copied, catches changes of the set that do not post any property
+            std::vector<int> vlinkindices1, vlinkindices2; ///< link indices of every pair
+        };
+
         KinBodyInfo() : nLastStamp(0)
         {
         }
@@ -148,6 +174,9 @@ public:
                 _bodyManager.reset();
             }
             _geometrycallback.reset();
+            _octreecallback.reset();
+            _selfcollisionpairscallback.reset();
+            ResetSelfCollisionPairs();
             // should-I reinitialize nLastStamp ?
         }
 
@@ -157,11 +186,21 @@ public:
             return _pbody.lock();
         }
 
+        void ResetSelfCollisionPairs()
+        {
+            FOREACH(itpairs, vselfcollisionpairs) {
+                itpairs->psetnonadjacent = NULL;
+            }
+        }
+
         KinBodyWeakPtr _pbody;
         int nLastStamp;  // used during synchronization ("is transform up to date")
         vector< boost::shared_ptr<LINK> > vlinks;
         BroadPhaseCollisionManagerPtr _bodyManager;
         OpenRAVE::UserDataPtr _geometrycallback;
+        OpenRAVE::UserDataPtr _octreecallback; ///< updates the fcl octrees in place when only the voxels changed
+        boost::array<SelfCollisionPairs, 4> vselfcollisionpairs; ///< indexed by the adjacent options
+        OpenRAVE::UserDataPtr _selfcollisionpairscallback;
     };
 
     typedef boost::shared_ptr<KinBodyInfo> KinBodyInfoPtr;
@@ -169,7 +208,7 @@ public:
     typedef boost::function<void (KinBodyInfoPtr)> SynchronizeCallbackFn;
 
     FCLSpace(EnvironmentBasePtr penv, const std::string& userdatakey)
-        : _penv(penv), _userdatakey(userdatakey)
+        : _penv(penv), _userdatakey(userdatakey), _nChangeJournalStamp(-1)
     {
         // TODO : test best default choice
         SetBVHRepresentation("OBB");
@@ -216,6 +255,12 @@ public:
             pinfo.reset(new KinBodyInfo());
         }
 
+        // keep the octrees alive through the reset so that they can be updated incrementally
+        std::vector<OctreeCachePtr> voldoctreecaches;
+        FOREACH(itlink, pinfo->vlinks) {
+            voldoctreecaches.insert(voldoctreecaches.end(), (*itlink)->voctreecaches.begin(), (*itlink)->voctreecaches.end());
+        }
+
         pinfo->Reset();
         pinfo->_pbody = boost::const_pointer_cast<KinBody>(pbody);
         pinfo->_bodyManager = CreateManager();
@@ -254,7 +299,7 @@ public:
             }
 
             for(GeometryInfoIterator itgeominfo = begingeom; itgeominfo != endgeom; ++itgeominfo) {
-                const CollisionGeometryPtr pfclgeom = _CreateFCLGeomFromGeometryInfo(_meshFactory, *itgeominfo);
+                const CollisionGeometryPtr pfclgeom = itgeominfo->_type == OpenRAVE::GT_Octree ? _CreateFCLOctree(itgeominfo->_octree, voldoctreecaches, link->voctreecaches) : _CreateFCLGeomFromGeometryInfo(_meshFactory, *itgeominfo);
 
                 if( !pfclgeom ) {
                     continue;
@@ -301,12 +346,15 @@ public:
         }
 
         pinfo->_geometrycallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry, boost::bind(&FCLSpace::_ResetKinBodyCallback,boost::bind(&OpenRAVE::utils::sptr_from<FCLSpace>, weak_space()),boost::weak_ptr<KinBody const>(pbody)));
+        pinfo->_octreecallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkOctree, boost::bind(&FCLSpace::_UpdateOctreesCallback,boost::bind(&OpenRAVE::utils::sptr_from<FCLSpace>, weak_space()),boost::weak_ptr<KinBody const>(pbody)));
+        // the set of non-adjacent links can change without changing its size
+        pinfo->_selfcollisionpairscallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkEnable|KinBody::Prop_RobotActiveDOFs, boost::bind(&KinBodyInfo::ResetSelfCollisionPairs, pinfo.get()));
 
         pbody->SetUserData(_userdatakey, pinfo);
         _setInitializedBodies.insert(pbody);
 
-        // make sure that synchronization do occur !
-        pinfo->nLastStamp = pbody->GetUpdateStamp() - 1;
+        // make sure that synchronization of all the links do occur !
+        pinfo->nLastStamp = -1;
         _Synchronize(pinfo);
 
 
@@ -417,6 +465,19 @@ public:
 
     void Synchronize()
     {
+        // only the bodies in the change journal since the last call can be out of date
+        OpenRAVE::EnvironmentChangeJournalPtr pjournal = _penv->GetChangeJournal();
+        if( !!pjournal && pjournal->GetChangedBodies(_nChangeJournalStamp, _vchangedbodyids) ) {
+            FOREACH(itbodyid, _vchangedbodyids) {
+                KinBodyPtr pbody = _penv->GetBodyFromEnvironmentId(*itbodyid);
+                // We synchronize only the initialized bodies, which differs from oderave
+                if( !!pbody && _setInitializedBodies.count(pbody) > 0 ) {
+                    Synchronize(pbody);
+                }
+            }
+            return;
+        }
+
         // We synchronize only the initialized bodies, which differs from oderave
         FOREACH(itbody, _setInitializedBodies) {
             Synchronize(*itbody);
@@ -502,6 +563,33 @@ public:
         }
     }
 
+    /// \brief returns the non-adjacent link pairs of the body as arrays, only copies the set of the body when it changes
+    ///
+    /// Pairs with a link that has no geometry are left out.
+    const KinBodyInfo::SelfCollisionPairs& GetSelfCollisionPairs(KinBodyConstPtr pbody, int adjacentoptions)
+    {
+        KinBodyInfoPtr pinfo = GetInfo(pbody);
+        BOOST_ASSERT( !!pinfo );
+        const std::set<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentoptions);
+        KinBodyInfo::SelfCollisionPairs& pairs = pinfo->vselfcollisionpairs.at(adjacentoptions);
+        if( pairs.psetnonadjacent != &nonadjacent || pairs.nsetsize != nonadjacent.size() ) {
+            pairs.vlinkindices1.resize(0);
+            pairs.vlinkindices2.resize(0);
+            pairs.vlinkindices1.reserve(nonadjacent.size());
+            pairs.vlinkindices2.reserve(nonadjacent.size());
+            FOREACHC(itset, nonadjacent) {
+                int index1 = *itset&0xffff, index2 = *itset>>16;
+                if( !!pinfo->vlinks.at(index1)->plinkBV && !!pinfo->vlinks.at(index2)->plinkBV ) {
+                    pairs.vlinkindices1.push_back(index1);
+                    pairs.vlinkindices2.push_back(index2);
+                }
+            }
+            pairs.psetnonadjacent = &nonadjacent;
+            pairs.nsetsize = nonadjacent.size();
+        }
+        return pairs;
+    }
+
     CollisionObjectPtr GetLinkBV(LinkConstPtr plink) {
         return GetLinkBV(plink->GetParent(), plink->GetIndex());
     }
@@ -631,19 +719,114 @@ private:
         }
     }
 
+    /// \brief returns the fcl octree of the occupancy, reusing and updating the cache in voldcaches with the same id if there is one
+    static CollisionGeometryPtr _CreateFCLOctree(const OpenRAVE::OctreeOccupancy& octree, const std::vector<OctreeCachePtr>& voldcaches, std::vector<OctreeCachePtr>& vnewcaches)
+    {
+#if FCL_HAVE_OCTOMAP
+        OctreeCachePtr pcache;
+        FOREACHC(itcache, voldcaches) {
+            if( (*itcache)->_id == octree.GetId() ) {
+                pcache = *itcache;
+                break;
+            }
+        }
+        if( !pcache || !_UpdateFCLOctree(octree, *pcache) ) {
+            pcache.reset(new OctreeCache());
+            pcache->_id = octree.GetId();
+            pcache->_octomap = make_shared<octomap::OcTree>(octree.GetResolution());
+            std::vector<Vector> voccupied;
+            octree.GetOccupiedCenters(voccupied);
+            FOREACHC(itpoint, voccupied) {
+                pcache->_octomap->updateNode(octomap::point3d(itpoint->x, itpoint->y, itpoint->z), true);
+            }
+            pcache->_revision = octree.GetRevision();
+        }
+        vnewcaches.push_back(pcache);
+        if( octree.GetNumOccupied() == 0 ) {
+            pcache->_pfclgeom.reset();
+        }
+        else {
+            pcache->_pfclgeom = make_shared<fcl::OcTree>(pcache->_octomap);
+        }
+        return pcache->_pfclgeom;
+#else
+        RAVELOG_WARN("fcl was compiled without octomap, so octree geometries are ignored\n");
+        return CollisionGeometryPtr();
+#endif
+    }
+
+    /// \brief applies the voxels that changed since cache._revision to cache._octomap
+    ///
+    /// \return false if the change log of the occupancy does not reach back to cache._revision
+    static bool _UpdateFCLOctree(const OpenRAVE::OctreeOccupancy& octree, OctreeCache& cache)
+    {
+#if FCL_HAVE_OCTOMAP
+        std::vector<Vector> voccupied, vfreed;
+        if( !octree.GetChangesSince(cache._revision, voccupied, vfreed) ) {
+            return false;
+        }
+        FOREACHC(itpoint, vfreed) {
+            cache._octomap->deleteNode(octomap::point3d(itpoint->x, itpoint->y, itpoint->z));
+        }
+        FOREACHC(itpoint, voccupied) {
+            cache._octomap->updateNode(octomap::point3d(itpoint->x, itpoint->y, itpoint->z), true);
+        }
+        cache._revision = octree.GetRevision();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// \brief called on Prop_LinkOctree, applies the voxel changes to the fcl octrees without resetting the body.
+    ///
+    /// The bounding box of an fcl octree only depends on its resolution and depth, so a link whose only geometry is a non-empty octree
+    /// keeps its collision objects. Otherwise, for example when the octree becomes empty or is merged into the bounding volume of the link, the body is reset.
+    void _UpdateOctreesCallback(boost::weak_ptr<KinBody const> _pbody)
+    {
+        KinBodyConstPtr pbody(_pbody);
+        std::pair<KinBodyInfoPtr, bool> infocreated = GetCreateInfo(pbody);
+        if( infocreated.second ) {
+            return;
+        }
+        KinBodyInfoPtr pinfo = infocreated.first;
+        FOREACH(itlink, pinfo->vlinks) {
+            KinBodyInfo::LINK& link = **itlink;
+            FOREACHC(itgeom, link.GetLink()->GetGeometries()) {
+                if( (*itgeom)->GetType() != OpenRAVE::GT_Octree ) {
+                    continue;
+                }
+                const OpenRAVE::OctreeOccupancy& octree = (*itgeom)->GetOctree();
+                FOREACHC(itcache, link.voctreecaches) {
+                    OctreeCache& cache = **itcache;
+                    if( cache._id != octree.GetId() || cache._revision == octree.GetRevision() ) {
+                        continue;
+                    }
+                    bool bsinglegeometry = !!link.plinkBV && link.vgeoms.size() == 0 && !!cache._pfclgeom && link.plinkBV->second->collisionGeometry() == cache._pfclgeom;
+                    if( !bsinglegeometry || octree.GetNumOccupied() == 0 || !_UpdateFCLOctree(octree, cache) ) {
+                        InitKinBody(pbody, pinfo);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
     void _Synchronize(KinBodyInfoPtr pinfo)
     {
         KinBodyPtr pbody = pinfo->GetBody();
         if( pinfo->nLastStamp != pbody->GetUpdateStamp()) {
-            vector<Transform> vtrans;
-            pbody->GetLinkTransformations(vtrans);
-            pinfo->nLastStamp = pbody->GetUpdateStamp();
-            BOOST_ASSERT( pbody->GetLinks().size() == pinfo->vlinks.size() );
-            BOOST_ASSERT( vtrans.size() == pinfo->vlinks.size() );
-            for(size_t i = 0; i < vtrans.size(); ++i) {
+            const std::vector<KinBody::LinkPtr>& vbodylinks = pbody->GetLinks();
+            BOOST_ASSERT( vbodylinks.size() == pinfo->vlinks.size() );
+            for(size_t i = 0; i < vbodylinks.size(); ++i) {
+                // the link did not move and was not enabled/disabled since the last synchronization
+                if( vbodylinks[i]->GetUpdateStamp() <= pinfo->nLastStamp ) {
+                    continue;
+                }
+                const Transform& tlink = vbodylinks[i]->GetTransform();
                 FOREACHC(itgeomcoll, pinfo->vlinks[i]->vgeoms) {
                     CollisionObjectPtr pcoll = (*itgeomcoll).second;
-                    Transform pose = vtrans[i] * (*itgeomcoll).first;
+                    Transform pose = tlink * (*itgeomcoll).first;
                     fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
                     fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
 
@@ -657,7 +840,7 @@ private:
 
                 if( !!pinfo->vlinks[i]->plinkBV ) {
                     CollisionObjectPtr pcoll = pinfo->vlinks[i]->plinkBV->second;
-                    Transform pose = vtrans[i] * pinfo->vlinks[i]->plinkBV->first;
+                    Transform pose = tlink * pinfo->vlinks[i]->plinkBV->first;
                     fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
                     fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
 
@@ -670,6 +853,7 @@ private:
                     _manager->update(pcoll.get());
                 }
             }
+            pinfo->nLastStamp = pbody->GetUpdateStamp();
 
             if( !!_synccallback ) {
                 _synccallback(pinfo);
@@ -748,6 +932,8 @@ private:
     MeshFactory _meshFactory;
 
     std::set<KinBodyConstPtr> _setInitializedBodies;
+    int _nChangeJournalStamp; ///< stamp of the last read of the environment change journal
+    std::vector<int> _vchangedbodyids; ///< cache
 
 };
 
@@ -100,8 +100,13 @@ using OpenRAVE::AttributesList;
 
 
 #include <fcl/collision.h>
+#include <fcl/distance.h>
 #include <fcl/BVH/BVH_model.h>
 #include <fcl/broadphase/broadphase.h>
 #include <fcl/shape/geometric_shapes.h>
+#include <fcl/config.h>
+#if FCL_HAVE_OCTOMAP
+#include <fcl/octree.h>
+#endif
 
 #endif
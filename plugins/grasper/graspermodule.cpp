@@ -68,7 +68,7 @@ public:
         RegisterCommand("Grasp",boost::bind(&GrasperModule::_GraspCommand,this,_1,_2),
                         "Performs a grasp and returns contact points");
         RegisterCommand("GraspThreaded",boost::bind(&GrasperModule::_GraspThreadedCommand,this,_1,_2),
-                        "Parllelizes the computation of the grasp planning and force closure. Number of threads can be specified with 'numthreads'.");
+                        "Parllelizes the computation of the grasp planning and force closure. Number of threads can be specified with 'numthreads', the number of grasp ids a thread takes at once with 'chunksize'. With 'poolenvironments 1' the cloned worker environments are kept between calls.");
         RegisterCommand("ComputeDistanceMap",boost::bind(&GrasperModule::_ComputeDistanceMapCommand,this,_1,_2),
                         "Computes a distance map around a particular point in space");
         RegisterCommand("GetStableContacts",boost::bind(&GrasperModule::_GetStableContactsCommand,this,_1,_2),
@@ -79,12 +79,22 @@ public:
     virtual ~GrasperModule() {
         if( !!errfile )
             fclose(errfile);
+        _DestroyWorkerEnvironments();
     }
 
     virtual void Destroy()
     {
         _planner.reset();
         _robot.reset();
+        _DestroyWorkerEnvironments();
+    }
+
+    void _DestroyWorkerEnvironments()
+    {
+        FOREACH(itenv, _vworkerenvs) {
+            (*itenv)->Destroy();
+        }
+        _vworkerenvs.clear();
     }
 
     virtual int main(const std::string& args)
@@ -648,6 +658,13 @@ public:
         Vector affineaxis;
 
         bool bCheckGraspIK;
+
+        // grasp table, the grasp id indexes into the product of these sets
+        vector< pair<Vector, Vector> > approachrays;
+        vector<dReal> rolls;
+        vector< vector<dReal> > preshapes;
+        vector<Vector> manipulatordirections;
+        vector<dReal> standoffs;
     };
 
     struct GraspParametersThread
@@ -676,12 +693,14 @@ public:
 
         WorkerParametersPtr worker_params(new WorkerParameters());
         int numthreads = 2;
+        size_t chunksize = 0;
+        bool bPoolEnvironments = false;
         string cmd;
-        vector< pair<Vector, Vector> > approachrays;
-        vector<dReal> rolls;
-        vector< vector<dReal> > preshapes;
-        vector<Vector> manipulatordirections;
-        vector<dReal> standoffs;
+        vector< pair<Vector, Vector> >& approachrays = worker_params->approachrays;
+        vector<dReal>& rolls = worker_params->rolls;
+        vector< vector<dReal> >& preshapes = worker_params->preshapes;
+        vector<Vector>& manipulatordirections = worker_params->manipulatordirections;
+        vector<dReal>& standoffs = worker_params->standoffs;
         size_t startindex = 0;
         size_t maxgrasps = 0;
 
@@ -733,6 +752,12 @@ public:
             else if( cmd == "numthreads" ) {
                 sinput >> numthreads;
             }
+            else if( cmd == "chunksize" ) {
+                sinput >> chunksize;
+            }
+            else if( cmd == "poolenvironments" ) {
+                sinput >> bPoolEnvironments;
+            }
             // grasp specific
             else if( cmd == "approachrays" ) {
                 int numapproachrays = 0;
@@ -797,59 +822,80 @@ public:
         worker_params->affinedofs = _robot->GetAffineDOF();
         worker_params->affineaxis = _robot->GetAffineRotationAxis();
 
-        EnvironmentBasePtr pcloneenv = GetEnv()->CloneSelf(Clone_Bodies|Clone_Simulation);
-
-        _bContinueWorker = true;
-        // start worker threads
-        vector<boost::shared_ptr<boost::thread> > listthreads(numthreads);
-        FOREACH(itthread,listthreads) {
-            itthread->reset(new boost::thread(boost::bind(&GrasperModule::_WorkerThread,this,worker_params,pcloneenv)));
-        }
-
-        _listGraspResults.clear();
         size_t numgrasps = approachrays.size()*rolls.size()*preshapes.size()*standoffs.size()*manipulatordirections.size();
         if( maxgrasps == 0 ) {
             maxgrasps = numgrasps;
         }
+        numthreads = max(1, numthreads);
+        if( chunksize == 0 ) {
+            // when only a few grasps are requested, take one id at a time so that workers do not overshoot maxgrasps by much
+            chunksize = maxgrasps < numgrasps ? 1 : max(size_t(1), min(size_t(64), (numgrasps-min(startindex,numgrasps))/(8*numthreads)));
+        }
         RAVELOG_INFO(str(boost::format("number of grasps to test: %d\n")%numgrasps));
-        size_t id = startindex;
-        for(id=startindex; id < numgrasps; ++id) {
-            size_t istandoff = id % standoffs.size();
-            size_t ipreshape = (id / standoffs.size()) % preshapes.size();
-            size_t iroll = (id / (preshapes.size() * standoffs.size())) % rolls.size();
-            size_t iapproachray = (id / (rolls.size() * preshapes.size() * standoffs.size()))%approachrays.size();
-            size_t imanipulatordirection = (id / (rolls.size() * preshapes.size() * standoffs.size()*approachrays.size()));
-
-            boost::mutex::scoped_lock lock(_mutexGrasp);
-            if( _listGraspResults.size() >= maxgrasps ) {
-                break;
+
+        // every worker needs its own environment. when pooling, the worker environments are kept between calls and only re-synchronized with the current environment, which reuses the already cloned bodies.
+        EnvironmentBasePtr pcloneenv;
+        if( bPoolEnvironments ) {
+            for(int i = 0; i < numthreads; ++i) {
+                if( i < (int)_vworkerenvs.size() ) {
+                    EnvironmentMutex::scoped_lock workerlock(_vworkerenvs[i]->GetMutex());
+                    _vworkerenvs[i]->Clone(GetEnv(), Clone_Bodies|Clone_Simulation);
+                }
+                else {
+                    _vworkerenvs.push_back(GetEnv()->CloneSelf(Clone_Bodies|Clone_Simulation));
+                }
             }
+        }
+        else {
+            // the workers clone this snapshot in parallel without having to hold the lock of the original environment
+            pcloneenv = GetEnv()->CloneSelf(Clone_Bodies|Clone_Simulation);
+        }
 
-            // initialize _graspParamsWork
-            BOOST_ASSERT(!_graspParamsWork);
-            _graspParamsWork.reset(new GraspParametersThread());
-            _graspParamsWork->id = id;
-            _graspParamsWork->vtargetposition = approachrays.at(iapproachray).first;
-            _graspParamsWork->vtargetdirection = approachrays.at(iapproachray).second;
-            _graspParamsWork->vmanipulatordirection = manipulatordirections.at(imanipulatordirection);
-            _graspParamsWork->ftargetroll = rolls.at(iroll);
-            _graspParamsWork->fstandoff = standoffs.at(istandoff);
-            _graspParamsWork->preshape = preshapes.at(ipreshape);
-            _condGraspHasWork.notify_one();     // notify there is work
-            _condGraspReceivedWork.wait(lock);     // wait for more work
+        _nNextGraspId = min(startindex, numgrasps);
+        _nEndGraspId = numgrasps;
+        _nGraspChunkSize = chunksize;
+        _nMaxGrasps = maxgrasps;
+        _nNumGraspResults = 0;
+
+        // start worker threads, each one stores its successful grasps in its own list
+        vector< vector<GraspParametersThreadPtr> > vworkerresults(numthreads);
+        vector<boost::shared_ptr<boost::thread> > listthreads(numthreads);
+        for(size_t i = 0; i < listthreads.size(); ++i) {
+            if( bPoolEnvironments ) {
+                listthreads[i].reset(new boost::thread(boost::bind(&GrasperModule::_WorkerThread,this,worker_params,_vworkerenvs[i],false,boost::ref(vworkerresults[i]))));
+            }
+            else {
+                listthreads[i].reset(new boost::thread(boost::bind(&GrasperModule::_WorkerThread,this,worker_params,pcloneenv,true,boost::ref(vworkerresults[i]))));
+            }
         }
 
         // wait for workers
-        _bContinueWorker = false;
         FOREACH(itthread,listthreads) {
-            _condGraspHasWork.notify_all();     // signal
             (*itthread)->join();
         }
         listthreads.clear();
+        if( !!pcloneenv ) {
+            pcloneenv->Destroy();
+        }
+
+        // merge the results in order of their ids so that the output does not depend on the thread scheduling
+        vector<GraspParametersThreadPtr> vgraspresults;
+        vgraspresults.reserve(_nNumGraspResults);
+        FOREACH(itworkerresults, vworkerresults) {
+            vgraspresults.insert(vgraspresults.end(), itworkerresults->begin(), itworkerresults->end());
+        }
+        std::sort(vgraspresults.begin(), vgraspresults.end(), _CompareGraspId);
+        // all ids before _nNextGraspId have been processed
+        size_t id = _nNextGraspId;
+        if( vgraspresults.size() > maxgrasps ) {
+            // the workers processed past maxgrasps, resume right after the last returned grasp
+            vgraspresults.resize(maxgrasps);
+            id = vgraspresults.back()->id+1;
+        }
 
         // parse results to output
-        sout << id << " " << _listGraspResults.size() << " ";
-        FOREACH(itresult, _listGraspResults) {
+        sout << id << " " << vgraspresults.size() << " ";
+        FOREACH(itresult, vgraspresults) {
             sout << (*itresult)->vtargetposition.x << " " << (*itresult)->vtargetposition.y << " " << (*itresult)->vtargetposition.z << " ";
             sout << (*itresult)->vtargetdirection.x << " " << (*itresult)->vtargetdirection.y << " " << (*itresult)->vtargetdirection.z << " ";
             sout << (*itresult)->ftargetroll << " " << (*itresult)->fstandoff << " ";
@@ -871,10 +917,18 @@ public:
         return true;
     }
 
-    void _WorkerThread(const WorkerParametersPtr worker_params, EnvironmentBasePtr penv)
+    static bool _CompareGraspId(const GraspParametersThreadPtr& a, const GraspParametersThreadPtr& b)
+    {
+        return a->id < b->id;
+    }
+
+    /// \brief processes chunks of grasp ids until all are taken or enough grasps have been found
+    ///
+    /// \param penv the environment to plan in, if bCloneEnv is true the worker plans in its own clone of it
+    /// \param vresults successful grasps of this worker, merged by the caller after the worker exits
+    void _WorkerThread(const WorkerParametersPtr worker_params, EnvironmentBasePtr penv, bool bCloneEnv, std::vector<GraspParametersThreadPtr>& vresults)
     {
-        // clone environment
-        EnvironmentBasePtr pcloneenv = penv->CloneSelf(Clone_Bodies|Clone_Simulation);
+        EnvironmentBasePtr pcloneenv = bCloneEnv ? penv->CloneSelf(Clone_Bodies|Clone_Simulation) : penv;
         {
             EnvironmentMutex::scoped_lock lock(pcloneenv->GetMutex());
             boost::shared_ptr<CollisionCheckerMngr> pcheckermngr(new CollisionCheckerMngr(pcloneenv, worker_params->collisionchecker));
@@ -911,22 +965,38 @@ public:
             coloptions &= ~CO_Contacts;
             pcloneenv->GetCollisionChecker()->SetCollisionOptions(coloptions|CO_Contacts);
 
-            while(_bContinueWorker) {
-                {
-                    // wait for work
+            const vector< pair<Vector, Vector> >& approachrays = worker_params->approachrays;
+            const vector<dReal>& rolls = worker_params->rolls;
+            const vector< vector<dReal> >& preshapes = worker_params->preshapes;
+            const vector<Vector>& manipulatordirections = worker_params->manipulatordirections;
+            const vector<dReal>& standoffs = worker_params->standoffs;
+            size_t id = 0, idend = 0; // current chunk of ids owned by this worker
+            while(1) {
+                if( id >= idend ) {
+                    // take the next chunk
                     boost::mutex::scoped_lock lock(_mutexGrasp);
-                    if( !_graspParamsWork ) {
-                        _condGraspHasWork.wait(lock);
-                        // after signal
-                        if( !_graspParamsWork ) {
-                            continue;
-                        }
+                    if( _nNextGraspId >= _nEndGraspId || _nNumGraspResults >= _nMaxGrasps ) {
+                        break;
                     }
-                    grasp_params = _graspParamsWork;
-                    _graspParamsWork.reset();
-                    _condGraspReceivedWork.notify_all();
+                    id = _nNextGraspId;
+                    idend = min(_nEndGraspId, id+_nGraspChunkSize);
+                    _nNextGraspId = idend;
                 }
 
+                size_t istandoff = id % standoffs.size();
+                size_t ipreshape = (id / standoffs.size()) % preshapes.size();
+                size_t iroll = (id / (preshapes.size() * standoffs.size())) % rolls.size();
+                size_t iapproachray = (id / (rolls.size() * preshapes.size() * standoffs.size()))%approachrays.size();
+                size_t imanipulatordirection = (id / (rolls.size() * preshapes.size() * standoffs.size()*approachrays.size()));
+                grasp_params.reset(new GraspParametersThread());
+                grasp_params->id = id++;
+                grasp_params->vtargetposition = approachrays.at(iapproachray).first;
+                grasp_params->vtargetdirection = approachrays.at(iapproachray).second;
+                grasp_params->vmanipulatordirection = manipulatordirections.at(imanipulatordirection);
+                grasp_params->ftargetroll = rolls.at(iroll);
+                grasp_params->fstandoff = standoffs.at(istandoff);
+                grasp_params->preshape = preshapes.at(ipreshape);
+
                 RAVELOG_DEBUG(str(boost::format("grasp %d: start")%grasp_params->id));
 
                 // fill params
@@ -1124,18 +1194,21 @@ public:
 
                 RAVELOG_DEBUG(str(boost::format("grasp %d: success")%grasp_params->id));
 
+                vresults.push_back(grasp_params);
                 boost::mutex::scoped_lock lock(_mutexGrasp);
-                _listGraspResults.push_back(grasp_params);
+                ++_nNumGraspResults;
             }
         }
-        pcloneenv->Destroy();
+        if( bCloneEnv ) {
+            pcloneenv->Destroy();
+        }
     }
 
-    bool _bContinueWorker;
-    boost::mutex _mutexGrasp;
-    GraspParametersThreadPtr _graspParamsWork;
-    list<GraspParametersThreadPtr> _listGraspResults;
-    boost::condition _condGraspHasWork, _condGraspReceivedWork;
+    boost::mutex _mutexGrasp; ///< protects the grasp id counters below
+    size_t _nNextGraspId, _nEndGraspId; ///< range of grasp ids that have not been taken by the workers yet
+    size_t _nGraspChunkSize; ///< number of consecutive grasp ids a worker takes at once
+    size_t _nMaxGrasps, _nNumGraspResults; ///< workers stop taking ids once _nNumGraspResults reaches _nMaxGrasps
+    std::vector<EnvironmentBasePtr> _vworkerenvs; ///< pooled worker environments of GraspThreaded, kept between calls
 
 protected:
     void _ComputeJointMaxLengths(vector<dReal>& vjointlengths)
@@ -559,6 +559,7 @@ protected:
 
     virtual bool Solve(const IkParameterization& rawparam, const std::vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn)
     {
+        OPENRAVE_PROFILE_SCOPE("IkFastSolver::Solve");
         IkParameterization ikparamdummy;
         const IkParameterization& param = _ConvertIkParameterization(rawparam, ikparamdummy);
         if( !!ikreturn ) {
@@ -580,6 +581,7 @@ protected:
 
     virtual bool SolveAll(const IkParameterization& rawparam, int filteroptions, std::vector<IkReturnPtr>& vikreturns)
     {
+        OPENRAVE_PROFILE_SCOPE("IkFastSolver::SolveAll");
         vikreturns.resize(0);
         IkParameterization ikparamdummy;
         const IkParameterization& param = _ConvertIkParameterization(rawparam, ikparamdummy);
@@ -600,6 +602,7 @@ protected:
 
     virtual bool Solve(const IkParameterization& rawparam, const std::vector<dReal>& q0, const std::vector<dReal>& vFreeParameters, int filteroptions, IkReturnPtr ikreturn)
     {
+        OPENRAVE_PROFILE_SCOPE("IkFastSolver::Solve");
         IkParameterization ikparamdummy;
         const IkParameterization& param = _ConvertIkParameterization(rawparam, ikparamdummy);
         if( vFreeParameters.size() != _vfreeparams.size() ) {
@@ -627,6 +630,7 @@ protected:
 
     virtual bool SolveAll(const IkParameterization& rawparam, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& vikreturns)
     {
+        OPENRAVE_PROFILE_SCOPE("IkFastSolver::SolveAll");
         vikreturns.resize(0);
         IkParameterization ikparamdummy;
         const IkParameterization& param = _ConvertIkParameterization(rawparam, ikparamdummy);
@@ -0,0 +1,64 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "plugindefs.h"
+
+/// \brief gives access to the profiling counters of libopenrave, see profiling.h
+class Profiler : public ModuleBase
+{
+public:
+    Profiler(EnvironmentBasePtr penv, std::istream& sinput) : ModuleBase(penv)
+    {
+        __description = ":Interface Author: Rosen Diankov\n\nReturns the statistics of the profiling sections compiled into OpenRAVE with the OPT_PROFILING cmake option. The counters are global and summed over all threads.";
+        RegisterCommand("GetStatistics",boost::bind(&Profiler::_GetStatisticsCommand,this,_1,_2),
+                        "Returns one line per section that was run::\n\n  [name] [count] [totaltime] [maxtime] [numbins] [bin0] [bin1] ...\n\nTimes are in nanoseconds. Bin i counts the runs that took less than 2^(i+1) nanoseconds. Because names can have spaces, the name is terminated by a tab.");
+        RegisterCommand("Reset",boost::bind(&Profiler::_ResetCommand,this,_1,_2),
+                        "Zeros the counters of all sections");
+        RegisterCommand("IsEnabled",boost::bind(&Profiler::_IsEnabledCommand,this,_1,_2),
+                        "Returns 1 if the profiling sections were compiled in, otherwise 0");
+    }
+
+protected:
+    bool _GetStatisticsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::vector<ProfileStatistics> vstatistics;
+        RaveGetProfileStatistics(vstatistics);
+        FOREACHC(itstats, vstatistics) {
+            sout << itstats->name << "\t" << itstats->count << " " << itstats->totaltime << " " << itstats->maxtime << " " << itstats->vhistogram.size();
+            FOREACHC(itbin, itstats->vhistogram) {
+                sout << " " << *itbin;
+            }
+            sout << std::endl;
+        }
+        return true;
+    }
+
+    bool _ResetCommand(std::ostream& sout, std::istream& sinput)
+    {
+        RaveResetProfileStatistics();
+        return true;
+    }
+
+    bool _IsEnabledCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sout << OPENRAVE_PROFILING;
+        return true;
+    }
+};
+
+ModuleBasePtr CreateProfiler(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return ModuleBasePtr(new Profiler(penv,sinput));
+}
@@ -686,6 +686,51 @@ public:
         return cb._bCollision;
     }
 
+    virtual bool CheckCollisionRays(const std::vector<RAY>& rays, KinBodyConstPtr pbody, std::vector<KinBody::LinkConstPtr>& vhitlinks, std::vector<CollisionReport::CONTACT>& vcontacts)
+    {
+        vhitlinks.resize(rays.size());
+        vcontacts.resize(rays.size());
+        FOREACH(itlink, vhitlinks) {
+            itlink->reset();
+        }
+        if( !!pbody && (pbody->GetLinks().size() == 0 || !pbody->IsEnabled()) ) {
+            return false;
+        }
+
+        // the space is synchronized and the callbacks are gathered once for all the rays
+        CollisionReportPtr report(new CollisionReport());
+        CollisionCallbackData cb(shared_checker(),report,pbody,KinBody::LinkConstPtr());
+#ifndef ODE_USE_MULTITHREAD
+        boost::mutex::scoped_lock lock(_mutexode);
+#endif
+        _odespace->Synchronize();
+        dGeomID space = !!pbody ? (dGeomID)_odespace->GetBodySpace(pbody) : (dGeomID)_odespace->GetSpace();
+        dGeomRaySetClosestHit(geomray, !(_options&OpenRAVE::CO_RayAnyHit));     // only care about the closest points
+        dGeomRaySetParams(geomray,0,0);
+        bool bCollision = false;
+        for(size_t i = 0; i < rays.size(); ++i) {
+            const RAY& ray = rays[i];
+            cb.fraymaxdist = OpenRAVE::RaveSqrt(ray.dir.lengthsqr3());
+            if( cb.fraymaxdist <= 0 ) {
+                vcontacts[i] = CollisionReport::CONTACT();
+                continue;
+            }
+            Vector vnormdir = ray.dir*(1/cb.fraymaxdist);
+            dGeomRaySet(geomray, ray.pos.x, ray.pos.y, ray.pos.z, vnormdir.x, vnormdir.y, vnormdir.z);
+            dGeomRaySetLength(geomray,cb.fraymaxdist);
+            report->Reset(_options);
+            cb._bCollision = false;
+            cb._bStopChecking = false;
+            dSpaceCollide2(space, geomray, &cb, RayCollisionCallback);
+            if( cb._bCollision ) {
+                vhitlinks[i] = report->plink1;
+                bCollision = true;
+            }
+            vcontacts[i] = cb._bCollision && report->contacts.size() > 0 ? report->contacts[0] : CollisionReport::CONTACT();
+        }
+        return bCollision;
+    }
+
     virtual bool CheckStandaloneSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report)
     {
         if( _options & OpenRAVE::CO_Distance ) {
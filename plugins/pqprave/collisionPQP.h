@@ -27,6 +27,16 @@ public:
     class KinBodyInfo : public OpenRAVE::UserData
     {
 public:
+        /// \brief compact copy of KinBody::GetNonAdjacentLinks for one set of adjacent options
+        struct SelfCollisionPairs
+        {
+            SelfCollisionPairs() : psetnonadjacent(NULL), nsetsize(0) {
+            }
+            const std::set<int>* psetnonadjacent; ///< the set the pairs were copied from, NULL if invalid
+            size_t nsetsize; ///< size of the set when copied, catches changes of the set that do not post any property
+            std::vector<int> vlinkindices1, vlinkindices2; ///< link indices of every pair
+        };
+
         KinBodyInfo() : nLastStamp(0) {
         }
         virtual ~KinBodyInfo() {
@@ -34,8 +44,18 @@ public:
         KinBodyPtr GetBody() const {
             return _pbody.lock();
         }
+
+        void ResetSelfCollisionPairs() {
+            FOREACH(itpairs, vselfcollisionpairs) {
+                itpairs->psetnonadjacent = NULL;
+            }
+        }
+
         KinBodyWeakPtr _pbody;
         vector<boost::shared_ptr<PQP_Model> > vlinks;
+        std::vector<Vector> vlinkspheres; ///< bounding sphere of every link in the link frame, w is the radius. The radius is negative if the link has no geometry
+        boost::array<SelfCollisionPairs, 4> vselfcollisionpairs; ///< indexed by the adjacent options
+        UserDataPtr _selfcollisionpairscallback;
         int nLastStamp;
     };
     typedef boost::shared_ptr<KinBodyInfo> KinBodyInfoPtr;
@@ -53,11 +73,23 @@ public:
         _benablecol = true;
         _benabledis = false;
         _benabletol = false;
+        _options = 0;
     }
     virtual ~CollisionCheckerPQP() {
         DestroyEnvironment();
     }
 
+    void Clone(InterfaceBaseConstPtr preference, int cloningoptions)
+    {
+        CollisionCheckerBase::Clone(preference, cloningoptions);
+        boost::shared_ptr<CollisionCheckerPQP const > r = boost::dynamic_pointer_cast<CollisionCheckerPQP const>(preference);
+        SetCollisionOptions(r->_options);
+        _tolerance = r->_tolerance;
+        _benabletol = r->_benabletol;
+        _rel_err = r->_rel_err;
+        _abs_err = r->_abs_err;
+    }
+
     virtual bool InitEnvironment()
     {
         RAVELOG_DEBUG("creating pqp collision\n");
@@ -101,10 +133,24 @@ public:
 
         PQP_REAL p1[3], p2[3], p3[3];
         pinfo->vlinks.reserve(pbody->GetLinks().size());
+        pinfo->vlinkspheres.reserve(pbody->GetLinks().size());
         FOREACHC(itlink, pbody->GetLinks()) {
             const TriMesh& trimesh = (*itlink)->GetCollisionData();
             boost::shared_ptr<PQP_Model> pm;
+            Vector sphere(0,0,0,-1);
             if( trimesh.indices.size() > 0 ) {
+                Vector vmin = trimesh.vertices.at(0), vmax = trimesh.vertices.at(0);
+                FOREACHC(itv, trimesh.vertices) {
+                    vmin.x = min(vmin.x, itv->x); vmin.y = min(vmin.y, itv->y); vmin.z = min(vmin.z, itv->z);
+                    vmax.x = max(vmax.x, itv->x); vmax.y = max(vmax.y, itv->y); vmax.z = max(vmax.z, itv->z);
+                }
+                sphere = 0.5*(vmin+vmax);
+                dReal fradiussqr = 0;
+                FOREACHC(itv, trimesh.vertices) {
+                    fradiussqr = max(fradiussqr, (*itv-sphere).lengthsqr3());
+                }
+                sphere.w = RaveSqrt(fradiussqr);
+
                 pm.reset(new PQP_Model());
                 pm->BeginModel(trimesh.indices.size()/3);
                 for(int j = 0; j < (int)trimesh.indices.size(); j+=3) {
@@ -116,7 +162,10 @@ public:
                 pm->EndModel();
             }
             pinfo->vlinks.push_back(pm);
+            pinfo->vlinkspheres.push_back(sphere);
         }
+        // the set of non-adjacent links can change without changing its size
+        pinfo->_selfcollisionpairscallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkEnable|KinBody::Prop_RobotActiveDOFs, boost::bind(&KinBodyInfo::ResetSelfCollisionPairs, pinfo.get()));
 
         return true;
     }
@@ -368,10 +417,12 @@ public:
         if( (_options&OpenRAVE::CO_ActiveDOFs) && pbody->IsRobot() ) {
             adjacentoptions |= KinBody::AO_ActiveDOFs;
         }
-        const std::set<int>& nonadjacent = pbody->GetNonAdjacentLinks(adjacentoptions);
-        FOREACHC(itset, nonadjacent) {
-            if( CheckCollision(KinBody::LinkConstPtr(pbody->GetLinks().at(*itset&0xffff)), KinBody::LinkConstPtr(pbody->GetLinks().at(*itset>>16)), report) ) {
-                RAVELOG_VERBOSE(str(boost::format("selfcol %s, Links %s %s are colliding\n")%pbody->GetName()%pbody->GetLinks().at(*itset&0xffff)->GetName()%pbody->GetLinks().at(*itset>>16)->GetName()));
+        const KinBodyInfo::SelfCollisionPairs& pairs = _GetSelfCollisionPairs(pbody, adjacentoptions);
+        _PruneSelfCollisionPairs(pbody, pairs, -1);
+        FOREACHC(itindex, _vselfcollisionpairindices) {
+            int index1 = pairs.vlinkindices1[*itindex], index2 = pairs.vlinkindices2[*itindex];
+            if( CheckCollision(KinBody::LinkConstPtr(pbody->GetLinks().at(index1)), KinBody::LinkConstPtr(pbody->GetLinks().at(index2)), report) ) {
+                RAVELOG_VERBOSE(str(boost::format("selfcol %s, Links %s %s are colliding\n")%pbody->GetName()%pbody->GetLinks().at(index1)->GetName()%pbody->GetLinks().at(index2)->GetName()));
                 return true;
             }
         }
@@ -393,17 +444,16 @@ public:
         if( (_options&OpenRAVE::CO_ActiveDOFs) && pbody->IsRobot() ) {
             adjacentoptions |= KinBody::AO_ActiveDOFs;
         }
-        const std::set<int>& nonadjacent = pbody->GetNonAdjacentLinks(adjacentoptions);
+        const KinBodyInfo::SelfCollisionPairs& pairs = _GetSelfCollisionPairs(pbody, adjacentoptions);
+        _PruneSelfCollisionPairs(pbody, pairs, plink->GetIndex());
         PQP_REAL R1[3][3], R2[3][3], T1[3], T2[3];
-        FOREACHC(itset, nonadjacent) {
-            KinBody::LinkConstPtr plink1(pbody->GetLinks().at(*itset&0xffff)), plink2(pbody->GetLinks().at(*itset>>16));
-            if( plink == plink1 || plink == plink2 ) {
-                GetPQPTransformFromTransform(plink1->GetTransform(),R1,T1);
-                GetPQPTransformFromTransform(plink2->GetTransform(),R2,T2);
-                if( DoPQP(plink1,R1,T1,plink2,R2,T2,report) ) {
-                    RAVELOG_VERBOSE(str(boost::format("selfcol %s, Links %s %s are colliding\n")%pbody->GetName()%pbody->GetLinks().at(*itset&0xffff)->GetName()%pbody->GetLinks().at(*itset>>16)->GetName()));
-                    return true;
-                }
+        FOREACHC(itindex, _vselfcollisionpairindices) {
+            KinBody::LinkConstPtr plink1(pbody->GetLinks().at(pairs.vlinkindices1[*itindex])), plink2(pbody->GetLinks().at(pairs.vlinkindices2[*itindex]));
+            GetPQPTransformFromTransform(plink1->GetTransform(),R1,T1);
+            GetPQPTransformFromTransform(plink2->GetTransform(),R2,T2);
+            if( DoPQP(plink1,R1,T1,plink2,R2,T2,report) ) {
+                RAVELOG_VERBOSE(str(boost::format("selfcol %s, Links %s %s are colliding\n")%pbody->GetName()%plink1->GetName()%plink2->GetName()));
+                return true;
             }
         }
 
@@ -422,6 +472,81 @@ public:
     }
 
 private:
+    /// \brief returns the non-adjacent link pairs of the body as arrays, only copies the set of the body when it changes
+    const KinBodyInfo::SelfCollisionPairs& _GetSelfCollisionPairs(KinBodyConstPtr pbody, int adjacentoptions)
+    {
+        KinBodyInfoPtr pinfo = boost::dynamic_pointer_cast<KinBodyInfo>(pbody->GetUserData(_userdatakey));
+        BOOST_ASSERT(!!pinfo && pinfo->GetBody() == pbody);
+        const std::set<int>& nonadjacent = pbody->GetNonAdjacentLinks(adjacentoptions);
+        KinBodyInfo::SelfCollisionPairs& pairs = pinfo->vselfcollisionpairs.at(adjacentoptions);
+        if( pairs.psetnonadjacent != &nonadjacent || pairs.nsetsize != nonadjacent.size() ) {
+            pairs.vlinkindices1.resize(0);
+            pairs.vlinkindices2.resize(0);
+            pairs.vlinkindices1.reserve(nonadjacent.size());
+            pairs.vlinkindices2.reserve(nonadjacent.size());
+            FOREACHC(itset, nonadjacent) {
+                int index1 = *itset&0xffff, index2 = *itset>>16;
+                // links without geometry can never collide
+                if( !!pinfo->vlinks.at(index1) && !!pinfo->vlinks.at(index2) ) {
+                    pairs.vlinkindices1.push_back(index1);
+                    pairs.vlinkindices2.push_back(index2);
+                }
+            }
+            pairs.psetnonadjacent = &nonadjacent;
+            pairs.nsetsize = nonadjacent.size();
+        }
+        return pairs;
+    }
+
+    /// \brief fills _vselfcollisionpairindices with the pairs whose link bounding spheres overlap
+    ///
+    /// The test runs over all the pairs at once with contiguous arrays. Distance queries need every pair, so nothing is pruned then.
+    /// \param linkindex if >= 0, only keep the pairs containing this link
+    void _PruneSelfCollisionPairs(KinBodyConstPtr pbody, const KinBodyInfo::SelfCollisionPairs& pairs, int linkindex)
+    {
+        KinBodyInfoPtr pinfo = boost::dynamic_pointer_cast<KinBodyInfo>(pbody->GetUserData(_userdatakey));
+        size_t numpairs = pairs.vlinkindices1.size();
+        _vselfcollisionpairindices.resize(0);
+        if( numpairs == 0 ) {
+            return;
+        }
+        const int* pindices1 = &pairs.vlinkindices1[0];
+        const int* pindices2 = &pairs.vlinkindices2[0];
+        _vselfcollisionpairmask.resize(numpairs);
+        uint8_t* pmask = &_vselfcollisionpairmask[0];
+        if( linkindex >= 0 ) {
+            for(size_t i = 0; i < numpairs; ++i) {
+                pmask[i] = pindices1[i] == linkindex || pindices2[i] == linkindex;
+            }
+        }
+        else {
+            std::fill(pmask, pmask+numpairs, 1);
+        }
+        if( !_benabledis ) {
+            // world spheres of all the links as a structure of arrays
+            size_t numlinks = pbody->GetLinks().size();
+            _vlinkspherex.resize(numlinks); _vlinkspherey.resize(numlinks); _vlinkspherez.resize(numlinks); _vlinkspherer.resize(numlinks);
+            for(size_t i = 0; i < numlinks; ++i) {
+                Vector v = pbody->GetLinks()[i]->GetTransform()*pinfo->vlinkspheres[i];
+                _vlinkspherex[i] = v.x; _vlinkspherey[i] = v.y; _vlinkspherez[i] = v.z; _vlinkspherer[i] = pinfo->vlinkspheres[i].w;
+            }
+            // pqp reports contacts at exactly 0 distance, so add a small margin for the floating-point error of the sphere
+            dReal fmargin = (_benabletol ? _tolerance : 0) + 1e-5;
+            const dReal* px = &_vlinkspherex[0], *py = &_vlinkspherey[0], *pz = &_vlinkspherez[0], *pr = &_vlinkspherer[0];
+            for(size_t i = 0; i < numpairs; ++i) {
+                int index1 = pindices1[i], index2 = pindices2[i];
+                dReal dx = px[index1]-px[index2], dy = py[index1]-py[index2], dz = pz[index1]-pz[index2];
+                dReal fradius = pr[index1]+pr[index2]+fmargin;
+                pmask[i] &= dx*dx+dy*dy+dz*dz <= fradius*fradius;
+            }
+        }
+        for(size_t i = 0; i < numpairs; ++i) {
+            if( pmask[i] ) {
+                _vselfcollisionpairindices.push_back(i);
+            }
+        }
+    }
+
     // does not check attached
     bool CheckCollisionP(KinBodyConstPtr pbody1, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report)
     {
@@ -682,6 +807,10 @@ private:
     PQP_REAL tri1[3][3], tri2[3][3];
     TransformMatrix tmtemp;
 
+    std::vector<int> _vselfcollisionpairindices; ///< indices of the self-collision pairs that passed _PruneSelfCollisionPairs
+    std::vector<uint8_t> _vselfcollisionpairmask;
+    std::vector<dReal> _vlinkspherex, _vlinkspherey, _vlinkspherez, _vlinkspherer; ///< world bounding spheres of the links of the body being checked
+
     RobotBaseConstPtr _pactiverobot;     ///< set if ActiveDOFs option is enabled
     vector<uint8_t> _vactivelinks;
     std::string _userdatakey;
@@ -95,7 +95,7 @@ KinBodyItem::KinBodyItem(QtCoinViewerPtr viewer, KinBodyPtr pchain, ViewGeometry
     _bReload = false;
     _bDrawStateChanged = false;
     networkid = pchain->GetEnvironmentId();
-    _geometrycallback = pchain->RegisterChangeCallback(KinBody::Prop_LinkGeometry, boost::bind(&KinBodyItem::GeometryChangedCallback,this));
+    _geometrycallback = pchain->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkOctree, boost::bind(&KinBodyItem::GeometryChangedCallback,this));
     _drawcallback = pchain->RegisterChangeCallback(KinBody::Prop_LinkDraw, boost::bind(&KinBodyItem::DrawChangedCallback,this));
 }
 
@@ -261,6 +261,7 @@ void KinBodyItem::Load()
                     break;
                 }
                 case GT_Container:
+                case GT_Octree:
                 case GT_TriMesh: {
                     // actually don't set to dual-sided rendering since flipped triangles can cause problems with collision and user should know about it
                     //phints->shapeType = SoShapeHints::UNKNOWN_SHAPE_TYPE; // set to render for both faces
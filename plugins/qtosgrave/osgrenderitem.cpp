@@ -230,7 +230,7 @@ KinBodyItem::KinBodyItem(OSGGroupPtr osgSceneRoot, OSGGroupPtr osgFigureRoot, Ki
     _bReload = false;
     _bDrawStateChanged = false;
     _environmentid = pbody->GetEnvironmentId();
-    _geometrycallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry, boost::bind(&KinBodyItem::_HandleGeometryChangedCallback,this));
+    _geometrycallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkOctree, boost::bind(&KinBodyItem::_HandleGeometryChangedCallback,this));
     _drawcallback = pbody->RegisterChangeCallback(KinBody::Prop_LinkDraw, boost::bind(&KinBodyItem::_HandleDrawChangedCallback,this));
 }
 
@@ -411,6 +411,7 @@ void KinBodyItem::Load()
                 }
                 //  Extract geometry from collision Mesh
                 case GT_Container:
+                case GT_Octree:
                 case GT_TriMesh: {
                     // make triangleMesh
                     osg::ref_ptr<osg::Geometry> geom = new osg::Geometry;
@@ -58,6 +58,8 @@ Method wraps the WorkspaceTrajectoryTracker planner. For more details on paramet
                         "Sets post processing parameters.");
         RegisterCommand("SetRobot",boost::bind(&BaseManipulation::SetRobotCommand,this,_1,_2),
                         "Sets the robot.");
+        RegisterCommand("SendWorkspacePlannerCommand",boost::bind(&BaseManipulation::SendWorkspacePlannerCommand,this,_1,_2),
+                        "Sends the rest of the line as a command to the planner kept by MoveHandStraight, for example GetCacheStatistics. Fails if MoveHandStraight was not called yet.");
         _minimumgoalpaths=1;
     }
 
@@ -67,11 +69,13 @@ Method wraps the WorkspaceTrajectoryTracker planner. For more details on paramet
     virtual void Destroy()
     {
         robot.reset();
+        _pworkspaceplanner.reset();
         ModuleBase::Destroy();
     }
 
     virtual void Reset()
     {
+        _pworkspaceplanner.reset();
         ModuleBase::Reset();
     }
 
@@ -316,10 +320,19 @@ protected:
             return false;
         }
 
-        PlannerBasePtr planner = RaveCreatePlanner(GetEnv(),plannername);
-        if( !planner ) {
-            RAVELOG_WARN("failed to create planner\n");
-            return false;
+        // keep the planner around so that its cached ik and collision results can be reused by the next call
+        PlannerBasePtr planner;
+        if( !!_pworkspaceplanner && _strWorkspacePlannerName == plannername ) {
+            planner = _pworkspaceplanner;
+        }
+        else {
+            planner = RaveCreatePlanner(GetEnv(),plannername);
+            if( !planner ) {
+                RAVELOG_WARN("failed to create planner\n");
+                return false;
+            }
+            _pworkspaceplanner = planner;
+            _strWorkspacePlannerName = plannername;
         }
 
         if( !planner->InitPlan(robot, params) ) {
@@ -1106,6 +1119,15 @@ protected:
         return !!sinput;
     }
 
+    bool SendWorkspacePlannerCommand(ostream& sout, istream& sinput)
+    {
+        if( !_pworkspaceplanner ) {
+            RAVELOG_WARN("MoveHandStraight has not created a planner yet\n");
+            return false;
+        }
+        return _pworkspaceplanner->SendCommand(sout, sinput);
+    }
+
     bool SetPostProcessingCommand(ostream& sout, istream& sinput)
     {
         if( !getline(sinput, _sPostProcessingParameters) ) {
@@ -1119,6 +1141,8 @@ protected:
     dReal _fMaxVelMult;
     int _minimumgoalpaths;
     string _sPostProcessingParameters;
+    PlannerBasePtr _pworkspaceplanner; ///< planner used by MoveHandStraight, kept for its caches
+    string _strWorkspacePlannerName;
 };
 
 ModuleBasePtr CreateBaseManipulation(EnvironmentBasePtr penv) {
@@ -15,28 +15,28 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "commonmanipulation.h"
 
-/// samples rays from the projected OBB and returns true if the test function returns true
-/// for all the rays. Otherwise, returns false
-/// allowableoutliers - specifies the % of allowable outliying rays
-bool SampleProjectedOBBWithTest(const OBB& obb, dReal delta, const boost::function<bool(const Vector&)>& testfn,dReal allowableocclusion=0)
+/// samples points on the faces of the OBB projected onto the image plane z=1 that are facing the camera
+/// \param[out] vpoints the points on the image plane in the camera coordinate system, appended to
+/// \return the area of the projected faces, used to compute the number of allowable occluded rays
+dReal SampleProjectedOBB(const OBB& obb, dReal delta, std::vector<Vector>& vpoints)
 {
     dReal fscalefactor = 0.95f; // have to make box smaller or else rays might miss
-    Vector vpoints[8] = { obb.pos + fscalefactor*(obb.right*obb.extents.x + obb.up*obb.extents.y + obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(obb.right*obb.extents.x + obb.up*obb.extents.y - obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(obb.right*obb.extents.x - obb.up*obb.extents.y + obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(obb.right*obb.extents.x - obb.up*obb.extents.y - obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(-obb.right*obb.extents.x + obb.up*obb.extents.y + obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(-obb.right*obb.extents.x + obb.up*obb.extents.y - obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(-obb.right*obb.extents.x - obb.up*obb.extents.y + obb.dir*obb.extents.z),
-                          obb.pos + fscalefactor*(-obb.right*obb.extents.x - obb.up*obb.extents.y - obb.dir*obb.extents.z)};
+    Vector vcorners[8] = { obb.pos + fscalefactor*(obb.right*obb.extents.x + obb.up*obb.extents.y + obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(obb.right*obb.extents.x + obb.up*obb.extents.y - obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(obb.right*obb.extents.x - obb.up*obb.extents.y + obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(obb.right*obb.extents.x - obb.up*obb.extents.y - obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(-obb.right*obb.extents.x + obb.up*obb.extents.y + obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(-obb.right*obb.extents.x + obb.up*obb.extents.y - obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(-obb.right*obb.extents.x - obb.up*obb.extents.y + obb.dir*obb.extents.z),
+                           obb.pos + fscalefactor*(-obb.right*obb.extents.x - obb.up*obb.extents.y - obb.dir*obb.extents.z)};
     //    Vector vpoints3d[8];
-    //    for(int j = 0; j < 8; ++j) vpoints3d[j] = tcamera*vpoints[j];
+    //    for(int j = 0; j < 8; ++j) vpoints3d[j] = tcamera*vcorners[j];
 
     for(int i =0; i < 8; ++i) {
-        dReal fz = 1.0f/vpoints[i].z;
-        vpoints[i].x *= fz;
-        vpoints[i].y *= fz;
-        vpoints[i].z = 1;
+        dReal fz = 1.0f/vcorners[i].z;
+        vcorners[i].x *= fz;
+        vcorners[i].y *= fz;
+        vcorners[i].z = 1;
     }
 
     int faceindices[3][4];
@@ -59,25 +59,21 @@ bool SampleProjectedOBBWithTest(const OBB& obb, dReal delta, const boost::functi
         faceindices[2][0] = 0; faceindices[2][1] = 2; faceindices[2][2] = 4; faceindices[2][3] = 6;
     }
 
-    int nallowableoutliers=0;
-    if( allowableocclusion > 0 ) {
-        // have to compute the area of all the faces!
-        dReal farea=0;
-        for(int i = 0; i < 3; ++i) {
-            Vector v0 = vpoints[faceindices[i][0]];
-            Vector v1 = vpoints[faceindices[i][1]]-v0;
-            Vector v2 = vpoints[faceindices[i][2]]-v0;
-            Vector v = v1.cross(v2);
-            farea += v.lengthsqr3();
-        }
-        nallowableoutliers = (int)(allowableocclusion*farea*0.5/(delta*delta));
+    // have to compute the area of all the faces!
+    dReal farea=0;
+    for(int i = 0; i < 3; ++i) {
+        Vector v0 = vcorners[faceindices[i][0]];
+        Vector v1 = vcorners[faceindices[i][1]]-v0;
+        Vector v2 = vcorners[faceindices[i][2]]-v0;
+        Vector v = v1.cross(v2);
+        farea += v.lengthsqr3();
     }
 
     for(int i = 0; i < 3; ++i) {
-        Vector v0 = vpoints[faceindices[i][0]];
-        Vector v1 = vpoints[faceindices[i][1]]-v0;
-        Vector v2 = vpoints[faceindices[i][2]]-v0;
-        Vector v3 = vpoints[faceindices[i][3]]-v0;
+        Vector v0 = vcorners[faceindices[i][0]];
+        Vector v1 = vcorners[faceindices[i][1]]-v0;
+        Vector v2 = vcorners[faceindices[i][2]]-v0;
+        Vector v3 = vcorners[faceindices[i][3]]-v0;
         dReal f3length = RaveSqrt(v3.lengthsqr2());
         Vector v3norm = v3 * (1.0f/f3length);
         Vector v3perp(-v3norm.y,v3norm.x,0,0);
@@ -94,10 +90,7 @@ bool SampleProjectedOBBWithTest(const OBB& obb, dReal delta, const boost::functi
             int numsteps = (int)(ftotalen/delta);
             Vector vdelta = (vcur2-vcur1)*(1.0f/numsteps), vcur = vcur1;
             for(int k = 0; k <= numsteps; ++k, vcur += vdelta) {
-                if( !testfn(vcur) ) {
-                    if( nallowableoutliers-- <= 0 )
-                        return false;
-                }
+                vpoints.push_back(vcur);
             }
         }
 
@@ -120,15 +113,12 @@ bool SampleProjectedOBBWithTest(const OBB& obb, dReal delta, const boost::functi
             int numsteps = (int)(ftotalen/delta);
             Vector vdelta = (vcur2-vcur1)*(1.0f/numsteps), vcur = vcur1;
             for(int k = 0; k <= numsteps; ++k, vcur += vdelta) {
-                if( !testfn(vcur) ) {
-                    if( nallowableoutliers-- <= 0 )
-                        return false;
-                }
+                vpoints.push_back(vcur);
             }
         }
     }
 
-    return true;
+    return farea*0.5;
 }
 
 class VisualFeedback : public ModuleBase
@@ -142,6 +132,14 @@ public:
     }
     friend class VisibilityConstraintFunction;
 
+    /// \brief points sampled on the target OBBs projected into the image of the camera for one camera pose
+    struct TargetRaySamples
+    {
+        std::vector< std::vector<Vector> > vvpoints; ///< for every target OBB, the points on the image plane z=1 of the camera
+        std::vector<dReal> vprojectedareas; ///< for every target OBB, the area of its projection on the image plane
+    };
+    typedef boost::shared_ptr<TargetRaySamples> TargetRaySamplesPtr;
+
     //        void Init(const SensorBase::CameraIntrinsics& KK,int width, int height)
     //    {
     //        ffovx = atanf(0.5f*width/KK.fx);
@@ -330,16 +328,19 @@ public:
         bool IsOccluded(const TransformMatrix& tCameraInTarget)
         {
             KinBody::KinBodyStateSaver saver1(_ptargetbox), saver2(_vf->_target,KinBody::Save_LinkEnable);
-            TransformMatrix tCameraInTargetinv = tCameraInTarget.inverse();
+            TargetRaySamplesPtr samples = _GetRaySamples(tCameraInTarget);
             Transform ttarget = _vf->_target->GetTransform();
             _ptargetbox->SetTransform(ttarget);
-            Transform tworldcamera = ttarget*tCameraInTarget;
+            TransformMatrix tworldcamera = ttarget*tCameraInTarget;
             _ptargetbox->Enable(true);
             //_vf->_target->Enable(false);
             SampleRaysScope srs(*this);
-            FOREACH(itobb,_vTargetOBBs) {
-                OBB cameraobb = geometry::TransformOBB(tCameraInTargetinv,*itobb);
-                if( !SampleProjectedOBBWithTest(cameraobb, _vf->_fSampleRayDensity, boost::bind(&VisibilityConstraintFunction::_TestRay, this, _1, boost::ref(tworldcamera)),_vf->_fAllowableOcclusion) ) {
+            for(size_t iobb = 0; iobb < samples->vvpoints.size(); ++iobb) {
+                int nallowableoutliers = 0;
+                if( _vf->_fAllowableOcclusion > 0 ) {
+                    nallowableoutliers = (int)(_vf->_fAllowableOcclusion*samples->vprojectedareas[iobb]/(_vf->_fSampleRayDensity*_vf->_fSampleRayDensity));
+                }
+                if( !_TestRays(samples->vvpoints[iobb], tworldcamera, false, nallowableoutliers) ) {
                     RAVELOG_VERBOSE("box is occluded\n");
                     return true;
                 }
@@ -363,16 +364,15 @@ public:
                     (*itlink)->SetTransform(tsensorinv*(*itlink)->GetTransform());
                 }
             }
-            TransformMatrix tcamerainv = tcamera.inverse();
+            TargetRaySamplesPtr samples = _GetRaySamples(tcamera);
             Transform ttarget = _vf->_target->GetTransform();
             _ptargetbox->SetTransform(ttarget);
-            Transform tworldcamera = ttarget*tcamera;
+            TransformMatrix tworldcamera = ttarget*tcamera;
             _ptargetbox->Enable(true);
             //_vf->_target->Enable(false);
             SampleRaysScope srs(*this);
-            FOREACH(itobb,_vTargetOBBs) {
-                OBB cameraobb = geometry::TransformOBB(tcamerainv,*itobb);
-                if( !SampleProjectedOBBWithTest(cameraobb, _vf->_fSampleRayDensity, boost::bind(&VisibilityConstraintFunction::_TestRayRigid, this, _1, boost::ref(tworldcamera),boost::ref(vattachedlinks)), 0.0f) ) {
+            FOREACHC(itpoints,samples->vvpoints) {
+                if( !_TestRays(*itpoints, tworldcamera, true, 0) ) {
                     return true;
                 }
             }
@@ -380,39 +380,80 @@ public:
         }
 
 private:
-        bool _TestRay(const Vector& v, const TransformMatrix& tcamera)
+        /// \brief returns the points sampled on the target OBBs projected into the image of a camera
+        ///
+        /// The samples only depend on the pose of the camera relative to the target, so the module caches them for all the constraint functions.
+        /// \param tCameraInTarget in target coordinate system
+        TargetRaySamplesPtr _GetRaySamples(const TransformMatrix& tCameraInTarget)
         {
-            RAY r;
-            dReal filen = 1/RaveSqrt(v.lengthsqr3());
-            r.dir = tcamera.rotate((2.0f*filen)*v);
-            r.pos = tcamera.trans + 0.5f*_vf->_fRayMinDist*r.dir;         // move the rays a little forward
-            if( !_vf->_robot->GetEnv()->CheckCollision(r,_report) ) {
-                return true;         // not supposed to happen, but it is OK
-            }
-
-            //            RaveVector<float> vpoints[2];
-            //            vpoints[0] = r.pos;
-            //            vpoints[1] = _report.contacts[0].pos;
-            //            _vf->_robot->GetEnv()->drawlinestrip(vpoints[0],2,16,1.0f,Vector(0,0,1));
-            if( !(!!_report->plink1 &&( _report->plink1->GetParent() == _ptargetbox) ) ) {
-                if( _report->contacts.size() > 0 ) {
-                    Vector v = _report->contacts.at(0).pos;
-                    RAVELOG_VERBOSE_FORMAT("bad collision: %s: %f %f %f", _report->__str__()%v.x%v.y%v.z);
+            _vf->_ValidateTargetRaySamples(_vTargetOBBs);
+            std::vector<int> vkey(12);
+            for(int i = 0; i < 3; ++i) {
+                for(int j = 0; j < 3; ++j) {
+                    vkey[3*i+j] = (int)floor(tCameraInTarget.m[4*i+j]*1e5+0.5);
                 }
-                else {
-                    RAVELOG_VERBOSE_FORMAT("bad collision: %s", _report->__str__());
+            }
+            vkey[9] = (int)floor(tCameraInTarget.trans.x*1e5+0.5);
+            vkey[10] = (int)floor(tCameraInTarget.trans.y*1e5+0.5);
+            vkey[11] = (int)floor(tCameraInTarget.trans.z*1e5+0.5);
+            std::map<std::vector<int>, TargetRaySamplesPtr>::iterator it = _vf->_mapTargetRaySamples.find(vkey);
+            if( it != _vf->_mapTargetRaySamples.end() ) {
+                return it->second;
+            }
+
+            TargetRaySamplesPtr samples(new TargetRaySamples());
+            TransformMatrix tCameraInTargetinv = tCameraInTarget.inverse();
+            samples->vvpoints.resize(_vTargetOBBs.size());
+            samples->vprojectedareas.resize(_vTargetOBBs.size());
+            for(size_t iobb = 0; iobb < _vTargetOBBs.size(); ++iobb) {
+                OBB cameraobb = geometry::TransformOBB(tCameraInTargetinv,_vTargetOBBs[iobb]);
+                samples->vprojectedareas[iobb] = SampleProjectedOBB(cameraobb, _vf->_fSampleRayDensity, samples->vvpoints[iobb]);
+            }
+            if( _vf->_nMaxTargetRaySamples > 0 ) {
+                if( _vf->_mapTargetRaySamples.size() >= _vf->_nMaxTargetRaySamples ) {
+                    _vf->_mapTargetRaySamples.clear();
                 }
+                _vf->_mapTargetRaySamples[vkey] = samples;
             }
-            return !!_report->plink1 && _report->plink1->GetParent() == _ptargetbox;
+            return samples;
         }
 
-        bool _TestRayRigid(const Vector& v, const TransformMatrix& tcamera, const vector<KinBody::LinkPtr>& vattachedlinks)
+        /// \brief shoots rays from the camera through the image points and returns false if more than nallowableoutliers rays are blocked
+        ///
+        /// The rays are checked in blocks so that occluded targets are rejected without checking all their rays.
+        /// \param bRigid if true, the rays are in the camera coordinate system and can only be blocked by the robot, otherwise any hit that is not the target box blocks a ray.
+        bool _TestRays(const std::vector<Vector>& vpoints, const TransformMatrix& tcamera, bool bRigid, int nallowableoutliers)
         {
-            dReal filen = 1/RaveSqrt(v.lengthsqr3());
-            RAY r((_vf->_fRayMinDist*filen)*v,(2.0f*filen)*v);
-            if( _vf->_robot->GetEnv()->CheckCollision(r,KinBodyConstPtr(_vf->_robot),_report) ) {
-                //RAVELOG_INFO(str(boost::format("ray col: %s\n")%_report->__str__()));
-                return false;
+            CollisionCheckerBasePtr pchecker = _vf->GetEnv()->GetCollisionChecker();
+            const size_t nblocksize = 64;
+            for(size_t istart = 0; istart < vpoints.size(); istart += nblocksize) {
+                _vrays.resize(min(nblocksize, vpoints.size()-istart));
+                for(size_t i = 0; i < _vrays.size(); ++i) {
+                    const Vector& v = vpoints[istart+i];
+                    dReal filen = 1/RaveSqrt(v.lengthsqr3());
+                    if( bRigid ) {
+                        _vrays[i].pos = (_vf->_fRayMinDist*filen)*v;
+                        _vrays[i].dir = (2.0f*filen)*v;
+                    }
+                    else {
+                        _vrays[i].dir = tcamera.rotate((2.0f*filen)*v);
+                        _vrays[i].pos = tcamera.trans + 0.5f*_vf->_fRayMinDist*_vrays[i].dir;         // move the rays a little forward
+                    }
+                }
+                pchecker->CheckCollisionRays(_vrays, bRigid ? KinBodyConstPtr(_vf->_robot) : KinBodyConstPtr(), _vhitlinks, _vcontacts);
+                for(size_t i = 0; i < _vrays.size(); ++i) {
+                    // a ray not hitting anything is not supposed to happen, but it is OK
+                    if( !_vhitlinks[i] || (!bRigid && _vhitlinks[i]->GetParent() == _ptargetbox) ) {
+                        continue;
+                    }
+                    if( !bRigid ) {
+                        Vector v = _vcontacts[i].pos;
+                        RAVELOG_VERBOSE_FORMAT("bad collision: %s:%s: %f %f %f", _vhitlinks[i]->GetParent()->GetName()%_vhitlinks[i]->GetName()%v.x%v.y%v.z);
+                    }
+                    if( nallowableoutliers-- <= 0 ) {
+                        return false;
+                    }
+                }
             }
             return true;
         }
@@ -450,6 +491,9 @@ private:
         vector<dReal> _vsolution;
         IkReturnPtr _ikreturn;
         CollisionReportPtr _report;
+        vector<RAY> _vrays;
+        vector<KinBody::LinkConstPtr> _vhitlinks;
+        vector<CollisionReport::CONTACT> _vcontacts;
         AABB _abTarget;         // target aabb
         vector<Vector> _vconvexplanes3d;
     };
@@ -521,6 +565,8 @@ Visibility computation checks occlusion with other objects using ray sampling in
         _fSampleRayDensity = 0.001;
         _fAllowableOcclusion = 0.1;
         _fRayMinDist = 0.02f;
+        _nMaxTargetRaySamples = 1000;
+        _fTargetRaySamplesDensity = 0;
 
         RegisterCommand("SetCameraAndTarget",boost::bind(&VisualFeedback::SetCameraAndTarget,this,_1,_2),
                         "Sets the camera index from the robot and its convex hull");
@@ -559,6 +605,8 @@ Visibility computation checks occlusion with other objects using ray sampling in
         _visibilitytransforms.clear();
         _pconstraintfn.reset();
         _preport.reset();
+        _mapTargetRaySamples.clear();
+        _vTargetRaySamplesOBBs.clear();
         ModuleBase::Destroy();
     }
 
@@ -1060,6 +1108,10 @@ Visibility computation checks occlusion with other objects using ray sampling in
             else if( cmd == "allowableocclusion" ) {
                 sinput >> _fAllowableOcclusion;
             }
+            else if( cmd == "raycachesize" ) {
+                sinput >> _nMaxTargetRaySamples;
+                _mapTargetRaySamples.clear();
+            }
             else {
                 RAVELOG_WARN(str(boost::format("unrecognized command: %s\n")%cmd));
                 break;
@@ -1411,6 +1463,21 @@ Visibility computation checks occlusion with other objects using ray sampling in
     }
 
 protected:
+    /// \brief clears the cached ray samples if they were sampled from different target OBBs or with a different ray density
+    void _ValidateTargetRaySamples(const std::vector<OBB>& vTargetOBBs)
+    {
+        bool bValid = _fTargetRaySamplesDensity == _fSampleRayDensity && _vTargetRaySamplesOBBs.size() == vTargetOBBs.size();
+        for(size_t i = 0; i < vTargetOBBs.size() && bValid; ++i) {
+            const OBB& obb0 = _vTargetRaySamplesOBBs[i], &obb1 = vTargetOBBs[i];
+            bValid = (obb0.pos-obb1.pos).lengthsqr3() == 0 && (obb0.extents-obb1.extents).lengthsqr3() == 0 && (obb0.right-obb1.right).lengthsqr3() == 0 && (obb0.up-obb1.up).lengthsqr3() == 0 && (obb0.dir-obb1.dir).lengthsqr3() == 0;
+        }
+        if( !bValid ) {
+            _mapTargetRaySamples.clear();
+            _vTargetRaySamplesOBBs = vTargetOBBs;
+            _fTargetRaySamplesDensity = _fSampleRayDensity;
+        }
+    }
+
     RobotBasePtr _robot, _sensorrobot;
     bool _bIgnoreSensorCollision; ///< if true will ignore any collisions with vf->_sensorrobot
     KinBodyPtr _target; ///< the target to check visibility for. Only links that are visible are checked
@@ -1427,6 +1494,11 @@ protected:
 
     boost::shared_ptr<VisibilityConstraintFunction> _pconstraintfn;
 
+    std::map<std::vector<int>, TargetRaySamplesPtr> _mapTargetRaySamples; ///< cached ray samples indexed by the quantized camera pose in the target coordinate system
+    std::vector<OBB> _vTargetRaySamplesOBBs; ///< target OBBs that _mapTargetRaySamples was sampled from
+    dReal _fTargetRaySamplesDensity; ///< ray density that _mapTargetRaySamples was sampled with
+    size_t _nMaxTargetRaySamples; ///< maximum number of camera poses to cache samples for, 0 disables caching
+
     vector<Vector> _vconvexplanes;     ///< the planes defining the bounding visibility region (posive is inside)
     Vector _vcenterconvex;     ///< center point on the z=1 plane of the convex region
 };
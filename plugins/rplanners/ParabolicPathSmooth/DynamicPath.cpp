@@ -71,7 +71,7 @@ inline Real MaxBBLInfDistance(const Vector& x,const Vector& bmin,const Vector& b
     return d;
 }
 
-bool SolveMinTime(const Vector& x0,const Vector& dx0,const Vector& x1,const Vector& dx1, const Vector& accMax,const Vector& velMax,const Vector& xMin,const Vector& xMax,DynamicPath& out, int multidofinterp)
+bool SolveMinTime(const Vector& x0,const Vector& dx0,const Vector& x1,const Vector& dx1, const Vector& accMax,const Vector& velMax,const Vector& xMin,const Vector& xMax,DynamicPath& out, int multidofinterp, Real maxEndTime)
 {
     if(xMin.empty()) {
         out.ramps.resize(1);
@@ -86,6 +86,20 @@ bool SolveMinTime(const Vector& x0,const Vector& dx0,const Vector& x1,const Vect
         }
     }
     else {
+        if( maxEndTime < Inf ) {
+            // the min time of every dof without the joint limits and the other dofs is a lower bound of the synchronized time.
+            // only reject when clearly above maxEndTime, the caller compares the total time of the combined ramps which can differ by round-off
+            ParabolicRamp1D temp;
+            for(size_t i = 0; i < x0.size(); ++i) {
+                temp.x0 = x0[i];
+                temp.dx0 = dx0[i];
+                temp.x1 = x1[i];
+                temp.dx1 = dx1[i];
+                if( temp.SolveMinTime(accMax[i],velMax[i]) && temp.ttotal > maxEndTime+EpsilonT ) {
+                    return false;
+                }
+            }
+        }
         vector<std::vector<ParabolicRamp1D> > ramps;
         Real res=SolveMinTimeBounded(x0,dx0,x1,dx1, accMax,velMax,xMin,xMax, ramps,multidofinterp);
         if(res < 0) {
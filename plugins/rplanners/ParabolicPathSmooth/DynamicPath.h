@@ -186,7 +186,9 @@ public:
     int _multidofinterp; ///< if true, will always force the max acceleration of the robot when retiming rather than using lesser acceleration whenever possible
 };
 
-bool SolveMinTime(const Vector& x0,const Vector& dx0,const Vector& x1,const Vector& dx1, const Vector& accMax,const Vector& velMax,const Vector& xMin,const Vector& xMax,DynamicPath& out, int multidofinterp);
+/// \brief solves the min time ramps from x0,dx0 to x1,dx1. If xMin is not empty, the ramps stay within the joint limits.
+/// \param maxEndTime with joint limits, fails early without synchronizing the dofs if the time is sure to be greater than this
+bool SolveMinTime(const Vector& x0,const Vector& dx0,const Vector& x1,const Vector& dx1, const Vector& accMax,const Vector& velMax,const Vector& xMin,const Vector& xMax,DynamicPath& out, int multidofinterp, Real maxEndTime=Inf);
 
 } //namespace ParabolicRamp
 
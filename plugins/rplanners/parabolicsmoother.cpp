@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "openraveplugindefs.h"
 #include <fstream>
+#include <boost/thread/condition.hpp>
 
 #include <openrave/planningutils.h>
 
@@ -171,8 +172,39 @@ private:
         std::vector<ParabolicRamp::ParabolicRampND> segmentoutramps;
     };
 
+    /// \brief a cloned environment and smoother that checks shortcut candidates for _ShortcutParallel
+    struct ShortcutWorker
+    {
+        EnvironmentBasePtr penv;
+        ConstraintTrajectoryTimingParametersPtr parameters; ///< parameters bound to the bodies of penv
+        boost::shared_ptr<ParabolicSmoother> smoother;
+        boost::shared_ptr<boost::thread> pthread; ///< runs _ShortcutWorkerLoop, not set for the first worker since it is run by the planning thread
+    };
+    typedef boost::shared_ptr<ShortcutWorker> ShortcutWorkerPtr;
+
+    /// \brief the data shared by all the workers of one _ShortcutParallel round
+    struct ShortcutRound
+    {
+        ShortcutRound() : pramps(NULL), prampStartTime(NULL), mintimestep(0), fstarttimemult(1) {
+        }
+        const std::vector<ParabolicRamp::ParabolicRampND>* pramps;
+        const std::vector<dReal>* prampStartTime;
+        dReal mintimestep, fstarttimemult;
+    };
+
+    /// \brief one shortcut window checked by a worker
+    struct ShortcutCandidate
+    {
+        dReal t1, t2; ///< the time window to shortcut
+        int iter; ///< the shortcut iteration
+        int retcode; ///< return of _ComputeShortcut
+        dReal fcurmult; ///< velocity/acceleration multiplier of outramps
+        int numslowdowns;
+        std::vector<ParabolicRamp::ParabolicRampND> outramps; ///< the ramps that replace [t1, t2]
+    };
+
 public:
-    ParabolicSmoother(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _feasibilitychecker(this)
+    ParabolicSmoother(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _feasibilitychecker(this), _nShortcutRound(0), _nShortcutPending(0), _bStopShortcutWorkers(false)
     {
         __description = ":Interface Author: Rosen Diankov\n\nInterface to `Indiana University Intelligent Motion Laboratory <http://www.iu.edu/~motion/software.html>`_ parabolic smoothing library (Kris Hauser).\n\n**Note:** The original trajectory will not be preserved at all, don't use this if the robot has to hit all points of the trajectory.\n";
         _bmanipconstraints = false;
@@ -183,6 +215,11 @@ public:
         }
     }
 
+    virtual ~ParabolicSmoother()
+    {
+        _DestroyShortcutWorkers();
+    }
+
     virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
     {
         EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
@@ -398,7 +435,12 @@ public:
             if( !!parameters->_setstatevaluesfn || !!parameters->_setstatefn ) {
                 // no idea what a good mintimestep is... _parameters->_fStepLength*0.5?
                 //numshortcuts = dynamicpath.Shortcut(parameters->_nMaxIterations,_feasibilitychecker,this, parameters->_fStepLength*0.99);
-                numshortcuts = _Shortcut(dynamicpath, parameters->_nMaxIterations,this, parameters->_fStepLength*0.99);
+                if( _InitShortcutWorkers(parameters->nshortcutthreads) ) {
+                    numshortcuts = _ShortcutParallel(dynamicpath, parameters->_nMaxIterations,this, parameters->_fStepLength*0.99);
+                }
+                else {
+                    numshortcuts = _Shortcut(dynamicpath, parameters->_nMaxIterations,this, parameters->_fStepLength*0.99);
+                }
                 if( numshortcuts < 0 ) {
                     return PS_Interrupted;
                 }
@@ -934,19 +976,15 @@ protected:
             rampStartTime[i] = endTime;
             endTime += ramps[i].endTime;
         }
-        ParabolicRamp::Vector x0, x1, dx0, dx1;
-        ParabolicRamp::DynamicPath &intermediate=_cacheintermediate, &intermediate2=_cacheintermediate2;
-        std::vector<dReal>& vellimits=_cachevellimits, &accellimits=_cacheaccellimits;
-        vellimits.resize(_parameters->_vConfigVelocityLimit.size());
-        accellimits.resize(_parameters->_vConfigAccelerationLimit.size());
-        std::vector<ParabolicRamp::ParabolicRampND>& accumoutramps=_cacheaccumoutramps, &outramps=_cacheoutramps;
+        std::vector<ParabolicRamp::ParabolicRampND>& accumoutramps=_cacheaccumoutramps;
 
         int numslowdowns = 0; // total number of times a ramp has been slowed down.
-        
+
         dReal fiSearchVelAccelMult = 1.0/_parameters->fSearchVelAccelMult; // for slowing down when timing constraints
         dReal fstarttimemult = 1.0; // the start velocity/accel multiplier for the velocity and acceleration computations. If manip speed/accel or dynamics constraints are used, then this will track the last successful multipler. Basically if the last successful one is 0.1, it's very unlikely than a muliplier of 0.8 will meet the constraints the next time.
         int iters=0;
         for(iters=0; iters<numIters; iters++) {
+            OPENRAVE_PROFILE_SCOPE("ParabolicSmoother::ShortcutIteration");
             dReal t1=rng->Rand()*endTime,t2=rng->Rand()*endTime;
             if( iters == 0 ) {
                 t1 = 0;
@@ -955,239 +993,556 @@ protected:
             if(t1 > t2) {
                 ParabolicRamp::Swap(t1,t2);
             }
-            int i1 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t1)-rampStartTime.begin()-1;
-            int i2 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t2)-rampStartTime.begin()-1;
-            // i1 can be equal to i2 and that is valid and should be rechecked again
-            
-            uint32_t iIterProgress = 0; // used for debug purposes
+
+            dReal fcurmult = fstarttimemult;
+            int ret = _ComputeShortcut(ramps, rampStartTime, t1, t2, mintimestep, fstarttimemult, iters, true, accumoutramps, fcurmult, numslowdowns);
+            if( ret < 0 ) {
+                return -1;
+            }
+            if( ret == 0 ) {
+                continue;
+            }
+            fstarttimemult = min(1.0, fcurmult*fiSearchVelAccelMult); // the new start time mult should be increased by one timemult
+
             try {
-                //same ramp
-                dReal u1 = t1-rampStartTime.at(i1); // at the same time check for boundaries
-                dReal u2 = t2-rampStartTime.at(i2); // at the same time check for boundaries
-                OPENRAVE_ASSERT_OP(u1, >=, 0);
-                OPENRAVE_ASSERT_OP(u1, <=, ramps[i1].endTime+ParabolicRamp::EpsilonT);
-                OPENRAVE_ASSERT_OP(u2, >=, 0);
-                OPENRAVE_ASSERT_OP(u2, <=, ramps[i2].endTime+ParabolicRamp::EpsilonT);
-                u1 = ParabolicRamp::Min(u1,ramps[i1].endTime);
-                u2 = ParabolicRamp::Min(u2,ramps[i2].endTime);
-                ramps[i1].Evaluate(u1,x0);
-                if( _parameters->SetStateValues(x0) != 0 ) {
-                    continue;
+                _ApplyShortcut(ramps, rampStartTime, t1, t2, accumoutramps);
+                shortcuts++;
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, exception happened during shortcut iteration %d: %s", GetEnv()->GetId()%iters%ex.what());
+            }
+
+            //revise the timing
+            rampStartTime.resize(ramps.size());
+            endTime=0;
+            for(size_t i=0; i<ramps.size(); i++) {
+                rampStartTime[i] = endTime;
+                endTime += ramps[i].endTime;
+            }
+            RAVELOG_VERBOSE_FORMAT("shortcut iter=%d slowdowns=%d, endTime=%f",iters%numslowdowns%endTime);
+        }
+
+        RAVELOG_VERBOSE_FORMAT("finished at shortcut iter=%d slowdowns=%d, endTime=%f",iters%numslowdowns%endTime);
+        return shortcuts;
+    }
+
+    /// \brief same as _Shortcut except several shortcut candidates are checked speculatively at the same time by _vshortcutworkers.
+    ///
+    /// Every round samples one candidate time window per worker from rng in the same order as _Shortcut. After all workers finish, the
+    /// successful candidates whose windows do not overlap an earlier successful candidate of the same round are committed. Since the
+    /// selection only depends on the candidate order, the result is deterministic for a fixed seed and number of workers.
+    int _ShortcutParallel(ParabolicRamp::DynamicPath& dynamicpath, int numIters, ParabolicRamp::RandomNumberGeneratorBase* rng, dReal mintimestep)
+    {
+        std::vector<ParabolicRamp::ParabolicRampND>& ramps = dynamicpath.ramps;
+        int shortcuts = 0;
+        vector<dReal> rampStartTime(ramps.size());
+        dReal endTime=0;
+        for(size_t i=0; i<ramps.size(); i++) {
+            rampStartTime[i] = endTime;
+            endTime += ramps[i].endTime;
+        }
+
+        int numslowdowns = 0;
+        dReal fiSearchVelAccelMult = 1.0/_parameters->fSearchVelAccelMult;
+        dReal fstarttimemult = 1.0;
+        std::vector<ShortcutCandidate>& vcandidates = _cacheshortcutcandidates;
+        std::vector<size_t> vcommitted;
+        int iters=0;
+        while(iters < numIters) {
+            OPENRAVE_PROFILE_SCOPE("ParabolicSmoother::ShortcutBatch");
+            size_t numcandidates = min(_vshortcutworkers.size(), (size_t)(numIters-iters));
+            vcandidates.resize(numcandidates);
+            for(size_t icandidate = 0; icandidate < numcandidates; ++icandidate) {
+                ShortcutCandidate& candidate = vcandidates[icandidate];
+                candidate.t1 = rng->Rand()*endTime;
+                candidate.t2 = rng->Rand()*endTime;
+                if( iters+icandidate == 0 ) {
+                    candidate.t1 = 0;
+                    candidate.t2 = endTime;
                 }
-                iIterProgress += 0x10000000;
-                _parameters->_getstatefn(x0);
-                iIterProgress += 0x10000000;
-                ramps[i2].Evaluate(u2,x1);
-                iIterProgress += 0x10000000;
-                if( _parameters->SetStateValues(x1) != 0 ) {
-                    continue;
+                if( candidate.t1 > candidate.t2 ) {
+                    ParabolicRamp::Swap(candidate.t1,candidate.t2);
                 }
-                iIterProgress += 0x10000000;
-                _parameters->_getstatefn(x1);
-                ramps[i1].Derivative(u1,dx0);
-                ramps[i2].Derivative(u2,dx1);
-                ++_progress._iteration;
+                candidate.iter = iters+icandidate;
+                candidate.fcurmult = fstarttimemult;
+                candidate.numslowdowns = 0;
+                candidate.retcode = 0;
+            }
 
-                bool bsuccess = false;
+            // wake up the pooled workers, the first candidate is checked by the calling thread
+            {
+                boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+                _shortcutround.pramps = &ramps;
+                _shortcutround.prampStartTime = &rampStartTime;
+                _shortcutround.mintimestep = mintimestep;
+                _shortcutround.fstarttimemult = fstarttimemult;
+                _nShortcutPending = _vshortcutworkers.size()-1;
+                ++_nShortcutRound;
+                _condShortcutStart.notify_all();
+            }
+            _ShortcutWorkerThread(_vshortcutworkers[0], ramps, rampStartTime, mintimestep, fstarttimemult, vcandidates[0]);
+            {
+                boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+                while(_nShortcutPending > 0) {
+                    _condShortcutDone.wait(lock);
+                }
+            }
+            iters += numcandidates;
+            _progress._iteration += numcandidates;
+            if( _CallCallbacks(_progress) == PA_Interrupt ) {
+                return -1;
+            }
 
-                vellimits = _parameters->_vConfigVelocityLimit;
-                accellimits = _parameters->_vConfigAccelerationLimit;
-                if( _bmanipconstraints && !!_manipconstraintchecker ) {
-                    if( _parameters->SetStateValues(x0) != 0 ) {
-                        RAVELOG_VERBOSE("state set error\n");
-                        continue;
-                    }
-                    _manipconstraintchecker->GetMaxVelocitiesAccelerations(dx0, vellimits, accellimits);
-                    if( _parameters->SetStateValues(x1) != 0 ) {
-                        RAVELOG_VERBOSE("state set error\n");
-                        continue;
-                    }
-                    _manipconstraintchecker->GetMaxVelocitiesAccelerations(dx1, vellimits, accellimits);
+            // choose the non-overlapping successful candidates in candidate order
+            vcommitted.resize(0);
+            for(size_t icandidate = 0; icandidate < numcandidates; ++icandidate) {
+                const ShortcutCandidate& candidate = vcandidates[icandidate];
+                numslowdowns += candidate.numslowdowns;
+                if( candidate.retcode <= 0 ) {
+                    continue;
                 }
-                for(size_t j = 0; j < _parameters->_vConfigVelocityLimit.size(); ++j) {
-                    // have to watch out that velocities don't drop under dx0 & dx1!
-                    dReal fminvel = max(RaveFabs(dx0[j]), RaveFabs(dx1[j]));
-                    if( vellimits[j] < fminvel ) {
-                        vellimits[j] = fminvel;
+                bool boverlaps = false;
+                FOREACHC(itcommitted, vcommitted) {
+                    if( candidate.t1 < vcandidates[*itcommitted].t2 && vcandidates[*itcommitted].t1 < candidate.t2 ) {
+                        boverlaps = true;
+                        break;
                     }
-                    else {
-                        dReal f = max(fminvel, _parameters->_vConfigVelocityLimit[j]*fstarttimemult);
-                        if( vellimits[j] > f ) {
-                            vellimits[j] = f;
-                        }
+                }
+                if( !boverlaps ) {
+                    vcommitted.push_back(icandidate);
+                    fstarttimemult = min(1.0, candidate.fcurmult*fiSearchVelAccelMult);
+                }
+            }
+            if( vcommitted.size() == 0 ) {
+                continue;
+            }
+
+            // apply the latest windows first so that the times of the earlier windows stay valid
+            std::sort(vcommitted.begin(), vcommitted.end(), boost::bind(&ParabolicSmoother::_CompareCandidateStartTimes, boost::cref(vcandidates), _1, _2));
+            FOREACHC(itcommitted, vcommitted) {
+                const ShortcutCandidate& candidate = vcandidates[*itcommitted];
+                try {
+                    _ApplyShortcut(ramps, rampStartTime, candidate.t1, candidate.t2, candidate.outramps);
+                    shortcuts++;
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_WARN_FORMAT("env=%d, exception happened during shortcut iteration %d: %s", GetEnv()->GetId()%candidate.iter%ex.what());
+                }
+            }
+
+            rampStartTime.resize(ramps.size());
+            endTime=0;
+            for(size_t i=0; i<ramps.size(); i++) {
+                rampStartTime[i] = endTime;
+                endTime += ramps[i].endTime;
+            }
+            RAVELOG_VERBOSE_FORMAT("env=%d, shortcut iter=%d committed %d/%d candidates, slowdowns=%d, endTime=%f", GetEnv()->GetId()%iters%vcommitted.size()%numcandidates%numslowdowns%endTime);
+        }
+
+        RAVELOG_VERBOSE_FORMAT("finished at shortcut iter=%d slowdowns=%d, endTime=%f",iters%numslowdowns%endTime);
+        return shortcuts;
+    }
+
+    /// \brief sorts candidate indices by decreasing start time
+    static bool _CompareCandidateStartTimes(const std::vector<ShortcutCandidate>& vcandidates, size_t index0, size_t index1)
+    {
+        return vcandidates[index0].t1 > vcandidates[index1].t1;
+    }
+
+    /// \brief checks one shortcut candidate with the smoother of the worker. Called from the worker threads.
+    void _ShortcutWorkerThread(ShortcutWorkerPtr worker, const std::vector<ParabolicRamp::ParabolicRampND>& ramps, const std::vector<dReal>& rampStartTime, dReal mintimestep, dReal fstarttimemult, ShortcutCandidate& candidate)
+    {
+        EnvironmentMutex::scoped_lock lock(worker->penv->GetMutex());
+        candidate.fcurmult = fstarttimemult;
+        try {
+            candidate.retcode = worker->smoother->_ComputeShortcut(ramps, rampStartTime, candidate.t1, candidate.t2, mintimestep, fstarttimemult, candidate.iter, false, candidate.outramps, candidate.fcurmult, candidate.numslowdowns);
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%d, exception happened during shortcut iteration %d: %s", GetEnv()->GetId()%candidate.iter%ex.what());
+            candidate.retcode = 0;
+        }
+    }
+
+    /// \brief pooled thread of the worker iworker. Checks the candidate iworker of every _ShortcutParallel round until _StopShortcutThreads is called.
+    ///
+    /// \param nround the round that was started last when the thread was created
+    void _ShortcutWorkerLoop(size_t iworker, int nround)
+    {
+        while(1) {
+            {
+                boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+                while(!_bStopShortcutWorkers && _nShortcutRound == nround) {
+                    _condShortcutStart.wait(lock);
+                }
+                if( _bStopShortcutWorkers ) {
+                    break;
+                }
+                nround = _nShortcutRound;
+            }
+            // the last round can have less candidates than workers
+            if( iworker < _cacheshortcutcandidates.size() ) {
+                _ShortcutWorkerThread(_vshortcutworkers.at(iworker), *_shortcutround.pramps, *_shortcutround.prampStartTime, _shortcutround.mintimestep, _shortcutround.fstarttimemult, _cacheshortcutcandidates[iworker]);
+            }
+            {
+                boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+                if( --_nShortcutPending == 0 ) {
+                    _condShortcutDone.notify_all();
+                }
+            }
+        }
+    }
+
+    /// \brief stops and joins the pooled threads of _vshortcutworkers
+    void _StopShortcutThreads()
+    {
+        {
+            boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+            _bStopShortcutWorkers = true;
+            _condShortcutStart.notify_all();
+        }
+        FOREACH(itworker, _vshortcutworkers) {
+            if( !!*itworker && !!(*itworker)->pthread ) {
+                (*itworker)->pthread->join();
+                (*itworker)->pthread.reset();
+            }
+        }
+        _bStopShortcutWorkers = false;
+    }
+
+    /// \brief stops the pooled threads and destroys the cloned environments of the workers
+    void _DestroyShortcutWorkers()
+    {
+        _StopShortcutThreads();
+        FOREACH(itworker, _vshortcutworkers) {
+            if( !!*itworker ) {
+                (*itworker)->smoother.reset();
+                (*itworker)->parameters.reset();
+                if( !!(*itworker)->penv ) {
+                    (*itworker)->penv->Destroy();
+                    (*itworker)->penv.reset();
+                }
+            }
+        }
+        _vshortcutworkers.clear();
+    }
+
+    /// \brief prepares one cloned environment and smoother per thread for _ShortcutParallel.
+    ///
+    /// The environments and threads are kept between calls and the environments are only resynchronized with the current environment.
+    /// The planner parameters are bound to the cloned bodies with SetConfigurationSpecification, so custom functions of the parameters
+    /// and checks registered with DynamicsCollisionConstraint::SetUserCheckFunction are not seen by the workers (see ConstraintTrajectoryTimingParameters::nshortcutthreads).
+    /// \return true if the workers are ready
+    bool _InitShortcutWorkers(int numthreads)
+    {
+        if( numthreads <= 1 ) {
+            _DestroyShortcutWorkers();
+            return false;
+        }
+        if( !!_parameters->_setstatefn ) {
+            RAVELOG_DEBUG_FORMAT("env=%d, planner parameters use the deprecated _setstatefn, so shortcutting serially", GetEnv()->GetId());
+            _DestroyShortcutWorkers();
+            return false;
+        }
+        if( _vshortcutworkers.size() != (size_t)numthreads ) {
+            _StopShortcutThreads();
+            for(size_t iworker = numthreads; iworker < _vshortcutworkers.size(); ++iworker) {
+                if( !!_vshortcutworkers[iworker] && !!_vshortcutworkers[iworker]->penv ) {
+                    _vshortcutworkers[iworker]->smoother.reset();
+                    _vshortcutworkers[iworker]->penv->Destroy();
+                }
+            }
+            _vshortcutworkers.resize(numthreads);
+        }
+        RAVELOG_DEBUG_FORMAT("env=%d, shortcutting with %d threads, custom functions of the planner parameters and user check functions are not seen by the workers", GetEnv()->GetId()%numthreads);
+        FOREACH(itworker, _vshortcutworkers) {
+            if( !*itworker ) {
+                itworker->reset(new ShortcutWorker());
+            }
+            ShortcutWorker& worker = **itworker;
+            try {
+                if( !worker.penv ) {
+                    worker.penv = GetEnv()->CloneSelf(Clone_Bodies);
+                }
+                else {
+                    worker.penv->Clone(GetEnv(), Clone_Bodies);
+                }
+                // the simulation thread would only compete with the worker for the environment lock
+                worker.penv->StopSimulation();
+                EnvironmentMutex::scoped_lock lock(worker.penv->GetMutex());
+                worker.parameters.reset(new ConstraintTrajectoryTimingParameters());
+                worker.parameters->copy(_parameters);
+                worker.parameters->SetConfigurationSpecification(worker.penv, _parameters->_configurationspecification);
+                // SetConfigurationSpecification resets the limits to the body limits, so restore the ones the user passed in
+                worker.parameters->_vConfigLowerLimit = _parameters->_vConfigLowerLimit;
+                worker.parameters->_vConfigUpperLimit = _parameters->_vConfigUpperLimit;
+                worker.parameters->_vConfigVelocityLimit = _parameters->_vConfigVelocityLimit;
+                worker.parameters->_vConfigAccelerationLimit = _parameters->_vConfigAccelerationLimit;
+                worker.parameters->_vConfigResolution = _parameters->_vConfigResolution;
+                if( !worker.smoother ) {
+                    std::stringstream ssempty;
+                    worker.smoother.reset(new ParabolicSmoother(worker.penv, ssempty));
+                }
+                if( !worker.smoother->InitPlan(RobotBasePtr(), worker.parameters) ) {
+                    RAVELOG_WARN_FORMAT("env=%d, failed to init shortcut worker, so shortcutting serially", GetEnv()->GetId());
+                    _DestroyShortcutWorkers();
+                    return false;
+                }
+                worker.smoother->_feasibilitychecker.tol = _feasibilitychecker.tol;
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to init shortcut worker, so shortcutting serially: %s", GetEnv()->GetId()%ex.what());
+                _DestroyShortcutWorkers();
+                return false;
+            }
+        }
+
+        int nround;
+        {
+            boost::mutex::scoped_lock lock(_mutexShortcutWorkers);
+            nround = _nShortcutRound;
+        }
+        for(size_t iworker = 1; iworker < _vshortcutworkers.size(); ++iworker) {
+            if( !_vshortcutworkers[iworker]->pthread ) {
+                _vshortcutworkers[iworker]->pthread.reset(new boost::thread(boost::bind(&ParabolicSmoother::_ShortcutWorkerLoop, this, iworker, nround)));
+            }
+        }
+        return true;
+    }
+
+    /// \brief checks if the ramps between t1 and t2 can be replaced by a faster ramp that satisfies all the constraints. ramps is not modified.
+    ///
+    /// \param iters the shortcut iteration, only used for logging
+    /// \param bcallcallbacks if true, will call the planner callbacks. Should be false when called from a worker thread
+    /// \param accumoutramps if successful, the ramps that replace [t1, t2]
+    /// \param fcurmult the velocity/acceleration multiplier of the found ramps
+    /// \return 1 if a shortcut was found, 0 if rejected, -1 if interrupted
+    int _ComputeShortcut(const std::vector<ParabolicRamp::ParabolicRampND>& ramps, const std::vector<dReal>& rampStartTime, dReal t1, dReal t2, dReal mintimestep, dReal fstarttimemult, int iters, bool bcallcallbacks, std::vector<ParabolicRamp::ParabolicRampND>& accumoutramps, dReal& fcurmult, int& numslowdowns)
+    {
+        ParabolicRamp::Vector x0, x1, dx0, dx1;
+        ParabolicRamp::DynamicPath &intermediate=_cacheintermediate, &intermediate2=_cacheintermediate2;
+        std::vector<dReal>& vellimits=_cachevellimits, &accellimits=_cacheaccellimits;
+        vellimits.resize(_parameters->_vConfigVelocityLimit.size());
+        accellimits.resize(_parameters->_vConfigAccelerationLimit.size());
+        std::vector<ParabolicRamp::ParabolicRampND>& outramps=_cacheoutramps;
+
+        int i1 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t1)-rampStartTime.begin()-1;
+        int i2 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t2)-rampStartTime.begin()-1;
+        // i1 can be equal to i2 and that is valid and should be rechecked again
+
+        uint32_t iIterProgress = 0; // used for debug purposes
+        try {
+            //same ramp
+            dReal u1 = t1-rampStartTime.at(i1); // at the same time check for boundaries
+            dReal u2 = t2-rampStartTime.at(i2); // at the same time check for boundaries
+            OPENRAVE_ASSERT_OP(u1, >=, 0);
+            OPENRAVE_ASSERT_OP(u1, <=, ramps[i1].endTime+ParabolicRamp::EpsilonT);
+            OPENRAVE_ASSERT_OP(u2, >=, 0);
+            OPENRAVE_ASSERT_OP(u2, <=, ramps[i2].endTime+ParabolicRamp::EpsilonT);
+            u1 = ParabolicRamp::Min(u1,ramps[i1].endTime);
+            u2 = ParabolicRamp::Min(u2,ramps[i2].endTime);
+            ramps[i1].Evaluate(u1,x0);
+            if( _parameters->SetStateValues(x0) != 0 ) {
+                return 0;
+            }
+            iIterProgress += 0x10000000;
+            _parameters->_getstatefn(x0);
+            iIterProgress += 0x10000000;
+            ramps[i2].Evaluate(u2,x1);
+            iIterProgress += 0x10000000;
+            if( _parameters->SetStateValues(x1) != 0 ) {
+                return 0;
+            }
+            iIterProgress += 0x10000000;
+            _parameters->_getstatefn(x1);
+            ramps[i1].Derivative(u1,dx0);
+            ramps[i2].Derivative(u2,dx1);
+            if( bcallcallbacks ) {
+                ++_progress._iteration;
+            }
+
+            vellimits = _parameters->_vConfigVelocityLimit;
+            accellimits = _parameters->_vConfigAccelerationLimit;
+            if( _bmanipconstraints && !!_manipconstraintchecker ) {
+                if( _parameters->SetStateValues(x0) != 0 ) {
+                    RAVELOG_VERBOSE("state set error\n");
+                    return 0;
+                }
+                _manipconstraintchecker->GetMaxVelocitiesAccelerations(dx0, vellimits, accellimits);
+                if( _parameters->SetStateValues(x1) != 0 ) {
+                    RAVELOG_VERBOSE("state set error\n");
+                    return 0;
+                }
+                _manipconstraintchecker->GetMaxVelocitiesAccelerations(dx1, vellimits, accellimits);
+            }
+            for(size_t j = 0; j < _parameters->_vConfigVelocityLimit.size(); ++j) {
+                // have to watch out that velocities don't drop under dx0 & dx1!
+                dReal fminvel = max(RaveFabs(dx0[j]), RaveFabs(dx1[j]));
+                if( vellimits[j] < fminvel ) {
+                    vellimits[j] = fminvel;
+                }
+                else {
+                    dReal f = max(fminvel, _parameters->_vConfigVelocityLimit[j]*fstarttimemult);
+                    if( vellimits[j] > f ) {
+                        vellimits[j] = f;
                     }
-                    {
-                        dReal f = _parameters->_vConfigAccelerationLimit[j]*fstarttimemult;
-                        if( accellimits[j] > f ) {
-                            accellimits[j] = f;
-                        }
+                }
+                {
+                    dReal f = _parameters->_vConfigAccelerationLimit[j]*fstarttimemult;
+                    if( accellimits[j] > f ) {
+                        accellimits[j] = f;
                     }
                 }
-                
-                dReal fcurmult = fstarttimemult;
-                for(size_t islowdowntry = 0; islowdowntry < 4; ++islowdowntry ) {
-                    bool res=ParabolicRamp::SolveMinTime(x0, dx0, x1, dx1, accellimits, vellimits, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, intermediate, _parameters->_multidofinterp);
-                    iIterProgress += 0x1000;
-                    if(!res) {
+            }
+
+            fcurmult = fstarttimemult;
+            for(size_t islowdowntry = 0; islowdowntry < 4; ++islowdowntry ) {
+                // candidates that cannot make a significant improvement are rejected from the lower bound before synchronizing the dofs
+                bool res=ParabolicRamp::SolveMinTime(x0, dx0, x1, dx1, accellimits, vellimits, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, intermediate, _parameters->_multidofinterp, t2-t1-mintimestep);
+                iIterProgress += 0x1000;
+                if(!res) {
+                    break;
+                }
+                // check the new ramp time makes significant steps
+                dReal newramptime = intermediate.GetTotalTime();
+                if( newramptime+mintimestep > t2-t1 ) {
+                    // reject since it didn't make significant improvement
+                    RAVELOG_VERBOSE_FORMAT("shortcut iter=%d rejected times [%f, %f]. final trajtime=%fs", iters%t1%t2%(rampStartTime.back()+ramps.back().endTime-(t2-t1)+newramptime));
+                    break;
+                }
+
+                if( bcallcallbacks && _CallCallbacks(_progress) == PA_Interrupt ) {
+                    return -1;
+                }
+
+                iIterProgress += 0x1000;
+                accumoutramps.resize(0);
+                ParabolicRamp::CheckReturn retcheck(0);
+                for(size_t iramp=0; iramp<intermediate.ramps.size(); iramp++) {
+                    iIterProgress += 0x10;
+                    if( iramp > 0 ) {
+                        intermediate.ramps[iramp].x0 = intermediate.ramps[iramp-1].x1; // to remove noise?
+                        intermediate.ramps[iramp].dx0 = intermediate.ramps[iramp-1].dx1; // to remove noise?
+                    }
+                    if( _parameters->SetStateValues(intermediate.ramps[iramp].x1) != 0 ) {
+                        retcheck.retcode = CFO_StateSettingError;
                         break;
                     }
-                    // check the new ramp time makes significant steps
-                    dReal newramptime = intermediate.GetTotalTime();
-                    if( newramptime+mintimestep > t2-t1 ) {
-                        // reject since it didn't make significant improvement
-                        RAVELOG_VERBOSE_FORMAT("shortcut iter=%d rejected times [%f, %f]. final trajtime=%fs", iters%t1%t2%(endTime-(t2-t1)+newramptime));
+                    _parameters->_getstatefn(intermediate.ramps[iramp].x1);
+                    // have to resolve for the ramp since the positions might have changed?
+                    //                for(size_t j = 0; j < intermediate.rams[iramp].x1.size(); ++j) {
+                    //                    intermediate.ramps[iramp].SolveFixedSwitchTime();
+                    //                }
+
+                    iIterProgress += 0x10;
+                    retcheck = _feasibilitychecker.Check2(intermediate.ramps[iramp], 0xffff, outramps);
+                    iIterProgress += 0x10;
+                    if( retcheck.retcode != 0) {
                         break;
                     }
-
-                    if( _CallCallbacks(_progress) == PA_Interrupt ) {
-                        return -1;
+                    //check for consistency
+                    if( IS_DEBUGLEVEL(Level_Verbose) ) {
+                        for(size_t i=0; i+1<outramps.size(); i++) {
+                            for(size_t j = 0; j < outramps[i].x1.size(); ++j) {
+                                OPENRAVE_ASSERT_OP(RaveFabs(outramps[i].x1[j]-outramps[i+1].x0[j]), <=, ParabolicRamp::EpsilonX);
+                                OPENRAVE_ASSERT_OP(RaveFabs(outramps[i].dx1[j]-outramps[i+1].dx0[j]), <=, ParabolicRamp::EpsilonV);
+                            }
+                        }
                     }
 
-                    iIterProgress += 0x1000;
-                    accumoutramps.resize(0);
-                    ParabolicRamp::CheckReturn retcheck(0);
-                    for(size_t iramp=0; iramp<intermediate.ramps.size(); iramp++) {
-                        iIterProgress += 0x10;
-                        if( iramp > 0 ) {
-                            intermediate.ramps[iramp].x0 = intermediate.ramps[iramp-1].x1; // to remove noise?
-                            intermediate.ramps[iramp].dx0 = intermediate.ramps[iramp-1].dx1; // to remove noise?
-                        }
-                        if( _parameters->SetStateValues(intermediate.ramps[iramp].x1) != 0 ) {
-                            retcheck.retcode = CFO_StateSettingError;
+                    if( retcheck.bDifferentVelocity && outramps.size() > 0 ) {
+                        ParabolicRamp::ParabolicRampND& outramp = outramps.at(outramps.size()-1);
+
+                        bool res=ParabolicRamp::SolveMinTime(outramp.x0, outramp.dx0, intermediate.ramps[iramp].x1, intermediate.ramps[iramp].dx1, accellimits, vellimits, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, intermediate2, _parameters->_multidofinterp);
+                        if( !res ) {
+                            RAVELOG_WARN("failed to SolveMinTime for different vel ramp\n");
                             break;
                         }
-                        _parameters->_getstatefn(intermediate.ramps[iramp].x1);
-                        // have to resolve for the ramp since the positions might have changed?
-                        //                for(size_t j = 0; j < intermediate.rams[iramp].x1.size(); ++j) {
-                        //                    intermediate.ramps[iramp].SolveFixedSwitchTime();
-                        //                }
-
-                        iIterProgress += 0x10;
-                        retcheck = _feasibilitychecker.Check2(intermediate.ramps[iramp], 0xffff, outramps);
-                        iIterProgress += 0x10;
-                        if( retcheck.retcode != 0) {
+                        if( RaveFabs(intermediate2.GetTotalTime()-outramp.endTime) > 0.01 ) {
+                            RAVELOG_DEBUG_FORMAT("env=%d, intermediate2 ramp duration is too long %fs", GetEnv()->GetId()%intermediate2.GetTotalTime());
+                            retcheck.retcode = CFO_FinalValuesNotReached;
                             break;
                         }
-                        //check for consistency
-                        if( IS_DEBUGLEVEL(Level_Verbose) ) {
-                            for(size_t i=0; i+1<outramps.size(); i++) {
-                                for(size_t j = 0; j < outramps[i].x1.size(); ++j) {
-                                    OPENRAVE_ASSERT_OP(RaveFabs(outramps[i].x1[j]-outramps[i+1].x0[j]), <=, ParabolicRamp::EpsilonX);
-                                    OPENRAVE_ASSERT_OP(RaveFabs(outramps[i].dx1[j]-outramps[i+1].dx0[j]), <=, ParabolicRamp::EpsilonV);
-                                }
-                            }
-                        }
-
-                        if( retcheck.bDifferentVelocity && outramps.size() > 0 ) {
-                            ParabolicRamp::ParabolicRampND& outramp = outramps.at(outramps.size()-1);
-
-                            bool res=ParabolicRamp::SolveMinTime(outramp.x0, outramp.dx0, intermediate.ramps[iramp].x1, intermediate.ramps[iramp].dx1, accellimits, vellimits, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, intermediate2, _parameters->_multidofinterp);
-                            if( !res ) {
-                                RAVELOG_WARN("failed to SolveMinTime for different vel ramp\n");
-                                break;
-                            }
-                            if( RaveFabs(intermediate2.GetTotalTime()-outramp.endTime) > 0.01 ) {
-                                RAVELOG_DEBUG_FORMAT("env=%d, intermediate2 ramp duration is too long %fs", GetEnv()->GetId()%intermediate2.GetTotalTime());
-                                retcheck.retcode = CFO_FinalValuesNotReached;
-                                break;
-                            }
-                            // intermediate2 should be pretty close to outramp, so just insert directly
-                            outramps.pop_back();
-                            outramps.insert(outramps.end(), intermediate2.ramps.begin(), intermediate2.ramps.end());
-                        }
-                        accumoutramps.insert(accumoutramps.end(), outramps.begin(), outramps.end());
+                        // intermediate2 should be pretty close to outramp, so just insert directly
+                        outramps.pop_back();
+                        outramps.insert(outramps.end(), intermediate2.ramps.begin(), intermediate2.ramps.end());
                     }
-                    iIterProgress += 0x1000;
-                    if(retcheck.retcode == 0) {
-                        bsuccess = true;
-                        break;
+                    accumoutramps.insert(accumoutramps.end(), outramps.begin(), outramps.end());
+                }
+                iIterProgress += 0x1000;
+                if(retcheck.retcode == 0) {
+                    if( accumoutramps.size() == 0 ) {
+                        RAVELOG_WARN("accumulated ramps are empty!\n");
+                        return 0;
                     }
+                    return 1;
+                }
 
-                    if( retcheck.retcode == CFO_CheckTimeBasedConstraints ) {
-                        RAVELOG_VERBOSE_FORMAT("env=%d, shortcut iter=%d, slow down ramp by fTimeBasedSurpassMult=%.15e, fcurmult=%.15e", GetEnv()->GetId()%iters%retcheck.fTimeBasedSurpassMult%fcurmult);
-                        for(size_t j = 0; j < vellimits.size(); ++j) {
-                            // have to watch out that velocities don't drop under dx0 & dx1!
-                            dReal fminvel = max(RaveFabs(dx0[j]), RaveFabs(dx1[j]));
-                            vellimits[j] = max(vellimits[j]*retcheck.fTimeBasedSurpassMult, fminvel);
-                            accellimits[j] *= retcheck.fTimeBasedSurpassMult;
-                        }
-                        fcurmult *= retcheck.fTimeBasedSurpassMult;
-                        if( fcurmult < 0.01 ) {
-                            RAVELOG_DEBUG_FORMAT("env=%d, shortcut iter=%d, fcurmult is too small (%.15e) so giving up on this ramp", GetEnv()->GetId()%iters%fcurmult);
-                            //retcheck = check.Check2(intermediate.ramps.at(0), 0xffff, outramps);
-                            break;
-                        }
-                        numslowdowns += 1;
+                if( retcheck.retcode == CFO_CheckTimeBasedConstraints ) {
+                    RAVELOG_VERBOSE_FORMAT("env=%d, shortcut iter=%d, slow down ramp by fTimeBasedSurpassMult=%.15e, fcurmult=%.15e", GetEnv()->GetId()%iters%retcheck.fTimeBasedSurpassMult%fcurmult);
+                    for(size_t j = 0; j < vellimits.size(); ++j) {
+                        // have to watch out that velocities don't drop under dx0 & dx1!
+                        dReal fminvel = max(RaveFabs(dx0[j]), RaveFabs(dx1[j]));
+                        vellimits[j] = max(vellimits[j]*retcheck.fTimeBasedSurpassMult, fminvel);
+                        accellimits[j] *= retcheck.fTimeBasedSurpassMult;
                     }
-                    else {
-                        RAVELOG_VERBOSE_FORMAT("env=%d, shortcut iter=%d rejected due to constraints 0x%x", GetEnv()->GetId()%iters%retcheck.retcode);
+                    fcurmult *= retcheck.fTimeBasedSurpassMult;
+                    if( fcurmult < 0.01 ) {
+                        RAVELOG_DEBUG_FORMAT("env=%d, shortcut iter=%d, fcurmult is too small (%.15e) so giving up on this ramp", GetEnv()->GetId()%iters%fcurmult);
+                        //retcheck = check.Check2(intermediate.ramps.at(0), 0xffff, outramps);
                         break;
                     }
-                    iIterProgress += 0x1000;
+                    numslowdowns += 1;
                 }
-
-                if( !bsuccess ) {
-                    continue;
-                }
-
-                if( accumoutramps.size() == 0 ) {
-                    RAVELOG_WARN("accumulated ramps are empty!\n");
-                    continue;
+                else {
+                    RAVELOG_VERBOSE_FORMAT("env=%d, shortcut iter=%d rejected due to constraints 0x%x", GetEnv()->GetId()%iters%retcheck.retcode);
+                    break;
                 }
-                fstarttimemult = min(1.0, fcurmult*fiSearchVelAccelMult); // the new start time mult should be increased by one timemult
+                iIterProgress += 0x1000;
+            }
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%d, exception happened during shortcut iteration progress=0x%x: %s", GetEnv()->GetId()%iIterProgress%ex.what());
+            // continue to next iteration...
+        }
+        return 0;
+    }
 
-                // perform shortcut. use accumoutramps rather than intermediate.ramps!
-                shortcuts++;
-                
-                if( i1 == i2 ) {
-                    // the same ramp is being cut on both sides, so copy the ramp
-                    ramps.insert(ramps.begin()+i1, ramps.at(i1));
-                    i2 = i1+1;
-                }
+    /// \brief replaces the ramps between t1 and t2 with accumoutramps. rampStartTime has to be consistent with ramps.
+    static void _ApplyShortcut(std::vector<ParabolicRamp::ParabolicRampND>& ramps, const std::vector<dReal>& rampStartTime, dReal t1, dReal t2, const std::vector<ParabolicRamp::ParabolicRampND>& accumoutramps)
+    {
+        int i1 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t1)-rampStartTime.begin()-1;
+        int i2 = std::upper_bound(rampStartTime.begin(),rampStartTime.end(),t2)-rampStartTime.begin()-1;
+        dReal u1 = ParabolicRamp::Min(t1-rampStartTime.at(i1),ramps.at(i1).endTime);
+        dReal u2 = ParabolicRamp::Min(t2-rampStartTime.at(i2),ramps.at(i2).endTime);
+        if( i1 == i2 ) {
+            // the same ramp is being cut on both sides, so copy the ramp
+            ramps.insert(ramps.begin()+i1, ramps.at(i1));
+            i2 = i1+1;
+        }
 
-                ramps.at(i1).TrimBack(ramps[i1].endTime-u1); // use at for bounds checking
-                ramps[i1].x1 = accumoutramps.front().x0;
-                ramps[i1].dx1 = accumoutramps.front().dx0;
-                ramps.at(i2).TrimFront(u2); // use at for bounds checking
-                ramps[i2].x0 = accumoutramps.back().x1;
-                ramps[i2].dx0 = accumoutramps.back().dx1;
-                
-                //RAVELOG_VERBOSE_FORMAT("replacing [%d, %d] with %d ramps", i1%i2%accumoutramps.size());
-                // replace with accumoutramps
-                if( i1+1 < i2 ) {
-                    ramps.erase(ramps.begin()+i1+1, ramps.begin()+i2);
-                }
-                ramps.insert(ramps.begin()+i1+1,accumoutramps.begin(),accumoutramps.end());
-                iIterProgress += 0x10000000;
+        ramps.at(i1).TrimBack(ramps[i1].endTime-u1); // use at for bounds checking
+        ramps[i1].x1 = accumoutramps.front().x0;
+        ramps[i1].dx1 = accumoutramps.front().dx0;
+        ramps.at(i2).TrimFront(u2); // use at for bounds checking
+        ramps[i2].x0 = accumoutramps.back().x1;
+        ramps[i2].dx0 = accumoutramps.back().dx1;
+
+        //RAVELOG_VERBOSE_FORMAT("replacing [%d, %d] with %d ramps", i1%i2%accumoutramps.size());
+        // replace with accumoutramps
+        if( i1+1 < i2 ) {
+            ramps.erase(ramps.begin()+i1+1, ramps.begin()+i2);
+        }
+        ramps.insert(ramps.begin()+i1+1,accumoutramps.begin(),accumoutramps.end());
 
-                //check for consistency
-                if( IS_DEBUGLEVEL(Level_Verbose) ) {
-                    for(size_t i=0; i+1<ramps.size(); i++) {
-                        for(size_t j = 0; j < ramps[i].x1.size(); ++j) {
-                            OPENRAVE_ASSERT_OP(RaveFabs(ramps[i].x1[j]-ramps[i+1].x0[j]), <=, ParabolicRamp::EpsilonX);
-                            OPENRAVE_ASSERT_OP(RaveFabs(ramps[i].dx1[j]-ramps[i+1].dx0[j]), <=, ParabolicRamp::EpsilonV);
-                        }
-                    }
-                }
-                iIterProgress += 0x10000000;
-
-                //revise the timing
-                rampStartTime.resize(ramps.size());
-                endTime=0;
-                for(size_t i=0; i<ramps.size(); i++) {
-                    rampStartTime[i] = endTime;
-                    endTime += ramps[i].endTime;
+        //check for consistency
+        if( IS_DEBUGLEVEL(Level_Verbose) ) {
+            for(size_t i=0; i+1<ramps.size(); i++) {
+                for(size_t j = 0; j < ramps[i].x1.size(); ++j) {
+                    OPENRAVE_ASSERT_OP(RaveFabs(ramps[i].x1[j]-ramps[i+1].x0[j]), <=, ParabolicRamp::EpsilonX);
+                    OPENRAVE_ASSERT_OP(RaveFabs(ramps[i].dx1[j]-ramps[i+1].dx0[j]), <=, ParabolicRamp::EpsilonV);
                 }
-                RAVELOG_VERBOSE_FORMAT("shortcut iter=%d slowdowns=%d, endTime=%f",iters%numslowdowns%endTime);
-            }
-            catch(const std::exception& ex) {
-                RAVELOG_WARN_FORMAT("env=%d, exception happened during shortcut iteration progress=0x%x: %s", GetEnv()->GetId()%iIterProgress%ex.what());
-                // continue to next iteration...
             }
         }
-
-        RAVELOG_VERBOSE_FORMAT("finished at shortcut iter=%d slowdowns=%d, endTime=%f",iters%numslowdowns%endTime);
-        return shortcuts;
     }
 
     /// \brief extracts the unique switch points for every 1D ramp. endtime is included.
@@ -1263,6 +1618,19 @@ protected:
     std::vector<dReal> _cachetrajpoints, _cacheswitchtimes;
     vector<ParabolicRamp::Vector> _cachepath;
     std::vector<dReal> _cachevellimits, _cacheaccellimits;
+    std::vector<ShortcutCandidate> _cacheshortcutcandidates;
+    //@}
+
+    std::vector<ShortcutWorkerPtr> _vshortcutworkers; ///< used by _ShortcutParallel, kept between calls to avoid cloning the environment again
+
+    //@{ thread pool of _vshortcutworkers
+    boost::mutex _mutexShortcutWorkers;
+    boost::condition _condShortcutStart; ///< notified when a new round is started or the threads should stop
+    boost::condition _condShortcutDone; ///< notified when all the pooled threads finished the current round
+    ShortcutRound _shortcutround; ///< protected by _mutexShortcutWorkers
+    int _nShortcutRound; ///< incremented for every started round
+    size_t _nShortcutPending; ///< number of pooled threads that have not finished the current round
+    bool _bStopShortcutWorkers;
     //@}
     
     TrajectoryBasePtr _dummytraj;
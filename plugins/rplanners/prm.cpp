@@ -0,0 +1,1267 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "rplanners.h"
+#include <boost/thread/thread.hpp>
+#include <queue>
+
+static const int s_nRoadmapFileVersion = 1;
+static const dReal s_fRoadmapAABBMargin = 0.02; ///< padding of the node and edge bounding boxes, covers the motion between the configurations sampled on an edge
+static const int s_nRoadmapEdgeSamples = 5; ///< number of configurations sampled on an edge for its bounding box, including the endpoints
+
+/// \brief multi-query probabilistic roadmap that is kept between queries and saved to the database.
+///
+/// The roadmap is keyed by the robot, its active DOFs and state, and the kinematics geometry hashes of the other bodies. Every node and edge keeps
+/// the bounding box of the robot links it moves, so when bodies move only the nodes and edges close to their old and new positions have to be checked again.
+class PrmPlanner : public PlannerBase
+{
+    enum RoadmapState
+    {
+        RS_Unknown=0, ///< has to be checked before being used
+        RS_Valid=1,
+        RS_Invalid=2,
+    };
+
+    struct RoadmapNode
+    {
+        RoadmapNode() : state(RS_Unknown) {
+        }
+        uint8_t state;
+        AABB ab; ///< bounding box of the moving links and grabbed bodies at the configuration
+        std::vector<int> vedges; ///< indices of the edges connected to the node
+    };
+
+    struct RoadmapEdge
+    {
+        RoadmapEdge() : inode0(-1), inode1(-1), cost(0), state(RS_Unknown) {
+        }
+        int inode0, inode1;
+        dReal cost; ///< the distance between the configurations
+        uint8_t state;
+        AABB ab; ///< approximate bounding box of the moving links and grabbed bodies along the edge
+    };
+
+    /// \brief the state of a body the roadmap was checked against
+    struct BodyRecord
+    {
+        BodyRecord() : enabled(false) {
+        }
+        std::string name, hash;
+        bool enabled;
+        std::vector<Transform> vlinktransforms;
+        AABB ab;
+    };
+
+    /// \brief samples and checks in its own environment
+    struct RoadmapWorker
+    {
+        EnvironmentBasePtr penv; ///< if it is the planner environment, the worker runs in the calling thread
+        PlannerParametersPtr parameters; ///< parameters bound to the bodies of penv
+        RobotBasePtr robot;
+        std::vector<dReal> vsamples; ///< valid samples of the last batch
+        std::vector<AABB> vsampleaabbs;
+        std::vector<dReal> vedgeconfigs; ///< the two configurations of every edge to check
+        std::vector<uint8_t> vedgestates;
+        std::vector<AABB> vedgeaabbs;
+    };
+    typedef boost::shared_ptr<RoadmapWorker> RoadmapWorkerPtr;
+
+public:
+    PrmPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv)
+    {
+        __description = "\
+:Interface Author: Rosen Diankov\n\n\
+Multi-query probabilistic roadmap that persists between queries. The roadmap is built with **BuildRoadmap**, possibly in the background and with several threads on cloned environments, and is saved to the database keyed by the robot and the kinematics geometry hashes of the environment. Queries connect the initial and goal configurations to the nearest roadmap nodes and search the roadmap with A*, checking the edges that are not known to be valid only along the found paths. When bodies move, only the nodes and edges whose bounding boxes overlap the old or new body positions are checked again. See\n\n\
+- L.E. Kavraki, P. Svestka, J.-C. Latombe, and M.H. Overmars. Probabilistic roadmaps for path planning in high-dimensional configuration spaces. IEEE Trans. on Robotics and Automation, 12(4):566-580, 1996.\n\
+- R. Bohlin and L.E. Kavraki. Path planning using lazy PRM. In Proc. IEEE Int'l Conf. on Robotics and Automation (ICRA'2000), pages 521-528, San Francisco, CA, April 2000.";
+        RegisterCommand("BuildRoadmap",boost::bind(&PrmPlanner::_BuildRoadmapCommand,this,_1,_2),
+                        "Adds nodes to the roadmap of the robot and parameters of the last InitPlan::\n\n  numnodes [numthreads] [wait] [neighbors]\n\n\
+numnodes is the total number of nodes to reach. If numthreads is 0 (default), uses the number of processors. With more than one thread, every thread checks in a cloned environment, so custom constraint functions of the parameters are not used. If wait is 0 (default), returns immediately and builds in the background. Every new node is connected to its neighbors (default 10) nearest nodes. When done, the roadmap is saved to the database.");
+        RegisterCommand("WaitForRoadmap",boost::bind(&PrmPlanner::_WaitForRoadmapCommand,this,_1,_2),
+                        "Waits until the background build of the roadmap is done.");
+        RegisterCommand("StopRoadmap",boost::bind(&PrmPlanner::_StopRoadmapCommand,this,_1,_2),
+                        "Stops the background build of the roadmap after the current batch.");
+        RegisterCommand("SaveRoadmap",boost::bind(&PrmPlanner::_SaveRoadmapCommand,this,_1,_2),
+                        "Saves the roadmap to the database and returns the filename.");
+        RegisterCommand("ClearRoadmap",boost::bind(&PrmPlanner::_ClearRoadmapCommand,this,_1,_2),
+                        "Removes all the nodes of the roadmap. The saved roadmap is not touched.");
+        RegisterCommand("GetRoadmapStatistics",boost::bind(&PrmPlanner::_GetRoadmapStatisticsCommand,this,_1,_2),
+                        "Returns 'numnodes numedges numvalidedges numinvalidedges numunknownedges'.");
+        _bStopBuild = false;
+    }
+    virtual ~PrmPlanner() {
+        _StopBuild();
+        _DestroyWorkers(0);
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
+    {
+        // the build thread uses the parameters, the moving links and the key that are reset below
+        _StopBuild();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset();
+        if( !pbase ) {
+            RAVELOG_WARN("PRM needs a robot\n");
+            return false;
+        }
+        PlannerParametersPtr parameters(new PlannerParameters());
+        parameters->copy(pparams);
+        parameters->Validate();
+        if( (int)parameters->vinitialconfig.size() % parameters->GetDOF() || (int)parameters->vgoalconfig.size() % parameters->GetDOF() ) {
+            RAVELOG_WARN("initial or goal configurations have the wrong dimension\n");
+            return false;
+        }
+
+        std::string robotkey = _ComputeRobotKey(pbase, parameters);
+        if( robotkey != _robotkey ) {
+            boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+            _ClearRoadmap();
+            _robotkey = robotkey;
+        }
+        _robot = pbase;
+        _parameters = parameters;
+        _ComputeMovingLinks();
+        _key = utils::GetMD5HashString(robotkey + _ComputeEnvironmentKey());
+
+        bool bload = false;
+        {
+            boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+            bload = _vroadmapnodes.size() == 0;
+        }
+        if( bload ) {
+            std::string filename = RaveFindDatabaseFile(std::string("prm.")+_key, true);
+            boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+            if( filename.size() > 0 && _LoadRoadmap(filename) ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, loaded roadmap of %d nodes and %d edges from %s", GetEnv()->GetId()%_vroadmapnodes.size()%_vroadmapedges.size()%filename);
+            }
+            else {
+                _ClearRoadmap();
+                _GetBodyRecords(_vbodyrecords);
+            }
+        }
+        _UpdateEnvironmentChanges();
+        return true;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj)
+    {
+        if( !_parameters ) {
+            RAVELOG_WARN("PRM planner not initialized\n");
+            return PS_Failed;
+        }
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        uint64_t starttime = utils::GetMicroTime();
+        PlannerParameters::StateSaver savestate(_parameters);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+        _UpdateEnvironmentChanges();
+
+        const int dof = _parameters->GetDOF();
+        _nQueryChecks = 0;
+        std::vector< std::vector<dReal> > vinitialconfigs, vgoalconfigs;
+        _GetValidConfigurations(_parameters->vinitialconfig, vinitialconfigs);
+        _GetValidConfigurations(_parameters->vgoalconfig, vgoalconfigs);
+        if( vinitialconfigs.size() == 0 || vgoalconfigs.size() == 0 ) {
+            RAVELOG_WARN_FORMAT("env=%d, no valid initial (%d) or goal (%d) configurations", GetEnv()->GetId()%vinitialconfigs.size()%vgoalconfigs.size());
+            return PS_Failed;
+        }
+
+        std::vector<dReal> vpath;
+        // try connecting directly
+        for(size_t iinitial = 0; iinitial < vinitialconfigs.size() && vpath.size() == 0; ++iinitial) {
+            for(size_t igoal = 0; igoal < vgoalconfigs.size(); ++igoal) {
+                ++_nQueryChecks;
+                if( _parameters->CheckPathAllConstraints(vinitialconfigs[iinitial], vgoalconfigs[igoal], std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open) == 0 ) {
+                    vpath.insert(vpath.end(), vinitialconfigs[iinitial].begin(), vinitialconfigs[iinitial].end());
+                    vpath.insert(vpath.end(), vgoalconfigs[igoal].begin(), vgoalconfigs[igoal].end());
+                    break;
+                }
+            }
+        }
+
+        if( vpath.size() == 0 ) {
+            boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+            if( _vroadmapnodes.size() == 0 ) {
+                RAVELOG_WARN_FORMAT("env=%d, roadmap is empty, call BuildRoadmap first", GetEnv()->GetId());
+                return PS_Failed;
+            }
+            std::vector< std::pair<int, dReal> > vstartconnections, vgoalconnections;
+            std::vector<int> vstartconfigindices, vgoalconfigindices;
+            for(size_t iinitial = 0; iinitial < vinitialconfigs.size(); ++iinitial) {
+                _ConnectToRoadmap(vinitialconfigs[iinitial], false, vstartconnections);
+                vstartconfigindices.resize(vstartconnections.size(), (int)iinitial);
+            }
+            for(size_t igoal = 0; igoal < vgoalconfigs.size(); ++igoal) {
+                _ConnectToRoadmap(vgoalconfigs[igoal], true, vgoalconnections);
+                vgoalconfigindices.resize(vgoalconnections.size(), (int)igoal);
+            }
+
+            std::vector<int> vnodepath;
+            int istartconnection = -1, igoalconnection = -1;
+            while(vstartconnections.size() > 0 && vgoalconnections.size() > 0 ) {
+                if( !_SearchRoadmap(vstartconnections, vgoalconnections, vgoalconfigs, vnodepath, istartconnection, igoalconnection) ) {
+                    break;
+                }
+                if( _CheckRoadmapPath(vnodepath) ) {
+                    break;
+                }
+                vnodepath.resize(0);
+            }
+            if( vnodepath.size() == 0 ) {
+                RAVELOG_WARN_FORMAT("env=%d, initial and goal are not connected in the roadmap of %d nodes, %d checks, %fs", GetEnv()->GetId()%_vroadmapnodes.size()%_nQueryChecks%(1e-6*(utils::GetMicroTime()-starttime)));
+                return PS_Failed;
+            }
+
+            const std::vector<dReal>& vinitial = vinitialconfigs.at(vstartconfigindices.at(istartconnection));
+            const std::vector<dReal>& vgoal = vgoalconfigs.at(vgoalconfigindices.at(igoalconnection));
+            vpath.insert(vpath.end(), vinitial.begin(), vinitial.end());
+            FOREACHC(itnode, vnodepath) {
+                vpath.insert(vpath.end(), _vroadmapconfigs.begin()+(*itnode)*dof, _vroadmapconfigs.begin()+(*itnode+1)*dof);
+            }
+            vpath.insert(vpath.end(), vgoal.begin(), vgoal.end());
+        }
+
+        if( ptraj->GetConfigurationSpecification().GetDOF() == 0 ) {
+            ptraj->Init(_parameters->_configurationspecification);
+        }
+        ptraj->Insert(ptraj->GetNumWaypoints(), vpath, _parameters->_configurationspecification);
+        RAVELOG_DEBUG_FORMAT("env=%d, prm path has %d points, %d checks, computation time=%fs", GetEnv()->GetId()%(vpath.size()/dof)%_nQueryChecks%(1e-6*(utils::GetMicroTime()-starttime)));
+        return _ProcessPostPlanners(_robot,ptraj);
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+protected:
+    bool _BuildRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int numnodes = 0, numthreads = 0, neighbors = 10;
+        bool bwait = false;
+        sinput >> numnodes;
+        if( !sinput ) {
+            return false;
+        }
+        sinput >> numthreads >> bwait >> neighbors;
+        if( !_parameters ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("need to call InitPlan before BuildRoadmap", ORE_InvalidState);
+        }
+        if( numthreads <= 0 ) {
+            numthreads = max(1, (int)boost::thread::hardware_concurrency());
+        }
+        _StopBuild();
+
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _UpdateEnvironmentChanges();
+        if( !_InitWorkers(numthreads, bwait) ) {
+            return false;
+        }
+        _bStopBuild = false;
+        if( bwait ) {
+            _BuildRoadmap(numnodes, neighbors);
+        }
+        else {
+            _threadBuild.reset(new boost::thread(boost::bind(&PrmPlanner::_BuildRoadmap, this, numnodes, neighbors)));
+        }
+        return true;
+    }
+
+    bool _WaitForRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        if( !!_threadBuild ) {
+            _threadBuild->join();
+            _threadBuild.reset();
+        }
+        return true;
+    }
+
+    bool _StopRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        _StopBuild();
+        return true;
+    }
+
+    bool _SaveRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        if( _key.size() == 0 ) {
+            return false;
+        }
+        std::string filename = RaveFindDatabaseFile(std::string("prm.")+_key, false);
+        boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+        if( filename.size() == 0 || !_SaveRoadmap(filename) ) {
+            return false;
+        }
+        sout << filename;
+        return true;
+    }
+
+    bool _ClearRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        _StopBuild();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+        _ClearRoadmap();
+        if( !!_robot ) {
+            _GetBodyRecords(_vbodyrecords);
+        }
+        return true;
+    }
+
+    bool _GetRoadmapStatisticsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+        int vnumedges[3] = {0,0,0};
+        FOREACHC(itedge, _vroadmapedges) {
+            vnumedges[itedge->state]++;
+        }
+        sout << _vroadmapnodes.size() << " " << _vroadmapedges.size() << " " << vnumedges[RS_Valid] << " " << vnumedges[RS_Invalid] << " " << vnumedges[RS_Unknown];
+        return true;
+    }
+
+    void _StopBuild()
+    {
+        if( !!_threadBuild ) {
+            _bStopBuild = true;
+            _threadBuild->join();
+            _threadBuild.reset();
+        }
+    }
+
+    /// \brief destroys the cloned environments of the workers starting at istart and removes the workers. The build thread has to be stopped.
+    void _DestroyWorkers(size_t istart)
+    {
+        for(size_t iworker = istart; iworker < _vworkers.size(); ++iworker) {
+            if( !!_vworkers[iworker] && !!_vworkers[iworker]->penv && _vworkers[iworker]->penv != GetEnv() ) {
+                _vworkers[iworker]->robot.reset();
+                _vworkers[iworker]->parameters.reset();
+                _vworkers[iworker]->penv->Destroy();
+                _vworkers[iworker]->penv.reset();
+            }
+        }
+        if( istart < _vworkers.size() ) {
+            _vworkers.resize(istart);
+        }
+    }
+
+    /// \brief the roadmap has to be locked
+    void _ClearRoadmap()
+    {
+        _vroadmapconfigs.resize(0);
+        _vroadmapnodes.resize(0);
+        _vroadmapedges.resize(0);
+        _vbodyrecords.resize(0);
+    }
+
+    /// \brief prepares the environments the roadmap is built in.
+    ///
+    /// With one thread and bwait, the worker uses the planner environment and parameters directly. Otherwise every worker has its own cloned environment
+    /// and the parameters are bound to the cloned bodies with SetConfigurationSpecification, so custom constraint functions are not available to the workers.
+    bool _InitWorkers(int numthreads, bool bwait)
+    {
+        if( numthreads == 1 && bwait ) {
+            _DestroyWorkers(0);
+            _vworkers.resize(1);
+            _vworkers[0].reset(new RoadmapWorker());
+            _vworkers[0]->penv = GetEnv();
+            _vworkers[0]->parameters = _parameters;
+            _vworkers[0]->robot = _robot;
+        }
+        else {
+            _DestroyWorkers(numthreads);
+            _vworkers.resize(numthreads);
+            FOREACH(itworker, _vworkers) {
+                if( !*itworker || (*itworker)->penv == GetEnv() ) {
+                    itworker->reset(new RoadmapWorker());
+                }
+                RoadmapWorker& worker = **itworker;
+                try {
+                    if( !worker.penv ) {
+                        worker.penv = GetEnv()->CloneSelf(Clone_Bodies);
+                    }
+                    else {
+                        worker.penv->Clone(GetEnv(), Clone_Bodies);
+                    }
+                    // the simulation thread would only compete with the worker for the environment lock
+                    worker.penv->StopSimulation();
+                    EnvironmentMutex::scoped_lock lock(worker.penv->GetMutex());
+                    worker.robot = worker.penv->GetRobot(_robot->GetName());
+                    worker.parameters.reset(new PlannerParameters());
+                    worker.parameters->copy(_parameters);
+                    worker.parameters->SetConfigurationSpecification(worker.penv, _parameters->_configurationspecification);
+                    // SetConfigurationSpecification resets the limits to the body limits, so restore the ones the user passed in
+                    worker.parameters->_vConfigLowerLimit = _parameters->_vConfigLowerLimit;
+                    worker.parameters->_vConfigUpperLimit = _parameters->_vConfigUpperLimit;
+                    worker.parameters->_vConfigVelocityLimit = _parameters->_vConfigVelocityLimit;
+                    worker.parameters->_vConfigAccelerationLimit = _parameters->_vConfigAccelerationLimit;
+                    worker.parameters->_vConfigResolution = _parameters->_vConfigResolution;
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_WARN_FORMAT("env=%d, failed to init roadmap worker: %s", GetEnv()->GetId()%ex.what());
+                    _DestroyWorkers(0);
+                    return false;
+                }
+                if( !worker.robot ) {
+                    RAVELOG_WARN_FORMAT("env=%d, cloned environment does not have robot %s", GetEnv()->GetId()%_robot->GetName());
+                    _DestroyWorkers(0);
+                    return false;
+                }
+            }
+        }
+        // continue the sample sequences where the last build left off so that the new nodes are different
+        uint32_t seed = _parameters->_nRandomGeneratorSeed + 1000003*(uint32_t)_vroadmapnodes.size();
+        for(size_t iworker = 0; iworker < _vworkers.size(); ++iworker) {
+            FOREACH(itsampler, _vworkers[iworker]->parameters->_listInternalSamplers) {
+                (*itsampler)->SetSeed(seed+iworker);
+            }
+        }
+        return true;
+    }
+
+    /// \brief adds batches of nodes until the roadmap has numnodes nodes, then saves it. Runs in the build thread or in the calling thread.
+    void _BuildRoadmap(int numnodes, int neighbors)
+    {
+        uint64_t starttime = utils::GetMicroTime();
+        const int dof = _parameters->GetDOF();
+        const int numworkers = (int)_vworkers.size();
+        const int batchsize = 32;
+        boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> distmetricfn = _vworkers.at(0)->parameters->_distmetricfn;
+        std::vector<dReal> vnewconfigs;
+        std::vector<AABB> vnewaabbs;
+        std::vector<RoadmapEdge> vnewedges;
+        std::vector< std::pair<dReal, int> > vneighbors;
+        std::vector<dReal> vconfig0(dof), vconfig1(dof);
+        int numfailedbatches = 0;
+        while( !_bStopBuild ) {
+            int numcurrentnodes = (int)_vroadmapnodes.size();
+            if( numcurrentnodes >= numnodes ) {
+                break;
+            }
+            // sample
+            int numsamples = min(batchsize, (numnodes-numcurrentnodes+numworkers-1)/numworkers);
+            _RunWorkers(boost::bind(&PrmPlanner::_SampleWorkerThread, this, _1, numsamples, 100*numsamples));
+            vnewconfigs.resize(0);
+            vnewaabbs.resize(0);
+            FOREACH(itworker, _vworkers) {
+                vnewconfigs.insert(vnewconfigs.end(), (*itworker)->vsamples.begin(), (*itworker)->vsamples.end());
+                vnewaabbs.insert(vnewaabbs.end(), (*itworker)->vsampleaabbs.begin(), (*itworker)->vsampleaabbs.end());
+            }
+            if( vnewaabbs.size() == 0 ) {
+                if( ++numfailedbatches > 10 ) {
+                    RAVELOG_WARN_FORMAT("env=%d, failed to sample valid configurations for the roadmap", GetEnv()->GetId());
+                    break;
+                }
+                continue;
+            }
+            numfailedbatches = 0;
+            if( numcurrentnodes+(int)vnewaabbs.size() > numnodes ) {
+                vnewaabbs.resize(numnodes-numcurrentnodes);
+                vnewconfigs.resize(vnewaabbs.size()*dof);
+            }
+
+            // connect every new node to its nearest nodes. only the build thread adds nodes, so the configurations can be read without the lock
+            vnewedges.resize(0);
+            for(size_t inew = 0; inew < vnewaabbs.size(); ++inew) {
+                std::copy(vnewconfigs.begin()+inew*dof, vnewconfigs.begin()+(inew+1)*dof, vconfig0.begin());
+                vneighbors.resize(0);
+                for(int inode = 0; inode < numcurrentnodes+(int)inew; ++inode) {
+                    if( inode < numcurrentnodes ) {
+                        std::copy(_vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof, vconfig1.begin());
+                    }
+                    else {
+                        std::copy(vnewconfigs.begin()+(inode-numcurrentnodes)*dof, vnewconfigs.begin()+(inode-numcurrentnodes+1)*dof, vconfig1.begin());
+                    }
+                    vneighbors.push_back(make_pair(distmetricfn(vconfig0, vconfig1), inode));
+                }
+                size_t numneighbors = min(vneighbors.size(), (size_t)neighbors);
+                std::partial_sort(vneighbors.begin(), vneighbors.begin()+numneighbors, vneighbors.end());
+                for(size_t ineighbor = 0; ineighbor < numneighbors; ++ineighbor) {
+                    RoadmapEdge edge;
+                    edge.inode0 = vneighbors[ineighbor].second;
+                    edge.inode1 = numcurrentnodes+inew;
+                    edge.cost = vneighbors[ineighbor].first;
+                    vnewedges.push_back(edge);
+                }
+            }
+
+            int numcurrentedges = 0;
+            {
+                boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+                _vroadmapconfigs.insert(_vroadmapconfigs.end(), vnewconfigs.begin(), vnewconfigs.end());
+                for(size_t inew = 0; inew < vnewaabbs.size(); ++inew) {
+                    _vroadmapnodes.push_back(RoadmapNode());
+                    _vroadmapnodes.back().state = RS_Valid;
+                    _vroadmapnodes.back().ab = vnewaabbs[inew];
+                }
+                numcurrentedges = (int)_vroadmapedges.size();
+                FOREACH(itedge, vnewedges) {
+                    _vroadmapnodes.at(itedge->inode0).vedges.push_back(_vroadmapedges.size());
+                    _vroadmapnodes.at(itedge->inode1).vedges.push_back(_vroadmapedges.size());
+                    _vroadmapedges.push_back(*itedge);
+                }
+            }
+
+            // check the new edges
+            for(int iworker = 0; iworker < numworkers; ++iworker) {
+                _vworkers[iworker]->vedgeconfigs.resize(0);
+            }
+            for(size_t iedge = 0; iedge < vnewedges.size(); ++iedge) {
+                std::vector<dReal>& vedgeconfigs = _vworkers[iedge%numworkers]->vedgeconfigs;
+                vedgeconfigs.insert(vedgeconfigs.end(), _vroadmapconfigs.begin()+vnewedges[iedge].inode0*dof, _vroadmapconfigs.begin()+(vnewedges[iedge].inode0+1)*dof);
+                vedgeconfigs.insert(vedgeconfigs.end(), _vroadmapconfigs.begin()+vnewedges[iedge].inode1*dof, _vroadmapconfigs.begin()+(vnewedges[iedge].inode1+1)*dof);
+            }
+            _RunWorkers(boost::bind(&PrmPlanner::_EdgeWorkerThread, this, _1));
+            {
+                boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+                for(size_t iedge = 0; iedge < vnewedges.size(); ++iedge) {
+                    RoadmapWorker& worker = *_vworkers[iedge%numworkers];
+                    RoadmapEdge& edge = _vroadmapedges.at(numcurrentedges+iedge);
+                    edge.state = worker.vedgestates.at(iedge/numworkers);
+                    edge.ab = worker.vedgeaabbs.at(iedge/numworkers);
+                }
+            }
+        }
+        RAVELOG_DEBUG_FORMAT("env=%d, roadmap has %d nodes and %d edges, built in %fs with %d threads", GetEnv()->GetId()%_vroadmapnodes.size()%_vroadmapedges.size()%(1e-6*(utils::GetMicroTime()-starttime))%numworkers);
+        std::string filename = RaveFindDatabaseFile(std::string("prm.")+_key, false);
+        boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+        if( filename.size() > 0 && !_SaveRoadmap(filename) ) {
+            RAVELOG_WARN_FORMAT("failed to save roadmap to %s", filename);
+        }
+    }
+
+    /// \brief runs workerfn on every worker, the first worker in the calling thread
+    void _RunWorkers(const boost::function<void(RoadmapWorkerPtr)>& workerfn)
+    {
+        std::vector<boost::shared_ptr<boost::thread> > vthreads(_vworkers.size());
+        for(size_t iworker = 1; iworker < _vworkers.size(); ++iworker) {
+            vthreads[iworker].reset(new boost::thread(boost::bind(workerfn, _vworkers[iworker])));
+        }
+        workerfn(_vworkers.at(0));
+        for(size_t iworker = 1; iworker < _vworkers.size(); ++iworker) {
+            vthreads[iworker]->join();
+        }
+    }
+
+    void _SampleWorkerThread(RoadmapWorkerPtr worker, int numsamples, int maxtries)
+    {
+        EnvironmentMutex::scoped_lock lock(worker->penv->GetMutex());
+        PlannerParameters::StateSaver savestate(worker->parameters);
+        CollisionOptionsStateSaver optionstate(worker->penv->GetCollisionChecker(),worker->penv->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+        worker->vsamples.resize(0);
+        worker->vsampleaabbs.resize(0);
+        std::vector<dReal> vsample;
+        for(int itry = 0; itry < maxtries && (int)worker->vsampleaabbs.size() < numsamples; ++itry) {
+            if( !worker->parameters->_samplefn(vsample) ) {
+                continue;
+            }
+            if( worker->parameters->CheckPathAllConstraints(vsample, vsample, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+                continue;
+            }
+            worker->parameters->SetStateValues(vsample);
+            worker->vsamples.insert(worker->vsamples.end(), vsample.begin(), vsample.end());
+            worker->vsampleaabbs.push_back(_ComputeMovingAABB(worker->robot));
+        }
+    }
+
+    void _EdgeWorkerThread(RoadmapWorkerPtr worker)
+    {
+        EnvironmentMutex::scoped_lock lock(worker->penv->GetMutex());
+        PlannerParameters::StateSaver savestate(worker->parameters);
+        CollisionOptionsStateSaver optionstate(worker->penv->GetCollisionChecker(),worker->penv->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+        const int dof = worker->parameters->GetDOF();
+        size_t numedges = worker->vedgeconfigs.size()/(2*dof);
+        worker->vedgestates.resize(numedges);
+        worker->vedgeaabbs.resize(numedges);
+        std::vector<dReal> vconfig0(dof), vconfig1(dof);
+        for(size_t iedge = 0; iedge < numedges; ++iedge) {
+            std::copy(worker->vedgeconfigs.begin()+2*iedge*dof, worker->vedgeconfigs.begin()+(2*iedge+1)*dof, vconfig0.begin());
+            std::copy(worker->vedgeconfigs.begin()+(2*iedge+1)*dof, worker->vedgeconfigs.begin()+(2*iedge+2)*dof, vconfig1.begin());
+            worker->vedgestates[iedge] = worker->parameters->CheckPathAllConstraints(vconfig0, vconfig1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open) == 0 ? RS_Valid : RS_Invalid;
+            worker->vedgeaabbs[iedge] = _ComputeEdgeAABB(worker->parameters, worker->robot, vconfig0, vconfig1);
+        }
+    }
+
+    /// \brief returns the bounding box of the links moved by the active DOFs and of the grabbed bodies at the current state of the robot
+    AABB _ComputeMovingAABB(RobotBasePtr robot) const
+    {
+        Vector vmin, vmax;
+        bool binit = false;
+        FOREACHC(itlinkindex, _vmovinglinks) {
+            KinBody::LinkPtr plink = robot->GetLinks().at(*itlinkindex);
+            _MergeAABB(plink->ComputeAABB(), vmin, vmax, binit);
+        }
+        std::vector<KinBodyPtr> vgrabbed;
+        robot->GetGrabbed(vgrabbed);
+        FOREACHC(itgrabbed, vgrabbed) {
+            _MergeAABB((*itgrabbed)->ComputeAABB(), vmin, vmax, binit);
+        }
+        AABB ab;
+        if( binit ) {
+            ab.pos = 0.5*(vmin+vmax);
+            ab.extents = 0.5*(vmax-vmin);
+        }
+        ab.extents += Vector(s_fRoadmapAABBMargin, s_fRoadmapAABBMargin, s_fRoadmapAABBMargin);
+        return ab;
+    }
+
+    /// \brief returns the union of the bounding boxes at configurations sampled along the edge
+    AABB _ComputeEdgeAABB(PlannerParametersPtr parameters, RobotBasePtr robot, const std::vector<dReal>& vconfig0, const std::vector<dReal>& vconfig1) const
+    {
+        std::vector<dReal> vdelta = vconfig1, vconfig;
+        parameters->_diffstatefn(vdelta, vconfig0);
+        Vector vmin, vmax;
+        bool binit = false;
+        for(int isample = 0; isample < s_nRoadmapEdgeSamples; ++isample) {
+            vconfig = vconfig0;
+            dReal f = dReal(isample)/dReal(s_nRoadmapEdgeSamples-1);
+            for(size_t i = 0; i < vconfig.size(); ++i) {
+                vconfig[i] += f*vdelta[i];
+            }
+            parameters->SetStateValues(vconfig);
+            _MergeAABB(_ComputeMovingAABB(robot), vmin, vmax, binit);
+        }
+        AABB ab;
+        ab.pos = 0.5*(vmin+vmax);
+        ab.extents = 0.5*(vmax-vmin);
+        return ab;
+    }
+
+    static void _MergeAABB(const AABB& ab, Vector& vmin, Vector& vmax, bool& binit)
+    {
+        if( !binit ) {
+            vmin = ab.pos - ab.extents;
+            vmax = ab.pos + ab.extents;
+            binit = true;
+        }
+        else {
+            for(int j = 0; j < 3; ++j) {
+                vmin[j] = min(vmin[j], ab.pos[j]-ab.extents[j]);
+                vmax[j] = max(vmax[j], ab.pos[j]+ab.extents[j]);
+            }
+        }
+    }
+
+    static bool _IntersectAABB(const AABB& ab0, const AABB& ab1)
+    {
+        for(int j = 0; j < 3; ++j) {
+            if( RaveFabs(ab0.pos[j]-ab1.pos[j]) > ab0.extents[j]+ab1.extents[j] ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief finds the links of the robot that the active DOFs move, and the bounding box of the rest
+    void _ComputeMovingLinks()
+    {
+        _vmovinglinks.resize(0);
+        Vector vmin, vmax;
+        bool binit = false;
+        FOREACHC(itlink, _robot->GetLinks()) {
+            if( (*itlink)->GetGeometries().size() == 0 ) {
+                continue;
+            }
+            bool bmoving = _robot->GetAffineDOF() != 0;
+            FOREACHC(itdofindex, _robot->GetActiveDOFIndices()) {
+                if( bmoving ) {
+                    break;
+                }
+                bmoving = !!_robot->DoesDOFAffectLink(*itdofindex, (*itlink)->GetIndex());
+            }
+            if( bmoving ) {
+                _vmovinglinks.push_back((*itlink)->GetIndex());
+            }
+            else {
+                _MergeAABB((*itlink)->ComputeAABB(), vmin, vmax, binit);
+            }
+        }
+        _bHasStaticLinks = binit;
+        if( binit ) {
+            _abStaticLinks.pos = 0.5*(vmin+vmax);
+            _abStaticLinks.extents = 0.5*(vmax-vmin);
+        }
+    }
+
+    /// \brief hashes everything about the robot that the roadmap depends on
+    std::string _ComputeRobotKey(RobotBasePtr robot, PlannerParametersConstPtr parameters) const
+    {
+        std::stringstream ss;
+        ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        ss << s_nRoadmapFileVersion << " " << robot->GetName() << " " << robot->GetRobotStructureHash() << " " << robot->GetAffineDOF() << " ";
+        Transform t = robot->GetTransform();
+        for(int j = 0; j < 4; ++j) {
+            ss << _QuantizeValue(t.rot[j]) << " ";
+        }
+        for(int j = 0; j < 3; ++j) {
+            ss << _QuantizeValue(t.trans[j]) << " ";
+        }
+        FOREACHC(itdofindex, robot->GetActiveDOFIndices()) {
+            ss << *itdofindex << " ";
+        }
+        // the values of the other DOFs change the geometry of the robot
+        std::vector<dReal> vdofvalues;
+        robot->GetDOFValues(vdofvalues);
+        for(size_t idof = 0; idof < vdofvalues.size(); ++idof) {
+            if( find(robot->GetActiveDOFIndices().begin(), robot->GetActiveDOFIndices().end(), (int)idof) == robot->GetActiveDOFIndices().end() ) {
+                ss << _QuantizeValue(vdofvalues[idof]) << " ";
+            }
+        }
+        std::vector<RobotBase::GrabbedInfoPtr> vgrabbedinfo;
+        robot->GetGrabbedInfo(vgrabbedinfo);
+        FOREACHC(itgrabbed, vgrabbedinfo) {
+            KinBodyPtr pgrabbed = GetEnv()->GetKinBody((*itgrabbed)->_grabbedname);
+            ss << (*itgrabbed)->_grabbedname << " " << (*itgrabbed)->_robotlinkname << " " << (!pgrabbed ? std::string() : pgrabbed->GetKinematicsGeometryHash()) << " ";
+            for(int j = 0; j < 4; ++j) {
+                ss << _QuantizeValue((*itgrabbed)->_trelative.rot[j]) << " ";
+            }
+            for(int j = 0; j < 3; ++j) {
+                ss << _QuantizeValue((*itgrabbed)->_trelative.trans[j]) << " ";
+            }
+        }
+        FOREACHC(it, parameters->_vConfigLowerLimit) {
+            ss << *it << " ";
+        }
+        FOREACHC(it, parameters->_vConfigUpperLimit) {
+            ss << *it << " ";
+        }
+        FOREACHC(it, parameters->_vConfigResolution) {
+            ss << *it << " ";
+        }
+        return ss.str();
+    }
+
+    /// \brief rounds values that are recomputed from the kinematics, so that numerical noise does not change the key
+    static int64_t _QuantizeValue(dReal f)
+    {
+        return (int64_t)floor(f*1e6+0.5);
+    }
+
+    /// \brief hashes the names and geometry of the bodies the robot is checked against, their poses are handled by \ref _UpdateEnvironmentChanges
+    std::string _ComputeEnvironmentKey() const
+    {
+        std::vector<BodyRecord> vbodyrecords;
+        _GetBodyRecords(vbodyrecords);
+        std::stringstream ss;
+        FOREACHC(itrecord, vbodyrecords) {
+            ss << itrecord->name << " " << itrecord->hash << " ";
+        }
+        return ss.str();
+    }
+
+    /// \brief gets the records of all bodies except the robot and the bodies it grabs, sorted by name
+    void _GetBodyRecords(std::vector<BodyRecord>& vbodyrecords) const
+    {
+        std::vector<KinBodyPtr> vbodies, vgrabbed;
+        GetEnv()->GetBodies(vbodies);
+        _robot->GetGrabbed(vgrabbed);
+        std::sort(vbodies.begin(), vbodies.end(), boost::bind(&KinBody::GetName, _1) < boost::bind(&KinBody::GetName, _2));
+        vbodyrecords.resize(0);
+        FOREACHC(itbody, vbodies) {
+            if( *itbody == _robot || find(vgrabbed.begin(), vgrabbed.end(), *itbody) != vgrabbed.end() ) {
+                continue;
+            }
+            vbodyrecords.push_back(BodyRecord());
+            BodyRecord& record = vbodyrecords.back();
+            record.name = (*itbody)->GetName();
+            record.hash = (*itbody)->GetKinematicsGeometryHash();
+            record.enabled = (*itbody)->IsEnabled();
+            (*itbody)->GetLinkTransformations(record.vlinktransforms);
+            record.ab = (*itbody)->ComputeAABB();
+        }
+    }
+
+    static bool _IsSameBody(const BodyRecord& record0, const BodyRecord& record1)
+    {
+        if( record0.hash != record1.hash || record0.enabled != record1.enabled || record0.vlinktransforms.size() != record1.vlinktransforms.size() ) {
+            return false;
+        }
+        for(size_t ilink = 0; ilink < record0.vlinktransforms.size(); ++ilink) {
+            const Transform& t0 = record0.vlinktransforms[ilink], &t1 = record1.vlinktransforms[ilink];
+            if( (t0.trans-t1.trans).lengthsqr3() > g_fEpsilonLinear*g_fEpsilonLinear || (t0.rot-t1.rot).lengthsqr4() > g_fEpsilonLinear*g_fEpsilonLinear ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief compares the bodies with the ones the roadmap was checked against, and marks the nodes and edges close to the changed bodies as unknown
+    void _UpdateEnvironmentChanges()
+    {
+        std::vector<BodyRecord> vbodyrecords;
+        _GetBodyRecords(vbodyrecords);
+        // the regions where the bodies were or are now
+        std::vector<AABB> vchangedaabbs;
+        std::vector<BodyRecord>::const_iterator itold = _vbodyrecords.begin(), itnew = vbodyrecords.begin();
+        while(itold != _vbodyrecords.end() || itnew != vbodyrecords.end() ) {
+            if( itnew == vbodyrecords.end() || (itold != _vbodyrecords.end() && itold->name < itnew->name) ) {
+                if( itold->enabled ) {
+                    vchangedaabbs.push_back(itold->ab);
+                }
+                ++itold;
+            }
+            else if( itold == _vbodyrecords.end() || itnew->name < itold->name ) {
+                if( itnew->enabled ) {
+                    vchangedaabbs.push_back(itnew->ab);
+                }
+                ++itnew;
+            }
+            else {
+                if( !_IsSameBody(*itold, *itnew) ) {
+                    if( itold->enabled ) {
+                        vchangedaabbs.push_back(itold->ab);
+                    }
+                    if( itnew->enabled ) {
+                        vchangedaabbs.push_back(itnew->ab);
+                    }
+                }
+                ++itold;
+                ++itnew;
+            }
+        }
+        if( vchangedaabbs.size() == 0 ) {
+            return;
+        }
+        // the build threads check against the old environment
+        _StopBuild();
+
+        boost::mutex::scoped_lock lockroadmap(_mutexRoadmap);
+        bool ball = false;
+        if( _bHasStaticLinks ) {
+            FOREACHC(itab, vchangedaabbs) {
+                if( _IntersectAABB(*itab, _abStaticLinks) ) {
+                    ball = true;
+                    break;
+                }
+            }
+        }
+        int numnodes = 0, numedges = 0;
+        FOREACH(itnode, _vroadmapnodes) {
+            FOREACHC(itab, vchangedaabbs) {
+                if( ball || _IntersectAABB(*itab, itnode->ab) ) {
+                    itnode->state = RS_Unknown;
+                    ++numnodes;
+                    break;
+                }
+            }
+        }
+        FOREACH(itedge, _vroadmapedges) {
+            FOREACHC(itab, vchangedaabbs) {
+                if( ball || _IntersectAABB(*itab, itedge->ab) ) {
+                    itedge->state = RS_Unknown;
+                    ++numedges;
+                    break;
+                }
+            }
+        }
+        _vbodyrecords.swap(vbodyrecords);
+        RAVELOG_DEBUG_FORMAT("env=%d, %d body changes, %d/%d nodes and %d/%d edges of the roadmap have to be checked again", GetEnv()->GetId()%vchangedaabbs.size()%numnodes%_vroadmapnodes.size()%numedges%_vroadmapedges.size());
+    }
+
+    /// \brief returns the configurations of vconfigs that satisfy the constraints
+    void _GetValidConfigurations(const std::vector<dReal>& vconfigs, std::vector< std::vector<dReal> >& vvalidconfigs)
+    {
+        const int dof = _parameters->GetDOF();
+        std::vector<dReal> vconfig(dof);
+        for(size_t index = 0; index < vconfigs.size(); index += dof) {
+            std::copy(vconfigs.begin()+index, vconfigs.begin()+index+dof, vconfig.begin());
+            ++_nQueryChecks;
+            if( _parameters->CheckPathAllConstraints(vconfig, vconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) == 0 ) {
+                vvalidconfigs.push_back(vconfig);
+            }
+            else {
+                RAVELOG_DEBUG_FORMAT("env=%d, configuration %d does not satisfy the constraints", GetEnv()->GetId()%(index/dof));
+            }
+        }
+    }
+
+    /// \brief checks a node that is not known to be valid. The roadmap has to be locked.
+    bool _CheckNode(int inode)
+    {
+        RoadmapNode& node = _vroadmapnodes.at(inode);
+        if( node.state == RS_Unknown ) {
+            const int dof = _parameters->GetDOF();
+            _vtempconfig0.resize(dof);
+            std::copy(_vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof, _vtempconfig0.begin());
+            ++_nQueryChecks;
+            node.state = _parameters->CheckPathAllConstraints(_vtempconfig0, _vtempconfig0, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) == 0 ? RS_Valid : RS_Invalid;
+        }
+        return node.state == RS_Valid;
+    }
+
+    /// \brief checks an edge that is not known to be valid, its nodes have to be valid. The roadmap has to be locked.
+    bool _CheckEdge(int iedge)
+    {
+        RoadmapEdge& edge = _vroadmapedges.at(iedge);
+        if( edge.state == RS_Unknown ) {
+            const int dof = _parameters->GetDOF();
+            _vtempconfig0.resize(dof);
+            _vtempconfig1.resize(dof);
+            std::copy(_vroadmapconfigs.begin()+edge.inode0*dof, _vroadmapconfigs.begin()+(edge.inode0+1)*dof, _vtempconfig0.begin());
+            std::copy(_vroadmapconfigs.begin()+edge.inode1*dof, _vroadmapconfigs.begin()+(edge.inode1+1)*dof, _vtempconfig1.begin());
+            ++_nQueryChecks;
+            edge.state = _parameters->CheckPathAllConstraints(_vtempconfig0, _vtempconfig1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open) == 0 ? RS_Valid : RS_Invalid;
+        }
+        return edge.state == RS_Valid;
+    }
+
+    /// \brief connects a valid configuration to its nearest roadmap nodes. The roadmap has to be locked.
+    ///
+    /// \param bgoal if true, the edges are checked from the nodes to vconfig
+    /// \param vconnections appends the connected node indices and the edge costs
+    void _ConnectToRoadmap(const std::vector<dReal>& vconfig, bool bgoal, std::vector< std::pair<int, dReal> >& vconnections)
+    {
+        const int dof = _parameters->GetDOF();
+        const size_t maxconnections = 5, maxtries = 20;
+        std::vector< std::pair<dReal, int> > vneighbors(_vroadmapnodes.size());
+        std::vector<dReal> vnodeconfig(dof);
+        for(size_t inode = 0; inode < _vroadmapnodes.size(); ++inode) {
+            std::copy(_vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof, vnodeconfig.begin());
+            vneighbors[inode] = make_pair(_parameters->_distmetricfn(vconfig, vnodeconfig), (int)inode);
+        }
+        size_t numtries = min(maxtries, vneighbors.size());
+        std::partial_sort(vneighbors.begin(), vneighbors.begin()+numtries, vneighbors.end());
+        size_t numconnections = 0;
+        for(size_t ineighbor = 0; ineighbor < numtries && numconnections < maxconnections; ++ineighbor) {
+            int inode = vneighbors[ineighbor].second;
+            if( !_CheckNode(inode) ) {
+                continue;
+            }
+            std::copy(_vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof, vnodeconfig.begin());
+            ++_nQueryChecks;
+            int ret = bgoal ? _parameters->CheckPathAllConstraints(vnodeconfig, vconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open) : _parameters->CheckPathAllConstraints(vconfig, vnodeconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open);
+            if( ret == 0 ) {
+                vconnections.push_back(make_pair(inode, vneighbors[ineighbor].first));
+                ++numconnections;
+            }
+        }
+    }
+
+    /// \brief A* search from the start connections to the goal connections over the nodes and edges that are not known to be invalid. The roadmap has to be locked.
+    ///
+    /// \param vnodepath the roadmap nodes of the path
+    /// \param istartconnection, igoalconnection the indices of the connections the path starts and ends with
+    bool _SearchRoadmap(const std::vector< std::pair<int, dReal> >& vstartconnections, const std::vector< std::pair<int, dReal> >& vgoalconnections, const std::vector< std::vector<dReal> >& vgoalconfigs, std::vector<int>& vnodepath, int& istartconnection, int& igoalconnection)
+    {
+        const int dof = _parameters->GetDOF();
+        const int numnodes = (int)_vroadmapnodes.size();
+        const int igoalnode = numnodes; // virtual node connected to all the goals
+        _vcosts.resize(numnodes+1);
+        _vparents.resize(numnodes+1);
+        _vclosed.resize(numnodes+1);
+        std::fill(_vcosts.begin(), _vcosts.end(), std::numeric_limits<dReal>::infinity());
+        std::fill(_vparents.begin(), _vparents.end(), -1);
+        std::fill(_vclosed.begin(), _vclosed.end(), 0);
+        _vgoalconnectionindices.resize(numnodes);
+        std::fill(_vgoalconnectionindices.begin(), _vgoalconnectionindices.end(), -1);
+        for(size_t iconnection = 0; iconnection < vgoalconnections.size(); ++iconnection) {
+            int inode = vgoalconnections[iconnection].first;
+            if( _vgoalconnectionindices[inode] < 0 || vgoalconnections[iconnection].second < vgoalconnections[_vgoalconnectionindices[inode]].second ) {
+                _vgoalconnectionindices[inode] = iconnection;
+            }
+        }
+
+        std::vector<dReal> vnodeconfig(dof);
+        // the distance to the closest goal never overestimates the cost to go
+        std::priority_queue< std::pair<dReal, int>, std::vector< std::pair<dReal, int> >, std::greater< std::pair<dReal, int> > > openset;
+        std::vector<int> vstartconnectionindices(numnodes, -1);
+        for(size_t iconnection = 0; iconnection < vstartconnections.size(); ++iconnection) {
+            int inode = vstartconnections[iconnection].first;
+            if( vstartconnections[iconnection].second < _vcosts[inode] ) {
+                _vcosts[inode] = vstartconnections[iconnection].second;
+                vstartconnectionindices[inode] = iconnection;
+                openset.push(make_pair(_vcosts[inode] + _ComputeHeuristic(inode, vgoalconfigs, vnodeconfig), inode));
+            }
+        }
+        while(!openset.empty()) {
+            int inode = openset.top().second;
+            openset.pop();
+            if( _vclosed[inode] ) {
+                continue;
+            }
+            _vclosed[inode] = 1;
+            if( inode == igoalnode ) {
+                break;
+            }
+            if( _vgoalconnectionindices[inode] >= 0 ) {
+                dReal cost = _vcosts[inode] + vgoalconnections[_vgoalconnectionindices[inode]].second;
+                if( cost < _vcosts[igoalnode] ) {
+                    _vcosts[igoalnode] = cost;
+                    _vparents[igoalnode] = inode;
+                    openset.push(make_pair(cost, igoalnode));
+                }
+            }
+            FOREACHC(itedgeindex, _vroadmapnodes[inode].vedges) {
+                const RoadmapEdge& edge = _vroadmapedges[*itedgeindex];
+                if( edge.state == RS_Invalid ) {
+                    continue;
+                }
+                int ichild = edge.inode0 == inode ? edge.inode1 : edge.inode0;
+                if( _vclosed[ichild] || _vroadmapnodes[ichild].state == RS_Invalid ) {
+                    continue;
+                }
+                dReal cost = _vcosts[inode] + edge.cost;
+                if( cost < _vcosts[ichild] ) {
+                    _vcosts[ichild] = cost;
+                    _vparents[ichild] = inode;
+                    openset.push(make_pair(cost + _ComputeHeuristic(ichild, vgoalconfigs, vnodeconfig), ichild));
+                }
+            }
+        }
+        if( !_vclosed[igoalnode] ) {
+            return false;
+        }
+
+        vnodepath.resize(0);
+        for(int inode = _vparents[igoalnode]; inode >= 0; inode = _vparents[inode]) {
+            vnodepath.push_back(inode);
+        }
+        std::reverse(vnodepath.begin(), vnodepath.end());
+        istartconnection = vstartconnectionindices.at(vnodepath.front());
+        igoalconnection = _vgoalconnectionindices.at(vnodepath.back());
+        return true;
+    }
+
+    inline dReal _ComputeHeuristic(int inode, const std::vector< std::vector<dReal> >& vgoalconfigs, std::vector<dReal>& vnodeconfig) const
+    {
+        const int dof = _parameters->GetDOF();
+        std::copy(_vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof, vnodeconfig.begin());
+        dReal fmin = std::numeric_limits<dReal>::infinity();
+        FOREACHC(itgoal, vgoalconfigs) {
+            fmin = min(fmin, _parameters->_distmetricfn(vnodeconfig, *itgoal));
+        }
+        return fmin;
+    }
+
+    /// \brief checks the nodes and edges of the path that are not known to be valid. The roadmap has to be locked.
+    ///
+    /// \return true if the path is valid, otherwise the failing node or edge is marked as invalid
+    bool _CheckRoadmapPath(const std::vector<int>& vnodepath)
+    {
+        FOREACHC(itnode, vnodepath) {
+            if( !_CheckNode(*itnode) ) {
+                return false;
+            }
+        }
+        for(size_t ipath = 1; ipath < vnodepath.size(); ++ipath) {
+            int iedge = -1;
+            FOREACHC(itedgeindex, _vroadmapnodes[vnodepath[ipath-1]].vedges) {
+                const RoadmapEdge& edge = _vroadmapedges[*itedgeindex];
+                if( edge.state != RS_Invalid && (edge.inode0 == vnodepath[ipath] || edge.inode1 == vnodepath[ipath]) ) {
+                    iedge = *itedgeindex;
+                    break;
+                }
+            }
+            BOOST_ASSERT(iedge >= 0);
+            if( !_CheckEdge(iedge) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief the roadmap has to be locked
+    bool _SaveRoadmap(const std::string& filename) const
+    {
+        FILE* pfile = fopen(filename.c_str(), "wb");
+        if( !pfile ) {
+            return false;
+        }
+        int dof = _parameters->GetDOF();
+        uint32_t numnodes = _vroadmapnodes.size(), numedges = _vroadmapedges.size(), numbodies = _vbodyrecords.size();
+        bool bSuccess = fwrite(&s_nRoadmapFileVersion, sizeof(s_nRoadmapFileVersion), 1, pfile) == 1;
+        bSuccess &= fwrite(&dof, sizeof(dof), 1, pfile) == 1;
+        bSuccess &= fwrite(&numnodes, sizeof(numnodes), 1, pfile) == 1;
+        bSuccess &= fwrite(&numedges, sizeof(numedges), 1, pfile) == 1;
+        bSuccess &= fwrite(&numbodies, sizeof(numbodies), 1, pfile) == 1;
+        std::vector<double> vvalues;
+        for(uint32_t inode = 0; inode < numnodes; ++inode) {
+            const RoadmapNode& node = _vroadmapnodes[inode];
+            vvalues.resize(0);
+            vvalues.insert(vvalues.end(), _vroadmapconfigs.begin()+inode*dof, _vroadmapconfigs.begin()+(inode+1)*dof);
+            _AppendAABB(node.ab, vvalues);
+            bSuccess &= fwrite(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1;
+            bSuccess &= fwrite(&node.state, sizeof(node.state), 1, pfile) == 1;
+        }
+        FOREACHC(itedge, _vroadmapedges) {
+            int32_t vindices[2] = {itedge->inode0, itedge->inode1};
+            vvalues.resize(0);
+            vvalues.push_back(itedge->cost);
+            _AppendAABB(itedge->ab, vvalues);
+            bSuccess &= fwrite(vindices, sizeof(vindices), 1, pfile) == 1;
+            bSuccess &= fwrite(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1;
+            bSuccess &= fwrite(&itedge->state, sizeof(itedge->state), 1, pfile) == 1;
+        }
+        FOREACHC(itrecord, _vbodyrecords) {
+            bSuccess &= _WriteString(itrecord->name, pfile) && _WriteString(itrecord->hash, pfile);
+            uint8_t enabled = itrecord->enabled;
+            uint32_t numlinks = itrecord->vlinktransforms.size();
+            bSuccess &= fwrite(&enabled, sizeof(enabled), 1, pfile) == 1;
+            bSuccess &= fwrite(&numlinks, sizeof(numlinks), 1, pfile) == 1;
+            vvalues.resize(0);
+            FOREACHC(ittrans, itrecord->vlinktransforms) {
+                for(int j = 0; j < 4; ++j) {
+                    vvalues.push_back(ittrans->rot[j]);
+                }
+                for(int j = 0; j < 3; ++j) {
+                    vvalues.push_back(ittrans->trans[j]);
+                }
+            }
+            _AppendAABB(itrecord->ab, vvalues);
+            bSuccess &= fwrite(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1;
+        }
+        fclose(pfile);
+        return bSuccess;
+    }
+
+    /// \brief the roadmap has to be locked
+    ///
+    /// \return false if the file does not exist or is not a roadmap of the current parameters
+    bool _LoadRoadmap(const std::string& filename)
+    {
+        FILE* pfile = fopen(filename.c_str(), "rb");
+        if( !pfile ) {
+            return false;
+        }
+        int version = 0, dof = 0;
+        uint32_t numnodes = 0, numedges = 0, numbodies = 0;
+        bool bSuccess = fread(&version, sizeof(version), 1, pfile) == 1 && version == s_nRoadmapFileVersion;
+        bSuccess = bSuccess && fread(&dof, sizeof(dof), 1, pfile) == 1 && dof == _parameters->GetDOF();
+        bSuccess = bSuccess && fread(&numnodes, sizeof(numnodes), 1, pfile) == 1 && fread(&numedges, sizeof(numedges), 1, pfile) == 1 && fread(&numbodies, sizeof(numbodies), 1, pfile) == 1;
+        std::vector<dReal> vroadmapconfigs;
+        std::vector<RoadmapNode> vroadmapnodes;
+        std::vector<RoadmapEdge> vroadmapedges;
+        std::vector<BodyRecord> vbodyrecords;
+        std::vector<double> vvalues;
+        if( bSuccess ) {
+            vroadmapconfigs.reserve(numnodes*dof);
+            vroadmapnodes.resize(numnodes);
+            vvalues.resize(dof+6);
+            for(uint32_t inode = 0; inode < numnodes && bSuccess; ++inode) {
+                bSuccess = fread(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1 && fread(&vroadmapnodes[inode].state, sizeof(vroadmapnodes[inode].state), 1, pfile) == 1;
+                vroadmapconfigs.insert(vroadmapconfigs.end(), vvalues.begin(), vvalues.begin()+dof);
+                vroadmapnodes[inode].ab = _ExtractAABB(vvalues.begin()+dof);
+            }
+        }
+        if( bSuccess ) {
+            vroadmapedges.resize(numedges);
+            vvalues.resize(7);
+            for(uint32_t iedge = 0; iedge < numedges && bSuccess; ++iedge) {
+                RoadmapEdge& edge = vroadmapedges[iedge];
+                int32_t vindices[2] = {0,0};
+                bSuccess = fread(vindices, sizeof(vindices), 1, pfile) == 1 && fread(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1 && fread(&edge.state, sizeof(edge.state), 1, pfile) == 1;
+                bSuccess = bSuccess && vindices[0] >= 0 && vindices[0] < (int)numnodes && vindices[1] >= 0 && vindices[1] < (int)numnodes && edge.state <= RS_Invalid;
+                if( bSuccess ) {
+                    edge.inode0 = vindices[0];
+                    edge.inode1 = vindices[1];
+                    edge.cost = vvalues[0];
+                    edge.ab = _ExtractAABB(vvalues.begin()+1);
+                    vroadmapnodes[edge.inode0].vedges.push_back(iedge);
+                    vroadmapnodes[edge.inode1].vedges.push_back(iedge);
+                }
+            }
+        }
+        if( bSuccess ) {
+            vbodyrecords.resize(numbodies);
+            for(uint32_t ibody = 0; ibody < numbodies && bSuccess; ++ibody) {
+                BodyRecord& record = vbodyrecords[ibody];
+                uint8_t enabled = 0;
+                uint32_t numlinks = 0;
+                bSuccess = _ReadString(record.name, pfile) && _ReadString(record.hash, pfile) && fread(&enabled, sizeof(enabled), 1, pfile) == 1 && fread(&numlinks, sizeof(numlinks), 1, pfile) == 1 && numlinks < 100000;
+                if( bSuccess ) {
+                    record.enabled = !!enabled;
+                    vvalues.resize(7*numlinks+6);
+                    bSuccess = fread(&vvalues[0], sizeof(vvalues[0])*vvalues.size(), 1, pfile) == 1;
+                    record.vlinktransforms.resize(numlinks);
+                    for(uint32_t ilink = 0; ilink < numlinks; ++ilink) {
+                        Transform& t = record.vlinktransforms[ilink];
+                        t.rot = Vector(vvalues[7*ilink], vvalues[7*ilink+1], vvalues[7*ilink+2], vvalues[7*ilink+3]);
+                        t.trans = Vector(vvalues[7*ilink+4], vvalues[7*ilink+5], vvalues[7*ilink+6]);
+                    }
+                    record.ab = _ExtractAABB(vvalues.begin()+7*numlinks);
+                }
+            }
+        }
+        fclose(pfile);
+        if( !bSuccess ) {
+            return false;
+        }
+        _vroadmapconfigs.swap(vroadmapconfigs);
+        _vroadmapnodes.swap(vroadmapnodes);
+        _vroadmapedges.swap(vroadmapedges);
+        _vbodyrecords.swap(vbodyrecords);
+        return true;
+    }
+
+    static void _AppendAABB(const AABB& ab, std::vector<double>& vvalues)
+    {
+        for(int j = 0; j < 3; ++j) {
+            vvalues.push_back(ab.pos[j]);
+        }
+        for(int j = 0; j < 3; ++j) {
+            vvalues.push_back(ab.extents[j]);
+        }
+    }
+
+    static AABB _ExtractAABB(std::vector<double>::const_iterator itvalues)
+    {
+        AABB ab;
+        ab.pos = Vector(itvalues[0], itvalues[1], itvalues[2]);
+        ab.extents = Vector(itvalues[3], itvalues[4], itvalues[5]);
+        return ab;
+    }
+
+    static bool _WriteString(const std::string& s, FILE* pfile)
+    {
+        uint32_t length = s.size();
+        return fwrite(&length, sizeof(length), 1, pfile) == 1 && (length == 0 || fwrite(s.c_str(), length, 1, pfile) == 1);
+    }
+
+    static bool _ReadString(std::string& s, FILE* pfile)
+    {
+        uint32_t length = 0;
+        if( fread(&length, sizeof(length), 1, pfile) != 1 || length > 100000 ) {
+            return false;
+        }
+        s.resize(length);
+        return length == 0 || fread(&s[0], length, 1, pfile) == 1;
+    }
+
+    PlannerParametersPtr _parameters;
+    RobotBasePtr _robot;
+    std::string _robotkey; ///< the robot part of the key of the roadmap in memory
+    std::string _key; ///< md5 hash the roadmap is saved with
+    std::vector<int> _vmovinglinks; ///< indices of the robot links moved by the active DOFs
+    AABB _abStaticLinks; ///< bounding box of the links that the active DOFs do not move
+    bool _bHasStaticLinks;
+
+    boost::mutex _mutexRoadmap; ///< protects the roadmap from the build thread. Only the build thread adds nodes and edges.
+    std::vector<dReal> _vroadmapconfigs; ///< the configurations of all nodes
+    std::vector<RoadmapNode> _vroadmapnodes;
+    std::vector<RoadmapEdge> _vroadmapedges;
+    std::vector<BodyRecord> _vbodyrecords; ///< the bodies the roadmap was checked against, sorted by name
+
+    std::vector<RoadmapWorkerPtr> _vworkers;
+    boost::shared_ptr<boost::thread> _threadBuild;
+    volatile bool _bStopBuild;
+
+    // query cache
+    int _nQueryChecks; ///< number of constraint checks of the last query
+    std::vector<dReal> _vcosts, _vtempconfig0, _vtempconfig1;
+    std::vector<int> _vparents, _vgoalconnectionindices;
+    std::vector<uint8_t> _vclosed;
+};
+
+PlannerBasePtr CreatePrmPlanner(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new PrmPlanner(penv, sinput));
+}
@@ -13,7 +13,7 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
-#include "openraveplugindefs.h"
+#include "rplanners.h"
 
 class RandomizedAStarPlanner : public PlannerBase
 {
@@ -49,79 +49,26 @@ private:
         dReal _thresh;
     };
 
-
-    // sorted by increasing getvalue
-    template <class T, class S> class BinarySearchTree
+    /// \brief distance to the goal configuration, 0 when closer than thresh
+    class GoalConfigMetric
     {
 public:
-        BinarySearchTree() {
-            Reset();
+        GoalConfigMetric(const PlannerBase::PlannerParameters::DistMetricFn& distmetricfn, const vector<dReal>& vgoalconfig, dReal thresh) : _distmetricfn(distmetricfn), _vgoalconfig(vgoalconfig), _thresh(thresh) {
         }
 
-        // other global definitions
-        void Add(T& pex)
-        {
-            BOOST_ASSERT( pex != NULL );
-
-            switch(blocks.size()) {
-            case 0:
-                blocks.push_back(pex);
-                return;
-            case 1:
-                if( blocks.front()->getvalue() < pex->getvalue() ) {
-                    blocks.push_back(pex);
-                }
-                else blocks.insert(blocks.begin(), pex);
-
-                return;
-
-            default: {
-                int imin = 0, imax = (int)blocks.size(), imid;
-
-                while(imin < imax) {
-                    imid = (imin+imax)>>1;
-
-                    if( blocks[imid]->getvalue() > pex->getvalue() ) imax = imid;
-                    else imin = imid+1;
-                }
-
-                blocks.insert(blocks.begin()+imin, pex);
-                return;
-            }
-            }
-        }
-
-        ///< returns the index into blocks
-        int Get(S& s)
-        {
-            switch(blocks.size()) {
-            case 1: return 0;
-            case 2: return blocks.front()->getvalue() < s;
-            default: {
-                int imin = 0, imax = blocks.size()-1, imid;
-
-                while(imin < imax) {
-                    imid = (imin+imax)>>1;
-
-                    if( blocks[imid]->getvalue() > s ) imax = imid;
-                    else if( blocks[imid]->getvalue() == s ) return imid;
-                    else imin = imid+1;
-                }
-
-                return imin;
-            }
-            }
-        }
-
-        void Reset()
+        dReal Eval(const vector<dReal>& c1)
         {
-            blocks.clear();
-            blocks.reserve(1<<16);
+            dReal f = _distmetricfn(c1, _vgoalconfig);
+            return f < _thresh ? 0 : f;
         }
 
-        vector<T> blocks;
+private:
+        PlannerBase::PlannerParameters::DistMetricFn _distmetricfn;
+        vector<dReal> _vgoalconfig;
+        dReal _thresh;
     };
 
+
 public:
     class RAStarParameters : public PlannerBase::PlannerParameters {
 public:
@@ -189,26 +136,22 @@ protected:
         }
     };
 
+    /// \brief search node allocated from the planner pool. be careful when constructing since placement new operator is needed.
     struct Node
     {
-        Node() {
-            parent = NULL; level = 0; numchildren = 0;
-        }
-
-        // negative because those are most likely to be popped first
-        dReal getvalue() {
-            return -ftotal;
-        }
-
-        bool compare(const Node* r) {
-            BOOST_ASSERT(r != NULL); return ftotal < r->ftotal;
+        Node(Node* parent, const vector<dReal>& config, int id) : parent(parent), id(id) {
+            fcost = 0; ftotal = 0; numchildren = 0; heapindex = -1;
+            level = parent != NULL ? parent->level + 1 : 0;
+            std::copy(config.begin(), config.end(), q);
         }
 
         dReal fcost, ftotal;
         int level;
         Node* parent;
         int numchildren;
-        vector<dReal> q;     // the configuration immediately follows the struct
+        int heapindex;     ///< position in the open set heap, -1 if the node is not open
+        int id;     ///< index into _vnodes, also stored as the user data of the nearest neighbor tree node
+        dReal q[0];     // the configuration immediately follows the struct
     };
 
     static bool SortChildGoal(const RandomizedAStarPlanner::Node* p1, const RandomizedAStarPlanner::Node* p2)
@@ -216,59 +159,94 @@ protected:
         return p1->ftotal < p2->ftotal;    //p1->ftotal-p1->fcost < p2->ftotal-p2->fcost;
     }
 
-    // implement kd-tree or approx-nn in the future, deallocates memory from Node
-    class SpatialTree
+    /// \brief binary min-heap of the open nodes ordered by ftotal.
+    ///
+    /// Every node tracks its own heap position so that its key can be decreased in place when a cheaper parent is found.
+    class OpenSet
     {
 public:
-        SpatialTree() {
-            _fBestDist = 0;
+        void Reset()
+        {
+            _vheap.resize(0);
+        }
+
+        inline bool IsEmpty() const {
+            return _vheap.size() == 0;
         }
-        ~SpatialTree() {
-            Destroy();
+
+        inline int GetSize() const {
+            return (int)_vheap.size();
         }
 
-        void Destroy()
+        void Push(Node* pnode)
         {
-            list<Node*>::iterator it;
-            FORIT(it, _nodes)
-            delete *it;
-            FORIT(it, _dead)
-            delete *it;
-            _nodes.clear();
+            BOOST_ASSERT( pnode != NULL && pnode->heapindex < 0 );
+            _vheap.push_back(pnode);
+            _SiftUp((int)_vheap.size()-1);
         }
 
-        inline void AddNode(Node* pnode) {
-            _nodes.push_back(pnode);
-        }
-        Node* GetNN(const vector<dReal>& q)
+        /// \brief removes and returns the node with the smallest ftotal
+        Node* Pop()
         {
-            if( _nodes.size() == 0 )
-                return NULL;
-
-            list<Node*>::iterator itnode = _nodes.begin(), itbest = _nodes.begin();
-            dReal fbest = _pDistMetric(q, _nodes.front()->q);
-            ++itnode;
-
-            while(itnode != _nodes.end()) {
-                dReal f = _pDistMetric(q, (*itnode)->q);
-                if( f < fbest ) {
-                    itbest = itnode;
-                    fbest = f;
-                }
-                ++itnode;
+            Node* ptop = _vheap.front();
+            ptop->heapindex = -1;
+            Node* plast = _vheap.back();
+            _vheap.pop_back();
+            if( _vheap.size() > 0 ) {
+                _vheap[0] = plast;
+                _SiftDown(0);
             }
+            return ptop;
+        }
 
-            _fBestDist = fbest;
-            return *itbest;
+        /// \brief restores the heap order after the ftotal of an open node has been lowered
+        void DecreaseKey(Node* pnode)
+        {
+            BOOST_ASSERT( pnode->heapindex >= 0 && pnode->heapindex < (int)_vheap.size() && _vheap[pnode->heapindex] == pnode );
+            _SiftUp(pnode->heapindex);
         }
-        inline void RemoveNode(Node* pnode) {
-            _nodes.remove(pnode);
+
+        std::vector<Node*> _vheap;
+
+private:
+        void _SiftUp(int index)
+        {
+            Node* pnode = _vheap[index];
+            while(index > 0) {
+                int parentindex = (index-1)>>1;
+                if( !(pnode->ftotal < _vheap[parentindex]->ftotal) ) {
+                    break;
+                }
+                _vheap[index] = _vheap[parentindex];
+                _vheap[index]->heapindex = index;
+                index = parentindex;
+            }
+            _vheap[index] = pnode;
+            pnode->heapindex = index;
         }
 
-        list<Node*> _nodes;
-        list<Node*> _dead;
-        boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> _pDistMetric;
-        dReal _fBestDist;         ///< valid after a call to GetNN
+        void _SiftDown(int index)
+        {
+            Node* pnode = _vheap[index];
+            int size = (int)_vheap.size();
+            while(1) {
+                int childindex = 2*index+1;
+                if( childindex >= size ) {
+                    break;
+                }
+                if( childindex+1 < size && _vheap[childindex+1]->ftotal < _vheap[childindex]->ftotal ) {
+                    ++childindex;
+                }
+                if( !(_vheap[childindex]->ftotal < pnode->ftotal) ) {
+                    break;
+                }
+                _vheap[index] = _vheap[childindex];
+                _vheap[index]->heapindex = index;
+                index = childindex;
+            }
+            _vheap[index] = pnode;
+            pnode->heapindex = index;
+        }
     };
 
     enum IntervalType {
@@ -278,15 +256,17 @@ public:
         CLOSED
     };
 
-    RandomizedAStarPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv)
+    RandomizedAStarPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _spatialtree(0)
     {
         __description = ":Interface Author: Rosen Diankov\n\nRandomized A*. A continuous version of A*. See:\n\
 Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf. on Intelligent Robots and Systems, October 2007.\"\n";
         bUseGauss = false;
         nIndex = 0;
+        _bGoalConfig = false;
     }
 
     virtual ~RandomizedAStarPlanner() {
+        Destroy();
     }
 
     virtual PlannerParametersConstPtr GetParameters() const {
@@ -295,15 +275,15 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
 
     void Destroy()
     {
-        _spatialtree.Destroy();
-        _sortedtree.Reset();
-
-        //    for(size_t i = 0; i < _vdeadnodes.size(); ++i) {
-        //        _vdeadnodes[i]->~Node();
-        //        free(_vdeadnodes[i]);
-        //    }
-        _vdeadnodes.clear();
-        _vdeadnodes.reserve(1<<16);
+        _spatialtree.Reset();
+        _openset.Reset();
+        FOREACH(itnode, _vnodes) {
+            (*itnode)->~Node();
+        }
+        _vnodes.resize(0);
+        if( !!_pNodesPool ) {
+            _pNodesPool->purge_memory();
+        }
     }
 
     // Planning Methods
@@ -319,15 +299,30 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
 
         RobotBase::RobotStateSaver savestate(_robot);
 
-        if( !parameters->_goalfn )
-            parameters->_goalfn = boost::bind(&SimpleGoalMetric::Eval,boost::shared_ptr<SimpleGoalMetric>(new SimpleGoalMetric(_robot)),_1);
+        _bGoalConfig = false;
+        if( !parameters->_goalfn ) {
+            if( (int)parameters->vgoalconfig.size() == parameters->GetDOF() ) {
+                // search towards the goal configuration and connect it to the path at the end
+                parameters->_goalfn = boost::bind(&GoalConfigMetric::Eval,boost::shared_ptr<GoalConfigMetric>(new GoalConfigMetric(parameters->_distmetricfn, parameters->vgoalconfig, parameters->fRadius)),_1);
+                _bGoalConfig = true;
+            }
+            else {
+                parameters->_goalfn = boost::bind(&SimpleGoalMetric::Eval,boost::shared_ptr<SimpleGoalMetric>(new SimpleGoalMetric(_robot)),_1);
+            }
+        }
         if( !parameters->_costfn )
             parameters->_costfn = boost::bind(&SimpleCostMetric::Eval,boost::shared_ptr<SimpleCostMetric>(new SimpleCostMetric(_robot)),_1);
 
-        _vSampleConfig.resize(GetDOF());
-        _jointIncrement.resize(GetDOF());
-        _vzero.resize(GetDOF(),0);
-        _spatialtree._pDistMetric = parameters->_distmetricfn;
+        _vSampleConfig.resize(parameters->GetDOF());
+        _vCurrentConfig.resize(parameters->GetDOF());
+        _vNearestConfig.resize(parameters->GetDOF());
+        _jointIncrement.resize(parameters->GetDOF());
+        _vzero.resize(parameters->GetDOF(),0);
+        _spatialtree.Init(shared_planner(), parameters->GetDOF(), parameters->_distmetricfn, parameters->_fStepLength, parameters->_distmetricfn(parameters->_vConfigLowerLimit, parameters->_vConfigUpperLimit));
+        size_t nodesize = sizeof(Node)+parameters->GetDOF()*sizeof(dReal);
+        if( !_pNodesPool || _pNodesPool->get_requested_size() != nodesize ) {
+            _pNodesPool.reset(new boost::pool<>(nodesize));
+        }
 
         _jointResolutionInv.resize(0);
         FOREACH(itj, parameters->_vConfigResolution) {
@@ -367,22 +362,20 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
         vector<dReal> tempconfig(GetDOF());
         int nMaxIter = _parameters->_nMaxIterations > 0 ? _parameters->_nMaxIterations : 8000;
 
-        while(1) {
-            if( _sortedtree.blocks.size() == 0 ) {
-                break;
-            }
-            else {
-                pcurrent = _sortedtree.blocks.back();
-            }
-
-            // delete from current lists
-            _sortedtree.blocks.pop_back();
-            _vdeadnodes.push_back(pcurrent);
+        while(!_openset.IsEmpty()) {
+            OPENRAVE_PROFILE_SCOPE("RandomizedAStarPlanner::Iteration");
+            pcurrent = _openset.Pop();
             BOOST_ASSERT( pcurrent->numchildren < _parameters->nMaxChildren );
 
+            std::copy(pcurrent->q, pcurrent->q+GetDOF(), _vCurrentConfig.begin());
+
             if( pcurrent->ftotal - pcurrent->fcost < 1e-4f ) {
-                pbest = pcurrent;
-                break;
+                if( !_bGoalConfig || _parameters->CheckPathAllConstraints(_vCurrentConfig, _parameters->vgoalconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) == 0 ) {
+                    pbest = pcurrent;
+                    break;
+                }
+                // the goal configuration cannot be connected to this node, so keep on expanding it
+                RAVELOG_VERBOSE("RA* could not connect the node to the goal configuration\n");
             }
 
             list<Node*> children;
@@ -393,12 +386,12 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
                 // keep on sampling until a valid config
                 int sample;
                 for(sample = 0; sample < _parameters->nMaxSampleTries; ++sample) {
-                    if( !_parameters->_sampleneighfn(_vSampleConfig, pcurrent->q, _parameters->fRadius) ) {
+                    if( !_parameters->_sampleneighfn(_vSampleConfig, _vCurrentConfig, _parameters->fRadius) ) {
                         sample = 1000;
                         break;
                     }
 
-                    if ( _parameters->CheckPathAllConstraints(pcurrent->q, _vSampleConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) == 0 ) {
+                    if ( _parameters->CheckPathAllConstraints(_vCurrentConfig, _vSampleConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
                         continue;
                     }
                     if( _parameters->SetStateValues(_vSampleConfig) != 0 ) {
@@ -412,20 +405,33 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
 
                 //while (getchar() != '\n') usleep(1000);
 
-                Node* nearestnode = _spatialtree.GetNN(_vSampleConfig);
-                if( _spatialtree._fBestDist > _parameters->fDistThresh ) {
-                    dReal fdist = _parameters->_distmetricfn(pcurrent->q, _vSampleConfig);
-                    CreateNode(nearestnode->fcost + fdist * _parameters->_costfn(_vSampleConfig), nearestnode, _vSampleConfig, true);
+                std::pair<NodeBasePtr, dReal> nn = _spatialtree.FindNearestNode(_vSampleConfig);
+                Node* nearestnode = _vnodes.at(((SimpleNode*)nn.first)->_userdata);
+                if( nn.second > _parameters->fDistThresh ) {
+                    dReal fdist = _parameters->_distmetricfn(_vCurrentConfig, _vSampleConfig);
+                    CreateNode(nearestnode->fcost + fdist * _parameters->_costfn(_vSampleConfig), nearestnode, _vSampleConfig);
                     pcurrent->numchildren++;
 
-                    if( (_spatialtree._nodes.size() % 50) == 0 ) {
+                    if( (_vnodes.size() % 50) == 0 ) {
                         //DumpNodes();
-                        RAVELOG_VERBOSE(str(boost::format("trees at %d(%d) : to goal at %f,%f\n")%_sortedtree.blocks.size()%_spatialtree._nodes.size()%((pcurrent->ftotal-pcurrent->fcost)/_parameters->fGoalCoeff)%pcurrent->fcost));
+                        RAVELOG_VERBOSE(str(boost::format("trees at %d(%d) : to goal at %f,%f\n")%_openset.GetSize()%_vnodes.size()%((pcurrent->ftotal-pcurrent->fcost)/_parameters->fGoalCoeff)%pcurrent->fcost));
+                    }
+                }
+                else if( nearestnode != pcurrent && nearestnode->heapindex >= 0 ) {
+                    // the sample duplicates a node that is still open, so reroute it through pcurrent if that is cheaper
+                    _vNearestConfig.assign(nearestnode->q, nearestnode->q+GetDOF());
+                    dReal fcost = pcurrent->fcost + _parameters->_distmetricfn(_vCurrentConfig, _vNearestConfig) * _parameters->_costfn(_vNearestConfig);
+                    if( fcost < nearestnode->fcost && _parameters->CheckPathAllConstraints(_vCurrentConfig, _vNearestConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) == 0 ) {
+                        nearestnode->ftotal += fcost - nearestnode->fcost;
+                        nearestnode->fcost = fcost;
+                        nearestnode->parent = pcurrent;
+                        nearestnode->level = pcurrent->level + 1;
+                        _openset.DecreaseKey(nearestnode);
                     }
                 }
             }
 
-            if( (int)_spatialtree._nodes.size() > nMaxIter ) {
+            if( (int)_vnodes.size() > nMaxIter ) {
                 break;
             }
         }
@@ -435,7 +441,8 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
         }
 
         RAVELOG_DEBUG("Path found, final node: %f, %f\n", pbest->fcost, pbest->ftotal-pbest->fcost);
-        if( _parameters->CheckPathAllConstraints(pbest->q,pbest->q,std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+        _vCurrentConfig.assign(pbest->q, pbest->q+GetDOF());
+        if( _parameters->CheckPathAllConstraints(_vCurrentConfig,_vCurrentConfig,std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
             RAVELOG_WARN("RA* bad initial config\n");
         }
 
@@ -469,38 +476,37 @@ Rosen Diankov, James Kuffner. \"Randomized Statistical Path Planning. Intl. Conf
             itprev = itcur;
             ++itcur;
         }
+        if( _bGoalConfig ) {
+            // the edge to the goal was checked when pbest was chosen
+            _InterpolateNodes(pbest->q, &_parameters->vgoalconfig[0], ptraj);
+        }
 
         _ProcessPostPlanners(_robot,ptraj);
         return PS_HasSolution;
     }
 
     int GetTotalNodes() {
-        return (int)_sortedtree.blocks.size();
+        return _openset.GetSize();
     }
 
     bool bUseGauss;
 
 private:
 
-    Node* CreateNode(dReal fcost, Node* parent, const vector<dReal>& pfConfig, bool add = true)
+    /// \brief allocates a node from the pool and adds it to the open set and the nearest neighbor tree
+    Node* CreateNode(dReal fcost, Node* parent, const vector<dReal>& pfConfig)
     {
-        Node* p = new Node();
-        p->parent = parent;
-        if( parent != NULL )
-            p->level = parent->level + 1;
-
-        p->q = pfConfig;
+        void* pmemory = _pNodesPool->malloc();
+        Node* p = new (pmemory) Node(parent, pfConfig, (int)_vnodes.size());
         p->fcost = fcost;
         p->ftotal = _parameters->fGoalCoeff*_parameters->_goalfn(pfConfig) + fcost;
-
-        if( add ) {
-            _spatialtree.AddNode(p);
-            _sortedtree.Add(p);
-        }
+        _vnodes.push_back(p);
+        _spatialtree.InsertNode(NULL, pfConfig, p->id);
+        _openset.Push(p);
         return p;
     }
 
-    void _InterpolateNodes(const vector<dReal>& pQ0, const vector<dReal>& pQ1, TrajectoryBasePtr ptraj)
+    void _InterpolateNodes(const dReal* pQ0, const dReal* pQ1, TrajectoryBasePtr ptraj)
     {
         // compute  the discretization
         int i, numSteps = 1;
@@ -544,7 +550,9 @@ private:
             advance(endNode, endIndex-startIndex);
 
             // check if the nodes can be connected by a straight line
-            if( _parameters->CheckPathAllConstraints((*startNode)->q, (*endNode)->q, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open)  != 0 ) {
+            _vCurrentConfig.assign((*startNode)->q, (*startNode)->q+GetDOF());
+            _vNearestConfig.assign((*endNode)->q, (*endNode)->q+GetDOF());
+            if( _parameters->CheckPathAllConstraints(_vCurrentConfig, _vNearestConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open)  != 0 ) {
                 continue;
             }
 
@@ -565,39 +573,17 @@ private:
             return;
         }
 
-        vector<Node*>::iterator it;
-
-        vector<Node*>* allnodes[2] = { &_vdeadnodes, &_sortedtree.blocks };
-
         fprintf(f, "allnodes = [");
-
-        for(int n = 0; n < 2; ++n) {
-
-            FORIT(it, *allnodes[n]) {
-                for(int i = 0; i < GetDOF(); ++i) {
-                    fprintf(f, "%f ", (*it)->q[i]);
-                }
-
-                int index = 0;
-                if( (*it)->parent != NULL ) {
-
-                    index = 0;
-                    for(size_t j = 0; j < 2; ++j) {
-                        vector<Node*>::iterator itfound = find(allnodes[j]->begin(), allnodes[j]->end(), (*it)->parent);
-                        if( itfound != allnodes[j]->end() ) {
-                            index += (int)(itfound-allnodes[j]->begin());
-                            break;
-                        }
-                        index += (int)_vdeadnodes.size();
-                    }
-                }
-
-                fprintf(f, "%f %d\n", ((*it)->ftotal-(*it)->fcost)/_parameters->fGoalCoeff, index+1);
+        FOREACHC(it, _vnodes) {
+            for(int i = 0; i < GetDOF(); ++i) {
+                fprintf(f, "%f ", (*it)->q[i]);
             }
+            int index = (*it)->parent != NULL ? (*it)->parent->id : 0;
+            fprintf(f, "%f %d\n", ((*it)->ftotal-(*it)->fcost)/_parameters->fGoalCoeff, index+1);
         }
 
         fprintf(f,"];\r\n\r\n");
-        fprintf(f, "%s", str(boost::format("startindex = %d")%(_vdeadnodes.size()+1)).c_str());
+        fprintf(f, "startindex = 1");
 
         fclose(f);
     }
@@ -607,18 +593,20 @@ private:
     }
 
     boost::shared_ptr<RAStarParameters> _parameters;
-    SpatialTree _spatialtree;
-    BinarySearchTree<Node*, dReal> _sortedtree;       // sorted by decreasing value
+    SpatialTree<SimpleNode> _spatialtree;     ///< cover tree over all nodes for nearest neighbor and duplicate queries, user data is the Node::id
+    OpenSet _openset;
+    boost::shared_ptr< boost::pool<> > _pNodesPool;     ///< pool nodes are created from, all memory is released in Destroy
+    vector<Node*> _vnodes;     ///< all nodes in creation order
 
     RobotBasePtr _robot;
 
-    vector<Node*> _vdeadnodes;     ///< dead nodes
-    vector<dReal> _vSampleConfig;
+    vector<dReal> _vSampleConfig, _vCurrentConfig, _vNearestConfig;
     vector<dReal> _jointIncrement, _jointResolutionInv;
     vector<dReal> _vzero;
 
     vector<Transform> _vectrans;     ///< cache
     int nIndex;
+    bool _bGoalConfig;     ///< if true, _goalfn is the distance to vgoalconfig and the path is connected to the goal
 };
 
 PlannerBasePtr CreateRandomizedAStarPlanner(EnvironmentBasePtr penv, std::istream& sinput) {
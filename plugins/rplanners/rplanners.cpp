@@ -22,10 +22,12 @@
 PlannerBasePtr CreateShortcutLinearPlanner(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateGraspGradientPlanner(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateRandomizedAStarPlanner(EnvironmentBasePtr penv, std::istream& sinput);
+PlannerBasePtr CreatePrmPlanner(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateWorkspaceTrajectoryTracker(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateLinearTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateParabolicTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateCubicTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput);
+PlannerBasePtr CreateToppraTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateLinearSmoother(EnvironmentBasePtr penv, std::istream& sinput);
 PlannerBasePtr CreateConstraintParabolicSmoother(EnvironmentBasePtr penv, std::istream& sinput);
 
@@ -47,6 +49,12 @@ InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string&
             RAVELOG_WARN("rBiRRT is deprecated, use BiRRT\n");
             return InterfaceBasePtr(new BirrtPlanner(penv));
         }
+        else if( interfacename == "lazybirrt") {
+            return InterfaceBasePtr(new LazyBirrtPlanner(penv));
+        }
+        else if( interfacename == "prm") {
+            return CreatePrmPlanner(penv,sinput);
+        }
         else if( interfacename == "basicrrt") {
             return InterfaceBasePtr(new BasicRrtPlanner(penv));
         }
@@ -68,6 +76,9 @@ InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string&
         else if( interfacename == "cubictrajectoryretimer" ) {
             return CreateCubicTrajectoryRetimer(penv,sinput);
         }
+        else if( interfacename == "toppratrajectoryretimer" ) {
+            return CreateToppraTrajectoryRetimer(penv,sinput);
+        }
         else if( interfacename == "workspacetrajectorytracker" ) {
             return CreateWorkspaceTrajectoryTracker(penv,sinput);
         }
@@ -91,6 +102,8 @@ void GetPluginAttributesValidated(PLUGININFO& info)
 {
     info.interfacenames[PT_Planner].push_back("RAStar");
     info.interfacenames[PT_Planner].push_back("BiRRT");
+    info.interfacenames[PT_Planner].push_back("LazyBiRRT");
+    info.interfacenames[PT_Planner].push_back("PRM");
     info.interfacenames[PT_Planner].push_back("BasicRRT");
     info.interfacenames[PT_Planner].push_back("ExplorationRRT");
     info.interfacenames[PT_Planner].push_back("GraspGradient");
@@ -98,6 +111,7 @@ void GetPluginAttributesValidated(PLUGININFO& info)
     info.interfacenames[PT_Planner].push_back("LinearTrajectoryRetimer");
     info.interfacenames[PT_Planner].push_back("ParabolicTrajectoryRetimer");
     info.interfacenames[PT_Planner].push_back("CubicTrajectoryRetimer");
+    info.interfacenames[PT_Planner].push_back("ToppraTrajectoryRetimer");
     info.interfacenames[PT_Planner].push_back("WorkspaceTrajectoryTracker");
     info.interfacenames[PT_Planner].push_back("LinearSmoother");
     info.interfacenames[PT_Planner].push_back("ParabolicSmoother");
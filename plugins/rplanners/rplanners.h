@@ -83,14 +83,18 @@ public:
         _level = 0;
         _hasselfchild = 0;
         _usenn = 1;
+        _edgechecked = 1;
         _userdata = 0;
+        _nodeindex = 0;
     }
     SimpleNode(SimpleNode* parent, const dReal* pconfig, int dof) : rrtparent(parent) {
         std::copy(pconfig, pconfig+dof, q);
         _level = 0;
         _hasselfchild = 0;
         _usenn = 1;
+        _edgechecked = 1;
         _userdata = 0;
+        _nodeindex = 0;
     }
     ~SimpleNode() {
     }
@@ -100,7 +104,9 @@ public:
     int16_t _level; ///< the level the node belongs to
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
     uint8_t _usenn; ///< if 1, then use part of the nearest neighbor search, otherwise ignore
+    uint8_t _edgechecked; ///< if 1, then the edge from rrtparent to this node satisfies all constraints. Nodes added by a lazy Extend start with 0.
     uint32_t _userdata; ///< user specified data tagging this node
+    uint32_t _nodeindex; ///< index of the node in SpatialTree::_vnodes
 
 #ifdef _DEBUG
     int id;
@@ -151,6 +157,8 @@ public:
         _fStepLength = 0.04f;
         _dof = 0;
         _numnodes = 0;
+        _nDeletedNodes = 0;
+        _nEdgeChecks = 0;
         _base = 1.5; // optimal is 1.3?
         _fBaseInv = 1/_base;
         _fBaseChildMult = 1/(_base-1);
@@ -159,6 +167,8 @@ public:
         _maxlevel = 0;
         _minlevel = 0;
         _fMaxLevelBound = 0;
+        _bLazyExtend = false;
+        _bLazyCheckStates = true;
     }
 
     ~SpatialTree() {
@@ -168,6 +178,7 @@ public:
     virtual void Init(boost::weak_ptr<PlannerBase> planner, int dof, boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)>& distmetricfn, dReal fStepLength, dReal maxdistance)
     {
         Reset();
+        _nEdgeChecks = 0;
         if( !!_pNodesPool ) {
             // see if pool can be preserved
             if( _dof != dof ) {
@@ -209,12 +220,24 @@ public:
             //_pNodesPool->purge_memory();
             _pNodesPool.reset(new boost::pool<>(sizeof(Node)+_dof*sizeof(dReal)));
         }
+        _vnodes.resize(0);
+        _nDeletedNodes = 0;
         _numnodes = 0;
     }
 
+    /// \brief sets how Extend validates the new nodes
+    ///
+    /// \param bLazy if true, the edges to the new nodes are not checked and the nodes are added with _edgechecked=0. The caller has to check the edges of the paths it uses.
+    /// \param bCheckStates if bLazy is true, check the new states without their edges
+    void SetLazyExtend(bool bLazy, bool bCheckStates)
+    {
+        _bLazyExtend = bLazy;
+        _bLazyCheckStates = bCheckStates;
+    }
+
     inline dReal _ComputeDistance(const dReal* config0, const dReal* config1) const
     {
-        return _distmetricfn(VectorWrapper<const dReal>(config0, config0+_dof), VectorWrapper<dReal>(config1, config1+_dof));
+        return _distmetricfn(VectorWrapper<dReal>(config0, config0+_dof), VectorWrapper<dReal>(config1, config1+_dof));
     }
 
     inline dReal _ComputeDistance(const dReal* config0, const std::vector<dReal>& config1) const
@@ -241,24 +264,17 @@ public:
     {
         //BOOST_ASSERT(Validate());
         uint64_t starttime = utils::GetNanoPerformanceTime();
-        // first gather all the nodes, and then delete them in reverse order they were originally added in
+        // the cover tree can hold clones of parent that represent the same rrt node, so invalidate them too.
+        // since the rrt parents are created before their children, one pass propagates the invalidation to all descendants.
         NodePtr parent = (NodePtr)parentbase;
-        parent->_usenn = 0;
-        _setchildcache.clear(); _setchildcache.insert(parent);
-        int numruns=0;
-        bool bchanged=true;
-        while(bchanged) {
-            bchanged=false;
-            FOREACHC(itchildren, _vsetLevelNodes) {
-                FOREACHC(itchild, *itchildren) {
-                    if( _setchildcache.find(*itchild) == _setchildcache.end() && _setchildcache.find((*itchild)->rrtparent) != _setchildcache.end() ) {
-                        (*itchild)->_usenn = 0;
-                        _setchildcache.insert(*itchild);
-                        bchanged=true;
-                    }
-                }
+        FOREACH(itnode, _vnodes) {
+            NodePtr pnode = *itnode;
+            if( !pnode ) {
+                continue;
+            }
+            if( pnode == parent || (!!pnode->rrtparent && !pnode->rrtparent->_usenn) || (pnode->rrtparent == parent->rrtparent && std::equal(parent->q, parent->q+_dof, pnode->q)) ) {
+                pnode->_usenn = 0;
             }
-            ++numruns;
         }
         RAVELOG_VERBOSE("computed in %fs", (1e-9*(utils::GetNanoPerformanceTime()-starttime)));
     }
@@ -358,12 +374,19 @@ public:
                 return ET_Failed;
             }
 
-            if( _fromgoal ) {
+            if( _bLazyExtend ) {
+                if( _bLazyCheckStates && params->CheckPathAllConstraints(_vNewConfig, _vNewConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+                    return bHasAdded ? ET_Sucess : ET_Failed;
+                }
+            }
+            else if( _fromgoal ) {
+                ++_nEdgeChecks;
                 if( params->CheckPathAllConstraints(_vNewConfig, _vCurConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenEnd) != 0 ) {
                     return bHasAdded ? ET_Sucess : ET_Failed;
                 }
             }
             else {
+                ++_nEdgeChecks;
                 if( params->CheckPathAllConstraints(_vCurConfig, _vNewConfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
                     return bHasAdded ? ET_Sucess : ET_Failed;
                 }
@@ -371,6 +394,7 @@ public:
 
             NodePtr pnewnode = _InsertNode(pnode, _vNewConfig, 0); ///< set userdata to 0
             if( !!pnewnode ) {
+                pnewnode->_edgechecked = !_bLazyExtend;
                 pnode = pnewnode;
                 lastnode = pnode;
                 bHasAdded = true;
@@ -388,6 +412,11 @@ public:
         return _numnodes;
     }
 
+    /// \brief returns the number of edges Extend checked since Init
+    int GetNumEdgeChecks() const {
+        return _nEdgeChecks;
+    }
+
     virtual const vector<dReal>& GetVectorConfig(NodeBasePtr nodebase) const
     {
         NodePtr node = (NodePtr)nodebase;
@@ -567,15 +596,37 @@ private:
         void* pmemory = _pNodesPool->malloc();
         NodePtr node = new (pmemory) Node(refnode->rrtparent, refnode->q, _dof);
         node->_userdata = refnode->_userdata;
+        node->_edgechecked = refnode->_edgechecked;
 #ifdef _DEBUG
         node->id = GetNewStaticId();
 #endif
+        _AddToNodesVector(node);
         return node;
     }
 
+    inline void _AddToNodesVector(NodePtr node)
+    {
+        node->_nodeindex = _vnodes.size();
+        _vnodes.push_back(node);
+    }
+
     void _DeleteNode(Node* p)
     {
         if( !!p ) {
+            // mark the slot as deleted instead of erasing it so that _vnodes keeps the parents before their children. compact once half of the slots are deleted.
+            _vnodes.at(p->_nodeindex) = NULL;
+            ++_nDeletedNodes;
+            if( 2*_nDeletedNodes > _vnodes.size() ) {
+                size_t nvalid = 0;
+                for(size_t inode = 0; inode < _vnodes.size(); ++inode) {
+                    if( !!_vnodes[inode] ) {
+                        _vnodes[inode]->_nodeindex = nvalid;
+                        _vnodes[nvalid++] = _vnodes[inode];
+                    }
+                }
+                _vnodes.resize(nvalid);
+                _nDeletedNodes = 0;
+            }
             p->~Node();
             _pNodesPool->free(p);
         }
@@ -617,7 +668,7 @@ private:
                 // only take the children whose distances are within the bound
                 FOREACHC(itchild, itcurrentnode->first->_vchildren) {
                     dReal curdist = _ComputeDistance((*itchild)->q, vquerystate);
-                    if( !bestnode.first || (curdist < bestnode.second && bestnode.first->_usenn)) {
+                    if( (*itchild)->_usenn && (!bestnode.first || curdist < bestnode.second) ) {
                         bestnode = make_pair(*itchild, curdist);
                     }
                     _vNextLevelNodes.push_back(make_pair(*itchild, curdist));
@@ -660,6 +711,7 @@ private:
                 return NodePtr();
             }
         }
+        _AddToNodesVector(newnode);
         //BOOST_ASSERT(Validate());
         return newnode;
     }
@@ -972,10 +1024,14 @@ private:
     dReal _fStepLength;
     int _dof; ///< the number of values of each state
     int _fromgoal;
+    bool _bLazyExtend; ///< if true, Extend does not check the new edges, see SetLazyExtend
+    bool _bLazyCheckStates; ///< if true, a lazy Extend still checks the new states
 
     // cover tree data structures
     boost::shared_ptr< boost::pool<> > _pNodesPool; ///< pool nodes are created from
 
+    std::vector<NodePtr> _vnodes; ///< all the nodes in the cover tree including the clones in the order they were inserted, so rrt parents come before their children. Deleted nodes leave NULL slots until the vector is compacted.
+    size_t _nDeletedNodes; ///< number of NULL slots in _vnodes
     std::vector< std::set<NodePtr> > _vsetLevelNodes; ///< _vsetLevelNodes[enc(level)][node] holds the indices of the children of "node" of a given the level. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. Every node has an entry in a map here. If the node doesn't hold any children, then it is at the leaf of the tree. _vsetLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
 
     dReal _maxdistance; ///< maximum possible distance between two states. used to balance the tree. Has to be > 0.
@@ -983,6 +1039,7 @@ private:
     dReal _base, _fBaseInv, _fBaseChildMult; ///< a constant used to control the max level of traversion. _fBaseInv = 1/_base, _fBaseChildMult=1/(_base-1)
     int _maxlevel; ///< the maximum allowed levels in the tree, this is where the root node starts (inclusive)
     int _minlevel; ///< the minimum allowed levels in the tree (inclusive)
+    int _nEdgeChecks; ///< number of edges Extend checked since Init
     int _numnodes; ///< the number of nodes in the current tree starting at the root at _vsetLevelNodes.at(_EncodeLevel(_maxlevel))
     dReal _fMaxLevelBound; // pow(_base, _maxlevel)
 
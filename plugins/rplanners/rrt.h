@@ -279,6 +279,8 @@ Some python code to display data::\n\
   robot.SetActiveDOFValues(sourcetree[argmin(sourcedist)])\n\
 \n\
 ");
+        RegisterCommand("GetNumEdgeChecks", boost::bind(&BirrtPlanner::_GetNumEdgeChecksCommand,this,_1,_2),
+                        "returns the number of edges checked by the last plan");
         _nValidGoals = 0;
     }
     virtual ~BirrtPlanner() {
@@ -379,6 +381,7 @@ Some python code to display data::\n\
         while(_vgoalpaths.size() < _parameters->_minimumgoalpaths && iter < 3*_parameters->_nMaxIterations) {
             RAVELOG_VERBOSE_FORMAT("iter=%d, forward=%d, backward=%d", (iter/3)%_treeForward.GetNumNodes()%_treeBackward.GetNumNodes());
             ++iter;
+            OPENRAVE_PROFILE_SCOPE("BirrtPlanner::Iteration");
 
             if( !!_parameters->_samplegoalfn ) {
                 vector<dReal> vgoal;
@@ -446,7 +449,7 @@ Some python code to display data::\n\
 
             et = TreeB->Extend(TreeA->GetVectorConfig(iConnectedA), iConnectedB);     // extend B toward A
 
-            if( et == ET_Connected ) {
+            if( et == ET_Connected && _ValidatePath(TreeA == &_treeForward ? iConnectedA : iConnectedB, TreeA == &_treeBackward ? iConnectedA : iConnectedB) ) {
                 // connected, process goal
                 _vgoalpaths.push_back(GOALPATH());
                 _ExtractPath(_vgoalpaths.back(), TreeA == &_treeForward ? iConnectedA : iConnectedB, TreeA == &_treeBackward ? iConnectedA : iConnectedB);
@@ -509,6 +512,14 @@ Some python code to display data::\n\
         return _ProcessPostPlanners(_robot,ptraj);
     }
 
+    /// \brief called when the trees connect before the path is extracted
+    ///
+    /// \return false if the path from the roots to the connected nodes does not satisfy the constraints. In that case the trees keep growing.
+    virtual bool _ValidatePath(NodeBase* iConnectedForward, NodeBase* iConnectedBackward)
+    {
+        return true;
+    }
+
     virtual void _ExtractPath(GOALPATH& goalpath, NodeBase* iConnectedForward, NodeBase* iConnectedBackward)
     {
 //        list< std::vector<dReal> > vecnodes;
@@ -628,6 +639,17 @@ Some python code to display data::\n\
     }
 
 protected:
+    virtual int _GetNumEdgeChecks() const
+    {
+        return _treeForward.GetNumEdgeChecks() + _treeBackward.GetNumEdgeChecks();
+    }
+
+    bool _GetNumEdgeChecksCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sout << _GetNumEdgeChecks();
+        return true;
+    }
+
     RRTParametersPtr _parameters;
     SpatialTree< SimpleNode > _treeBackward;
     dReal _fGoalBiasProb;
@@ -636,6 +658,113 @@ protected:
     std::vector<GOALPATH> _vgoalpaths;
 };
 
+class LazyBirrtPlanner : public BirrtPlanner
+{
+public:
+    LazyBirrtPlanner(EnvironmentBasePtr penv) : BirrtPlanner(penv)
+    {
+        __description += "\n\n\
+Lazy variant that grows the trees by only checking the new states. The edges are checked when the trees connect, and only along the connecting path. Invalid edges are removed along with their subtrees and the trees keep growing. See\n\n\
+- R. Bohlin and L.E. Kavraki. Path planning using lazy PRM. In Proc. IEEE Int'l Conf. on Robotics and Automation (ICRA'2000), pages 521-528, San Francisco, CA, April 2000.";
+        RegisterCommand("SetCheckStates", boost::bind(&LazyBirrtPlanner::_SetCheckStatesCommand,this,_1,_2),
+                        "if 1 (default), checks the new states while growing the trees. If 0, nothing is checked until the trees connect.");
+        _bCheckStates = true;
+        _nEdgeChecks = 0;
+        _nInvalidEdges = 0;
+    }
+    virtual ~LazyBirrtPlanner() {
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
+    {
+        if( !BirrtPlanner::InitPlan(pbase, pparams) ) {
+            return false;
+        }
+        _treeForward.SetLazyExtend(true, _bCheckStates);
+        _treeBackward.SetLazyExtend(true, _bCheckStates);
+        _nEdgeChecks = 0;
+        _nInvalidEdges = 0;
+        return true;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj)
+    {
+        PlannerStatus status = BirrtPlanner::PlanPath(ptraj);
+        RAVELOG_DEBUG_FORMAT("env=%d, lazy birrt checked %d edges, %d were invalid", GetEnv()->GetId()%_nEdgeChecks%_nInvalidEdges);
+        return status;
+    }
+
+    virtual bool _ValidatePath(NodeBase* iConnectedForward, NodeBase* iConnectedBackward)
+    {
+        // the roots are already checked, so only check the unchecked edges starting from the roots
+        _vforwardnodes.resize(0);
+        for(SimpleNode* pnode = (SimpleNode*)iConnectedForward; !!pnode->rrtparent; pnode = pnode->rrtparent) {
+            _vforwardnodes.push_back(pnode);
+        }
+        _vbackwardnodes.resize(0);
+        for(SimpleNode* pnode = (SimpleNode*)iConnectedBackward; !!pnode->rrtparent; pnode = pnode->rrtparent) {
+            _vbackwardnodes.push_back(pnode);
+        }
+
+        for(std::vector<SimpleNode*>::reverse_iterator itnode = _vforwardnodes.rbegin(); itnode != _vforwardnodes.rend(); ++itnode) {
+            if( (*itnode)->_edgechecked ) {
+                continue;
+            }
+            _treeForward.GetVectorConfig((*itnode)->rrtparent, _vtempconfig0);
+            _treeForward.GetVectorConfig(*itnode, _vtempconfig1);
+            ++_nEdgeChecks;
+            if( _parameters->CheckPathAllConstraints(_vtempconfig0, _vtempconfig1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+                ++_nInvalidEdges;
+                _treeForward.InvalidateNodesWithParent(*itnode);
+                return false;
+            }
+            (*itnode)->_edgechecked = 1;
+        }
+
+        for(std::vector<SimpleNode*>::reverse_iterator itnode = _vbackwardnodes.rbegin(); itnode != _vbackwardnodes.rend(); ++itnode) {
+            if( (*itnode)->_edgechecked ) {
+                continue;
+            }
+            _treeBackward.GetVectorConfig(*itnode, _vtempconfig0);
+            _treeBackward.GetVectorConfig((*itnode)->rrtparent, _vtempconfig1);
+            ++_nEdgeChecks;
+            if( _parameters->CheckPathAllConstraints(_vtempconfig0, _vtempconfig1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenEnd) != 0 ) {
+                ++_nInvalidEdges;
+                _treeBackward.InvalidateNodesWithParent(*itnode);
+                return false;
+            }
+            (*itnode)->_edgechecked = 1;
+        }
+
+        // a lazy Extend can connect from a node that is a few steps away from the other tree when inserting the nodes in between fails
+        _treeForward.GetVectorConfig(iConnectedForward, _vtempconfig0);
+        _treeBackward.GetVectorConfig(iConnectedBackward, _vtempconfig1);
+        ++_nEdgeChecks;
+        if( _parameters->CheckPathAllConstraints(_vtempconfig0, _vtempconfig1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open) != 0 ) {
+            ++_nInvalidEdges;
+            return false;
+        }
+        return true;
+    }
+
+protected:
+    virtual int _GetNumEdgeChecks() const
+    {
+        return BirrtPlanner::_GetNumEdgeChecks() + _nEdgeChecks;
+    }
+
+    bool _SetCheckStatesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sinput >> _bCheckStates;
+        return !!sinput;
+    }
+
+    bool _bCheckStates; ///< if true, the trees check the new states while growing
+    int _nEdgeChecks, _nInvalidEdges; ///< statistics of the last plan
+    std::vector<SimpleNode*> _vforwardnodes, _vbackwardnodes;
+    std::vector<dReal> _vtempconfig0, _vtempconfig1;
+};
+
 class BasicRrtPlanner : public RrtPlanner<SimpleNode>
 {
 public:
@@ -730,6 +859,7 @@ public:
         
         while(iter < _parameters->_nMaxIterations) {
             iter++;
+            OPENRAVE_PROFILE_SCOPE("BasicRrtPlanner::Iteration");
             if( !!bestGoalNode && iter >= _parameters->_nMinIterations ) {
                 break;
             }
@@ -939,6 +1069,7 @@ public:
         int iter = 0;
         while(iter < _parameters->_nMaxIterations && _treeForward.GetNumNodes() < _parameters->_nExpectedDataSize ) {
             ++iter;
+            OPENRAVE_PROFILE_SCOPE("ExplorationPlanner::Iteration");
 
             if( RaveRandomFloat() < _parameters->_fExploreProb ) {
                 // explore
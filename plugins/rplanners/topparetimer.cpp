@@ -0,0 +1,774 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "trajectoryretimer.h"
+#include <openrave/planningutils.h>
+
+static const dReal s_fMaxPathVelocitySqr = 1e8; ///< bound on the squared path velocity where the path does not move any dof, keeps the times finite
+static const dReal s_fPathEpsilon = 1e-9;
+
+/// \brief time-optimal retiming of a fixed path with reachability analysis (TOPP-RA, Pham and Pham 2018).
+///
+/// The path is discretized into a grid and the squared path velocity x=sd^2 and path acceleration u=sdd are the variables. On every grid interval
+/// the velocity, acceleration and torque limits are linear in (u,x), so a backward pass computes the interval of x that can still reach the end at rest
+/// and a forward pass greedily takes the largest feasible u. Every grid point costs a small fixed number of operations, so the retiming is linear in the
+/// number of grid points.
+class ToppraTrajectoryRetimer : public PlannerBase
+{
+public:
+    class ToppraParameters : public TrajectoryTimingParameters
+    {
+public:
+        ToppraParameters() : _nGridPoints(100), _torquelimitmode(0), _bProcessingToppra(false) {
+            _vXMLParameters.push_back("gridpoints");
+            _vXMLParameters.push_back("torquelimitmode");
+        }
+
+        int _nGridPoints; ///< minimum number of grid intervals along the whole path. Every waypoint is also a grid point.
+        int _torquelimitmode; ///< -1 to ignore the torque limits, 0 to use the nominal torque limits, 1 to use the instantaneous torque limits
+
+protected:
+        bool _bProcessingToppra;
+        virtual bool serialize(std::ostream& O, int options=0) const
+        {
+            if( !TrajectoryTimingParameters::serialize(O, options&~1) ) {
+                return false;
+            }
+            O << "<gridpoints>" << _nGridPoints << "</gridpoints>" << std::endl;
+            O << "<torquelimitmode>" << _torquelimitmode << "</torquelimitmode>" << std::endl;
+            if( !(options & 1) ) {
+                O << _sExtraParameters << std::endl;
+            }
+            return !!O;
+        }
+
+        ProcessElement startElement(const std::string& name, const AttributesList& atts)
+        {
+            if( _bProcessingToppra ) {
+                return PE_Ignore;
+            }
+            switch( TrajectoryTimingParameters::startElement(name,atts) ) {
+            case PE_Pass: break;
+            case PE_Support: return PE_Support;
+            case PE_Ignore: return PE_Ignore;
+            }
+            _bProcessingToppra = name=="gridpoints" || name=="torquelimitmode";
+            return _bProcessingToppra ? PE_Support : PE_Pass;
+        }
+
+        virtual bool endElement(const std::string& name)
+        {
+            if( _bProcessingToppra ) {
+                if( name == "gridpoints" ) {
+                    _ss >> _nGridPoints;
+                }
+                else if( name == "torquelimitmode" ) {
+                    _ss >> _torquelimitmode;
+                }
+                else {
+                    RAVELOG_WARN(str(boost::format("unknown tag %s\n")%name));
+                }
+                _bProcessingToppra = false;
+                return false;
+            }
+            return TrajectoryTimingParameters::endElement(name);
+        }
+    };
+    typedef boost::shared_ptr<ToppraParameters> ToppraParametersPtr;
+
+    /// \brief how the path between the waypoints of the input trajectory is defined
+    enum PathType
+    {
+        PT_Linear=0, ///< straight segments between the waypoints, stops at every corner
+        PT_Spline=1, ///< natural cubic spline through the waypoints parameterized by the chord length
+        PT_Quadratic=2, ///< the quadratic interpolation of a timed trajectory, parameterized by its original time
+    };
+
+    ToppraTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv)
+    {
+        __description = ":Interface Author: Rosen Diankov\n\nTime-optimal re-timing of the path of a trajectory under velocity, acceleration and torque limits with reachability analysis (TOPP-RA) on a grid of the path. By default the path is the straight segments between the waypoints that the planners checked, stopping at the corners. If **interpolation** is 'cubic', the path passes through all the waypoints with a cubic spline instead, which is checked with the constraints of the parameters and falls back to the straight segments if it violates them or the joint limits. Timed trajectories with quadratic interpolation are retimed along their own path and fail if the retimed path violates the constraints. The robot starts and ends at rest. Torque limits of the used bodies are computed with inverse dynamics, **torquelimitmode** is -1 to ignore them, 0 for nominal and 1 for instantaneous limits. **gridpoints** sets the minimum number of grid intervals. Overwrites the velocities and timestamps of the input trajectory.";
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        params->Validate();
+        _parameters.reset(new ToppraParameters());
+        _parameters->copy(params);
+        return _InitPlan();
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, std::istream& isParameters)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset(new ToppraParameters());
+        isParameters >> *_parameters;
+        _parameters->Validate();
+        return _InitPlan();
+    }
+
+    bool _InitPlan()
+    {
+        if( (int)_parameters->_vConfigVelocityLimit.size() != _parameters->GetDOF() || (int)_parameters->_vConfigAccelerationLimit.size() != _parameters->GetDOF() ) {
+            return false;
+        }
+        if( _parameters->_interpolation.size() > 0 && _parameters->_interpolation != "linear" && _parameters->_interpolation != "cubic" ) {
+            RAVELOG_WARN_FORMAT("interpolation %s is not supported, only linear and cubic paths", _parameters->_interpolation);
+            return false;
+        }
+        if( _parameters->_hasvelocities ) {
+            RAVELOG_WARN("retiming with initial and final velocities is not supported\n");
+            return false;
+        }
+        if( _parameters->_nGridPoints <= 0 ) {
+            _parameters->_nGridPoints = 100;
+        }
+        return true;
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj)
+    {
+        BOOST_ASSERT(!!_parameters && !!ptraj && ptraj->GetEnv()==GetEnv());
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        size_t numwaypoints = ptraj->GetNumWaypoints();
+        if( numwaypoints == 0 ) {
+            return PS_Failed;
+        }
+
+        uint64_t starttime = utils::GetMicroTime();
+        const ConfigurationSpecification& posspec = _parameters->_configurationspecification;
+        ConfigurationSpecification velspec = posspec.ConvertToVelocitySpecification();
+        const ConfigurationSpecification& trajspec = ptraj->GetConfigurationSpecification();
+        int dof = posspec.GetDOF();
+
+        // the straight segments are what the planners checked, so only use a spline when asked for
+        PathType waypointpathtype = _parameters->_interpolation == "cubic" ? PT_Spline : PT_Linear;
+        PathType pathtype = waypointpathtype;
+        std::vector<ConfigurationSpecification::Group>::const_iterator itposgroup = trajspec.FindCompatibleGroup(posspec._vgroups.at(0), false);
+        if( itposgroup != trajspec._vgroups.end() && itposgroup->interpolation == "quadratic" && trajspec.FindCompatibleGroup("deltatime", true) != trajspec._vgroups.end() ) {
+            pathtype = PT_Quadratic;
+            FOREACHC(itgroup, velspec._vgroups) {
+                if( trajspec.FindCompatibleGroup(*itgroup, false) == trajspec._vgroups.end() ) {
+                    pathtype = waypointpathtype;
+                    break;
+                }
+            }
+        }
+
+        if( !_InitializeKnots(ptraj, pathtype) ) {
+            return PS_Failed;
+        }
+        if( _vknots.size() < 2 ) {
+            // nothing moves, so only have to add the time and velocity groups
+            _vgridpos.resize(dof);
+            std::copy(_vknotpos.begin(), _vknotpos.begin()+dof, _vgridpos.begin());
+            _vgridsd.assign(1, 0);
+            _vgridpathvel.assign(dof, 0);
+            _vgridtimes.assign(1, 0);
+            _WriteTrajectory(ptraj, pathtype);
+            return PS_HasSolution;
+        }
+
+        if( pathtype == PT_Spline ) {
+            _ComputeSpline();
+            _ComputeGrid(pathtype);
+            if( !_IsGridInLimits() || !_IsGridPathValid() ) {
+                RAVELOG_DEBUG("spline through the waypoints violates the joint limits or the constraints, so using straight segments\n");
+                pathtype = PT_Linear;
+                if( !_InitializeKnots(ptraj, pathtype) ) {
+                    return PS_Failed;
+                }
+                _ComputeGrid(pathtype);
+            }
+        }
+        else {
+            _ComputeGrid(pathtype);
+            if( pathtype == PT_Quadratic && !_IsGridPathValid() ) {
+                RAVELOG_WARN_FORMAT("env=%d, the retimed path of the quadratic trajectory violates the constraints", GetEnv()->GetId());
+                return PS_Failed;
+            }
+        }
+
+        if( !_ComputeConstraints(pathtype) ) {
+            return PS_Failed;
+        }
+        if( !_ComputeControllableSets() ) {
+            return PS_Failed;
+        }
+        if( !_ComputeProfile() ) {
+            return PS_Failed;
+        }
+        _WriteTrajectory(ptraj, pathtype);
+        RAVELOG_DEBUG_FORMAT("env=%d, retimed %d waypoints with %d grid points in %fs, duration=%fs", GetEnv()->GetId()%numwaypoints%_vgrids.size()%(1e-6*(utils::GetMicroTime()-starttime))%ptraj->GetDuration());
+        return PS_HasSolution;
+    }
+
+protected:
+    /// \brief fills the knots of the path from the trajectory waypoints. Duplicate waypoints are skipped.
+    bool _InitializeKnots(TrajectoryBasePtr ptraj, PathType pathtype)
+    {
+        const ConfigurationSpecification& posspec = _parameters->_configurationspecification;
+        int dof = posspec.GetDOF();
+        size_t numwaypoints = ptraj->GetNumWaypoints();
+        ptraj->GetWaypoints(0, numwaypoints, _vwaypoints, posspec);
+        _vknots.resize(0);
+        _vknotpos.resize(0);
+        _vknotvel.resize(0);
+        if( pathtype == PT_Quadratic ) {
+            ConfigurationSpecification timespec;
+            timespec.AddDeltaTimeGroup();
+            ptraj->GetWaypoints(0, numwaypoints, _vwaypointvels, posspec.ConvertToVelocitySpecification());
+            ptraj->GetWaypoints(0, numwaypoints, _vwaypointtimes, timespec);
+            dReal curtime = 0;
+            for(size_t i = 0; i < numwaypoints; ++i) {
+                if( i > 0 ) {
+                    if( _vwaypointtimes[i] <= g_fEpsilonLinear ) {
+                        continue;
+                    }
+                    curtime += _vwaypointtimes[i];
+                }
+                _vknots.push_back(curtime);
+                _vknotpos.insert(_vknotpos.end(), _vwaypoints.begin()+i*dof, _vwaypoints.begin()+(i+1)*dof);
+                _vknotvel.insert(_vknotvel.end(), _vwaypointvels.begin()+i*dof, _vwaypointvels.begin()+(i+1)*dof);
+            }
+            return true;
+        }
+
+        // unwrap the waypoints with the state difference so that circular joints take the short way
+        _vtempdiff.resize(dof);
+        _vtempconfig.resize(dof);
+        _vknots.push_back(0);
+        _vknotpos.insert(_vknotpos.end(), _vwaypoints.begin(), _vwaypoints.begin()+dof);
+        for(size_t i = 1; i < numwaypoints; ++i) {
+            std::copy(_vwaypoints.begin()+i*dof, _vwaypoints.begin()+(i+1)*dof, _vtempdiff.begin());
+            std::copy(_vwaypoints.begin()+(i-1)*dof, _vwaypoints.begin()+i*dof, _vtempconfig.begin());
+            _parameters->_diffstatefn(_vtempdiff, _vtempconfig);
+            dReal length = 0;
+            for(int j = 0; j < dof; ++j) {
+                length += _vtempdiff[j]*_vtempdiff[j];
+            }
+            length = RaveSqrt(length);
+            if( length <= g_fEpsilonLinear ) {
+                continue;
+            }
+            size_t prevoffset = _vknotpos.size()-dof;
+            for(int j = 0; j < dof; ++j) {
+                _vknotpos.push_back(_vknotpos[prevoffset+j] + _vtempdiff[j]);
+            }
+            _vknots.push_back(_vknots.back()+length);
+        }
+        return true;
+    }
+
+    /// \brief computes the second derivatives of the natural cubic spline through the knots with the tridiagonal algorithm
+    void _ComputeSpline()
+    {
+        int dof = _parameters->GetDOF();
+        size_t numknots = _vknots.size();
+        _vsplinesecond.resize(numknots*dof);
+        std::fill(_vsplinesecond.begin(), _vsplinesecond.end(), dReal(0));
+        if( numknots < 3 ) {
+            return;
+        }
+        _vtempdiag.resize(numknots);
+        _vtemprhs.resize(numknots);
+        for(int j = 0; j < dof; ++j) {
+            // h[i-1]*M[i-1] + 2*(h[i-1]+h[i])*M[i] + h[i]*M[i+1] = 6*((y[i+1]-y[i])/h[i] - (y[i]-y[i-1])/h[i-1]), M[0] = M[n-1] = 0
+            for(size_t i = 1; i+1 < numknots; ++i) {
+                dReal h0 = _vknots[i]-_vknots[i-1], h1 = _vknots[i+1]-_vknots[i];
+                _vtempdiag[i] = 2*(h0+h1);
+                _vtemprhs[i] = 6*((_vknotpos[(i+1)*dof+j]-_vknotpos[i*dof+j])/h1 - (_vknotpos[i*dof+j]-_vknotpos[(i-1)*dof+j])/h0);
+                if( i > 1 ) {
+                    dReal factor = h0/_vtempdiag[i-1];
+                    _vtempdiag[i] -= factor*h0;
+                    _vtemprhs[i] -= factor*_vtemprhs[i-1];
+                }
+            }
+            for(size_t i = numknots-2; i > 0; --i) {
+                dReal h1 = _vknots[i+1]-_vknots[i];
+                _vsplinesecond[i*dof+j] = (_vtemprhs[i] - h1*_vsplinesecond[(i+1)*dof+j])/_vtempdiag[i];
+            }
+        }
+    }
+
+    /// \brief evaluates the path at offset t from the start of knot segment iknot
+    void _EvalPath(PathType pathtype, size_t iknot, dReal t, dReal* pos, dReal* vel, dReal* accel)
+    {
+        int dof = _parameters->GetDOF();
+        const dReal* p0 = &_vknotpos[iknot*dof];
+        const dReal* p1 = &_vknotpos[(iknot+1)*dof];
+        dReal h = _vknots[iknot+1]-_vknots[iknot];
+        for(int j = 0; j < dof; ++j) {
+            if( pathtype == PT_Linear ) {
+                vel[j] = (p1[j]-p0[j])/h;
+                pos[j] = p0[j] + t*vel[j];
+                accel[j] = 0;
+            }
+            else if( pathtype == PT_Spline ) {
+                dReal m0 = _vsplinesecond[iknot*dof+j], m1 = _vsplinesecond[(iknot+1)*dof+j];
+                dReal a = h-t;
+                pos[j] = (m0*a*a*a + m1*t*t*t)/(6*h) + (p0[j]/h - m0*h/6)*a + (p1[j]/h - m1*h/6)*t;
+                vel[j] = (m1*t*t - m0*a*a)/(2*h) + (p1[j]-p0[j])/h - (m1-m0)*h/6;
+                accel[j] = (m0*a + m1*t)/h;
+            }
+            else {
+                dReal v0 = _vknotvel[iknot*dof+j], v1 = _vknotvel[(iknot+1)*dof+j];
+                accel[j] = (v1-v0)/h;
+                vel[j] = v0 + t*accel[j];
+                pos[j] = p0[j] + t*(v0 + 0.5*t*accel[j]);
+            }
+        }
+    }
+
+    /// \brief samples the path on the grid. Every knot is a grid point and the knot segments are split evenly.
+    void _ComputeGrid(PathType pathtype)
+    {
+        int dof = _parameters->GetDOF();
+        size_t numknots = _vknots.size();
+        dReal fGridStep = _vknots.back()/_parameters->_nGridPoints;
+        // linear paths stop at the corners, so need an interval for speeding up and one for slowing down
+        int nMinIntervals = pathtype == PT_Linear ? 2 : 1;
+        _vgrids.resize(0);
+        _vgridknots.resize(0);
+        for(size_t iknot = 0; iknot+1 < numknots; ++iknot) {
+            dReal h = _vknots[iknot+1]-_vknots[iknot];
+            int numintervals = max(nMinIntervals, (int)RaveCeil(h/fGridStep-g_fEpsilonLinear));
+            for(int i = 0; i < numintervals; ++i) {
+                _vgrids.push_back(h*i/numintervals);
+                _vgridknots.push_back(iknot);
+            }
+        }
+        _vgrids.push_back(_vknots[numknots-1]-_vknots[numknots-2]);
+        _vgridknots.push_back(numknots-2);
+
+        size_t numgrids = _vgrids.size();
+        _vgridpos.resize(numgrids*dof);
+        _vgridpathvel.resize(numgrids*dof);
+        _vgridpathaccel.resize(numgrids*dof);
+        _vgridstop.resize(numgrids);
+        for(size_t i = 0; i < numgrids; ++i) {
+            // evaluate with the segment that starts at the point, so the constraints of the interval after the point use its derivatives
+            _EvalPath(pathtype, _vgridknots[i], _vgrids[i], &_vgridpos[i*dof], &_vgridpathvel[i*dof], &_vgridpathaccel[i*dof]);
+            _vgridstop[i] = i == 0 || i+1 == numgrids;
+            if( _vgrids[i] == 0 ) {
+                // knot, use the exact waypoint
+                std::copy(_vknotpos.begin()+_vgridknots[i]*dof, _vknotpos.begin()+(_vgridknots[i]+1)*dof, _vgridpos.begin()+i*dof);
+                if( pathtype == PT_Linear && i > 0 ) {
+                    // stop unless the previous segment has the same direction
+                    size_t iknot = _vgridknots[i];
+                    const dReal* p0 = &_vknotpos[(iknot-1)*dof], *p1 = &_vknotpos[iknot*dof], *p2 = &_vknotpos[(iknot+1)*dof];
+                    dReal h0 = _vknots[iknot]-_vknots[iknot-1], h1 = _vknots[iknot+1]-_vknots[iknot];
+                    for(int j = 0; j < dof; ++j) {
+                        if( RaveFabs((p1[j]-p0[j])/h0 - (p2[j]-p1[j])/h1) > 1e-6 ) {
+                            _vgridstop[i] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+            // convert to the path parameter of the whole path
+            _vgrids[i] += _vknots[_vgridknots[i]];
+        }
+        std::copy(_vknotpos.end()-dof, _vknotpos.end(), _vgridpos.end()-dof);
+
+        // derivatives at the end of every interval from the segment before the point. The constraints are imposed at both ends of the interval.
+        // The velocity limits are only imposed on the grid points, so also bound by the path velocity inside the neighboring intervals since the dofs can move faster there.
+        _vgridpathvelleft.resize(numgrids*dof);
+        _vgridpathaccelleft.resize(numgrids*dof);
+        std::copy(_vgridpathvel.begin(), _vgridpathvel.begin()+dof, _vgridpathvelleft.begin());
+        std::copy(_vgridpathaccel.begin(), _vgridpathaccel.begin()+dof, _vgridpathaccelleft.begin());
+        _vgridmaxpathvel.resize(numgrids*dof);
+        for(size_t i = 0; i < _vgridpathvel.size(); ++i) {
+            _vgridmaxpathvel[i] = RaveFabs(_vgridpathvel[i]);
+        }
+        _vtempconfig.resize(dof);
+        _vtempvel.resize(dof);
+        _vtempdiff.resize(dof);
+        for(size_t i = 0; i+1 < numgrids; ++i) {
+            size_t iknot = _vgridknots[i];
+            dReal s0 = _vgrids[i]-_vknots[iknot], s1 = _vgrids[i+1]-_vknots[iknot];
+            _EvalPath(pathtype, iknot, 0.5*(s0+s1), &_vtempconfig[0], &_vtempvel[0], &_vtempdiff[0]);
+            _EvalPath(pathtype, iknot, s1, &_vtempconfig[0], &_vgridpathvelleft[(i+1)*dof], &_vgridpathaccelleft[(i+1)*dof]);
+            for(int j = 0; j < dof; ++j) {
+                dReal fabsvel = max(RaveFabs(_vtempvel[j]), RaveFabs(_vgridpathvelleft[(i+1)*dof+j]));
+                _vgridmaxpathvel[i*dof+j] = max(_vgridmaxpathvel[i*dof+j], fabsvel);
+                _vgridmaxpathvel[(i+1)*dof+j] = max(_vgridmaxpathvel[(i+1)*dof+j], fabsvel);
+            }
+        }
+    }
+
+    /// \brief checks the path between the grid points with the constraints of the parameters.
+    ///
+    /// The output trajectory interpolates the grid points, so checking the segments between them covers the curved paths up to the grid resolution.
+    bool _IsGridPathValid()
+    {
+        if( !_parameters->_checkpathvelocityconstraintsfn ) {
+            return true;
+        }
+        int dof = _parameters->GetDOF();
+        PlannerParameters::StateSaver savestate(_parameters);
+        std::vector<dReal> vprevconfig(_vgridpos.begin(), _vgridpos.begin()+dof), vconfig(dof);
+        for(size_t i = dof; i < _vgridpos.size(); i += dof) {
+            std::copy(_vgridpos.begin()+i, _vgridpos.begin()+i+dof, vconfig.begin());
+            if( _parameters->CheckPathAllConstraints(vprevconfig, vconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+                return false;
+            }
+            vprevconfig.swap(vconfig);
+        }
+        return true;
+    }
+
+    bool _IsGridInLimits() const
+    {
+        int dof = _parameters->GetDOF();
+        for(size_t i = 0; i < _vgridpos.size(); i += dof) {
+            for(int j = 0; j < dof; ++j) {
+                if( _vgridpos[i+j] < _parameters->_vConfigLowerLimit.at(j)-g_fEpsilonJointLimit || _vgridpos[i+j] > _parameters->_vConfigUpperLimit.at(j)+g_fEpsilonJointLimit ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// \brief adds the constraint lower <= a*u + b*x <= upper of grid point igrid
+    inline void _AddConstraint(size_t igrid, dReal a, dReal b, dReal lower, dReal upper)
+    {
+        if( RaveFabs(a) > s_fPathEpsilon ) {
+            // bounds of u as lines p*x + q
+            dReal ia = 1/a;
+            if( a < 0 ) {
+                std::swap(lower, upper);
+            }
+            _vlowerlines.push_back(-b*ia);
+            _vlowerlines.push_back(lower*ia);
+            _vupperlines.push_back(-b*ia);
+            _vupperlines.push_back(upper*ia);
+        }
+        else if( b > s_fPathEpsilon ) {
+            _vxmin[igrid] = max(_vxmin[igrid], lower/b);
+            _vxmax[igrid] = min(_vxmax[igrid], upper/b);
+        }
+        else if( b < -s_fPathEpsilon ) {
+            _vxmin[igrid] = max(_vxmin[igrid], upper/b);
+            _vxmax[igrid] = min(_vxmax[igrid], lower/b);
+        }
+        else if( lower > g_fEpsilonLinear || upper < -g_fEpsilonLinear ) {
+            // cannot be satisfied at any speed, for example gravity torque over the limits
+            _vxmax[igrid] = -1;
+        }
+    }
+
+    /// \brief gets the torque limits of the dofs of the body, speed dependent limits use their lowest torque
+    void _GetTorqueLimits(KinBodyPtr pbody, std::vector< std::pair<int, std::pair<dReal, dReal> > >& vtorquelimits)
+    {
+        vtorquelimits.resize(0);
+        FOREACHC(itjoint, pbody->GetJoints()) {
+            for(int idof = 0; idof < (*itjoint)->GetDOF(); ++idof) {
+                std::pair<dReal, dReal> torquelimits = _parameters->_torquelimitmode == 1 ? (*itjoint)->GetInstantaneousTorqueLimits(idof) : (*itjoint)->GetNominalTorqueLimits(idof);
+                ElectricMotorActuatorInfoPtr infoElectricMotor = (*itjoint)->GetInfo()._infoElectricMotor;
+                if( !!infoElectricMotor ) {
+                    const std::vector< std::pair<dReal, dReal> >& vpoints = _parameters->_torquelimitmode == 1 ? infoElectricMotor->max_speed_torque_points : infoElectricMotor->nominal_speed_torque_points;
+                    FOREACHC(itpoint, vpoints) {
+                        dReal ftorque = itpoint->second*infoElectricMotor->gear_ratio;
+                        torquelimits.first = max(torquelimits.first, -ftorque);
+                        torquelimits.second = min(torquelimits.second, ftorque);
+                    }
+                }
+                if( torquelimits.first < torquelimits.second ) {
+                    vtorquelimits.push_back(make_pair((*itjoint)->GetDOFIndex()+idof, torquelimits));
+                }
+            }
+        }
+    }
+
+    /// \brief computes the (u,x) constraints of every grid interval
+    bool _ComputeConstraints(PathType pathtype)
+    {
+        int dof = _parameters->GetDOF();
+        size_t numgrids = _vgrids.size();
+        _vxmin.resize(numgrids);
+        _vxmax.resize(numgrids);
+        std::fill(_vxmin.begin(), _vxmin.end(), dReal(0));
+        std::fill(_vxmax.begin(), _vxmax.end(), s_fMaxPathVelocitySqr);
+
+        // torque = a*u + b*x + c where a = ID(q,0,q') - c, b = ID(q,q',q'') - c, c = ID(q,0,0), evaluated for all the grid points with batch calls per body.
+        // a and b are computed for the derivatives on both sides of the grid points, so every body stores (a,b,aleft,bleft,c) for each grid point and torque limit
+        std::vector< std::vector<dReal> > vtorquecoeffs;
+        std::vector< std::vector< std::pair<int, std::pair<dReal, dReal> > > > vbodytorquelimits;
+        std::vector<KinBodyPtr> vusedbodies;
+        if( _parameters->_torquelimitmode >= 0 ) {
+            _parameters->_configurationspecification.ExtractUsedBodies(GetEnv(), vusedbodies);
+        }
+        ConfigurationSpecification velspec = _parameters->_configurationspecification.ConvertToVelocitySpecification();
+        FOREACH(itbody, vusedbodies) {
+            KinBodyPtr pbody = *itbody;
+            std::vector< std::pair<int, std::pair<dReal, dReal> > > vtorquelimits;
+            _GetTorqueLimits(pbody, vtorquelimits);
+            if( vtorquelimits.size() == 0 ) {
+                continue;
+            }
+            int bodydof = pbody->GetDOF();
+            std::vector<int> vdofindices(bodydof);
+            for(int i = 0; i < bodydof; ++i) {
+                vdofindices[i] = i;
+            }
+            pbody->GetDOFValues(_vtempconfig);
+            _vbodyvalues.resize(numgrids*bodydof);
+            _vbodyvelocities.resize(numgrids*bodydof);
+            _vbodyaccelerations.resize(numgrids*bodydof);
+            for(size_t i = 0; i < numgrids; ++i) {
+                std::copy(_vtempconfig.begin(), _vtempconfig.end(), _vbodyvalues.begin()+i*bodydof);
+                _parameters->_configurationspecification.ExtractJointValues(_vbodyvalues.begin()+i*bodydof, _vgridpos.begin()+i*dof, pbody, vdofindices, 0);
+            }
+            try {
+                std::vector<dReal> vc, va, vb;
+                std::fill(_vbodyvelocities.begin(), _vbodyvelocities.end(), dReal(0));
+                std::fill(_vbodyaccelerations.begin(), _vbodyaccelerations.end(), dReal(0));
+                pbody->ComputeInverseDynamics(vc, _vbodyvalues, _vbodyvelocities, _vbodyaccelerations);
+                const size_t numcoeffs = 5*vtorquelimits.size();
+                std::vector<dReal> vcoeffs(numgrids*numcoeffs);
+                for(int iside = 0; iside < 2; ++iside) {
+                    const std::vector<dReal>& vpathvel = iside == 0 ? _vgridpathvel : _vgridpathvelleft;
+                    const std::vector<dReal>& vpathaccel = iside == 0 ? _vgridpathaccel : _vgridpathaccelleft;
+                    std::fill(_vbodyvelocities.begin(), _vbodyvelocities.end(), dReal(0));
+                    for(size_t i = 0; i < numgrids; ++i) {
+                        velspec.ExtractJointValues(_vbodyaccelerations.begin()+i*bodydof, vpathvel.begin()+i*dof, pbody, vdofindices, 1);
+                    }
+                    pbody->ComputeInverseDynamics(va, _vbodyvalues, _vbodyvelocities, _vbodyaccelerations);
+                    for(size_t i = 0; i < numgrids; ++i) {
+                        velspec.ExtractJointValues(_vbodyvelocities.begin()+i*bodydof, vpathvel.begin()+i*dof, pbody, vdofindices, 1);
+                        velspec.ExtractJointValues(_vbodyaccelerations.begin()+i*bodydof, vpathaccel.begin()+i*dof, pbody, vdofindices, 1);
+                    }
+                    pbody->ComputeInverseDynamics(vb, _vbodyvalues, _vbodyvelocities, _vbodyaccelerations);
+                    for(size_t i = 0; i < numgrids; ++i) {
+                        for(size_t k = 0; k < vtorquelimits.size(); ++k) {
+                            int index = i*bodydof+vtorquelimits[k].first;
+                            dReal* pcoeffs = &vcoeffs[i*numcoeffs+5*k];
+                            pcoeffs[2*iside+0] = va[index]-vc[index];
+                            pcoeffs[2*iside+1] = vb[index]-vc[index];
+                            pcoeffs[4] = vc[index];
+                        }
+                    }
+                }
+                vtorquecoeffs.push_back(vcoeffs);
+                vbodytorquelimits.push_back(vtorquelimits);
+            }
+            catch(const openrave_exception& ex) {
+                if( ex.GetCode() != ORE_NotImplemented ) {
+                    throw;
+                }
+                RAVELOG_WARN_FORMAT("env=%d, cannot compute the torques of body %s, ignoring its torque limits: %s", GetEnv()->GetId()%pbody->GetName()%ex.what());
+            }
+        }
+
+        _vlowerlines.resize(0);
+        _vupperlines.resize(0);
+        _vlowerindices.resize(numgrids+1);
+        _vupperindices.resize(numgrids+1);
+        for(size_t i = 0; i < numgrids; ++i) {
+            _vlowerindices[i] = _vlowerlines.size();
+            _vupperindices[i] = _vupperlines.size();
+            if( _vgridstop[i] ) {
+                _vxmax[i] = 0;
+            }
+            for(int j = 0; j < dof; ++j) {
+                if( _vgridmaxpathvel[i*dof+j] > s_fPathEpsilon ) {
+                    dReal fmaxsd = _parameters->_vConfigVelocityLimit[j]/_vgridmaxpathvel[i*dof+j];
+                    _vxmax[i] = min(_vxmax[i], fmaxsd*fmaxsd);
+                }
+            }
+            if( i+1 == numgrids ) {
+                continue;
+            }
+
+            // the constraints of the end of the interval are written with x[i+1] = x[i] + 2*delta*u
+            dReal delta2 = 2*(_vgrids[i+1]-_vgrids[i]);
+            const dReal* pathvel = &_vgridpathvel[i*dof], *pathaccel = &_vgridpathaccel[i*dof];
+            const dReal* pathvelend = &_vgridpathvelleft[(i+1)*dof], *pathaccelend = &_vgridpathaccelleft[(i+1)*dof];
+            for(int j = 0; j < dof; ++j) {
+                dReal faccel = _parameters->_vConfigAccelerationLimit[j];
+                _AddConstraint(i, pathvel[j], pathaccel[j], -faccel, faccel);
+                _AddConstraint(i, pathvelend[j] + delta2*pathaccelend[j], pathaccelend[j], -faccel, faccel);
+            }
+            for(size_t ibody = 0; ibody < vtorquecoeffs.size(); ++ibody) {
+                const std::vector< std::pair<int, std::pair<dReal, dReal> > >& vtorquelimits = vbodytorquelimits[ibody];
+                for(size_t k = 0; k < vtorquelimits.size(); ++k) {
+                    const dReal* pcoeffs = &vtorquecoeffs[ibody][5*(i*vtorquelimits.size()+k)];
+                    const dReal* pcoeffsend = &vtorquecoeffs[ibody][5*((i+1)*vtorquelimits.size()+k)];
+                    _AddConstraint(i, pcoeffs[0], pcoeffs[1], vtorquelimits[k].second.first-pcoeffs[4], vtorquelimits[k].second.second-pcoeffs[4]);
+                    _AddConstraint(i, pcoeffsend[2] + delta2*pcoeffsend[3], pcoeffsend[3], vtorquelimits[k].second.first-pcoeffsend[4], vtorquelimits[k].second.second-pcoeffsend[4]);
+                }
+            }
+        }
+        _vlowerindices[numgrids] = _vlowerlines.size();
+        _vupperindices[numgrids] = _vupperlines.size();
+        return true;
+    }
+
+    /// \brief backward pass, computes the interval [_vkmin[i], _vkmax[i]] of x from which the end can be reached at rest
+    bool _ComputeControllableSets()
+    {
+        size_t numgrids = _vgrids.size();
+        _vkmin.resize(numgrids);
+        _vkmax.resize(numgrids);
+        _vkmin[numgrids-1] = 0;
+        _vkmax[numgrids-1] = 0;
+        for(int i = (int)numgrids-2; i >= 0; --i) {
+            dReal idelta2 = 0.5/(_vgrids[i+1]-_vgrids[i]);
+            // kmin <= x + 2*delta*u <= kmax is the last pair of lines
+            _vtemplower.resize(0);
+            _vtempupper.resize(0);
+            _vtemplower.insert(_vtemplower.end(), _vlowerlines.begin()+_vlowerindices[i], _vlowerlines.begin()+_vlowerindices[i+1]);
+            _vtempupper.insert(_vtempupper.end(), _vupperlines.begin()+_vupperindices[i], _vupperlines.begin()+_vupperindices[i+1]);
+            _vtemplower.push_back(-idelta2);
+            _vtemplower.push_back(_vkmin[i+1]*idelta2);
+            _vtempupper.push_back(-idelta2);
+            _vtempupper.push_back(_vkmax[i+1]*idelta2);
+
+            // max(lower lines) <= min(upper lines) for all the pairs
+            dReal xmin = max(dReal(0), _vxmin[i]), xmax = _vxmax[i];
+            for(size_t ilower = 0; ilower < _vtemplower.size(); ilower += 2) {
+                for(size_t iupper = 0; iupper < _vtempupper.size(); iupper += 2) {
+                    dReal p = _vtemplower[ilower]-_vtempupper[iupper];
+                    dReal q = _vtempupper[iupper+1]-_vtemplower[ilower+1];
+                    if( p > s_fPathEpsilon ) {
+                        xmax = min(xmax, q/p);
+                    }
+                    else if( p < -s_fPathEpsilon ) {
+                        xmin = max(xmin, q/p);
+                    }
+                    else if( q < -g_fEpsilonLinear ) {
+                        xmax = -1;
+                    }
+                }
+            }
+            if( xmin > xmax + g_fEpsilonLinear ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, path cannot be timed at grid point %d/%d (s=%f), controllable set is empty", GetEnv()->GetId()%i%numgrids%_vgrids[i]);
+                return false;
+            }
+            _vkmin[i] = xmin;
+            _vkmax[i] = max(xmin, xmax);
+        }
+        if( _vkmin[0] > g_fEpsilonLinear ) {
+            RAVELOG_DEBUG("path cannot be timed from rest\n");
+            return false;
+        }
+        return true;
+    }
+
+    /// \brief forward pass, takes the largest path acceleration that keeps the next point controllable
+    bool _ComputeProfile()
+    {
+        size_t numgrids = _vgrids.size();
+        _vgridsd.resize(numgrids);
+        _vgridtimes.resize(numgrids);
+        dReal x = 0;
+        _vgridsd[0] = 0;
+        _vgridtimes[0] = 0;
+        for(size_t i = 0; i+1 < numgrids; ++i) {
+            dReal delta = _vgrids[i+1]-_vgrids[i];
+            dReal umax = (_vkmax[i+1]-x)/(2*delta), umin = (_vkmin[i+1]-x)/(2*delta);
+            for(size_t iupper = _vupperindices[i]; iupper < _vupperindices[i+1]; iupper += 2) {
+                umax = min(umax, _vupperlines[iupper]*x + _vupperlines[iupper+1]);
+            }
+            for(size_t ilower = _vlowerindices[i]; ilower < _vlowerindices[i+1]; ilower += 2) {
+                umin = max(umin, _vlowerlines[ilower]*x + _vlowerlines[ilower+1]);
+            }
+            dReal u = umax >= umin ? umax : 0.5*(umax+umin); // only numerical errors can make the interval empty
+            dReal xnext = min(_vkmax[i+1], max(_vkmin[i+1], x + 2*delta*u));
+            dReal sdsum = RaveSqrt(x) + RaveSqrt(xnext);
+            if( sdsum <= g_fEpsilon ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, path velocity is 0 at grid points %d and %d", GetEnv()->GetId()%i%(i+1));
+                return false;
+            }
+            _vgridtimes[i+1] = 2*delta/sdsum;
+            x = xnext;
+            _vgridsd[i+1] = RaveSqrt(x);
+        }
+        return true;
+    }
+
+    void _WriteTrajectory(TrajectoryBasePtr ptraj, PathType pathtype)
+    {
+        const ConfigurationSpecification& posspec = _parameters->_configurationspecification;
+        ConfigurationSpecification velspec = posspec.ConvertToVelocitySpecification();
+        int dof = posspec.GetDOF();
+        size_t numgrids = _vgridsd.size();
+
+        // straight segments with constant path accelerations are exactly quadratic, the curved paths are approximated by cubics through the grid points
+        std::string posinterpolation = pathtype == PT_Linear ? "quadratic" : "cubic";
+        ConfigurationSpecification newspec = posspec;
+        newspec.AddDerivativeGroups(1, false);
+        newspec.AddDeltaTimeGroup();
+        FOREACH(itgroup, newspec._vgroups) {
+            if( posspec.FindCompatibleGroup(*itgroup, true) != posspec._vgroups.end() ) {
+                itgroup->interpolation = posinterpolation;
+            }
+            else if( velspec.FindCompatibleGroup(*itgroup, true) != velspec._vgroups.end() ) {
+                itgroup->interpolation = ConfigurationSpecification::GetInterpolationDerivative(posinterpolation);
+            }
+        }
+        ConfigurationSpecification timespec;
+        timespec.AddDeltaTimeGroup();
+
+        _vtempvel.resize(numgrids*dof);
+        for(size_t i = 0; i < numgrids; ++i) {
+            for(int j = 0; j < dof; ++j) {
+                _vtempvel[i*dof+j] = _vgridpathvel[i*dof+j]*_vgridsd[i];
+            }
+        }
+        _vdata.resize(numgrids*newspec.GetDOF());
+        std::fill(_vdata.begin(), _vdata.end(), dReal(0));
+        ConfigurationSpecification::ConvertData(_vdata.begin(), newspec, _vgridpos.begin(), posspec, numgrids, GetEnv(), true);
+        ConfigurationSpecification::ConvertData(_vdata.begin(), newspec, _vtempvel.begin(), velspec, numgrids, GetEnv(), false);
+        ConfigurationSpecification::ConvertData(_vdata.begin(), newspec, _vgridtimes.begin(), timespec, numgrids, GetEnv(), false);
+        ptraj->Init(newspec);
+        ptraj->Insert(0, _vdata);
+    }
+
+    ToppraParametersPtr _parameters;
+
+    std::vector<dReal> _vknots; ///< path parameter of every knot. For waypoint paths the knots are the distinct waypoints, for quadratic paths the timed waypoints.
+    std::vector<dReal> _vknotpos, _vknotvel; ///< positions (unwrapped for circular joints) and, for quadratic paths, velocities of the knots
+    std::vector<dReal> _vsplinesecond; ///< second derivatives of the spline at the knots
+
+    std::vector<dReal> _vgrids; ///< path parameter of every grid point
+    std::vector<size_t> _vgridknots; ///< knot segment of every grid point
+    std::vector<dReal> _vgridpos, _vgridpathvel, _vgridpathaccel; ///< q(s), q'(s), q''(s) of the grid points, the derivatives from the segment after the point
+    std::vector<dReal> _vgridpathvelleft, _vgridpathaccelleft; ///< q'(s), q''(s) of the grid points from the segment before the point
+    std::vector<dReal> _vgridmaxpathvel; ///< largest |q'(s)| of every dof around the grid point
+    std::vector<uint8_t> _vgridstop; ///< 1 if the path has to stop at the grid point
+
+    std::vector<dReal> _vlowerlines, _vupperlines; ///< (p,q) lines bounding the path acceleration u >= p*x+q and u <= p*x+q of the grid intervals
+    std::vector<size_t> _vlowerindices, _vupperindices; ///< the lines of grid interval i are [indices[i], indices[i+1])
+    std::vector<dReal> _vxmin, _vxmax; ///< bounds of x at the grid points that do not depend on u
+    std::vector<dReal> _vkmin, _vkmax; ///< controllable sets
+    std::vector<dReal> _vgridsd, _vgridtimes; ///< path velocity and the delta time from the previous grid point
+
+    // caching
+    std::vector<dReal> _vwaypoints, _vwaypointvels, _vwaypointtimes, _vdata;
+    std::vector<dReal> _vtempconfig, _vtempdiff, _vtempvel, _vtempdiag, _vtemprhs, _vtemplower, _vtempupper;
+    std::vector<dReal> _vbodyvalues, _vbodyvelocities, _vbodyaccelerations;
+};
+
+PlannerBasePtr CreateToppraTrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new ToppraTrajectoryRetimer(penv, sinput));
+}
@@ -39,9 +39,25 @@ Planner Parameters\n\
 \n\
 - **TrajectoryBasePtr workspacetraj** - workspace trajectory of the end effector, needs to hold 'ikparam_values' groups\n\
 \n\
+Caching\n\
+=======\n\
+\n\
+End effector collision and inverse kinematics results are cached across calls to PlanPath, binned by the discretized end effector pose. An entry is only reused if its pose and the arm configuration it started from match the query. Cached ik solutions are passed through the custom filters of the ik solver again, and failed ik queries are not cached. The cache is dropped whenever the environment changes (update stamps of the other bodies), the robot state outside of the arm or the grabbed bodies change, or the collision options or relevant parameters change. Reuse the same planner instance for repeated moves to benefit from it.\n\
 ";
+        RegisterCommand("SetCacheSize",boost::bind(&WorkspaceTrajectoryTracker::SetCacheSizeCommand,this,_1,_2),
+                        "Sets the maximum number of cached end effector collision and ik entries. 0 disables the cache.");
+        RegisterCommand("ClearCache",boost::bind(&WorkspaceTrajectoryTracker::ClearCacheCommand,this,_1,_2),
+                        "Clears all cached results.");
+        RegisterCommand("GetCacheStatistics",boost::bind(&WorkspaceTrajectoryTracker::GetCacheStatisticsCommand,this,_1,_2),
+                        "Returns the number of entries, ee collision hits, ee collision misses, ik hits, and ik misses.");
         _report.reset(new CollisionReport());
         _filteroptions = 0;
+        _nMaxCacheEntries = 20000;
+        _fCacheBinTrans = 0.005;
+        _fCacheBinRot = 0.01;
+        _nCacheEntries = 0;
+        _nEECollisionHits = _nEECollisionMisses = _nIkHits = _nIkMisses = 0;
+        _bIgnoreValidateSolution = false;
     }
     virtual ~WorkspaceTrajectoryTracker() {
     }
@@ -147,6 +163,10 @@ Planner Parameters\n\
             poutputtraj->Init(_parameters->_configurationspecification);
         }
 
+        if( _nMaxCacheEntries > 0 ) {
+            _UpdateCacheContext();
+        }
+
         // first check if the end effectors are in collision
         TrajectoryBaseConstPtr workspacetraj = _parameters->workspacetraj;
         IkParameterization ikparam;
@@ -158,7 +178,7 @@ Planner Parameters\n\
         if( minimumcompletetime <= 0 ) {
             minimumcompletetime += workspacetraj->GetDuration();
         }
-        if( _manip->CheckEndEffectorCollision(tlasttrans,_report) ) {
+        if( _CheckEndEffectorCollision(tlasttrans) ) {
             if( minimumcompletetime >= workspacetraj->GetDuration() ) {
                 RAVELOG_DEBUG(str(boost::format("final configuration colliding: %s\n")%_report->__str__()));
                 return PS_Failed;
@@ -175,7 +195,7 @@ Planner Parameters\n\
             Transform t = ikparam.GetTransform6D();
             listtransforms.push_back(t);
             // end effector is only fully known given the entire 6D transform!
-            if( _manip->CheckEndEffectorCollision(t,_report) ) {
+            if( _CheckEndEffectorCollision(t) ) {
                 if(( ftime < _parameters->ignorefirstcollision) && bPrevInCollision ) {
                     continue;
                 }
@@ -242,14 +262,14 @@ Planner Parameters\n\
         for(; ittrans != listtransforms.end(); ftime += _parameters->_fStepLength, ++ittrans) {
             _filteroptions = (ftime >= fstarttime) ? IKFO_CheckEnvCollisions : 0;
             IkParameterization ikparam(*ittrans,IKP_Transform6D);
-            if( !_manip->FindIKSolution(ikparam,vsolution,_filteroptions) ) {
+            if( !_FindIKSolution(ikparam,vsolution) ) {
                 if( _filteroptions == 0 ) {
                     // haven't even checked with environment collisions, so a solution really doesn't exist
                     return PS_Failed;
                 }
                 if(( ftime < _parameters->ignorefirstcollision) && bPrevInCollision ) {
                     _filteroptions = 0;
-                    if( !_manip->FindIKSolution(ikparam,vsolution,_filteroptions) ) {
+                    if( !_FindIKSolution(ikparam,vsolution) ) {
                         return PS_Failed;
                     }
                 }
@@ -292,6 +312,292 @@ Planner Parameters\n\
     }
 
 protected:
+    /// \brief cached end effector collision result
+    struct EECollisionEntry
+    {
+        Transform t;
+        bool bcollision;
+    };
+
+    /// \brief cached ik solution, only valid when starting from the same arm configuration
+    struct IkEntry
+    {
+        Transform t;
+        std::vector<dReal> vstartvalues; ///< arm values of the robot when the ik was queried
+        int filteroptions;
+        bool bhasprevsolution, bhasjacobian;
+        std::vector<dReal> vsolution;
+    };
+
+    /// \brief all entries whose poses discretize to the same bin
+    struct CacheBin
+    {
+        std::vector<EECollisionEntry> veecollisions;
+        std::vector<IkEntry> viks;
+    };
+
+    typedef boost::array<int,7> CacheBinKey;
+
+    bool SetCacheSizeCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int nMaxCacheEntries = 0;
+        sinput >> nMaxCacheEntries;
+        if( !sinput ) {
+            return false;
+        }
+        _nMaxCacheEntries = nMaxCacheEntries;
+        _ClearCache();
+        return true;
+    }
+
+    bool ClearCacheCommand(std::ostream& sout, std::istream& sinput)
+    {
+        _ClearCache();
+        return true;
+    }
+
+    bool GetCacheStatisticsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sout << _nCacheEntries << " " << _nEECollisionHits << " " << _nEECollisionMisses << " " << _nIkHits << " " << _nIkMisses;
+        return true;
+    }
+
+    void _ClearCache()
+    {
+        _mapcachebins.clear();
+        _nCacheEntries = 0;
+    }
+
+    /// \brief gathers everything the cached results depend on besides the pose and arm configuration, clears the cache if any of it changed.
+    void _UpdateCacheContext()
+    {
+        std::vector<int>& vstamps = _vnewcontextstamps;
+        std::vector<dReal>& vvalues = _vnewcontextvalues;
+        std::string& sids = _snewcontextids;
+        vstamps.resize(0);
+        vvalues.resize(0);
+        sids.resize(0);
+
+        _robot->GetGrabbed(_vgrabbedbodies);
+        sids += _robot->GetKinematicsGeometryHash();
+        sids += _manip->GetName();
+        sids += _manip->GetIkSolver()->GetXMLId();
+        CollisionCheckerBasePtr pchecker = GetEnv()->GetCollisionChecker();
+        if( !!pchecker ) {
+            sids += pchecker->GetXMLId();
+            vstamps.push_back(pchecker->GetCollisionOptions());
+        }
+        vstamps.push_back(_robot->GetEnvironmentId());
+        FOREACHC(itlink, _robot->GetLinks()) {
+            vstamps.push_back((*itlink)->IsEnabled());
+        }
+
+        // grabbed bodies move with the arm, so their stamps cannot be used
+        FOREACHC(itgrabbed, _vgrabbedbodies) {
+            KinBody::LinkPtr plink = _robot->IsGrabbing(*itgrabbed);
+            vstamps.push_back((*itgrabbed)->GetEnvironmentId());
+            vstamps.push_back(!plink ? -1 : plink->GetIndex());
+            sids += (*itgrabbed)->GetKinematicsGeometryHash();
+            if( !!plink ) {
+                _PushTransform(vvalues, plink->GetTransform().inverse() * (*itgrabbed)->GetTransform());
+            }
+            FOREACHC(itlink, (*itgrabbed)->GetLinks()) {
+                vstamps.push_back((*itlink)->IsEnabled());
+            }
+        }
+
+        GetEnv()->GetBodies(_vbodies);
+        FOREACHC(itbody, _vbodies) {
+            if( *itbody == _robot || find(_vgrabbedbodies.begin(),_vgrabbedbodies.end(),*itbody) != _vgrabbedbodies.end() ) {
+                continue;
+            }
+            vstamps.push_back((*itbody)->GetEnvironmentId());
+            vstamps.push_back((*itbody)->GetUpdateStamp());
+        }
+        _vbodies.resize(0);
+
+        _PushTransform(vvalues, _robot->GetTransform());
+        _robot->GetDOFValues(_vrobotvalues);
+        FOREACHC(itindex, _manip->GetArmIndices()) {
+            _vrobotvalues.at(*itindex) = 0; // arm values are part of each entry
+        }
+        vvalues.insert(vvalues.end(), _vrobotvalues.begin(), _vrobotvalues.end());
+        vvalues.push_back(_parameters->maxdeviationangle);
+        vvalues.insert(vvalues.end(), _parameters->_vConfigResolution.begin(), _parameters->_vConfigResolution.end());
+        vvalues.insert(vvalues.end(), _parameters->_vConfigLowerLimit.begin(), _parameters->_vConfigLowerLimit.end());
+        vvalues.insert(vvalues.end(), _parameters->_vConfigUpperLimit.begin(), _parameters->_vConfigUpperLimit.end());
+
+        if( vstamps != _vcontextstamps || vvalues != _vcontextvalues || sids != _scontextids ) {
+            if( _nCacheEntries > 0 ) {
+                RAVELOG_VERBOSE(str(boost::format("environment changed, clearing %d cached workspace entries")%_nCacheEntries));
+            }
+            _ClearCache();
+            _vcontextstamps.swap(vstamps);
+            _vcontextvalues.swap(vvalues);
+            _scontextids.swap(sids);
+        }
+    }
+
+    static void _PushTransform(std::vector<dReal>& vvalues, const Transform& t)
+    {
+        vvalues.push_back(t.rot.x); vvalues.push_back(t.rot.y); vvalues.push_back(t.rot.z); vvalues.push_back(t.rot.w);
+        vvalues.push_back(t.trans.x); vvalues.push_back(t.trans.y); vvalues.push_back(t.trans.z);
+    }
+
+    CacheBinKey _GetCacheBinKey(const Transform& t) const
+    {
+        CacheBinKey key;
+        key[0] = (int)floor(t.trans.x/_fCacheBinTrans);
+        key[1] = (int)floor(t.trans.y/_fCacheBinTrans);
+        key[2] = (int)floor(t.trans.z/_fCacheBinTrans);
+        key[3] = (int)floor(t.rot.x/_fCacheBinRot);
+        key[4] = (int)floor(t.rot.y/_fCacheBinRot);
+        key[5] = (int)floor(t.rot.z/_fCacheBinRot);
+        key[6] = (int)floor(t.rot.w/_fCacheBinRot);
+        return key;
+    }
+
+    static bool _IsSameTransform(const Transform& t0, const Transform& t1)
+    {
+        return (t0.trans-t1.trans).lengthsqr3() <= g_fEpsilonLinear*g_fEpsilonLinear && (t0.rot-t1.rot).lengthsqr4() <= g_fEpsilonLinear*g_fEpsilonLinear;
+    }
+
+    static bool _IsSameValues(const std::vector<dReal>& v0, const std::vector<dReal>& v1)
+    {
+        if( v0.size() != v1.size() ) {
+            return false;
+        }
+        for(size_t i = 0; i < v0.size(); ++i) {
+            if( RaveFabs(v0[i]-v1[i]) > g_fEpsilonLinear ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief returns the bin the entry should be added to, or NULL if the cache is full or disabled
+    CacheBin* _GetCacheBinForInsert(const CacheBinKey& key)
+    {
+        if( _nMaxCacheEntries <= 0 ) {
+            return NULL;
+        }
+        if( _nCacheEntries >= _nMaxCacheEntries ) {
+            RAVELOG_DEBUG(str(boost::format("workspace cache reached %d entries, clearing")%_nCacheEntries));
+            _ClearCache();
+        }
+        ++_nCacheEntries;
+        return &_mapcachebins[key];
+    }
+
+    /// \brief CheckEndEffectorCollision through the cache. On a hit, _report is reset.
+    bool _CheckEndEffectorCollision(const Transform& t)
+    {
+        if( _nMaxCacheEntries <= 0 ) {
+            return _manip->CheckEndEffectorCollision(t,_report);
+        }
+        CacheBinKey key = _GetCacheBinKey(t);
+        std::map<CacheBinKey, CacheBin>::const_iterator itbin = _mapcachebins.find(key);
+        if( itbin != _mapcachebins.end() ) {
+            FOREACHC(itentry, itbin->second.veecollisions) {
+                if( _IsSameTransform(itentry->t, t) ) {
+                    ++_nEECollisionHits;
+                    _report->Reset();
+                    return itentry->bcollision;
+                }
+            }
+        }
+        ++_nEECollisionMisses;
+        bool bcollision = _manip->CheckEndEffectorCollision(t,_report);
+        CacheBin* pbin = _GetCacheBinForInsert(key);
+        if( !!pbin ) {
+            EECollisionEntry entry;
+            entry.t = t;
+            entry.bcollision = bcollision;
+            pbin->veecollisions.push_back(entry);
+        }
+        return bcollision;
+    }
+
+    /// \brief FindIKSolution with _filteroptions through the cache.
+    ///
+    /// The result of _ValidateSolution only depends on the pose, the current arm configuration (which is the previous solution if one is set) and whether the jacobian is used, everything else is covered by _UpdateCacheContext.
+    /// The other custom filters registered on the ik solver can depend on any state, so they are called again on every cached solution, and failures are not cached since the filters might accept a solution later.
+    bool _FindIKSolution(const IkParameterization& ikparam, std::vector<dReal>& vsolution)
+    {
+        if( _nMaxCacheEntries <= 0 ) {
+            return _manip->FindIKSolution(ikparam,vsolution,_filteroptions);
+        }
+        Transform t = ikparam.GetTransform6D();
+        bool bhasprevsolution = _vprevsolution.size() > 0, bhasjacobian = _mjacobian.num_elements() > 0;
+        _robot->GetDOFValues(_vstartvalues, _manip->GetArmIndices());
+        CacheBinKey key = _GetCacheBinKey(t);
+        std::map<CacheBinKey, CacheBin>::iterator itbin = _mapcachebins.find(key);
+        if( itbin != _mapcachebins.end() ) {
+            std::vector<IkEntry>& viks = itbin->second.viks;
+            for(std::vector<IkEntry>::iterator itentry = viks.begin(); itentry != viks.end(); ++itentry) {
+                if( itentry->filteroptions == _filteroptions && itentry->bhasprevsolution == bhasprevsolution && itentry->bhasjacobian == bhasjacobian && _IsSameTransform(itentry->t, t) && _IsSameValues(itentry->vstartvalues, _vstartvalues) ) {
+                    if( _CallIkFilters(itentry->vsolution) ) {
+                        ++_nIkHits;
+                        vsolution = itentry->vsolution;
+                        return true;
+                    }
+                    // the filters reject the cached solution now, so query again and update the entry
+                    ++_nIkMisses;
+                    bool bsuccess = _manip->FindIKSolution(ikparam,vsolution,_filteroptions);
+                    if( bsuccess ) {
+                        itentry->vsolution = vsolution;
+                    }
+                    else {
+                        viks.erase(itentry);
+                        --_nCacheEntries;
+                    }
+                    return bsuccess;
+                }
+            }
+        }
+        ++_nIkMisses;
+        bool bsuccess = _manip->FindIKSolution(ikparam,vsolution,_filteroptions);
+        if( !bsuccess ) {
+            return false;
+        }
+        CacheBin* pbin = _GetCacheBinForInsert(key);
+        if( !!pbin ) {
+            pbin->viks.push_back(IkEntry());
+            IkEntry& entry = pbin->viks.back();
+            entry.t = t;
+            entry.vstartvalues = _vstartvalues;
+            entry.filteroptions = _filteroptions;
+            entry.bhasprevsolution = bhasprevsolution;
+            entry.bhasjacobian = bhasjacobian;
+            entry.vsolution = vsolution;
+        }
+        return bsuccess;
+    }
+
+    /// \brief calls all custom filters of the ik solver on an arm configuration
+    ///
+    /// \return true if the filters accept it
+    bool _CallIkFilters(const std::vector<dReal>& vsolution)
+    {
+        if( _filteroptions & IKFO_IgnoreCustomFilters ) {
+            return true;
+        }
+        RobotBase::RobotStateSaver saver(_robot);
+        _robot->SetDOFValues(vsolution, KinBody::CLA_Nothing, _manip->GetArmIndices());
+        // the cached solution already passed _ValidateSolution
+        _bIgnoreValidateSolution = true;
+        IkReturnAction action = IKRA_Reject;
+        try {
+            action = _manip->GetIkSolver()->CallFilters(_manip->GetIkParameterization(IKP_Transform6D,false));
+        }
+        catch(...) {
+            _bIgnoreValidateSolution = false;
+            throw;
+        }
+        _bIgnoreValidateSolution = false;
+        return action == IKRA_Success;
+    }
+
     void _SetPreviousSolution(const std::vector<dReal>& vsolution, bool bsetjacobian=true)
     {
         if( bsetjacobian ) {
@@ -320,6 +626,9 @@ protected:
 
     IkReturnAction _ValidateSolution(std::vector<dReal>& vsolution, RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikp)
     {
+        if( _bIgnoreValidateSolution ) {
+            return IKRA_Success;
+        }
         RobotBase::RobotStateSaver saver(_robot);
 
         // check if continuous with previous solution using the jacobian
@@ -429,6 +738,18 @@ protected:
     IkParameterization _ikprev;
     vector<dReal> _vprevsolution;
     PlannerBasePtr _retimerplanner;
+
+    // cache of end effector collision and ik results, persists across PlanPath calls
+    std::map<CacheBinKey, CacheBin> _mapcachebins;
+    int _nMaxCacheEntries, _nCacheEntries;
+    dReal _fCacheBinTrans, _fCacheBinRot; ///< discretization of the end effector translation and quaternion
+    std::vector<int> _vcontextstamps, _vnewcontextstamps;
+    std::vector<dReal> _vcontextvalues, _vnewcontextvalues;
+    std::string _scontextids, _snewcontextids;
+    int _nEECollisionHits, _nEECollisionMisses, _nIkHits, _nIkMisses;
+    std::vector<KinBodyPtr> _vgrabbedbodies, _vbodies;
+    std::vector<dReal> _vrobotvalues, _vstartvalues;
+    bool _bIgnoreValidateSolution; ///< if true, _ValidateSolution accepts every solution. set while calling the custom filters on cached solutions
 };
 
 PlannerBasePtr CreateWorkspaceTrajectoryTracker(EnvironmentBasePtr penv, std::istream& sinput) {
@@ -113,12 +113,65 @@ public:
     boost::shared_ptr<void const> _handle;
 };
 
+#ifdef OPENRAVE_BININGS_PYARRAY
+
+/// \brief maps a C++ scalar type to its numpy type, NPY_NOTYPE if the values cannot be block copied
+template <typename T> struct select_npy_type { static const int type = NPY_NOTYPE; };
+template <> struct select_npy_type<double> { static const int type = NPY_DOUBLE; };
+template <> struct select_npy_type<float> { static const int type = NPY_FLOAT; };
+template <> struct select_npy_type<int> { static const int type = NPY_INT; };
+template <> struct select_npy_type<uint32_t> { static const int type = NPY_UINT; };
+template <> struct select_npy_type<uint8_t> { static const int type = NPY_UBYTE; };
+
+/// \brief copies all the values of a numpy array in C order with one memcpy. Multi-dimensional arrays are flattened.
+///
+/// If the array is already contiguous and of type T, no intermediate array is created. Otherwise the array is cast
+/// to T, which is only allowed for safe or same kind casts (int64 to int32 is fine, float to int is not).
+/// \throw error_already_set with a python TypeError if the dtype of the array cannot be cast to T
+/// \return false if o is not a numpy array or T has no numpy type
+template <typename T>
+inline bool ExtractNumpyArray(const object& o, std::vector<T>& v)
+{
+    if( select_npy_type<T>::type == NPY_NOTYPE || !PyArray_Check(o.ptr()) ) {
+        return false;
+    }
+    PyArrayObject* pyinput = (PyArrayObject*)o.ptr();
+    handle<> harray;
+    if( PyArray_TYPE(pyinput) == select_npy_type<T>::type && PyArray_ISCARRAY_RO(pyinput) ) {
+        harray = handle<>(borrowed(o.ptr()));
+    }
+    else {
+        PyArray_Descr* pydescr = PyArray_DescrFromType(select_npy_type<T>::type);
+        if( !PyArray_CanCastArrayTo(pyinput, pydescr, NPY_SAME_KIND_CASTING) ) {
+            char targettype = pydescr->type;
+            Py_DECREF(pydescr);
+            PyErr_Format(PyExc_TypeError, "cannot safely cast array of dtype '%c' to '%c'", PyArray_DESCR(pyinput)->type, targettype);
+            throw_error_already_set();
+        }
+        // steals pydescr, the returned array is C contiguous
+        harray = handle<>(PyArray_CastToType(pyinput, pydescr, 0));
+    }
+    v.resize(PyArray_SIZE((PyArrayObject*)harray.get()));
+    if( v.size() > 0 ) {
+        memcpy(&v[0], PyArray_DATA((PyArrayObject*)harray.get()), v.size()*sizeof(T));
+    }
+    return true;
+}
+
+#endif
+
 template <typename T>
 inline std::vector<T> ExtractArray(const object& o)
 {
     if( IS_PYTHONOBJECT_NONE(o) ) {
         return std::vector<T>();
     }
+#ifdef OPENRAVE_BININGS_PYARRAY
+    std::vector<T> vnumpy;
+    if( ExtractNumpyArray<T>(o, vnumpy) ) {
+        return vnumpy;
+    }
+#endif
     std::vector<T> v(len(o));
     for(size_t i = 0; i < v.size(); ++i) {
         v[i] = extract<T>(o[i]);
@@ -501,7 +501,7 @@ public:
         return bCollision;
     }
 
-    object CheckCollisionRays(object rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false)
+    object CheckCollisionRays(object rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false, bool releasegil=true)
     {
         object shape = rays.attr("shape");
         int num = extract<int>(shape[0]);
@@ -511,6 +511,11 @@ public:
         if( extract<int>(shape[1]) != 6 ) {
             throw openrave_exception(_("rays object needs to be a Nx6 vector\n"));
         }
+        // copy all the rays in one block rather than extracting them row by row
+        std::vector<dReal> vrays = ExtractArray<dReal>(rays);
+        if( (int)vrays.size() != 6*num ) {
+            throw openrave_exception(_("rays object needs to be a Nx6 vector\n"));
+        }
         CollisionReport report;
         CollisionReportPtr preport(&report,null_deleter());
 
@@ -520,8 +525,17 @@ public:
         dReal* ppos = (dReal*)PyArray_DATA(pypos);
         PyObject* pycollision = PyArray_SimpleNew(1,&dims[0], PyArray_BOOL);
         bool* pcollision = (bool*)PyArray_DATA(pycollision);
+        KinBodyConstPtr pcheckbody;
+        if( !!pbody ) {
+            pcheckbody = openravepy::GetKinBody(pbody);
+        }
+        // the output arrays are not visible to python yet, so they can be filled without the GIL
+        openravepy::PythonThreadSaverPtr statesaver;
+        if( releasegil ) {
+            statesaver.reset(new openravepy::PythonThreadSaver());
+        }
         for(int i = 0; i < num; ++i, ppos += 6) {
-            vector<dReal> ray = ExtractArray<dReal>(rays[i]);
+            const dReal* ray = &vrays[6*i];
             r.pos.x = ray[0];
             r.pos.y = ray[1];
             r.pos.z = ray[2];
@@ -529,11 +543,11 @@ public:
             r.dir.y = ray[4];
             r.dir.z = ray[5];
             bool bCollision;
-            if( !pbody ) {
+            if( !pcheckbody ) {
                 bCollision = _pCollisionChecker->CheckCollision(r, preport);
             }
             else {
-                bCollision = _pCollisionChecker->CheckCollision(r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), preport);
+                bCollision = _pCollisionChecker->CheckCollision(r, pcheckbody, preport);
             }
             pcollision[i] = false;
             ppos[0] = 0; ppos[1] = 0; ppos[2] = 0; ppos[3] = 0; ppos[4] = 0; ppos[5] = 0;
@@ -549,6 +563,7 @@ public:
                 }
             }
         }
+        statesaver.reset(); // reacquire the GIL before touching python objects
 
         return boost::python::make_tuple(static_cast<numeric::array>(handle<>(pycollision)),static_cast<numeric::array>(handle<>(pypos)));
     }
@@ -565,6 +580,24 @@ public:
         return bCollision;
     }
 
+    object CheckContinuousCollision(PyKinBodyPtr pbody, object odofvalues0, object odofvalues1, PyCollisionReportPtr pReport=PyCollisionReportPtr())
+    {
+        std::vector<dReal> vdofvalues0 = ExtractArray<dReal>(odofvalues0), vdofvalues1 = ExtractArray<dReal>(odofvalues1);
+        dReal fTimeOfContact = -1;
+        bool bCollision = _pCollisionChecker->CheckContinuousCollision(openravepy::GetKinBody(pbody), vdofvalues0, vdofvalues1, fTimeOfContact, openravepy::GetCollisionReport(pReport));
+        openravepy::UpdateCollisionReport(pReport,_pyenv);
+        return boost::python::make_tuple(bCollision, fTimeOfContact);
+    }
+
+    object CheckContinuousStandaloneSelfCollision(PyKinBodyPtr pbody, object odofvalues0, object odofvalues1, PyCollisionReportPtr pReport=PyCollisionReportPtr())
+    {
+        std::vector<dReal> vdofvalues0 = ExtractArray<dReal>(odofvalues0), vdofvalues1 = ExtractArray<dReal>(odofvalues1);
+        dReal fTimeOfContact = -1;
+        bool bCollision = _pCollisionChecker->CheckContinuousStandaloneSelfCollision(openravepy::GetKinBody(pbody), vdofvalues0, vdofvalues1, fTimeOfContact, openravepy::GetCollisionReport(pReport));
+        openravepy::UpdateCollisionReport(pReport,_pyenv);
+        return boost::python::make_tuple(bCollision, fTimeOfContact);
+    }
+
     virtual bool CheckSelfCollision(object o1, PyCollisionReportPtr pReport)
     {
         KinBody::LinkConstPtr plink1 = openravepy::GetKinBodyLinkConst(o1);
@@ -645,7 +678,9 @@ PyCollisionCheckerBasePtr RaveCreateCollisionChecker(PyEnvironmentBasePtr pyenv,
     return PyCollisionCheckerBasePtr(new PyCollisionCheckerBase(p,pyenv));
 }
 
-BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckContinuousCollision_overloads, CheckContinuousCollision, 3, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckContinuousStandaloneSelfCollision_overloads, CheckContinuousStandaloneSelfCollision, 3, 4)
 
 void init_openravepy_collisionchecker()
 {
@@ -730,9 +765,11 @@ void init_openravepy_collisionchecker()
     .def("CheckCollision",pcoly,args("ray"), DOXY_FN(CollisionCheckerBase,CheckCollision "const RAY; CollisionReportPtr"))
     .def("CheckCollision",pcolyr,args("ray", "report"), DOXY_FN(CollisionCheckerBase,CheckCollision "const RAY; CollisionReportPtr"))
     .def("CheckSelfCollision",&PyCollisionCheckerBase::CheckSelfCollision,args("linkbody", "report"), DOXY_FN(CollisionCheckerBase,CheckSelfCollision "KinBodyConstPtr, CollisionReportPtr"))
+    .def("CheckContinuousCollision",&PyCollisionCheckerBase::CheckContinuousCollision, CheckContinuousCollision_overloads(args("body","dofvalues0","dofvalues1","report"), "Checks the body against the environment along the linear motion from dofvalues0 to dofvalues1. Returns a tuple of whether it is in collision and the interpolation parameter of the earliest contact."))
+    .def("CheckContinuousStandaloneSelfCollision",&PyCollisionCheckerBase::CheckContinuousStandaloneSelfCollision, CheckContinuousStandaloneSelfCollision_overloads(args("body","dofvalues0","dofvalues1","report"), "Checks the self-collisions of the body along the linear motion from dofvalues0 to dofvalues1. Returns a tuple of whether it is in collision and the interpolation parameter of the earliest contact."))
     .def("CheckCollisionRays",&PyCollisionCheckerBase::CheckCollisionRays,
-         CheckCollisionRays_overloads(args("rays","body","front_facing_only"),
-                                      "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columsn are position, last 3 are direction+range."))
+         CheckCollisionRays_overloads(args("rays","body","front_facing_only","releasegil"),
+                                      "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columsn are position, last 3 are direction+range. The python GIL is released while checking unless releasegil is False."))
     ;
 
     def("RaveCreateCollisionChecker",openravepy::RaveCreateCollisionChecker,args("env","name"),DOXY_FN1(RaveCreateCollisionChecker));
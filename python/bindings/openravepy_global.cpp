@@ -608,6 +608,22 @@ object pyRaveGetAffineDOFValuesFromTransform(object otransform, int affinedofs,
     return toPyArray(values);
 }
 
+/// \brief returns a list of (name, count, totaltime, maxtime, histogram) tuples, times are in nanoseconds
+object pyRaveGetProfileStatistics()
+{
+    std::vector<ProfileStatistics> vstatistics;
+    RaveGetProfileStatistics(vstatistics);
+    boost::python::list ostatistics;
+    FOREACHC(itstats, vstatistics) {
+        boost::python::list ohistogram;
+        FOREACHC(itbin, itstats->vhistogram) {
+            ohistogram.append(*itbin);
+        }
+        ostatistics.append(boost::python::make_tuple(itstats->name, itstats->count, itstats->totaltime, itstats->maxtime, ohistogram));
+    }
+    return ostatistics;
+}
+
 std::string openravepyCompilerVersion()
 {
     stringstream ss;
@@ -1038,6 +1054,10 @@ void init_openravepy_global()
     .value("Verbose",Level_Verbose)
     .value("VerifyPlans",Level_VerifyPlans)
     ;
+    enum_<LogMode>("LogMode" DOXY_ENUM(LogMode))
+    .value("Direct",LM_Direct)
+    .value("Async",LM_Async)
+    ;
     enum_<SerializationOptions>("SerializationOptions" DOXY_ENUM(SerializationOptions))
     .value("Kinematics",SO_Kinematics)
     .value("Dynamics",SO_Dynamics)
@@ -1214,6 +1234,12 @@ void init_openravepy_global()
 
     def("RaveSetDebugLevel",openravepy::pyRaveSetDebugLevel,args("level"), DOXY_FN1(RaveSetDebugLevel));
     def("RaveGetDebugLevel",OpenRAVE::RaveGetDebugLevel,DOXY_FN1(RaveGetDebugLevel));
+    def("RaveSetLogMode",OpenRAVE::RaveSetLogMode,args("mode"), DOXY_FN1(RaveSetLogMode));
+    def("RaveGetLogMode",OpenRAVE::RaveGetLogMode,DOXY_FN1(RaveGetLogMode));
+    def("RaveFlushLog",OpenRAVE::RaveFlushLog,DOXY_FN1(RaveFlushLog));
+    def("RaveGetLogDropCount",OpenRAVE::RaveGetLogDropCount,DOXY_FN1(RaveGetLogDropCount));
+    def("RaveGetProfileStatistics",openravepy::pyRaveGetProfileStatistics,DOXY_FN1(RaveGetProfileStatistics));
+    def("RaveResetProfileStatistics",OpenRAVE::RaveResetProfileStatistics,DOXY_FN1(RaveResetProfileStatistics));
     def("RaveSetDataAccess",openravepy::pyRaveSetDataAccess,args("accessoptions"), DOXY_FN1(RaveSetDataAccess));
     def("RaveGetDataAccess",OpenRAVE::RaveGetDataAccess, DOXY_FN1(RaveGetDataAccess));
     def("RaveGetDefaultViewerType", OpenRAVE::RaveGetDefaultViewerType, DOXY_FN1(RaveGetDefaultViewerType));
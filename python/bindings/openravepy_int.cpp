@@ -571,13 +571,18 @@ public:
     }
     bool CheckCollision(PyKinBodyPtr pbody1)
     {
-        CHECK_POINTER(pbody1);
-        return _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)));
+        return CheckCollision(pbody1, PyCollisionReportPtr());
     }
     bool CheckCollision(PyKinBodyPtr pbody1, PyCollisionReportPtr pReport)
     {
         CHECK_POINTER(pbody1);
-        bool bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), openravepy::GetCollisionReport(pReport));
+        KinBodyConstPtr pbody = openravepy::GetKinBody(pbody1);
+        CollisionReportPtr preport = openravepy::GetCollisionReport(pReport);
+        bool bCollision;
+        {
+            openravepy::PythonThreadSaver statesaver;
+            bCollision = _penv->CheckCollision(pbody, preport);
+        }
         openravepy::UpdateCollisionReport(pReport,shared_from_this());
         return bCollision;
     }
@@ -600,34 +605,34 @@ public:
 
     bool CheckCollision(object o1)
     {
-        CHECK_POINTER(o1);
-        KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
-        if( !!plink ) {
-            return _penv->CheckCollision(plink);
-        }
-        KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
-        if( !!pbody ) {
-            return _penv->CheckCollision(pbody);
-        }
-        throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
+        return CheckCollision(o1, PyCollisionReportPtr(), true);
     }
 
     bool CheckCollision(object o1, PyCollisionReportPtr pReport)
+    {
+        return CheckCollision(o1, pReport, true);
+    }
+
+    /// \brief checks a link or a body against the environment, the GIL is released while checking unless releasegil is false
+    bool CheckCollision(object o1, PyCollisionReportPtr pReport, bool releasegil)
     {
         CHECK_POINTER(o1);
         KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
-        bool bCollision;
-        if( !!plink ) {
-            bCollision = _penv->CheckCollision(plink,openravepy::GetCollisionReport(pReport));
-        }
-        else {
-            KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
-            if( !!pbody ) {
-                bCollision = _penv->CheckCollision(pbody,openravepy::GetCollisionReport(pReport));
+        KinBodyConstPtr pbody;
+        if( !plink ) {
+            pbody = openravepy::GetKinBody(o1);
+            if( !pbody ) {
+                throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
             }
-            else {
-                throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument"),ORE_InvalidArguments);
+        }
+        CollisionReportPtr preport = openravepy::GetCollisionReport(pReport);
+        bool bCollision;
+        {
+            openravepy::PythonThreadSaverPtr statesaver;
+            if( releasegil ) {
+                statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            bCollision = !!plink ? _penv->CheckCollision(plink,preport) : _penv->CheckCollision(pbody,preport);
         }
         openravepy::UpdateCollisionReport(pReport,shared_from_this());
         return bCollision;
@@ -907,7 +912,7 @@ public:
         return bCollision;
     }
 
-    object CheckCollisionRays(object rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false)
+    object CheckCollisionRays(object rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false, bool releasegil=true)
     {
         object shape = rays.attr("shape");
         int num = extract<int>(shape[0]);
@@ -917,6 +922,11 @@ public:
         if( extract<int>(shape[1]) != 6 ) {
             throw openrave_exception(_("rays object needs to be a Nx6 vector\n"));
         }
+        // copy all the rays in one block rather than extracting them row by row
+        std::vector<dReal> vrays = ExtractArray<dReal>(rays);
+        if( (int)vrays.size() != 6*num ) {
+            throw openrave_exception(_("rays object needs to be a Nx6 vector\n"));
+        }
         CollisionReport report;
         CollisionReportPtr preport(&report,null_deleter());
 
@@ -926,8 +936,17 @@ public:
         dReal* ppos = (dReal*)PyArray_DATA(pypos);
         PyObject* pycollision = PyArray_SimpleNew(1,&dims[0], PyArray_BOOL);
         bool* pcollision = (bool*)PyArray_DATA(pycollision);
+        KinBodyConstPtr pcheckbody;
+        if( !!pbody ) {
+            pcheckbody = openravepy::GetKinBody(pbody);
+        }
+        // the output arrays are not visible to python yet, so they can be filled without the GIL
+        openravepy::PythonThreadSaverPtr statesaver;
+        if( releasegil ) {
+            statesaver.reset(new openravepy::PythonThreadSaver());
+        }
         for(int i = 0; i < num; ++i, ppos += 6) {
-            vector<dReal> ray = ExtractArray<dReal>(rays[i]);
+            const dReal* ray = &vrays[6*i];
             r.pos.x = ray[0];
             r.pos.y = ray[1];
             r.pos.z = ray[2];
@@ -935,11 +954,11 @@ public:
             r.dir.y = ray[4];
             r.dir.z = ray[5];
             bool bCollision;
-            if( !pbody ) {
+            if( !pcheckbody ) {
                 bCollision = _penv->CheckCollision(r, preport);
             }
             else {
-                bCollision = _penv->CheckCollision(r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), preport);
+                bCollision = _penv->CheckCollision(r, pcheckbody, preport);
             }
             pcollision[i] = false;
             ppos[0] = 0; ppos[1] = 0; ppos[2] = 0; ppos[3] = 0; ppos[4] = 0; ppos[5] = 0;
@@ -955,10 +974,27 @@ public:
                 }
             }
         }
+        statesaver.reset(); // reacquire the GIL before touching python objects
 
         return boost::python::make_tuple(static_cast<numeric::array>(handle<>(pycollision)),static_cast<numeric::array>(handle<>(pypos)));
     }
 
+    object CheckConfigurations(PyKinBodyPtr pbody, object odofindices, object oconfigs, int checkoptions=EnvironmentBase::CCR_EnvironmentCollision|EnvironmentBase::CCR_SelfCollision|EnvironmentBase::CCR_OutOfLimits, int numthreads=0, bool releasegil=true)
+    {
+        CHECK_POINTER(pbody);
+        std::vector<int> dofindices = ExtractArray<int>(odofindices);
+        std::vector<dReal> vconfigs = ExtractArray<dReal>(oconfigs);
+        std::vector<uint8_t> vresults;
+        {
+            openravepy::PythonThreadSaverPtr statesaver;
+            if( releasegil ) {
+                statesaver.reset(new openravepy::PythonThreadSaver());
+            }
+            _penv->CheckConfigurations(openravepy::GetKinBody(pbody), dofindices, vconfigs, vresults, checkoptions, numthreads);
+        }
+        return toPyArrayN(vresults.size() > 0 ? &vresults[0] : NULL, vresults.size());
+    }
+
     bool CheckCollision(boost::shared_ptr<PyRay> pyray)
     {
         return _penv->CheckCollision(pyray->r);
@@ -1594,6 +1630,24 @@ public:
     {
         std::vector<KinBody::BodyState> vbodystates;
         _penv->GetPublishedBodies(vbodystates, timeout);
+        return _ConvertBodyStates(vbodystates);
+    }
+
+    /// \return (bodystates, removedbodyids, publishedversion, isdelta)
+    object GetPublishedBodiesChanged(uint64_t publishedversion=0, uint64_t timeout=0)
+    {
+        std::vector<KinBody::BodyState> vbodystates;
+        std::vector<int> vremovedbodyids;
+        bool bdelta = _penv->GetPublishedBodiesChanged(vbodystates, vremovedbodyids, publishedversion, timeout);
+        boost::python::list oremovedbodyids;
+        FOREACH(itid, vremovedbodyids) {
+            oremovedbodyids.append(*itid);
+        }
+        return boost::python::make_tuple(_ConvertBodyStates(vbodystates), oremovedbodyids, publishedversion, bdelta);
+    }
+
+    object _ConvertBodyStates(const std::vector<KinBody::BodyState>& vbodystates)
+    {
         boost::python::list ostates;
         FOREACH(itstate, vbodystates) {
             boost::python::dict ostate;
@@ -1800,7 +1854,8 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(StartSimulation_overloads, StartSimulatio
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(StopSimulation_overloads, StopSimulation, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetViewer_overloads, SetViewer, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetDefaultViewer_overloads, SetDefaultViewer, 0, 1)
-BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckConfigurations_overloads, CheckConfigurations, 3, 6)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(plot3_overloads, plot3, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(drawlinestrip_overloads, drawlinestrip, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(drawlinelist_overloads, drawlinelist, 2, 4)
@@ -1812,6 +1867,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Add_overloads, Add, 1, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Save_overloads, Save, 1, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetUserData_overloads, GetUserData, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodies_overloads, GetPublishedBodies, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodiesChanged_overloads, GetPublishedBodiesChanged, 0, 2)
 
 object get_openrave_exception_unicode(openrave_exception* p)
 {
@@ -1889,7 +1945,7 @@ In C++ the syntax is::\n\n  success = SendCommand(OUT, IN)\n\n\
 In python, the syntax is::\n\n\
   OUT = SendCommand(IN,releasegil)\n\
   success = OUT is not None\n\n\n\
-The **releasegil** parameter controls whether the python Global Interpreter Lock should be released when executing this code. For calls that take a long time and if there are many threads running called from different python threads, releasing the GIL could speed up things a lot. Please keep in mind that releasing and re-acquiring the GIL also takes computation time.\n\
+The **releasegil** parameter (default True) controls whether the python Global Interpreter Lock should be released when executing this code. For calls that take a long time and if there are many threads running called from different python threads, releasing the GIL could speed up things a lot. Please keep in mind that releasing and re-acquiring the GIL also takes computation time.\n\
 Because race conditions can pop up when trying to lock the openrave environment without releasing the GIL, if lockenv=True is specified, the system can try to safely lock the openrave environment without causing a deadlock with the python GIL and other threads.\n");
         class_<PyInterfaceBase, boost::shared_ptr<PyInterfaceBase> >("Interface", DOXY_CLASS(InterfaceBase), no_init)
         .def("GetInterfaceType",&PyInterfaceBase::GetInterfaceType, DOXY_FN(InterfaceBase,GetInterfaceType))
@@ -1926,6 +1982,7 @@ Because race conditions can pop up when trying to lock the openrave environment
         bool (PyEnvironmentBase::*pcolbbr)(PyKinBodyPtr, PyKinBodyPtr,PyCollisionReportPtr) = &PyEnvironmentBase::CheckCollision;
         bool (PyEnvironmentBase::*pcoll)(object) = &PyEnvironmentBase::CheckCollision;
         bool (PyEnvironmentBase::*pcollr)(object, PyCollisionReportPtr) = &PyEnvironmentBase::CheckCollision;
+        bool (PyEnvironmentBase::*pcollrg)(object, PyCollisionReportPtr, bool) = &PyEnvironmentBase::CheckCollision;
         bool (PyEnvironmentBase::*pcolll)(object,object) = &PyEnvironmentBase::CheckCollision;
         bool (PyEnvironmentBase::*pcolllr)(object,object, PyCollisionReportPtr) = &PyEnvironmentBase::CheckCollision;
         bool (PyEnvironmentBase::*pcollb)(object, PyKinBodyPtr) = &PyEnvironmentBase::CheckCollision;
@@ -1998,9 +2055,13 @@ Because race conditions can pop up when trying to lock the openrave environment
                     .def("CheckCollision",pcolybr,args("ray","body","report"), DOXY_FN(EnvironmentBase,CheckCollision "const RAY; KinBodyConstPtr; CollisionReportPtr"))
                     .def("CheckCollision",pcoly,args("ray"), DOXY_FN(EnvironmentBase,CheckCollision "const RAY; CollisionReportPtr"))
                     .def("CheckCollision",pcolyr,args("ray"), DOXY_FN(EnvironmentBase,CheckCollision "const RAY; CollisionReportPtr"))
+                    .def("CheckCollision",pcollrg,args("body","report","releasegil"), "Checks a body or a link against the environment. The python GIL is released while checking unless releasegil is False.")
                     .def("CheckCollisionRays",&PyEnvironmentBase::CheckCollisionRays,
-                         CheckCollisionRays_overloads(args("rays","body","front_facing_only"),
-                                                      "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columsn are position, last 3 are direction+range."))
+                         CheckCollisionRays_overloads(args("rays","body","front_facing_only","releasegil"),
+                                                      "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columsn are position, last 3 are direction+range. The python GIL is released while checking unless releasegil is False."))
+                    .def("CheckConfigurations",&PyEnvironmentBase::CheckConfigurations,
+                         CheckConfigurations_overloads(args("body","dofindices","configs","checkoptions","numthreads","releasegil"),
+                                                       "Checks a Nxlen(dofindices) array of configurations and returns a uint8 array of ConfigurationCheckResult bits for each of them, 0 if valid. The python GIL is released while checking unless releasegil is False."))
                     .def("LoadURI",&PyEnvironmentBase::LoadURI,LoadURI_overloads(args("filename","atts"), DOXY_FN(EnvironmentBase,LoadURI)))
                     .def("Load",load1,args("filename"), DOXY_FN(EnvironmentBase,Load))
                     .def("Load",load2,args("filename","atts"), DOXY_FN(EnvironmentBase,Load))
@@ -2084,6 +2145,7 @@ Because race conditions can pop up when trying to lock the openrave environment
                     .def("GetSensors",&PyEnvironmentBase::GetSensors, DOXY_FN(EnvironmentBase,GetSensors))
                     .def("UpdatePublishedBodies",&PyEnvironmentBase::UpdatePublishedBodies, DOXY_FN(EnvironmentBase,UpdatePublishedBodies))
                     .def("GetPublishedBodies",&PyEnvironmentBase::GetPublishedBodies, GetPublishedBodies_overloads(args("timeout"), DOXY_FN(EnvironmentBase,GetPublishedBodies)))
+                    .def("GetPublishedBodiesChanged",&PyEnvironmentBase::GetPublishedBodiesChanged, GetPublishedBodiesChanged_overloads(args("publishedversion","timeout"), DOXY_FN(EnvironmentBase,GetPublishedBodiesChanged)))
                     .def("Triangulate",&PyEnvironmentBase::Triangulate,args("body"), DOXY_FN(EnvironmentBase,Triangulate))
                     .def("TriangulateScene",&PyEnvironmentBase::TriangulateScene,args("options","name"), DOXY_FN(EnvironmentBase,TriangulateScene))
                     .def("SetDebugLevel",&PyEnvironmentBase::SetDebugLevel,args("level"), DOXY_FN(EnvironmentBase,SetDebugLevel))
@@ -2111,6 +2173,11 @@ Because race conditions can pop up when trying to lock the openrave environment
                                   .value("AllExceptBody",EnvironmentBase::SO_AllExceptBody)
         ;
         env.attr("TriangulateOptions") = selectionoptions;
+        enum_<EnvironmentBase::ConfigurationCheckResult>("ConfigurationCheckResult" DOXY_ENUM(ConfigurationCheckResult))
+        .value("EnvironmentCollision",EnvironmentBase::CCR_EnvironmentCollision)
+        .value("SelfCollision",EnvironmentBase::CCR_SelfCollision)
+        .value("OutOfLimits",EnvironmentBase::CCR_OutOfLimits)
+        ;
     }
 
     {
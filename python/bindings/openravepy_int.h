@@ -255,9 +255,36 @@ inline RaveVector<T> ExtractVector(const object& oraw)
     return v;
 }
 
+/// \brief extracts a numpy array of either 7 values (quaternion, translation) or a 3x4/4x4 matrix with one block copy
+template <typename T>
+inline RaveTransformMatrix<T> ExtractTransformMatrixFromBlock(const object& o)
+{
+    std::vector<T> v;
+    if( !ExtractNumpyArray<T>(o, v) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("failed to convert numpy array to transform"), ORE_InvalidArguments);
+    }
+    if( v.size() == 7 ) {
+        return RaveTransform<T>(RaveVector<T>(v[0], v[1], v[2], v[3]), RaveVector<T>(v[4], v[5], v[6]));
+    }
+    if( v.size() != 12 && v.size() != 16 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("transform needs 7, 12, or 16 values, got %d"), v.size(), ORE_InvalidArguments);
+    }
+    RaveTransformMatrix<T> t;
+    for(int i = 0; i < 3; ++i) {
+        t.m[4*i+0] = v[4*i+0];
+        t.m[4*i+1] = v[4*i+1];
+        t.m[4*i+2] = v[4*i+2];
+        t.trans[i] = v[4*i+3];
+    }
+    return t;
+}
+
 template <typename T>
 inline RaveTransform<T> ExtractTransformType(const object& o)
 {
+    if( PyArray_Check(o.ptr()) ) {
+        return ExtractTransformMatrixFromBlock<T>(o);
+    }
     if( len(o) == 7 ) {
         return RaveTransform<T>(RaveVector<T>(extract<T>(o[0]), extract<T>(o[1]), extract<T>(o[2]), extract<T>(o[3])), RaveVector<T>(extract<T>(o[4]), extract<T>(o[5]), extract<T>(o[6])));
     }
@@ -275,6 +302,9 @@ inline RaveTransform<T> ExtractTransformType(const object& o)
 template <typename T>
 inline RaveTransformMatrix<T> ExtractTransformMatrixType(const object& o)
 {
+    if( PyArray_Check(o.ptr()) ) {
+        return ExtractTransformMatrixFromBlock<T>(o);
+    }
     if( len(o) == 7 ) {
         return RaveTransform<T>(RaveVector<T>(extract<T>(o[0]), extract<T>(o[1]), extract<T>(o[2]), extract<T>(o[3])), RaveVector<T>(extract<T>(o[4]), extract<T>(o[5]), extract<T>(o[6])));
     }
@@ -564,7 +594,7 @@ public:
 
     bool SupportsCommand(const string& cmd);
 
-    object SendCommand(const string& in, bool releasegil=false, bool lockenv=false);
+    object SendCommand(const string& in, bool releasegil=true, bool lockenv=false);
 
     virtual object GetReadableInterfaces();
     virtual object GetReadableInterface(const std::string& xmltag);
@@ -52,6 +52,16 @@ boost::python::object GetCustomParameters(const std::map<std::string, std::vecto
     return boost::python::object();
 }
 
+/// \brief extracts an Nx3 array of points
+void ExtractPoints3(object opoints, std::vector<Vector>& vpoints)
+{
+    int numpoints = len(opoints);
+    vpoints.resize(numpoints);
+    for(int i = 0; i < numpoints; ++i) {
+        vpoints[i] = ExtractVector3(opoints[i]);
+    }
+}
+
 class PyGeometryInfo
 {
 public:
@@ -68,6 +78,8 @@ public:
         _vCollisionScale = toPyVector3(Vector(1,1,1));
         _bVisible = true;
         _bModifiable = true;
+        _fOctreeResolution = 0.01;
+        _vOctreePoints = toPyArray3(std::vector<Vector>());
     }
     PyGeometryInfo(const KinBody::GeometryInfo& info) {
         _t = ReturnTransform(info._t);
@@ -85,6 +97,10 @@ public:
         _fTransparency = info._fTransparency;
         _bVisible = info._bVisible;
         _bModifiable = info._bModifiable;
+        _fOctreeResolution = info._octree.GetResolution();
+        std::vector<Vector> vpoints;
+        info._octree.GetOccupiedCenters(vpoints);
+        _vOctreePoints = toPyArray3(vpoints);
         //TODO
         //_mapExtraGeometries = info. _mapExtraGeometries;
     }
@@ -113,6 +129,12 @@ public:
         info._fTransparency = _fTransparency;
         info._bVisible = _bVisible;
         info._bModifiable = _bModifiable;
+        info._octree.SetResolution(_fOctreeResolution);
+        if( !IS_PYTHONOBJECT_NONE(_vOctreePoints) ) {
+            std::vector<Vector> vpoints;
+            ExtractPoints3(_vOctreePoints, vpoints);
+            info._octree.Update(vpoints, true);
+        }
         //TODO
         //info._mapExtraGeometries =  _mapExtraGeometries;
         return pinfo;
@@ -125,6 +147,8 @@ public:
     boost::python::dict _mapExtraGeometries;
     float _fTransparency;
     bool _bVisible, _bModifiable;
+    dReal _fOctreeResolution;
+    object _vOctreePoints; ///< Nx3 centers of the occupied octree voxels
 };
 typedef boost::shared_ptr<PyGeometryInfo> PyGeometryInfoPtr;
 
@@ -616,6 +640,22 @@ public:
         object GetContainerBottomCross() const {
             return toPyVector3(_pgeometry->GetContainerBottomCross());
         }
+        dReal GetOctreeResolution() const {
+            return _pgeometry->GetOctree().GetResolution();
+        }
+        object GetOctreePoints() const {
+            std::vector<Vector> vpoints;
+            _pgeometry->GetOctree().GetOccupiedCenters(vpoints);
+            return toPyArray3(vpoints);
+        }
+        int UpdateOctree(object opoints, bool occupied=true) {
+            std::vector<Vector> vpoints;
+            ExtractPoints3(opoints, vpoints);
+            return _pgeometry->UpdateOctree(vpoints, occupied);
+        }
+        void ClearOctree() {
+            _pgeometry->ClearOctree();
+        }
         object GetRenderScale() const {
             return toPyVector3(_pgeometry->GetRenderScale());
         }
@@ -675,6 +715,9 @@ public:
     void Enable(bool bEnable) {
         _plink->Enable(bEnable);
     }
+    int GetUpdateStamp() const {
+        return _plink->GetUpdateStamp();
+    }
 
     object GetParent() const
     {
@@ -1834,19 +1877,70 @@ object PyKinBody::GetTransformPose() const {
 
 object PyKinBody::GetLinkTransformations(bool returndoflastvlaues) const
 {
-    boost::python::list otransforms;
     vector<Transform> vtransforms;
     std::vector<dReal> vdoflastsetvalues;
     _pbody->GetLinkTransformations(vtransforms, vdoflastsetvalues);
+    // fill one numlinks x 4 x 4 (or numlinks x 7 for quaternions) array instead of creating an array per link
+    bool bquaternions = GetReturnTransformQuaternions();
+    npy_intp dims[] = { npy_intp(vtransforms.size()), npy_intp(bquaternions ? 7 : 4), npy_intp(4) };
+    PyObject *pytransforms = PyArray_SimpleNew(bquaternions ? 2 : 3, dims, sizeof(dReal)==8 ? PyArray_DOUBLE : PyArray_FLOAT);
+    dReal* pdata = (dReal*)PyArray_DATA(pytransforms);
     FOREACHC(it, vtransforms) {
-        otransforms.append(ReturnTransform(*it));
+        if( bquaternions ) {
+            *pdata++ = it->rot.x; *pdata++ = it->rot.y; *pdata++ = it->rot.z; *pdata++ = it->rot.w;
+            *pdata++ = it->trans.x; *pdata++ = it->trans.y; *pdata++ = it->trans.z;
+        }
+        else {
+            TransformMatrix t(*it);
+            *pdata++ = t.m[0]; *pdata++ = t.m[1]; *pdata++ = t.m[2]; *pdata++ = t.trans.x;
+            *pdata++ = t.m[4]; *pdata++ = t.m[5]; *pdata++ = t.m[6]; *pdata++ = t.trans.y;
+            *pdata++ = t.m[8]; *pdata++ = t.m[9]; *pdata++ = t.m[10]; *pdata++ = t.trans.z;
+            *pdata++ = 0; *pdata++ = 0; *pdata++ = 0; *pdata++ = 1;
+        }
     }
+    object otransforms = static_cast<numeric::array>(handle<>(pytransforms));
     if( returndoflastvlaues ) {
         return boost::python::make_tuple(otransforms, toPyArray(vdoflastsetvalues));
     }
     return otransforms;
 }
 
+object PyKinBody::ComputeLinkTransformations(object odofvalues, object oindices, int linkindex, object olocalposition) const
+{
+    vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    // numconfigs x dofstride numpy arrays are flattened by ExtractArray
+    std::vector<dReal> vdofvalues = ExtractArray<dReal>(odofvalues);
+    std::vector<Transform> vtransforms;
+    std::vector<dReal> vjacobians;
+    if( linkindex >= 0 ) {
+        Vector localposition;
+        if( !IS_PYTHONOBJECT_NONE(olocalposition) ) {
+            localposition = ExtractVector3(olocalposition);
+        }
+        _pbody->ComputeLinkTransformations(vtransforms, vjacobians, linkindex, localposition, vdofvalues, vindices);
+    }
+    else {
+        _pbody->ComputeLinkTransformations(vtransforms, vdofvalues, vindices);
+    }
+    size_t numlinks = _pbody->GetLinks().size();
+    std::vector<dReal> vposes(vtransforms.size()*7);
+    std::vector<dReal>::iterator itpose = vposes.begin();
+    FOREACHC(it, vtransforms) {
+        *itpose++ = it->rot.x; *itpose++ = it->rot.y; *itpose++ = it->rot.z; *itpose++ = it->rot.w;
+        *itpose++ = it->trans.x; *itpose++ = it->trans.y; *itpose++ = it->trans.z;
+    }
+    size_t numconfigs = numlinks > 0 ? vtransforms.size()/numlinks : 0;
+    std::vector<npy_intp> dims(3); dims[0] = numconfigs; dims[1] = numlinks; dims[2] = 7;
+    if( linkindex < 0 ) {
+        return toPyArray(vposes,dims);
+    }
+    std::vector<npy_intp> jacobiandims(3); jacobiandims[0] = numconfigs; jacobiandims[1] = 6; jacobiandims[2] = vindices.size() > 0 ? vindices.size() : _pbody->GetDOF();
+    return boost::python::make_tuple(toPyArray(vposes,dims), toPyArray(vjacobians,jacobiandims));
+}
+
 void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
 {
     size_t numtransforms = len(transforms);
@@ -1854,8 +1948,34 @@ void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
         throw openrave_exception(_("number of input transforms not equal to links"));
     }
     std::vector<Transform> vtransforms(numtransforms);
-    for(size_t i = 0; i < numtransforms; ++i) {
-        vtransforms[i] = ExtractTransform(transforms[i]);
+    if( PyArray_Check(transforms.ptr()) ) {
+        // numlinks x 7, numlinks x 3 x 4, or numlinks x 4 x 4 array from GetLinkTransformations
+        std::vector<dReal> vvalues = ExtractArray<dReal>(transforms);
+        size_t stride = numtransforms > 0 ? vvalues.size()/numtransforms : 0;
+        if( numtransforms > 0 && (stride*numtransforms != vvalues.size() || (stride != 7 && stride != 12 && stride != 16)) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("transforms need 7, 12, or 16 values each, got %d"), stride, ORE_InvalidArguments);
+        }
+        for(size_t i = 0; i < numtransforms; ++i) {
+            const dReal* pvalues = &vvalues[i*stride];
+            if( stride == 7 ) {
+                vtransforms[i] = Transform(Vector(pvalues[0], pvalues[1], pvalues[2], pvalues[3]), Vector(pvalues[4], pvalues[5], pvalues[6]));
+            }
+            else {
+                TransformMatrix t;
+                for(int j = 0; j < 3; ++j) {
+                    t.m[4*j+0] = pvalues[4*j+0];
+                    t.m[4*j+1] = pvalues[4*j+1];
+                    t.m[4*j+2] = pvalues[4*j+2];
+                    t.trans[j] = pvalues[4*j+3];
+                }
+                vtransforms[i] = t;
+            }
+        }
+    }
+    else {
+        for(size_t i = 0; i < numtransforms; ++i) {
+            vtransforms[i] = ExtractTransform(transforms[i]);
+        }
     }
     if( IS_PYTHONOBJECT_NONE(odoflastvalues) ) {
         _pbody->SetLinkTransformations(vtransforms);
@@ -2292,6 +2412,19 @@ object PyKinBody::ComputeInverseDynamics(object odofaccelerations, object oexter
     }
 }
 
+object PyKinBody::ComputeInverseDynamicsOfStates(object odofvalues, object odofvelocities, object odofaccelerations) const
+{
+    // numstates x dof numpy arrays are flattened by ExtractArray
+    std::vector<dReal> vdofvalues = ExtractArray<dReal>(odofvalues);
+    std::vector<dReal> vdofvelocities = ExtractArray<dReal>(odofvelocities);
+    std::vector<dReal> vdofaccelerations = ExtractArray<dReal>(odofaccelerations);
+    std::vector<dReal> vdoftorques;
+    _pbody->ComputeInverseDynamics(vdoftorques, vdofvalues, vdofvelocities, vdofaccelerations);
+    int dof = _pbody->GetDOF();
+    std::vector<npy_intp> dims(2); dims[0] = dof > 0 ? vdoftorques.size()/dof : 0; dims[1] = dof;
+    return toPyArray(vdoftorques,dims);
+}
+
 void PyKinBody::SetSelfCollisionChecker(PyCollisionCheckerBasePtr pycollisionchecker)
 {
     _pbody->SetSelfCollisionChecker(openravepy::GetCollisionChecker(pycollisionchecker));
@@ -2621,7 +2754,7 @@ class GeometryInfo_pickle_suite : public pickle_suite
 public:
     static boost::python::tuple getstate(const PyGeometryInfo& r)
     {
-        return boost::python::make_tuple(r._t, boost::make_tuple(r._vGeomData, r._vGeomData2, r._vGeomData3), r._vDiffuseColor, r._vAmbientColor, r._meshcollision, r._type, r._filenamerender, r._filenamecollision, r._vRenderScale, r._vCollisionScale, r._fTransparency, r._bVisible, r._bModifiable, r._mapExtraGeometries);
+        return boost::python::make_tuple(r._t, boost::make_tuple(r._vGeomData, r._vGeomData2, r._vGeomData3), r._vDiffuseColor, r._vAmbientColor, r._meshcollision, r._type, r._filenamerender, r._filenamecollision, r._vRenderScale, r._vCollisionScale, r._fTransparency, r._bVisible, r._bModifiable, r._mapExtraGeometries, boost::python::make_tuple(r._fOctreeResolution, r._vOctreePoints));
     }
     static void setstate(PyGeometryInfo& r, boost::python::tuple state) {
         int num = len(state);
@@ -2641,6 +2774,10 @@ public:
         r._bVisible = boost::python::extract<bool>(state[11]);
         r._bModifiable = boost::python::extract<bool>(state[12]);
         r._mapExtraGeometries = dict(state[13]);
+        if( num > 14 ) {
+            r._fOctreeResolution = boost::python::extract<dReal>(state[14][0]);
+            r._vOctreePoints = state[14][1];
+        }
     }
 };
 
@@ -2745,6 +2882,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetMimicEquation_overloads, GetMimicEquat
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetMimicDOFIndices_overloads, GetMimicDOFIndices, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetChain_overloads, GetChain, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetConfigurationSpecification_overloads, GetConfigurationSpecification, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(UpdateOctree_overloads, UpdateOctree, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetConfigurationSpecificationIndices_overloads, GetConfigurationSpecificationIndices, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetAxis_overloads, GetAxis, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetWrapOffset_overloads, GetWrapOffset, 0, 1)
@@ -2756,6 +2894,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetInstantaneousTorqueLimits_overloads, G
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetNominalTorqueLimits_overloads, GetNominalTorqueLimits, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetMaxInertia_overloads, GetMaxInertia, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetLinkTransformations_overloads, GetLinkTransformations, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeLinkTransformations_overloads, ComputeLinkTransformations, 1, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetLinkTransformations_overloads, SetLinkTransformations, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetDOFLimits_overloads, SetDOFLimits, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SubtractDOFValues_overloads, SubtractDOFValues, 2, 3)
@@ -2798,6 +2937,7 @@ void init_openravepy_kinbody()
                           .value("Cylinder",GT_Cylinder)
                           .value("Trimesh",GT_TriMesh)
                           .value("Container",GT_Container)
+                          .value("Octree",GT_Octree)
     ;
     object electricmotoractuatorinfo = class_<PyElectricMotorActuatorInfo, boost::shared_ptr<PyElectricMotorActuatorInfo> >("ElectricMotorActuatorInfo", DOXY_CLASS(KinBody::ElectricMotorActuatorInfo))
                                        .def_readwrite("model_type",&PyElectricMotorActuatorInfo::model_type)
@@ -2907,6 +3047,7 @@ void init_openravepy_kinbody()
                         .def("GetTransformPose",&PyKinBody::GetTransformPose, DOXY_FN(KinBody,GetTransform))
                         .def("GetLinkTransformations",&PyKinBody::GetLinkTransformations, GetLinkTransformations_overloads(args("returndoflastvlaues"), DOXY_FN(KinBody,GetLinkTransformations)))
                         .def("GetBodyTransformations",&PyKinBody::GetLinkTransformations, DOXY_FN(KinBody,GetLinkTransformations))
+                        .def("ComputeLinkTransformations",&PyKinBody::ComputeLinkTransformations,ComputeLinkTransformations_overloads(args("dofvalues","dofindices","linkindex","localposition"), "Computes the link poses of a batch of configurations without modifying the body.\n\n:param dofvalues: numconfigs x dofstride array of dof values\n\n:param dofindices: the dof indices of the values, all dofs if None\n\n:param linkindex: if >= 0, also computes the jacobians of this link\n\n:param localposition: the position in the link coordinate system of the translation jacobian\n\n:return: numconfigs x numlinks x 7 poses, and if linkindex >= 0, a numconfigs x 6 x dofstride array of the translation jacobian followed by the axis-angle jacobian\n\n")
                         .def("SetLinkTransformations",&PyKinBody::SetLinkTransformations,SetLinkTransformations_overloads(args("transforms","doflastsetvalues"), DOXY_FN(KinBody,SetLinkTransformations)))
                         .def("SetBodyTransformations",&PyKinBody::SetLinkTransformations,args("transforms"), DOXY_FN(KinBody,SetLinkTransformations))
                         .def("SetLinkVelocities",&PyKinBody::SetLinkVelocities,args("velocities"), DOXY_FN(KinBody,SetLinkVelocities))
@@ -2946,6 +3087,7 @@ void init_openravepy_kinbody()
                         .def("ComputeHessianTranslation",&PyKinBody::ComputeHessianTranslation,ComputeHessianTranslation_overloads(args("linkindex","position","indices"), DOXY_FN(KinBody,ComputeHessianTranslation)))
                         .def("ComputeHessianAxisAngle",&PyKinBody::ComputeHessianAxisAngle,ComputeHessianAxisAngle_overloads(args("linkindex","indices"), DOXY_FN(KinBody,ComputeHessianAxisAngle)))
                         .def("ComputeInverseDynamics",&PyKinBody::ComputeInverseDynamics, ComputeInverseDynamics_overloads(args("dofaccelerations","externalforcetorque","returncomponents"), sComputeInverseDynamicsDoc.c_str()))
+                        .def("ComputeInverseDynamicsOfStates",&PyKinBody::ComputeInverseDynamicsOfStates, args("dofvalues","dofvelocities","dofaccelerations"), "Computes the torques of a batch of states without modifying the body.\n\n:param dofvalues: numstates x N array of dof values\n\n:param dofvelocities: numstates x N array of dof velocities\n\n:param dofaccelerations: numstates x N array of dof accelerations\n\n:return: numstates x N array of torques\n\n")
                         .def("SetSelfCollisionChecker",&PyKinBody::SetSelfCollisionChecker,args("collisionchecker"), DOXY_FN(KinBody,SetSelfCollisionChecker))
                         .def("GetSelfCollisionChecker",&PyKinBody::GetSelfCollisionChecker,args("collisionchecker"), DOXY_FN(KinBody,GetSelfCollisionChecker))
                         .def("CheckSelfCollision",&PyKinBody::CheckSelfCollision, CheckSelfCollision_overloads(args("report","collisionchecker"), DOXY_FN(KinBody,CheckSelfCollision)))
@@ -3035,6 +3177,8 @@ void init_openravepy_kinbody()
                               .def_readwrite("_bVisible",&PyGeometryInfo::_bVisible)
                               .def_readwrite("_bModifiable",&PyGeometryInfo::_bModifiable)
                               .def_readwrite("_mapExtraGeometries",&PyGeometryInfo::_mapExtraGeometries)
+                              .def_readwrite("_fOctreeResolution",&PyGeometryInfo::_fOctreeResolution)
+                              .def_readwrite("_vOctreePoints",&PyGeometryInfo::_vOctreePoints)
                               .def_pickle(GeometryInfo_pickle_suite())
         ;
         object linkinfo = class_<PyLinkInfo, boost::shared_ptr<PyLinkInfo> >("LinkInfo", DOXY_CLASS(KinBody::LinkInfo))
@@ -3087,6 +3231,7 @@ void init_openravepy_kinbody()
                          .def("Enable",&PyLink::Enable,args("enable"), DOXY_FN(KinBody::Link,Enable))
                          .def("IsEnabled",&PyLink::IsEnabled, DOXY_FN(KinBody::Link,IsEnabled))
                          .def("IsStatic",&PyLink::IsStatic, DOXY_FN(KinBody::Link,IsStatic))
+                         .def("GetUpdateStamp",&PyLink::GetUpdateStamp, DOXY_FN(KinBody::Link,GetUpdateStamp))
                          .def("SetVisible",&PyLink::SetVisible,args("visible"), DOXY_FN(KinBody::Link,SetVisible))
                          .def("IsVisible",&PyLink::IsVisible, DOXY_FN(KinBody::Link,IsVisible))
                          .def("GetParent",&PyLink::GetParent, DOXY_FN(KinBody::Link,GetParent))
@@ -3168,6 +3313,10 @@ void init_openravepy_kinbody()
                                  .def("GetContainerOuterExtents",&PyLink::PyGeometry::GetContainerOuterExtents, DOXY_FN(KinBody::Link::Geometry,GetContainerOuterExtents))
                                  .def("GetContainerInnerExtents",&PyLink::PyGeometry::GetContainerInnerExtents, DOXY_FN(KinBody::Link::Geometry,GetContainerInnerExtents))
                                  .def("GetContainerBottomCross",&PyLink::PyGeometry::GetContainerBottomCross, DOXY_FN(KinBody::Link::Geometry,GetContainerBottomCross))
+                                 .def("GetOctreeResolution",&PyLink::PyGeometry::GetOctreeResolution, DOXY_FN(OctreeOccupancy,GetResolution))
+                                 .def("GetOctreePoints",&PyLink::PyGeometry::GetOctreePoints, DOXY_FN(OctreeOccupancy,GetOccupiedCenters))
+                                 .def("UpdateOctree",&PyLink::PyGeometry::UpdateOctree, UpdateOctree_overloads(args("points","occupied"), DOXY_FN(KinBody::Link::Geometry,UpdateOctree)))
+                                 .def("ClearOctree",&PyLink::PyGeometry::ClearOctree, DOXY_FN(KinBody::Link::Geometry,ClearOctree))
                                  .def("GetRenderScale",&PyLink::PyGeometry::GetRenderScale, DOXY_FN(KinBody::Link::Geometry,GetRenderScale))
                                  .def("GetRenderFilename",&PyLink::PyGeometry::GetRenderFilename, DOXY_FN(KinBody::Link::Geometry,GetRenderFilename))
                                  .def("GetTransparency",&PyLink::PyGeometry::GetTransparency,DOXY_FN(KinBody::Link::Geometry,GetTransparency))
@@ -141,6 +141,7 @@ public:
     object GetTransformPose() const;
     object GetLinkTransformations(bool returndoflastvlaues=false) const;
     void SetLinkTransformations(object transforms, object odoflastvalues=object());
+    object ComputeLinkTransformations(object odofvalues, object oindices=object(), int linkindex=-1, object olocalposition=object()) const;
     void SetLinkVelocities(object ovelocities);
     object GetLinkEnableStates() const;
     void SetLinkEnableStates(object oenablestates);
@@ -180,6 +181,7 @@ public:
     object ComputeHessianTranslation(int index, object oposition, object oindices=object());
     object ComputeHessianAxisAngle(int index, object oindices=object());
     object ComputeInverseDynamics(object odofaccelerations, object oexternalforcetorque=object(), bool returncomponents=false);
+    object ComputeInverseDynamicsOfStates(object odofvalues, object odofvelocities, object odofaccelerations) const;
     void SetSelfCollisionChecker(PyCollisionCheckerBasePtr pycollisionchecker);
     PyInterfaceBasePtr GetSelfCollisionChecker();
     bool CheckSelfCollision(PyCollisionReportPtr pReport=PyCollisionReportPtr(), PyCollisionCheckerBasePtr pycollisionchecker=PyCollisionCheckerBasePtr());
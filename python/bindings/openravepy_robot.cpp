@@ -230,10 +230,12 @@ public:
 
         bool _FindIKSolution(const IkParameterization& ikparam, std::vector<dReal>& solution, int filteroptions, bool releasegil) const
         {
+            // release the GIL before locking, otherwise another python thread holding the environment lock and waiting for the GIL deadlocks
             openravepy::PythonThreadSaverPtr statesaver;
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolution(ikparam,solution,filteroptions);
 
         }
@@ -243,6 +245,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolution(ikparam,vFreeParameters, solution,filteroptions);
         }
         bool _FindIKSolution(const IkParameterization& ikparam, int filteroptions, IkReturn& ikreturn, bool releasegil) const
@@ -251,6 +254,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolution(ikparam,filteroptions,IkReturnPtr(&ikreturn,utils::null_deleter()));
         }
         bool _FindIKSolution(const IkParameterization& ikparam, const std::vector<dReal>& vFreeParameters, int filteroptions, IkReturn& ikreturn, bool releasegil) const
@@ -259,6 +263,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolution(ikparam,vFreeParameters, filteroptions,IkReturnPtr(&ikreturn,utils::null_deleter()));
         }
 
@@ -268,6 +273,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolutions(ikparam,solutions,filteroptions);
         }
         bool _FindIKSolutions(const IkParameterization& ikparam, const std::vector<dReal>& vFreeParameters, std::vector<std::vector<dReal> >& solutions, int filteroptions, bool releasegil) const
@@ -276,6 +282,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolutions(ikparam,vFreeParameters,solutions,filteroptions);
         }
         bool _FindIKSolutions(const IkParameterization& ikparam, int filteroptions, std::vector<IkReturnPtr>& vikreturns, bool releasegil) const
@@ -284,6 +291,7 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolutions(ikparam,filteroptions,vikreturns);
         }
         bool _FindIKSolutions(const IkParameterization& ikparam, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& vikreturns, bool releasegil) const
@@ -292,13 +300,13 @@ public:
             if( releasegil ) {
                 statesaver.reset(new openravepy::PythonThreadSaver());
             }
+            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             return _pmanip->FindIKSolutions(ikparam,vFreeParameters,filteroptions,vikreturns);
         }
 
-        object FindIKSolution(object oparam, int filteroptions, bool ikreturn=false, bool releasegil=false) const
+        object FindIKSolution(object oparam, int filteroptions, bool ikreturn=false, bool releasegil=true) const
         {
             IkParameterization ikparam;
-            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             if( ExtractIkParameterization(oparam,ikparam) ) {
                 if( ikreturn ) {
                     IkReturn ikreturn(IKRA_Reject);
@@ -330,11 +338,10 @@ public:
             }
         }
 
-        object FindIKSolution(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=false) const
+        object FindIKSolution(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=true) const
         {
             vector<dReal> vfreeparams = ExtractArray<dReal>(freeparams);
             IkParameterization ikparam;
-            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             if( ExtractIkParameterization(oparam,ikparam) ) {
                 if( ikreturn ) {
                     IkReturn ikreturn(IKRA_Reject);
@@ -366,10 +373,9 @@ public:
             }
         }
 
-        object FindIKSolutions(object oparam, int filteroptions, bool ikreturn=false, bool releasegil=false) const
+        object FindIKSolutions(object oparam, int filteroptions, bool ikreturn=false, bool releasegil=true) const
         {
             IkParameterization ikparam;
-            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             if( ikreturn ) {
                 std::vector<IkReturnPtr> vikreturns;
                 if( ExtractIkParameterization(oparam,ikparam) ) {
@@ -412,11 +418,10 @@ public:
             }
         }
 
-        object FindIKSolutions(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=false) const
+        object FindIKSolutions(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=true) const
         {
             vector<dReal> vfreeparams = ExtractArray<dReal>(freeparams);
             IkParameterization ikparam;
-            EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
             if( ikreturn ) {
                 std::vector<IkReturnPtr> vikreturns;
                 if( ExtractIkParameterization(oparam,ikparam) ) {
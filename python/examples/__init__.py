@@ -39,6 +39,7 @@ import dualarmdemo_schunk
 import fastgrasping
 import fastgraspingthreaded
 import graspplanning
+import graspthreadedscaling
 import hanoi
 import inversekinematicspick
 import movehandstraight
@@ -58,6 +59,7 @@ import simplenavigation
 import testphysics
 import testphysics_controller
 import testphysics_diffdrive
+import threadedplanning
 import testupdatingbodies
 import testviewercallback
 import visibilityplanning
@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# Copyright (C) 2014 Rosen Diankov (rosen.diankov@gmail.com)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Measures how the grasp set generation of the grasper module scales with the number of threads.
+
+.. examplepre-block:: graspthreadedscaling
+
+Description
+-----------
+
+The same set of grasps is evaluated with GraspThreaded using 1, 2, 4, ... threads up to **--maxthreads**:
+
+.. code-block:: python
+
+  nextid, grasps = grasper.GraspThreaded(approachrays=approachrays, rolls=rolls, standoffs=standoffs, preshapes=preshapes, manipulatordirections=manipulatordirections, target=target, numthreads=numthreads, poolenvironments=True)
+
+The threads take chunks of consecutive grasps from a shared counter and store their successful grasps in their own lists, which are merged and sorted when all threads are done, so the returned grasps do not depend on the number of threads. With **poolenvironments=True** the module keeps the cloned environments of the threads and only re-synchronizes them in the next call, the first call for every thread count warms up the pool and is not timed.
+
+.. examplepost-block:: graspthreadedscaling
+"""
+from __future__ import with_statement # for python 2.5
+__author__ = 'Rosen Diankov'
+
+import time
+import openravepy
+if not __openravepy_build_doc__:
+    from openravepy import *
+    from numpy import *
+
+def main(env,options):
+    "Main example code."
+    robot = env.ReadRobotXMLFile(options.robot)
+    env.Add(robot)
+    target = env.ReadKinBodyXMLFile(options.target)
+    env.Add(target)
+    manip = robot.GetActiveManipulator()
+    gmodel = databases.grasping.GraspingModel(robot,target)
+    grasper = interfaces.Grasper(robot,friction=0.4)
+    with env:
+        approachrays = gmodel.computeBoxApproachRays(delta=options.boxdelta,normalanglerange=0)
+        approachrays[:,3:6] = -approachrays[:,3:6]
+        preshapes = array([robot.GetDOFValues(manip.GetGripperIndices())])
+        rolls = arange(0,2*pi,pi/2)
+        standoffs = array([0,0.025])
+        manipulatordirections = array([manip.GetLocalToolDirection()])
+        robot.SetTransform(eye(4))
+        robot.SetActiveDOFs(manip.GetGripperIndices(),DOFAffine.X+DOFAffine.Y+DOFAffine.Z)
+    numgrasps = len(approachrays)*len(rolls)*len(standoffs)
+    print('evaluating %d grasps'%numgrasps)
+    numthreads = 1
+    while numthreads <= options.maxthreads:
+        kwargs = dict(approachrays=approachrays, rolls=rolls, standoffs=standoffs, preshapes=preshapes, manipulatordirections=manipulatordirections, target=target, forceclosurethreshold=1e-9, numthreads=numthreads, poolenvironments=True)
+        grasper.GraspThreaded(maxgrasps=1,**kwargs) # creates the pooled environments
+        starttime = time.time()
+        nextid, grasps = grasper.GraspThreaded(**kwargs)
+        elapsedtime = time.time()-starttime
+        print('%d threads: %d/%d grasps succeeded in %fs, %f grasps/s'%(numthreads,len(grasps),numgrasps,elapsedtime,numgrasps/elapsedtime))
+        numthreads *= 2
+
+from optparse import OptionParser
+from openravepy.misc import OpenRAVEGlobalArguments
+
+@openravepy.with_destroy
+def run(args=None):
+    """Command-line execution of the example.
+
+    :param args: arguments for script to parse, if not specified will use sys.argv
+    """
+    parser = OptionParser(description='Measures the grasp planning throughput of GraspThreaded for an increasing number of threads.')
+    OpenRAVEGlobalArguments.addOptions(parser)
+    parser.add_option('--robot',action="store",type='string',dest='robot',default='robots/barretthand.robot.xml',
+                      help='Robot hand to grasp with (default=%default)')
+    parser.add_option('--target',action="store",type='string',dest='target',default='data/mug1.kinbody.xml',
+                      help='Target body to grasp (default=%default)')
+    parser.add_option('--boxdelta',action="store",type='float',dest='boxdelta',default=0.01,
+                      help='Step size of the approach rays sampled on the bounding box of the target (default=%default)')
+    parser.add_option('--maxthreads',action="store",type='int',dest='maxthreads',default=32,
+                      help='Maximum number of threads to measure (default=%default)')
+    (options, leftargs) = parser.parse_args(args=args)
+    OpenRAVEGlobalArguments.parseAndCreateThreadedUser(options,main,defaultviewer=False)
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,137 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# Copyright (C) 2014 Rosen Diankov (rosen.diankov@gmail.com)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Runs IK, planning, and retiming from several python threads and measures the throughput with and without releasing the python GIL.
+
+.. examplepre-block:: threadedplanning
+
+Description
+-----------
+
+Every python thread owns a clone of the environment and repeatedly solves IK for a random reachable pose, plans to the solution with BiRRT, and retimes the result:
+
+.. code-block:: python
+
+  solutions = manip.FindIKSolutions(Tgoal,IkFilterOptions.CheckEnvCollisions,releasegil=releasegil)
+  planner.InitPlan(robot,params)
+  planner.PlanPath(traj,releasegil=releasegil)
+  planningutils.RetimeActiveDOFTrajectory(traj,robot,releasegil=releasegil)
+
+All long-running openravepy calls release the GIL by default, so the threads run the C++ code concurrently and the throughput scales with the number of cores. Passing **releasegil=False** keeps the GIL held during the call, which serializes the threads and serves as the baseline.
+
+.. examplepost-block:: threadedplanning
+"""
+from __future__ import with_statement # for python 2.5
+__author__ = 'Rosen Diankov'
+
+import time, threading
+import openravepy
+if not __openravepy_build_doc__:
+    from openravepy import *
+    from numpy import *
+
+def PlanningWorker(env,manipname,releasegil,duration,stats,randomseed):
+    "Plans to random IK solutions in env until duration seconds have passed, stores the number of successful plans in stats."
+    robot = env.GetRobots()[0]
+    manip = robot.SetActiveManipulator(manipname)
+    robot.SetActiveDOFs(manip.GetArmIndices())
+    planner = RaveCreatePlanner(env,'birrt')
+    traj = RaveCreateTrajectory(env,'')
+    rng = random.RandomState(randomseed)
+    numplans = 0
+    starttime = time.time()
+    while time.time()-starttime < duration:
+        with env:
+            lower,upper = robot.GetActiveDOFLimits()
+            initvalues = robot.GetActiveDOFValues()
+            robot.SetActiveDOFValues(lower+rng.rand(len(lower))*(upper-lower))
+            Tgoal = manip.GetTransform()
+            robot.SetActiveDOFValues(initvalues)
+        solutions = manip.FindIKSolutions(Tgoal,IkFilterOptions.CheckEnvCollisions,releasegil=releasegil)
+        if solutions is None or len(solutions) == 0:
+            continue
+        with env:
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            params.SetGoalConfig(solutions[0])
+            params.SetExtraParameters('<_nmaxiterations>2000</_nmaxiterations>')
+            if not planner.InitPlan(robot,params):
+                continue
+        if planner.PlanPath(traj,releasegil=releasegil) != PlannerStatus.HasSolution:
+            continue
+        planningutils.RetimeActiveDOFTrajectory(traj,robot,releasegil=releasegil)
+        with env:
+            robot.SetActiveDOFValues(solutions[0])
+        numplans += 1
+    stats.append(numplans)
+
+def RunThreads(envs,manipname,releasegil,duration):
+    stats = []
+    threads = [threading.Thread(target=PlanningWorker,args=(env,manipname,releasegil,duration,stats,i)) for i,env in enumerate(envs)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return sum(stats)/duration
+
+def main(env,options):
+    "Main example code."
+    env.Load(options.scene)
+    robot = env.GetRobots()[0]
+    if options.manipname is not None:
+        robot.SetActiveManipulator(options.manipname)
+    manip = robot.GetActiveManipulator()
+    ikmodel = databases.inversekinematics.InverseKinematicsModel(robot, iktype=IkParameterization.Type.Transform6D)
+    if not ikmodel.load():
+        ikmodel.autogenerate()
+    envs = []
+    for i in range(options.numthreads):
+        clonedenv = env.CloneSelf(CloningOptions.Bodies)
+        clonedenv.StopSimulation()
+        clonedrobot = clonedenv.GetRobot(robot.GetName())
+        clonedrobot.SetActiveManipulator(manip.GetName())
+        databases.inversekinematics.InverseKinematicsModel(clonedrobot, iktype=IkParameterization.Type.Transform6D).load()
+        envs.append(clonedenv)
+    try:
+        for releasegil in [False,True]:
+            rate = RunThreads(envs,manip.GetName(),releasegil,options.duration)
+            print('releasegil=%d: %d threads computed %f plans/s'%(releasegil,options.numthreads,rate))
+    finally:
+        for clonedenv in envs:
+            clonedenv.Destroy()
+
+from optparse import OptionParser
+from openravepy.misc import OpenRAVEGlobalArguments
+
+@openravepy.with_destroy
+def run(args=None):
+    """Command-line execution of the example.
+
+    :param args: arguments for script to parse, if not specified will use sys.argv
+    """
+    parser = OptionParser(description='Measures planning throughput of several python threads with and without releasing the GIL.')
+    OpenRAVEGlobalArguments.addOptions(parser)
+    parser.add_option('--scene',action="store",type='string',dest='scene',default='data/lab1.env.xml',
+                      help='Scene file to load (default=%default)')
+    parser.add_option('--manipname',action="store",type='string',dest='manipname',default=None,
+                      help='name of manipulator to use (default=%default)')
+    parser.add_option('--numthreads',action="store",type='int',dest='numthreads',default=4,
+                      help='number of python threads to plan from (default=%default)')
+    parser.add_option('--duration',action="store",type='float',dest='duration',default=10.0,
+                      help='seconds to run each configuration for (default=%default)')
+    (options, leftargs) = parser.parse_args(args=args)
+    OpenRAVEGlobalArguments.parseAndCreateThreadedUser(options,main,defaultviewer=False)
+
+if __name__ == "__main__":
+    run()
@@ -111,8 +111,11 @@ class Grasper:
         contacts = reshape(array([float64(s) for s in resvalues],float64),(len(resvalues)/6,6))
         return contacts,finalconfig,mindist,volume
 
-    def GraspThreaded(self,approachrays,standoffs,preshapes,rolls,manipulatordirections=None,target=None,transformrobot=True,onlycontacttarget=True,tightgrasp=False,graspingnoise=None,forceclosurethreshold=None,collisionchecker=None,translationstepmult=None,numthreads=None,startindex=None,maxgrasps=None,finestep=None):
+    def GraspThreaded(self,approachrays,standoffs,preshapes,rolls,manipulatordirections=None,target=None,transformrobot=True,onlycontacttarget=True,tightgrasp=False,graspingnoise=None,forceclosurethreshold=None,collisionchecker=None,translationstepmult=None,numthreads=None,startindex=None,maxgrasps=None,finestep=None,chunksize=None,poolenvironments=None):
         """See :ref:`module-grasper-graspthreaded`
+
+        :param chunksize: number of consecutive grasps a thread takes from the queue at once, by default chosen from the number of grasps and threads
+        :param poolenvironments: if True, the cloned environments of the threads are kept by the module and reused in the next call
         """
         cmd = 'GraspThreaded '
         if target is not None:
@@ -134,6 +137,10 @@ class Grasper:
             cmd += 'finestep %.15e '%finestep
         if numthreads is not None:
             cmd += 'numthreads %d '%numthreads
+        if chunksize is not None:
+            cmd += 'chunksize %d '%chunksize
+        if poolenvironments is not None:
+            cmd += 'poolenvironments %d '%poolenvironments
         cmd += 'approachrays %d '%len(approachrays)
         for f in approachrays.flat:
             cmd += str(f) + ' '
@@ -206,8 +206,10 @@ class VisualFeedback:
         if res is None:
             raise PlanningError()
         return res
-    def SetParameter(self,raydensity=None,raymindist=None,allowableocclusion=None):
+    def SetParameter(self,raydensity=None,raymindist=None,allowableocclusion=None,raycachesize=None):
         """See :ref:`module-visualfeedback-setparameter`
+
+        :param raycachesize: maximum number of camera poses the sampled occlusion rays of the target are cached for, 0 disables the cache
         """
         cmd = 'SetParameter '
         if raydensity is not None:
@@ -216,4 +218,6 @@ class VisualFeedback:
             cmd += 'raymindist %.15e '%raymindist
         if allowableocclusion is not None:
             cmd += 'allowableocclusion %.15e '%allowableocclusion
+        if raycachesize is not None:
+            cmd += 'raycachesize %d '%raycachesize
         return self.prob.SendCommand(cmd)
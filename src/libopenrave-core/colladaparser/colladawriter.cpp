@@ -1715,6 +1715,7 @@ private:
             }
             case GT_None:
             case GT_TriMesh:
+            case GT_Octree: // written as the triangulated collision mesh
                 // don't add anything
                 break;
             }
@@ -118,6 +118,8 @@ public:
 
         _nBodiesModifiedStamp = 0;
         _nEnvironmentIndex = 1;
+        _nPublishedVersion = 0;
+        _nPublishedMinDeltaVersion = 0;
 
         _fDeltaSimTime = 0.01f;
         _nCurSimTime = 0;
@@ -259,6 +261,12 @@ public:
             if( !!_pCurrentChecker ) {
                 _pCurrentChecker->DestroyEnvironment();
             }
+            FOREACH(itworker, _vConfigurationCheckWorkers) {
+                if( !!(*itworker)->penv ) {
+                    (*itworker)->penv->Destroy();
+                }
+            }
+            _vConfigurationCheckWorkers.clear();
 
             // clear internal interface lists
             {
@@ -275,7 +283,7 @@ public:
                     (*itrobot)->Destroy();
                 }
                 _vecrobots.clear();
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
                 _nBodiesModifiedStamp++;
                 FOREACH(itsensor,_listSensors) {
                     (*itsensor)->Configure(SensorBase::CC_PowerOff);
@@ -319,6 +327,7 @@ public:
 
             FOREACH(itbody,_vecbodies) {
                 (*itbody)->_environmentid=0;
+                (*itbody)->_pchangejournal.reset();
                 (*itbody)->Destroy();
             }
             if( _listRegisteredBodyCallbacks.size() > 0 ) {
@@ -327,13 +336,14 @@ public:
             _vecbodies.clear();
             FOREACH(itrobot,_vecrobots) {
                 (*itrobot)->_environmentid=0;
+                (*itrobot)->_pchangejournal.reset();
                 (*itrobot)->Destroy();
             }
             if( _listRegisteredBodyCallbacks.size() > 0 ) {
                 vcallbackbodies.insert(vcallbackbodies.end(), _vecrobots.begin(), _vecrobots.end());
             }
             _vecrobots.clear();
-            _vPublishedBodies.clear();
+            _ClearPublishedBodies();
             _nBodiesModifiedStamp++;
 
             _mapBodies.clear();
@@ -869,6 +879,7 @@ public:
 
     virtual bool CheckCollision(KinBodyConstPtr pbody1, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(body)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(pbody1);
         return _pCurrentChecker->CheckCollision(pbody1,report);
@@ -876,6 +887,7 @@ public:
 
     virtual bool CheckCollision(KinBodyConstPtr pbody1, KinBodyConstPtr pbody2, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(body,body)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(pbody1);
         CHECK_COLLISION_BODY(pbody2);
@@ -884,6 +896,7 @@ public:
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, CollisionReportPtr report )
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(link)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(plink->GetParent());
         return _pCurrentChecker->CheckCollision(plink,report);
@@ -891,6 +904,7 @@ public:
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink1, KinBody::LinkConstPtr plink2, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(link,link)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(plink1->GetParent());
         CHECK_COLLISION_BODY(plink2->GetParent());
@@ -899,6 +913,7 @@ public:
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, KinBodyConstPtr pbody, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(link,body)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(plink->GetParent());
         CHECK_COLLISION_BODY(pbody);
@@ -907,6 +922,7 @@ public:
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(link,excluded)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(plink->GetParent());
         return _pCurrentChecker->CheckCollision(plink,vbodyexcluded,vlinkexcluded,report);
@@ -914,6 +930,7 @@ public:
 
     virtual bool CheckCollision(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(body,excluded)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(pbody);
         return _pCurrentChecker->CheckCollision(pbody,vbodyexcluded,vlinkexcluded,report);
@@ -921,28 +938,93 @@ public:
 
     virtual bool CheckCollision(const RAY& ray, KinBody::LinkConstPtr plink, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(ray,link)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(plink->GetParent());
         return _pCurrentChecker->CheckCollision(ray,plink,report);
     }
     virtual bool CheckCollision(const RAY& ray, KinBodyConstPtr pbody, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(ray,body)");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(pbody);
         return _pCurrentChecker->CheckCollision(ray,pbody,report);
     }
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckCollision(ray)");
         return _pCurrentChecker->CheckCollision(ray,report);
     }
 
     virtual bool CheckStandaloneSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report)
     {
+        OPENRAVE_PROFILE_SCOPE("CheckStandaloneSelfCollision");
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
         CHECK_COLLISION_BODY(pbody);
         return _pCurrentChecker->CheckStandaloneSelfCollision(pbody,report);
     }
 
+    virtual void CheckConfigurations(KinBodyConstPtr pbody, const std::vector<int>& dofindices, const std::vector<dReal>& vconfigs, std::vector<uint8_t>& vresults, int checkoptions, int numthreads)
+    {
+        OPENRAVE_PROFILE_SCOPE("CheckConfigurations");
+        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        CHECK_COLLISION_BODY(pbody);
+        int dofstride = dofindices.size() > 0 ? (int)dofindices.size() : pbody->GetDOF();
+        vresults.resize(0);
+        if( dofstride == 0 ) {
+            return;
+        }
+        if( (vconfigs.size() % dofstride) != 0 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("configuration array size %d is not a multiple of the dof stride %d"), vconfigs.size()%dofstride, ORE_InvalidArguments);
+        }
+        FOREACHC(itindex, dofindices) {
+            OPENRAVE_ASSERT_FORMAT(*itindex >= 0 && *itindex < pbody->GetDOF(), "body %s dof index %d is out of range", pbody->GetName()%*itindex, ORE_InvalidArguments);
+        }
+        int numconfigs = (int)vconfigs.size()/dofstride;
+        vresults.resize(numconfigs, 0);
+        if( numconfigs == 0 ) {
+            return;
+        }
+
+        if( numthreads <= 0 ) {
+            numthreads = max(1, (int)boost::thread::hardware_concurrency());
+        }
+        // every thread has to check enough configurations to amortize starting it and synchronizing its environment
+        const int nMinConfigurationsPerThread = 16;
+        numthreads = min(numthreads, (numconfigs+nMinConfigurationsPerThread-1)/nMinConfigurationsPerThread);
+
+        while( (int)_vConfigurationCheckWorkers.size() < numthreads ) {
+            _vConfigurationCheckWorkers.push_back(boost::shared_ptr<ConfigurationCheckWorker>(new ConfigurationCheckWorker()));
+        }
+        std::vector<KinBodyPtr> vbodies(numthreads);
+        vbodies[0] = boost::const_pointer_cast<KinBody>(pbody);
+        for(int ithread = 1; ithread < numthreads; ++ithread) {
+            ConfigurationCheckWorker& worker = *_vConfigurationCheckWorkers[ithread];
+            _SynchronizeConfigurationCheckWorker(worker);
+            vbodies[ithread] = worker.penv->GetKinBody(pbody->GetName());
+            OPENRAVE_ASSERT_FORMAT(!!vbodies[ithread], "failed to find body %s in cloned environment", pbody->GetName(), ORE_Assert);
+        }
+
+        // spread the remainder over the first threads
+        std::vector<int> vstartindices(numthreads+1, 0);
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            vstartindices[ithread+1] = vstartindices[ithread] + numconfigs/numthreads + (ithread < numconfigs%numthreads ? 1 : 0);
+        }
+        std::vector< boost::shared_ptr<boost::thread> > vthreads;
+        for(int ithread = 1; ithread < numthreads; ++ithread) {
+            vthreads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&Environment::_CheckConfigurationsThread, this, boost::ref(*_vConfigurationCheckWorkers[ithread]), vbodies[ithread], boost::cref(dofindices), boost::cref(vconfigs), vstartindices[ithread], vstartindices[ithread+1], boost::ref(vresults), checkoptions))));
+        }
+        _CheckConfigurationsThread(*_vConfigurationCheckWorkers[0], vbodies[0], dofindices, vconfigs, vstartindices[0], vstartindices[1], vresults, checkoptions);
+        FOREACH(itthread, vthreads) {
+            (*itthread)->join();
+        }
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            if( _vConfigurationCheckWorkers[ithread]->error.size() > 0 ) {
+                throw OPENRAVE_EXCEPTION_FORMAT(_("failed to check configurations of body %s: %s"), pbody->GetName()%_vConfigurationCheckWorkers[ithread]->error, ORE_Failed);
+            }
+        }
+    }
+
     virtual void StepSimulation(dReal fTimeStep)
     {
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
@@ -1820,67 +1902,179 @@ public:
     {
         if( timeout == 0 ) {
             boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
-            vbodies = _vPublishedBodies;
+            _CopyPublishedBodies(vbodies, 0);
         }
         else {
             boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
-            vbodies = _vPublishedBodies;
+            _CopyPublishedBodies(vbodies, 0);
         }
     }
 
-    virtual void UpdatePublishedBodies(uint64_t timeout=0)
+    virtual bool GetPublishedBodiesChanged(std::vector<KinBody::BodyState>& vbodies, std::vector<int>& vremovedbodyids, uint64_t& publishedversion, uint64_t timeout)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
         if( timeout == 0 ) {
             boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
-            _UpdatePublishedBodies();
+            return _GetPublishedBodiesChanged(vbodies, vremovedbodyids, publishedversion);
         }
         else {
             boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
-            _UpdatePublishedBodies();
+            return _GetPublishedBodiesChanged(vbodies, vremovedbodyids, publishedversion);
         }
     }
 
-    virtual void _UpdatePublishedBodies()
+    virtual void UpdatePublishedBodies(uint64_t timeout=0)
     {
-        // updated the published bodies, resize dynamically in case an exception occurs
-        // when creating an item and bad data is left inside _vPublishedBodies
-        _vPublishedBodies.resize(0);
-        if( _vPublishedBodies.capacity() < _vecbodies.size() ) {
-            _vPublishedBodies.reserve(_vecbodies.size());
+        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        // the back buffer is filled without blocking the readers. when nothing changed there is nothing to swap
+        if( !_UpdatePublishedBodies() ) {
+            return;
+        }
+        if( timeout == 0 ) {
+            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            _SwapPublishedBodies();
         }
+        else {
+            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            if (!lock.owns_lock()) {
+                throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
+            }
+            _SwapPublishedBodies();
+        }
+    }
 
+    /// \brief fills _vPublishedBodiesBack with the current state of all bodies, environment has to be locked.
+    ///
+    /// The front buffer is only modified while the environment is locked, so it can be read here without _mutexInterfaces.
+    /// States of bodies whose update stamp did not change are shared with the front buffer instead of captured again.
+    /// \return true if the published set changed and the buffers need to be swapped
+    virtual bool _UpdatePublishedBodies()
+    {
+        // resize dynamically in case an exception occurs when creating an item and bad data is left inside _vPublishedBodiesBack
+        _vPublishedBodiesBack.resize(0);
+        if( _vPublishedBodiesBack.capacity() < _vecbodies.size() ) {
+            _vPublishedBodiesBack.reserve(_vecbodies.size());
+        }
+        _vPublishedRemovedBodyIdsBack.resize(0);
+
+        // bodies keep their relative order in _vecbodies, so the previous states are matched by walking both lists.
+        // previous states that are skipped over belong to removed bodies
+        bool bchanged = false;
+        uint64_t newversion = _nPublishedVersion+1;
+        size_t iprev = 0;
         std::vector<dReal> vdoflastsetvalues;
         FOREACH(itbody, _vecbodies) {
-            _vPublishedBodies.push_back(KinBody::BodyState());
-            KinBody::BodyState& state = _vPublishedBodies.back();
-            state.pbody = *itbody;
-            (*itbody)->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
-            (*itbody)->GetDOFValues(state.jointvalues);
-            state.strname =(*itbody)->GetName();
-            state.uri = (*itbody)->GetURI();
-            state.updatestamp = (*itbody)->GetUpdateStamp();
-            state.environmentid = (*itbody)->GetEnvironmentId();
-            if( (*itbody)->IsRobot() ) {
+            const KinBody& body = **itbody;
+            PublishedBodyConstPtr pprev;
+            for(size_t iprevtest = iprev; iprevtest < _vPublishedBodies.size(); ++iprevtest) {
+                if( _vPublishedBodies[iprevtest]->state.pbody == *itbody ) {
+                    pprev = _vPublishedBodies[iprevtest];
+                    for(; iprev < iprevtest; ++iprev) {
+                        _vPublishedRemovedBodyIdsBack.push_back(_vPublishedBodies[iprev]->state.environmentid);
+                    }
+                    iprev = iprevtest+1;
+                    break;
+                }
+            }
+
+            std::string activemanipname;
+            RobotBase::ManipulatorPtr pmanip;
+            if( body.IsRobot() ) {
                 RobotBasePtr probot = RaveInterfaceCast<RobotBase>(*itbody);
                 if( !!probot ) {
-                    RobotBase::ManipulatorPtr pmanip = probot->GetActiveManipulator();
-                    if( !!pmanip ) {
-                        state.activeManipulatorName = pmanip->GetName();
-                        state.activeManipulatorTransform = pmanip->GetTransform();
-                    }
+                    pmanip = probot->GetActiveManipulator();
                 }
             }
-            _vPublishedBodies.push_back(state);
+            if( !!pprev && pprev->state.updatestamp == body.GetUpdateStamp() && pprev->state.environmentid == body.GetEnvironmentId() && pprev->state.strname == body.GetName() && (!pmanip ? pprev->state.activeManipulatorName.size() == 0 : pprev->state.activeManipulatorName == pmanip->GetName()) ) {
+                _vPublishedBodiesBack.push_back(pprev);
+                continue;
+            }
+
+            boost::shared_ptr<PublishedBody> ppublished(new PublishedBody());
+            ppublished->version = newversion;
+            KinBody::BodyState& state = ppublished->state;
+            state.pbody = *itbody;
+            body.GetLinkTransformations(state.vectrans, vdoflastsetvalues);
+            body.GetDOFValues(state.jointvalues);
+            state.strname = body.GetName();
+            state.uri = body.GetURI();
+            state.updatestamp = body.GetUpdateStamp();
+            state.environmentid = body.GetEnvironmentId();
+            if( !!pmanip ) {
+                state.activeManipulatorName = pmanip->GetName();
+                state.activeManipulatorTransform = pmanip->GetTransform();
+            }
+            _vPublishedBodiesBack.push_back(ppublished);
+            bchanged = true;
+        }
+        for(; iprev < _vPublishedBodies.size(); ++iprev) {
+            _vPublishedRemovedBodyIdsBack.push_back(_vPublishedBodies[iprev]->state.environmentid);
+        }
+        return bchanged || _vPublishedRemovedBodyIdsBack.size() > 0;
+    }
+
+    /// \brief publishes the back buffer, _mutexInterfaces has to be locked.
+    virtual void _SwapPublishedBodies()
+    {
+        ++_nPublishedVersion;
+        FOREACHC(itid, _vPublishedRemovedBodyIdsBack) {
+            _vPublishedRemovedBodies.push_back(std::make_pair(_nPublishedVersion, *itid));
+        }
+        if( _vPublishedRemovedBodies.size() > 4096 ) {
+            // forget the oldest half, clients older than that get the full set
+            size_t nremove = _vPublishedRemovedBodies.size()/2;
+            _nPublishedMinDeltaVersion = _vPublishedRemovedBodies.at(nremove-1).first;
+            _vPublishedRemovedBodies.erase(_vPublishedRemovedBodies.begin(), _vPublishedRemovedBodies.begin()+nremove);
+        }
+        _vPublishedBodies.swap(_vPublishedBodiesBack);
+        _vPublishedBodiesBack.resize(0);
+    }
+
+    /// \brief removes all published bodies, the environment and _mutexInterfaces have to be locked.
+    virtual void _ClearPublishedBodies()
+    {
+        _vPublishedBodies.resize(0);
+        _vPublishedBodiesBack.resize(0);
+        _vPublishedRemovedBodyIdsBack.resize(0);
+        _vPublishedRemovedBodies.resize(0);
+        ++_nPublishedVersion;
+        _nPublishedMinDeltaVersion = _nPublishedVersion;
+    }
+
+    /// \brief copies the published bodies captured after version, _mutexInterfaces has to be locked.
+    virtual void _CopyPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t version) const
+    {
+        vbodies.resize(0);
+        FOREACHC(itpublished, _vPublishedBodies) {
+            if( (*itpublished)->version > version ) {
+                vbodies.push_back((*itpublished)->state);
+            }
         }
     }
 
+    virtual bool _GetPublishedBodiesChanged(std::vector<KinBody::BodyState>& vbodies, std::vector<int>& vremovedbodyids, uint64_t& publishedversion) const
+    {
+        vremovedbodyids.resize(0);
+        if( publishedversion < _nPublishedMinDeltaVersion || publishedversion > _nPublishedVersion ) {
+            _CopyPublishedBodies(vbodies, 0);
+            publishedversion = _nPublishedVersion;
+            return false;
+        }
+        _CopyPublishedBodies(vbodies, publishedversion);
+        FOREACHC(itremoved, _vPublishedRemovedBodies) {
+            if( itremoved->first > publishedversion ) {
+                vremovedbodyids.push_back(itremoved->second);
+            }
+        }
+        publishedversion = _nPublishedVersion;
+        return true;
+    }
+
     virtual std::pair<std::string, dReal> GetUnit() const
     {
         return _unit;
@@ -1917,6 +2111,124 @@ protected:
         return OpenRAVEXMLParser::ParseXMLData(preader, pdata);
     }
 
+    /// \brief per-thread state of \ref CheckConfigurations, kept between calls so the buffers and cloned checkers are reused
+    struct ConfigurationCheckWorker
+    {
+        ConfigurationCheckWorker() : nJournalStamp(-1), nBodiesModifiedStamp(-1) {
+        }
+        EnvironmentBasePtr penv; ///< cloned environment the thread checks in, empty for the first worker which uses this environment
+        int nJournalStamp; ///< stamp of the change journal of this environment when penv was last synchronized
+        int nBodiesModifiedStamp; ///< _nBodiesModifiedStamp when penv was last synchronized
+        CollisionCheckerBaseWeakPtr pchecker; ///< collision checker of this environment when penv was last synchronized
+        std::vector<int> vchangedbodyids;
+        std::vector<Transform> vlinktransforms, vtransforms;
+        std::vector<dReal> vconfigs, vdofvalues, vlower, vupper;
+        std::string error; ///< set when the last check of the worker failed, exceptions cannot cross threads
+    };
+
+    /// \brief brings the cloned environment of the worker up to date with this environment
+    ///
+    /// Only the state of the bodies recorded in the change journal since the last call is copied. The whole environment is
+    /// cloned again when bodies were added or removed, their geometry changed, the collision checker changed, or the journal
+    /// was trimmed.
+    void _SynchronizeConfigurationCheckWorker(ConfigurationCheckWorker& worker)
+    {
+        bool bjournalvalid = GetChangeJournal()->GetChangedBodies(worker.nJournalStamp, worker.vchangedbodyids);
+        bool bclone = !worker.penv || !bjournalvalid || worker.nBodiesModifiedStamp != _nBodiesModifiedStamp || worker.pchecker.lock() != _pCurrentChecker;
+        if( !bclone ) {
+            std::sort(worker.vchangedbodyids.begin(), worker.vchangedbodyids.end());
+            worker.vchangedbodyids.erase(std::unique(worker.vchangedbodyids.begin(), worker.vchangedbodyids.end()), worker.vchangedbodyids.end());
+            FOREACHC(itid, worker.vchangedbodyids) {
+                KinBodyPtr pbody = GetBodyFromEnvironmentId(*itid);
+                KinBodyPtr pnewbody = worker.penv->GetBodyFromEnvironmentId(*itid);
+                if( !pbody || !pnewbody || pbody->GetKinematicsGeometryHash() != pnewbody->GetKinematicsGeometryHash() ) {
+                    bclone = true;
+                    break;
+                }
+                if( pbody->IsRobot() ) {
+                    RobotBase::RobotStateSaver saver(RaveInterfaceCast<RobotBase>(pbody), 0xffffffff);
+                    saver.Restore(RaveInterfaceCast<RobotBase>(pnewbody));
+                }
+                else {
+                    KinBody::KinBodyStateSaver saver(pbody, 0xffffffff);
+                    saver.Restore(pnewbody);
+                }
+            }
+        }
+        if( bclone ) {
+            if( !worker.penv ) {
+                worker.penv = CloneSelf(Clone_Bodies);
+                worker.penv->StopSimulation();
+            }
+            else {
+                worker.penv->Clone(shared_from_this(), Clone_Bodies);
+            }
+        }
+        else if( !!_pCurrentChecker && !!worker.penv->GetCollisionChecker() ) {
+            worker.penv->GetCollisionChecker()->SetCollisionOptions(_pCurrentChecker->GetCollisionOptions());
+        }
+        worker.nBodiesModifiedStamp = _nBodiesModifiedStamp;
+        worker.pchecker = _pCurrentChecker;
+    }
+
+    /// \brief checks the configurations [istart,iend) of the body with the environment of the body. Errors are stored in the worker.
+    void _CheckConfigurationsThread(ConfigurationCheckWorker& worker, KinBodyPtr pbody, const std::vector<int>& dofindices, const std::vector<dReal>& vconfigs, int istart, int iend, std::vector<uint8_t>& vresults, int checkoptions)
+    {
+        worker.error.resize(0);
+        try {
+            EnvironmentBasePtr penv = pbody->GetEnv();
+            EnvironmentMutex::scoped_lock lockenv(penv->GetMutex());
+            KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+            int dofstride = dofindices.size() > 0 ? (int)dofindices.size() : pbody->GetDOF();
+            size_t numlinks = pbody->GetLinks().size();
+            worker.vconfigs.resize(0);
+            worker.vconfigs.insert(worker.vconfigs.end(), vconfigs.begin()+istart*dofstride, vconfigs.begin()+iend*dofstride);
+            pbody->ComputeLinkTransformations(worker.vlinktransforms, worker.vconfigs, dofindices);
+            pbody->GetDOFValues(worker.vdofvalues);
+            if( checkoptions & CCR_OutOfLimits ) {
+                pbody->GetDOFLimits(worker.vlower, worker.vupper, dofindices);
+                for(int idof = 0; idof < dofstride; ++idof) {
+                    KinBody::JointPtr pjoint = pbody->GetJointFromDOFIndex(dofindices.size() > 0 ? dofindices[idof] : idof);
+                    if( pjoint->IsCircular(0) ) {
+                        worker.vlower[idof] = -std::numeric_limits<dReal>::infinity();
+                        worker.vupper[idof] = std::numeric_limits<dReal>::infinity();
+                    }
+                }
+            }
+            const dReal fEpsilonJointLimit = RavePow(g_fEpsilon,0.8);
+            worker.vtransforms.resize(numlinks);
+            for(int iconfig = istart; iconfig < iend; ++iconfig) {
+                const dReal* pconfig = &worker.vconfigs[(iconfig-istart)*dofstride];
+                uint8_t result = 0;
+                if( checkoptions & CCR_OutOfLimits ) {
+                    for(int idof = 0; idof < dofstride; ++idof) {
+                        if( pconfig[idof] < worker.vlower[idof]-fEpsilonJointLimit || pconfig[idof] > worker.vupper[idof]+fEpsilonJointLimit ) {
+                            result |= CCR_OutOfLimits;
+                            break;
+                        }
+                    }
+                }
+                if( result == 0 && (checkoptions & (CCR_EnvironmentCollision|CCR_SelfCollision)) ) {
+                    std::copy(worker.vlinktransforms.begin()+(iconfig-istart)*numlinks, worker.vlinktransforms.begin()+(iconfig-istart+1)*numlinks, worker.vtransforms.begin());
+                    for(int idof = 0; idof < dofstride; ++idof) {
+                        worker.vdofvalues[dofindices.size() > 0 ? dofindices[idof] : idof] = pconfig[idof];
+                    }
+                    pbody->SetLinkTransformations(worker.vtransforms, worker.vdofvalues);
+                    if( (checkoptions & CCR_EnvironmentCollision) && penv->CheckCollision(KinBodyConstPtr(pbody)) ) {
+                        result |= CCR_EnvironmentCollision;
+                    }
+                    if( (checkoptions & CCR_SelfCollision) && pbody->CheckSelfCollision() ) {
+                        result |= CCR_SelfCollision;
+                    }
+                }
+                vresults[iconfig] = result;
+            }
+        }
+        catch(const std::exception& ex) {
+            worker.error = ex.what();
+        }
+    }
+
     virtual void _Clone(boost::shared_ptr<Environment const> r, int options, bool bCheckSharedResources=false)
     {
         if( !bCheckSharedResources ) {
@@ -1958,7 +2270,7 @@ protected:
                     (*itrobot)->Destroy();
                 }
                 _vecrobots.clear();
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
             }
             // a little tricky due to a deadlocking situation
             std::map<int, KinBodyWeakPtr> mapBodies;
@@ -2066,6 +2378,8 @@ protected:
                         listToCopyState.push_back(*itrobot);
                     }
                     pnewrobot->_environmentid = (*itrobot)->GetEnvironmentId();
+                    pnewrobot->_pchangejournal = GetChangeJournal();
+                    pnewrobot->_RecordChange();
                     BOOST_ASSERT( _mapBodies.find(pnewrobot->GetEnvironmentId()) == _mapBodies.end() );
                     _vecbodies.push_back(pnewrobot);
                     _vecrobots.push_back(pnewrobot);
@@ -2098,6 +2412,8 @@ protected:
                         listToCopyState.push_back(*itbody);
                     }
                     pnewbody->_environmentid = (*itbody)->GetEnvironmentId();
+                    pnewbody->_pchangejournal = GetChangeJournal();
+                    pnewbody->_RecordChange();
                     _vecbodies.push_back(pnewbody);
                     _mapBodies[pnewbody->GetEnvironmentId()] = pnewbody;
                 }
@@ -2323,13 +2639,19 @@ protected:
         BOOST_ASSERT( _mapBodies.find(id) == _mapBodies.end() );
         pbody->_environmentid=id;
         _mapBodies[id] = pbody;
+        pbody->_pchangejournal = GetChangeJournal();
+        pbody->_nChangeJournalStamp = -1; // record under the new id even if recorded in this stamp before
+        pbody->_RecordChange();
     }
 
     virtual void RemoveEnvironmentId(KinBodyPtr pbody)
     {
         boost::mutex::scoped_lock locknetworkid(_mutexEnvironmentIds);
         _mapBodies.erase(pbody->_environmentid);
+        // consumers see the removal as a change of a body that no longer exists
+        GetChangeJournal()->RecordChange(pbody->_environmentid);
         pbody->_environmentid = 0;
+        pbody->_pchangejournal.reset();
     }
 
     void _StartSimulationThread()
@@ -2580,7 +2902,20 @@ protected:
     mutable boost::timed_mutex _mutexInterfaces;     ///< lock when managing interfaces like _listOwnedInterfaces, _listModules, _mapBodies
     mutable boost::mutex _mutexInit;     ///< lock for destroying the environment
 
-    vector<KinBody::BodyState> _vPublishedBodies;
+    /// \brief published state of one body. Never modified once published, so the front and back buffers share it until the body changes.
+    struct PublishedBody
+    {
+        KinBody::BodyState state;
+        uint64_t version; ///< _nPublishedVersion the state was captured for
+    };
+    typedef boost::shared_ptr<PublishedBody const> PublishedBodyConstPtr;
+
+    std::vector<PublishedBodyConstPtr> _vPublishedBodies; ///< front buffer read by GetPublishedBodies. Protected by _mutexInterfaces and only modified while the environment is locked
+    std::vector<PublishedBodyConstPtr> _vPublishedBodiesBack; ///< back buffer filled by _UpdatePublishedBodies while the environment is locked
+    std::vector<int> _vPublishedRemovedBodyIdsBack; ///< environment ids of the bodies _UpdatePublishedBodies dropped from the back buffer
+    std::vector< std::pair<uint64_t, int> > _vPublishedRemovedBodies; ///< (version, environment id) of the bodies that left the published set, oldest first
+    uint64_t _nPublishedVersion; ///< incremented every time the published set changes
+    uint64_t _nPublishedMinDeltaVersion; ///< oldest client version GetPublishedBodiesChanged can compute the changes for
     string _homedirectory;
     std::pair<std::string, dReal> _unit; ///< unit name mm, cm, inches, m and the conversion for meters
 
@@ -2590,6 +2925,7 @@ protected:
 
     std::list<UserDataWeakPtr> _listRegisteredCollisionCallbacks;     ///< see EnvironmentBase::RegisterCollisionCallback
     std::list<UserDataWeakPtr> _listRegisteredBodyCallbacks;     ///< see EnvironmentBase::RegisterBodyCallback
+    std::vector< boost::shared_ptr<ConfigurationCheckWorker> > _vConfigurationCheckWorkers; ///< see CheckConfigurations
 
     bool _bInit;                   ///< environment is initialized
     bool _bEnableSimulation;            ///< enable simulation loop
@@ -187,6 +187,7 @@ KinBody::KinBody(InterfaceType type, EnvironmentBasePtr penv) : InterfaceBase(ty
     _environmentid = 0;
     _nNonAdjacentLinkCache = 0x80000000;
     _nUpdateStampId = 0;
+    _nChangeJournalStamp = -1;
 }
 
 KinBody::~KinBody()
@@ -1402,6 +1403,7 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, const Transfo
 
 void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t checklimits, const std::vector<int>& dofindices)
 {
+    OPENRAVE_PROFILE_SCOPE("KinBody::SetDOFValues");
     CHECK_INTERNAL_COMPUTATION;
     if( vJointValues.size() == 0 || _veclinks.size() == 0) {
         return;
@@ -1499,11 +1501,69 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         pJointValues = &_vTempJoints[0];
     }
 
-    boost::array<dReal,3> dummyvalues; // dummy values for a joint
-    std::vector<dReal> vtempvalues, veval;
-
     // have to compute the angles ahead of time since they are dependent on the link transformations
-    std::vector< std::vector<dReal> > vPassiveJointValues(_vPassiveJoints.size());
+    std::vector< std::vector<dReal> > vPassiveJointValues;
+    _GetPassiveJointValues(vPassiveJointValues);
+
+    std::vector<Transform> vlinktransforms(_veclinks.size());
+    for(size_t ilink = 0; ilink < _veclinks.size(); ++ilink) {
+        vlinktransforms[ilink] = _veclinks[ilink]->GetTransform();
+    }
+    std::vector<uint8_t> vlinkscomputed;
+    _ComputeLinkTransformations(&vlinktransforms[0], pJointValues, vPassiveJointValues, vlinkscomputed, checklimits, true);
+    for(size_t ilink = 1; ilink < _veclinks.size(); ++ilink) {
+        if( vlinkscomputed[ilink] ) {
+            _veclinks[ilink]->SetTransform(vlinktransforms[ilink]);
+        }
+    }
+
+    _PostprocessChangedParameters(Prop_LinkTransforms);
+}
+
+void KinBody::ComputeLinkTransformations(std::vector<Transform>& vlinktransforms, const std::vector<dReal>& vdofvalues, const std::vector<int>& dofindices) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    size_t dofstride = dofindices.size() > 0 ? dofindices.size() : (size_t)GetDOF();
+    size_t numlinks = _veclinks.size();
+    size_t numconfigs = dofstride > 0 ? vdofvalues.size()/dofstride : 0;
+    if( vdofvalues.size() != numconfigs*dofstride ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(str(boost::format("number of values %d is not a multiple of %d")%vdofvalues.size()%dofstride), ORE_InvalidArguments);
+    }
+    vlinktransforms.resize(numconfigs*numlinks);
+    if( numconfigs == 0 || numlinks == 0 ) {
+        return;
+    }
+
+    std::vector<Transform> vcurtransforms;
+    GetLinkTransformations(vcurtransforms);
+    std::vector<dReal> vfulldofvalues;
+    if( dofindices.size() > 0 ) {
+        GetDOFValues(vfulldofvalues);
+    }
+
+    // passive joint values are state dependent, so gather them once like SetDOFValues does. mimic values are filled per configuration
+    std::vector< std::vector<dReal> > vPassiveJointValuesInit, vPassiveJointValues;
+    _GetPassiveJointValues(vPassiveJointValuesInit);
+
+    std::vector<uint8_t> vlinkscomputed;
+    for(size_t iconfig = 0; iconfig < numconfigs; ++iconfig) {
+        const dReal* pJointValues = &vdofvalues[iconfig*dofstride];
+        if( dofindices.size() > 0 ) {
+            for(size_t i = 0; i < dofindices.size(); ++i) {
+                vfulldofvalues.at(dofindices[i]) = pJointValues[i];
+            }
+            pJointValues = vfulldofvalues.size() > 0 ? &vfulldofvalues[0] : NULL;
+        }
+        Transform* ptransforms = &vlinktransforms[iconfig*numlinks];
+        std::copy(vcurtransforms.begin(), vcurtransforms.end(), ptransforms);
+        vPassiveJointValues = vPassiveJointValuesInit;
+        _ComputeLinkTransformations(ptransforms, pJointValues, vPassiveJointValues, vlinkscomputed, CLA_Nothing, false);
+    }
+}
+
+void KinBody::_GetPassiveJointValues(std::vector< std::vector<dReal> >& vPassiveJointValues) const
+{
+    vPassiveJointValues.resize(_vPassiveJoints.size());
     for(size_t i = 0; i < vPassiveJointValues.size(); ++i) {
         if( !_vPassiveJoints[i]->IsMimic() ) {
             _vPassiveJoints[i]->GetValues(vPassiveJointValues[i]);
@@ -1526,11 +1586,18 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
             }
         }
         else {
+            vPassiveJointValues[i].resize(0);
             vPassiveJointValues[i].reserve(_vPassiveJoints[i]->GetDOF()); // do not resize so that we can catch hierarchy errors
         }
     }
+}
 
-    std::vector<uint8_t> vlinkscomputed(_veclinks.size(),0);
+void KinBody::_ComputeLinkTransformations(Transform* ptransforms, const dReal* pJointValues, std::vector< std::vector<dReal> >& vPassiveJointValues, std::vector<uint8_t>& vlinkscomputed, uint32_t checklimits, bool bsetlastvalues) const
+{
+    boost::array<dReal,3> dummyvalues; // dummy values for a joint
+    std::vector<dReal> vtempvalues, veval, vdata;
+    vlinkscomputed.resize(_veclinks.size());
+    std::fill(vlinkscomputed.begin(), vlinkscomputed.end(), 0);
     vlinkscomputed[0] = 1;
 
     for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
@@ -1634,7 +1701,7 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                     }
                 }
                 else if( dofindex >= 0 ) {
-                    dummyvalues[i] = pvalues[dofindex+i]; // is this correct? what is a joint has a mimic and non-mimic axis?
+                    dummyvalues[i] = pvalues[i];
                 }
                 else {
                     // preserve passive joint values
@@ -1644,7 +1711,8 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
             pvalues = &dummyvalues[0];
         }
         // do the test after mimic computation!
-        if( vlinkscomputed[pjoint->GetHierarchyChildLink()->GetIndex()] ) {
+        int childindex = pjoint->GetHierarchyChildLink()->GetIndex();
+        if( vlinkscomputed[childindex] ) {
             continue;
         }
         if( !pvalues ) {
@@ -1661,8 +1729,10 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                 Transform tsecond;
                 tsecond.rot = quatFromAxisAngle(tfirst.rotate(pjoint->GetInternalHierarchyAxis(1)), pvalues[1]);
                 tjoint = tsecond * tfirst;
-                pjoint->_doflastsetvalues[0] = pvalues[0];
-                pjoint->_doflastsetvalues[1] = pvalues[1];
+                if( bsetlastvalues ) {
+                    pjoint->_doflastsetvalues[0] = pvalues[0];
+                    pjoint->_doflastsetvalues[1] = pvalues[1];
+                }
                 break;
             }
             case JointSpherical: {
@@ -1675,7 +1745,6 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                 break;
             }
             case JointTrajectory: {
-                vector<dReal> vdata;
                 tjoint = Transform();
                 dReal fvalue = pvalues[0];
                 if( pjoint->IsCircular(0) ) {
@@ -1686,7 +1755,9 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                 if( !pjoint->_info._trajfollow->GetConfigurationSpecification().ExtractTransform(tjoint,vdata.begin(),KinBodyConstPtr()) ) {
                     RAVELOG_WARN(str(boost::format("trajectory sampling for joint %s failed")%pjoint->GetName()));
                 }
-                pjoint->_doflastsetvalues[0] = 0;
+                if( bsetlastvalues ) {
+                    pjoint->_doflastsetvalues[0] = 0;
+                }
                 break;
             }
             default:
@@ -1697,7 +1768,9 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         else {
             if( pjoint->GetType() == JointRevolute ) {
                 tjoint.rot = quatFromAxisAngle(pjoint->GetInternalHierarchyAxis(0), pvalues[0]);
-                pjoint->_doflastsetvalues[0] = pvalues[0];
+                if( bsetlastvalues ) {
+                    pjoint->_doflastsetvalues[0] = pvalues[0];
+                }
             }
             else if( pjoint->GetType() == JointPrismatic ) {
                 tjoint.trans = pjoint->GetInternalHierarchyAxis(0) * pvalues[0];
@@ -1707,7 +1780,9 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                     Transform tdelta;
                     if( pjoint->IsRevolute(iaxis) ) {
                         tdelta.rot = quatFromAxisAngle(pjoint->GetInternalHierarchyAxis(iaxis), pvalues[iaxis]);
-                        pjoint->_doflastsetvalues[iaxis] = pvalues[iaxis];
+                        if( bsetlastvalues ) {
+                            pjoint->_doflastsetvalues[iaxis] = pvalues[iaxis];
+                        }
                     }
                     else {
                         tdelta.trans = pjoint->GetInternalHierarchyAxis(iaxis) * pvalues[iaxis];
@@ -1717,18 +1792,103 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
             }
         }
 
-        Transform t = pjoint->GetInternalHierarchyLeftTransform() * tjoint * pjoint->GetInternalHierarchyRightTransform();
-        if( !pjoint->GetHierarchyParentLink() ) {
-            t = _veclinks.at(0)->GetTransform() * t;
+        LinkPtr pparentlink = pjoint->GetHierarchyParentLink();
+        ptransforms[childindex] = ptransforms[!pparentlink ? 0 : pparentlink->GetIndex()] * (pjoint->GetInternalHierarchyLeftTransform() * tjoint * pjoint->GetInternalHierarchyRightTransform());
+        vlinkscomputed[childindex] = 1;
+    }
+}
+
+void KinBody::ComputeLinkTransformations(std::vector<Transform>& vlinktransforms, std::vector<dReal>& vjacobians, int linkindex, const Vector& localposition, const std::vector<dReal>& vdofvalues, const std::vector<int>& dofindices) const
+{
+    OPENRAVE_ASSERT_FORMAT(linkindex >= 0 && linkindex < (int)_veclinks.size(), "body %s bad link index %d (num links %d)", GetName()%linkindex%_veclinks.size(),ORE_InvalidArguments);
+    ComputeLinkTransformations(vlinktransforms, vdofvalues, dofindices);
+    size_t dofstride = dofindices.size() > 0 ? dofindices.size() : (size_t)GetDOF();
+    size_t numlinks = _veclinks.size();
+    size_t numconfigs = numlinks > 0 ? vlinktransforms.size()/numlinks : 0;
+    vjacobians.resize(numconfigs*6*dofstride);
+    if( vjacobians.size() == 0 ) {
+        return;
+    }
+    std::fill(vjacobians.begin(), vjacobians.end(), 0);
+
+    // column of every dof in the jacobian, -1 if not requested
+    std::vector<int> vdofcolumns(GetDOF(), -1);
+    if( dofindices.size() > 0 ) {
+        for(size_t i = 0; i < dofindices.size(); ++i) {
+            vdofcolumns.at(dofindices[i]) = i;
+        }
+    }
+    else {
+        for(size_t i = 0; i < vdofcolumns.size(); ++i) {
+            vdofcolumns[i] = i;
+        }
+    }
+
+    // gather the joints on the chain to the link once, mimic partials are state dependent so they are also computed once
+    std::vector<std::pair<JointPtr, int> > vchainaxes; // joint and axis
+    std::vector< std::vector<std::pair<int,dReal> > > vchainpartials;
+    std::vector<std::pair<int,dReal> > vpartials;
+    std::map< std::pair<Mimic::DOFFormat, int>, dReal > mapcachedpartials;
+    int offset = linkindex*numlinks;
+    int curlink = 0;
+    while(_vAllPairsShortestPaths[offset+curlink].first>=0) {
+        int jointindex = _vAllPairsShortestPaths[offset+curlink].second;
+        if( jointindex < (int)_vecjoints.size() ) {
+            JointPtr pjoint = _vecjoints.at(jointindex);
+            if( DoesAffect(pjoint->GetJointIndex(), linkindex) != 0 ) {
+                for(int idof = 0; idof < pjoint->GetDOF(); ++idof) {
+                    vpartials.resize(0);
+                    vpartials.push_back(make_pair(pjoint->GetDOFIndex()+idof, dReal(1)));
+                    vchainaxes.push_back(make_pair(pjoint, idof));
+                    vchainpartials.push_back(vpartials);
+                }
+            }
         }
         else {
-            t = pjoint->GetHierarchyParentLink()->GetTransform() * t;
+            JointPtr pjoint = _vPassiveJoints.at(jointindex-_vecjoints.size());
+            for(int idof = 0; idof < pjoint->GetDOF(); ++idof) {
+                if( pjoint->IsMimic(idof) ) {
+                    pjoint->_ComputePartialVelocities(vpartials,idof,mapcachedpartials);
+                    vchainaxes.push_back(make_pair(pjoint, idof));
+                    vchainpartials.push_back(vpartials);
+                }
+            }
         }
-        pjoint->GetHierarchyChildLink()->SetTransform(t);
-        vlinkscomputed[pjoint->GetHierarchyChildLink()->GetIndex()] = 1;
+        curlink = _vAllPairsShortestPaths[offset+curlink].first;
     }
 
-    _PostprocessChangedParameters(Prop_LinkTransforms);
+    for(size_t iconfig = 0; iconfig < numconfigs; ++iconfig) {
+        const Transform* ptransforms = &vlinktransforms[iconfig*numlinks];
+        dReal* pjacobian = &vjacobians[iconfig*6*dofstride];
+        Vector position = ptransforms[linkindex] * localposition;
+        for(size_t iaxis = 0; iaxis < vchainaxes.size(); ++iaxis) {
+            const JointPtr& pjoint = vchainaxes[iaxis].first;
+            int idof = vchainaxes[iaxis].second;
+            LinkPtr pparentlink = pjoint->GetHierarchyParentLink();
+            Transform tleft = ptransforms[!pparentlink ? 0 : pparentlink->GetIndex()] * pjoint->GetInternalHierarchyLeftTransform();
+            Vector vaxis = tleft.rotate(pjoint->GetInternalHierarchyAxis(idof));
+            Vector vtrans, vrot;
+            if( pjoint->IsRevolute(idof) ) {
+                vtrans = vaxis.cross(position-tleft.trans);
+                vrot = vaxis;
+            }
+            else if( pjoint->IsPrismatic(idof) ) {
+                vtrans = vaxis;
+            }
+            else {
+                RAVELOG_WARN("ComputeLinkTransformations joint %d not supported\n", pjoint->GetType());
+                continue;
+            }
+            FOREACHC(itpartial, vchainpartials[iaxis]) {
+                int index = vdofcolumns.at(itpartial->first);
+                if( index < 0 ) {
+                    continue;
+                }
+                pjacobian[index] += vtrans.x*itpartial->second; pjacobian[dofstride+index] += vtrans.y*itpartial->second; pjacobian[2*dofstride+index] += vtrans.z*itpartial->second;
+                pjacobian[3*dofstride+index] += vrot.x*itpartial->second; pjacobian[4*dofstride+index] += vrot.y*itpartial->second; pjacobian[5*dofstride+index] += vrot.z*itpartial->second;
+            }
+        }
+    }
 }
 
 bool KinBody::IsDOFRevolute(int dofindex) const
@@ -2934,6 +3094,205 @@ void KinBody::ComputeInverseDynamics(boost::array< std::vector<dReal>, 3>& vDOFT
     }
 }
 
+void KinBody::ComputeInverseDynamics(std::vector<dReal>& vdoftorques, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccelerations) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    size_t dof = GetDOF();
+    size_t numlinks = _veclinks.size();
+    size_t numstates = dof > 0 ? vdofvalues.size()/dof : 0;
+    if( vdofvalues.size() != numstates*dof ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(str(boost::format("number of values %d is not a multiple of %d")%vdofvalues.size()%dof), ORE_InvalidArguments);
+    }
+    OPENRAVE_ASSERT_OP(vdofvelocities.size(),==,vdofvalues.size());
+    OPENRAVE_ASSERT_OP(vdofaccelerations.size(),==,vdofvalues.size());
+    vdoftorques.resize(numstates*dof);
+    if( numstates == 0 || _vecjoints.size() == 0 ) {
+        std::fill(vdoftorques.begin(), vdoftorques.end(), 0);
+        return;
+    }
+    // supports 1-dof revolute and prismatic joints, passive joints can mimic active dofs
+    FOREACHC(itjoint, _vTopologicallySortedJointsAll) {
+        const JointPtr& pjoint = *itjoint;
+        bool bsupported = pjoint->GetDOF() == 1 && (pjoint->GetType() == JointRevolute || pjoint->GetType() == JointPrismatic);
+        if( pjoint->IsMimic() ) {
+            bsupported &= pjoint->GetDOFIndex() < 0;
+            FOREACHC(itdof, pjoint->_vmimic.at(0)->_vdofformat) {
+                bsupported &= itdof->dofindex >= 0;
+            }
+        }
+        else if( pjoint->GetDOFIndex() < 0 ) {
+            bsupported = true; // passive joints keep their values, so they move rigidly with the parent
+        }
+        if( !bsupported ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("body %s joint %s type 0x%x is not supported by batch inverse dynamics"), GetName()%pjoint->GetName()%pjoint->GetType(), ORE_NotImplemented);
+        }
+    }
+
+    std::vector<Transform> vlinktransforms;
+    ComputeLinkTransformations(vlinktransforms, vdofvalues);
+
+    Vector vgravity = GetEnv()->GetPhysicsEngine()->GetGravity();
+    Vector vbaselinear, vbaseangular;
+    _veclinks.at(0)->GetVelocity(vbaselinear,vbaseangular);
+
+    // buffers shared by all the states. all values are in the global coordinate system, linear accelerations are at the link origins
+    std::vector<Vector> vLinkAngularVelocities(numlinks), vLinkAngularAccelerations(numlinks), vLinkLinearAccelerations(numlinks);
+    std::vector<Vector> vLinkCOMs(numlinks), vLinkCOMLinearAccelerations(numlinks), vLinkCOMMomentOfInertia(numlinks);
+    std::vector< std::pair<Vector, Vector> > vLinkForceTorques(numlinks);
+    std::vector<uint8_t> vlinkscomputed(numlinks);
+    std::vector< std::vector<dReal> > vPassiveJointPartials(_vPassiveJoints.size()); ///< for mimic joints, partial velocities with respect to the mimic dofs
+    std::vector<dReal> vtempvalues, veval;
+
+    for(size_t istate = 0; istate < numstates; ++istate) {
+        const Transform* ptransforms = &vlinktransforms[istate*numlinks];
+        const dReal* pdofvelocities = &vdofvelocities[istate*dof];
+        const dReal* pdofaccelerations = &vdofaccelerations[istate*dof];
+        dReal* pdoftorques = &vdoftorques[istate*dof];
+        // check if all velocities are 0 like ComputeInverseDynamics does, in which case friction is ignored
+        bool bHasVelocity = false;
+        for(size_t i = 0; i < dof; ++i) {
+            if( RaveFabs(pdofvelocities[i]) > g_fEpsilonLinear ) {
+                bHasVelocity = true;
+                break;
+            }
+        }
+
+        // forward recursion
+        std::fill(vLinkAngularVelocities.begin(), vLinkAngularVelocities.end(), Vector());
+        std::fill(vLinkAngularAccelerations.begin(), vLinkAngularAccelerations.end(), Vector());
+        std::fill(vLinkLinearAccelerations.begin(), vLinkLinearAccelerations.end(), Vector());
+        std::fill(vlinkscomputed.begin(), vlinkscomputed.end(), 0);
+        vLinkAngularVelocities[0] = vbaseangular;
+        vLinkLinearAccelerations[0] = vbaseangular.cross(vbaselinear) - vgravity;
+        vlinkscomputed[0] = 1;
+        for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+            const JointPtr& pjoint = _vTopologicallySortedJointsAll[ijoint];
+            int childindex = pjoint->GetHierarchyChildLink()->GetIndex();
+            if( vlinkscomputed[childindex] ) {
+                continue;
+            }
+            int parentindex = !pjoint->GetHierarchyParentLink() ? 0 : pjoint->GetHierarchyParentLink()->GetIndex();
+            const Vector& wparent = vLinkAngularVelocities[parentindex];
+            const Vector& dwparent = vLinkAngularAccelerations[parentindex];
+            Vector xyzdelta = ptransforms[childindex].trans - ptransforms[parentindex].trans;
+            Vector& vchildaccel = vLinkLinearAccelerations[childindex];
+            vchildaccel = vLinkLinearAccelerations[parentindex] + dwparent.cross(xyzdelta) + wparent.cross(wparent.cross(xyzdelta));
+            vLinkAngularVelocities[childindex] = wparent;
+            vLinkAngularAccelerations[childindex] = dwparent;
+            int dofindex = pjoint->GetDOFIndex();
+            bool bmoving = dofindex >= 0;
+            dReal fvelocity = 0, facceleration = 0;
+            if( dofindex >= 0 ) {
+                fvelocity = pdofvelocities[dofindex];
+                facceleration = pdofaccelerations[dofindex];
+            }
+            else if( pjoint->IsMimic() ) {
+                // same as _ComputeLinkAccelerations
+                const std::vector<Mimic::DOFFormat>& vdofformat = pjoint->_vmimic[0]->_vdofformat;
+                vtempvalues.resize(0);
+                FOREACHC(itdof, vdofformat) {
+                    vtempvalues.push_back(vdofvalues[istate*dof+itdof->dofindex]);
+                }
+                std::vector<dReal>& vpartials = vPassiveJointPartials.at(_vTopologicallySortedJointIndicesAll[ijoint]-_vecjoints.size());
+                vpartials.resize(0);
+                int err = pjoint->_Eval(0,1,vtempvalues,vpartials);
+                if( err || vpartials.size() < vdofformat.size() ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT(_("failed to evaluate joint %s velocity, fparser error %d"), pjoint->GetName()%err, ORE_InvalidState);
+                }
+                err = pjoint->_Eval(0,2,vtempvalues,veval);
+                if( err || veval.size() < vdofformat.size() ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT(_("failed to evaluate joint %s acceleration, fparser error %d"), pjoint->GetName()%err, ORE_InvalidState);
+                }
+                for(size_t ipartial = 0; ipartial < vdofformat.size(); ++ipartial) {
+                    fvelocity += vpartials[ipartial]*pdofvelocities[vdofformat[ipartial].dofindex];
+                    facceleration += veval[ipartial]*pdofaccelerations[vdofformat[ipartial].dofindex];
+                }
+                bmoving = true;
+            }
+            if( bmoving ) {
+                Transform tleft = ptransforms[parentindex] * pjoint->GetInternalHierarchyLeftTransform();
+                Vector vaxis = tleft.rotate(pjoint->GetInternalHierarchyAxis(0));
+                Vector gw = vaxis*(bHasVelocity ? fvelocity : dReal(0)), gdw = vaxis*facceleration;
+                if( pjoint->GetType() == JointRevolute ) {
+                    // the anchor is fixed in both links, see _ComputeLinkAccelerations
+                    Vector vanchortochild = ptransforms[childindex].trans - tleft.trans;
+                    vchildaccel += gdw.cross(vanchortochild) + wparent.cross(gw.cross(vanchortochild))*2 + gw.cross(gw.cross(vanchortochild));
+                    vLinkAngularVelocities[childindex] += gw;
+                    vLinkAngularAccelerations[childindex] += gdw + wparent.cross(gw);
+                }
+                else {
+                    vchildaccel += wparent.cross(gw)*2 + gdw;
+                }
+            }
+            // passive joints that are not mimic keep their values, so they move rigidly with the parent
+            vlinkscomputed[childindex] = 1;
+        }
+
+        for(size_t i = 0; i < numlinks; ++i) {
+            const KinBody::LinkInfo& info = _veclinks[i]->_info;
+            Transform tmass = ptransforms[i] * info._tMassFrame;
+            vLinkCOMs[i] = tmass.trans;
+            Vector vglobalcomfromlink = tmass.trans - ptransforms[i].trans;
+            const Vector& vangularaccel = vLinkAngularAccelerations[i];
+            const Vector& vangularvelocity = vLinkAngularVelocities[i];
+            vLinkCOMLinearAccelerations[i] = vLinkLinearAccelerations[i] + vangularaccel.cross(vglobalcomfromlink) + vangularvelocity.cross(vangularvelocity.cross(vglobalcomfromlink));
+            // I*v = R*diag(moments)*R^T*v
+            Vector vlocalaccel = tmass.inverse().rotate(vangularaccel), vlocalvelocity = tmass.inverse().rotate(vangularvelocity);
+            Vector vinertiaaccel = tmass.rotate(Vector(vlocalaccel.x*info._vinertiamoments.x, vlocalaccel.y*info._vinertiamoments.y, vlocalaccel.z*info._vinertiamoments.z));
+            Vector vinertiavelocity = tmass.rotate(Vector(vlocalvelocity.x*info._vinertiamoments.x, vlocalvelocity.y*info._vinertiamoments.y, vlocalvelocity.z*info._vinertiamoments.z));
+            vLinkCOMMomentOfInertia[i] = vinertiaaccel + vangularvelocity.cross(vinertiavelocity);
+        }
+
+        // backward recursion
+        std::fill(vLinkForceTorques.begin(), vLinkForceTorques.end(), std::make_pair(Vector(), Vector()));
+        std::fill(pdoftorques, pdoftorques+dof, dReal(0));
+        for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+            const JointPtr& pjoint = _vTopologicallySortedJointsAll[_vTopologicallySortedJointsAll.size()-1-ijoint];
+            int childindex = pjoint->GetHierarchyChildLink()->GetIndex();
+            Vector vcomforce = vLinkCOMLinearAccelerations[childindex]*pjoint->GetHierarchyChildLink()->GetMass() + vLinkForceTorques[childindex].first;
+            Vector vjointtorque = vLinkForceTorques[childindex].second + vLinkCOMMomentOfInertia[childindex];
+            int parentindex = !pjoint->GetHierarchyParentLink() ? 0 : pjoint->GetHierarchyParentLink()->GetIndex();
+            if( !!pjoint->GetHierarchyParentLink() ) {
+                vLinkForceTorques[parentindex].first += vcomforce;
+                vLinkForceTorques[parentindex].second += vjointtorque + (vLinkCOMs[childindex] - vLinkCOMs[parentindex]).cross(vcomforce);
+            }
+
+            int dofindex = pjoint->GetDOFIndex();
+            if( dofindex >= 0 || pjoint->IsMimic() ) {
+                Transform tleft = ptransforms[parentindex] * pjoint->GetInternalHierarchyLeftTransform();
+                Vector vaxis = tleft.rotate(pjoint->GetInternalHierarchyAxis(0));
+                dReal faxistorque;
+                if( pjoint->GetType() == JointRevolute ) {
+                    faxistorque = vaxis.dot3(vjointtorque + (vLinkCOMs[childindex] - tleft.trans).cross(vcomforce));
+                }
+                else {
+                    faxistorque = vaxis.dot3(vcomforce);
+                }
+                if( dofindex < 0 ) {
+                    // passive joint, so transfer the torque to its dependent dofs
+                    const std::vector<Mimic::DOFFormat>& vdofformat = pjoint->_vmimic[0]->_vdofformat;
+                    const std::vector<dReal>& vpartials = vPassiveJointPartials.at(_vTopologicallySortedJointIndicesAll[_vTopologicallySortedJointsAll.size()-1-ijoint]-_vecjoints.size());
+                    for(size_t ipartial = 0; ipartial < vdofformat.size(); ++ipartial) {
+                        pdoftorques[vdofformat[ipartial].dofindex] += vpartials[ipartial]*faxistorque;
+                    }
+                    continue;
+                }
+                pdoftorques[dofindex] += faxistorque;
+                if( !!pjoint->_info._infoElectricMotor && bHasVelocity ) {
+                    dReal fvelocity = pdofvelocities[dofindex];
+                    if( fvelocity > g_fEpsilonLinear ) {
+                        pdoftorques[dofindex] += pjoint->_info._infoElectricMotor->coloumb_friction;
+                    }
+                    else if( fvelocity < -g_fEpsilonLinear ) {
+                        pdoftorques[dofindex] -= pjoint->_info._infoElectricMotor->coloumb_friction;
+                    }
+                    pdoftorques[dofindex] += fvelocity*pjoint->_info._infoElectricMotor->viscous_friction;
+                }
+            }
+        }
+    }
+}
+
 void KinBody::GetLinkAccelerations(const std::vector<dReal>&vDOFAccelerations, std::vector<std::pair<Vector,Vector> >&vLinkAccelerations, AccelerationMapConstPtr externalaccelerations) const
 {
     CHECK_INTERNAL_COMPUTATION;
@@ -4042,6 +4401,7 @@ void KinBody::_ComputeInternalInformation()
         _ResetInternalCollisionCache();
     }
     _nHierarchyComputed = 2;
+    _UpdateStampAllLinks(); // links might have been recreated
     // because of mimic joints, need to call SetDOFValues at least once, also use this to check for links that are off
     {
         vector<Transform> vprevtrans, vnewtrans;
@@ -4323,7 +4683,7 @@ private:
         for(size_t i = 0; i < _veclinks.size(); ++i) {
             boost::static_pointer_cast<Link>(_veclinks[i])->_info._t = _vInitialLinkTransformations.at(i);
         }
-        _nUpdateStampId++; // because transforms were modified
+        _UpdateStampAllLinks(); // because transforms were modified
         for(size_t i = 0; i < _veclinks.size(); ++i) {
             for(size_t j = i+1; j < _veclinks.size(); ++j) {
                 if((_setAdjacentLinks.find(i|(j<<16)) == _setAdjacentLinks.end())&& !collisionchecker->CheckCollision(LinkConstPtr(_veclinks[i]), LinkConstPtr(_veclinks[j])) ) {
@@ -4331,7 +4691,7 @@ private:
                 }
             }
         }
-        _nUpdateStampId++; // because transforms were modified
+        _UpdateStampAllLinks(); // because transforms were modified, saver restores them without changing the stamps again
         _nNonAdjacentLinkCache = 0;
     }
     if( (_nNonAdjacentLinkCache&adjacentoptions) != adjacentoptions ) {
@@ -4381,6 +4741,7 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
         std::vector<Link::GeometryPtr> vnewgeometries(pnewlink->_vGeometries.size());
         for(size_t igeom = 0; igeom < vnewgeometries.size(); ++igeom) {
             vnewgeometries[igeom].reset(new Link::Geometry(pnewlink, pnewlink->_vGeometries[igeom]->_info));
+            vnewgeometries[igeom]->_bCollisionMeshOutdated = pnewlink->_vGeometries[igeom]->_bCollisionMeshOutdated;
         }
         pnewlink->_vGeometries = vnewgeometries;
         _veclinks.push_back(pnewlink);
@@ -4475,12 +4836,30 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
 
     // cache
     _ResetInternalCollisionCache();
-    _nUpdateStampId++; // update the stamp instead of copying
+    _UpdateStampAllLinks(); // update the stamp instead of copying
+}
+
+void KinBody::_RecordChange() const
+{
+    if( !!_pchangejournal && _nChangeJournalStamp != _pchangejournal->GetStamp() ) {
+        _nChangeJournalStamp = _pchangejournal->GetStamp();
+        _pchangejournal->RecordChange(_environmentid);
+    }
+}
+
+void KinBody::_UpdateStampAllLinks() const
+{
+    _nUpdateStampId++;
+    FOREACH(itlink, _veclinks) {
+        (*itlink)->_nUpdateStampId = _nUpdateStampId;
+    }
+    _RecordChange();
 }
 
 void KinBody::_PostprocessChangedParameters(uint32_t parameters)
 {
     _nUpdateStampId++;
+    _RecordChange();
     if( _nHierarchyComputed == 1 ) {
         _nParametersChanged |= parameters;
         return;
@@ -4493,7 +4872,7 @@ void KinBody::_PostprocessChangedParameters(uint32_t parameters)
         _ComputeInternalInformation();
     }
     // do not change hash if geometry changed!
-    if( !!(parameters & (Prop_LinkDynamics|Prop_LinkGeometry|Prop_JointMimic)) ) {
+    if( !!(parameters & (Prop_LinkDynamics|Prop_LinkGeometry|Prop_LinkOctree|Prop_JointMimic)) ) {
         __hashkinematics.resize(0);
     }
 
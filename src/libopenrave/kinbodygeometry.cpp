@@ -160,6 +160,243 @@ void AppendBoxTriangulation(const Vector& pos, const Vector& ex, TriMesh& tri)
     tri.indices.insert(tri.indices.end(), &indices[0], &indices[nindices]);
 }
 
+static const int64_t s_nOctreeKeyOffset = 1<<20; ///< voxel indices are stored with this offset in 21 bits
+static const uint64_t s_nOctreeKeyMask = (1<<21)-1;
+static const uint64_t s_nOctreeOccupiedFlag = 0x8000000000000000ULL; ///< set in the change log when a voxel became occupied
+
+static boost::mutex s_mutexOctreeId;
+static uint64_t s_nOctreeNextId = 0;
+
+static uint64_t GetNewOctreeId()
+{
+    boost::mutex::scoped_lock lock(s_mutexOctreeId);
+    return ++s_nOctreeNextId;
+}
+
+OctreeOccupancy::OctreeOccupancy(dReal resolution) : _resolution(resolution), _id(GetNewOctreeId()), _revision(0), _changelogstartrevision(0)
+{
+    OPENRAVE_ASSERT_OP(resolution,>,0);
+}
+
+OctreeOccupancy::OctreeOccupancy(const OctreeOccupancy& r) : _resolution(r._resolution), _vkeys(r._vkeys), _vchangelog(r._vchangelog), _id(GetNewOctreeId()), _revision(r._revision), _changelogstartrevision(r._changelogstartrevision)
+{
+}
+
+OctreeOccupancy& OctreeOccupancy::operator=(const OctreeOccupancy& r)
+{
+    if( this != &r ) {
+        _resolution = r._resolution;
+        _vkeys = r._vkeys;
+        _vchangelog = r._vchangelog;
+        _id = GetNewOctreeId(); // the data was replaced, so whoever cached it by id has to rebuild
+        _revision = r._revision;
+        _changelogstartrevision = r._changelogstartrevision;
+    }
+    return *this;
+}
+
+void OctreeOccupancy::SetResolution(dReal resolution)
+{
+    OPENRAVE_ASSERT_OP(resolution,>,0);
+    Clear();
+    _resolution = resolution;
+}
+
+int OctreeOccupancy::Update(const std::vector<Vector>& vpoints, bool occupied)
+{
+    std::vector<uint64_t> vnewkeys;
+    vnewkeys.reserve(vpoints.size());
+    uint64_t key = 0;
+    FOREACHC(itpoint, vpoints) {
+        if( _GetKey(*itpoint, key) ) {
+            vnewkeys.push_back(key);
+        }
+    }
+    std::sort(vnewkeys.begin(), vnewkeys.end());
+    vnewkeys.erase(std::unique(vnewkeys.begin(), vnewkeys.end()), vnewkeys.end());
+
+    std::vector<uint64_t> vchanged, vmerged;
+    if( occupied ) {
+        std::set_difference(vnewkeys.begin(), vnewkeys.end(), _vkeys.begin(), _vkeys.end(), std::back_inserter(vchanged));
+        if( vchanged.size() == 0 ) {
+            return 0;
+        }
+        vmerged.reserve(_vkeys.size()+vchanged.size());
+        std::merge(_vkeys.begin(), _vkeys.end(), vchanged.begin(), vchanged.end(), std::back_inserter(vmerged));
+    }
+    else {
+        std::set_intersection(vnewkeys.begin(), vnewkeys.end(), _vkeys.begin(), _vkeys.end(), std::back_inserter(vchanged));
+        if( vchanged.size() == 0 ) {
+            return 0;
+        }
+        vmerged.reserve(_vkeys.size()-vchanged.size());
+        std::set_difference(_vkeys.begin(), _vkeys.end(), vchanged.begin(), vchanged.end(), std::back_inserter(vmerged));
+    }
+    _vkeys.swap(vmerged);
+
+    ++_revision;
+    _vchangelog.reserve(_vchangelog.size()+vchanged.size());
+    FOREACHC(itkey, vchanged) {
+        _vchangelog.push_back(std::make_pair(_revision, occupied ? (*itkey|s_nOctreeOccupiedFlag) : *itkey));
+    }
+    _TrimChangeLog();
+    return (int)vchanged.size();
+}
+
+void OctreeOccupancy::Clear()
+{
+    if( _vkeys.size() == 0 ) {
+        return;
+    }
+    _vkeys.clear();
+    ++_revision;
+    // rebuilding an empty tree is free, so do not log every removal
+    _vchangelog.clear();
+    _changelogstartrevision = _revision;
+}
+
+bool OctreeOccupancy::IsOccupied(const Vector& point) const
+{
+    uint64_t key = 0;
+    return _GetKey(point, key) && std::binary_search(_vkeys.begin(), _vkeys.end(), key);
+}
+
+void OctreeOccupancy::GetOccupiedCenters(std::vector<Vector>& vcenters) const
+{
+    vcenters.resize(_vkeys.size());
+    for(size_t i = 0; i < _vkeys.size(); ++i) {
+        vcenters[i] = _GetCenter(_vkeys[i]);
+    }
+}
+
+bool OctreeOccupancy::GetChangesSince(uint64_t revision, std::vector<Vector>& voccupied, std::vector<Vector>& vfreed) const
+{
+    voccupied.resize(0);
+    vfreed.resize(0);
+    if( revision < _changelogstartrevision || revision > _revision ) {
+        return false;
+    }
+    std::vector< std::pair<uint64_t, uint64_t> >::const_iterator itchange = std::upper_bound(_vchangelog.begin(), _vchangelog.end(), std::make_pair(revision, std::numeric_limits<uint64_t>::max()));
+    std::map<uint64_t, bool> mapfinalstate;
+    for(; itchange != _vchangelog.end(); ++itchange) {
+        mapfinalstate[itchange->second&~s_nOctreeOccupiedFlag] = !!(itchange->second&s_nOctreeOccupiedFlag);
+    }
+    FOREACHC(itstate, mapfinalstate) {
+        if( itstate->second ) {
+            voccupied.push_back(_GetCenter(itstate->first));
+        }
+        else {
+            vfreed.push_back(_GetCenter(itstate->first));
+        }
+    }
+    return true;
+}
+
+void OctreeOccupancy::serialize(std::ostream& o, int options) const
+{
+    SerializeRound(o,_resolution);
+    o << _vkeys.size() << " ";
+    FOREACHC(itkey, _vkeys) {
+        o << *itkey << " ";
+    }
+}
+
+AABB OctreeOccupancy::ComputeAABB() const
+{
+    AABB ab;
+    if( _vkeys.size() == 0 ) {
+        return ab;
+    }
+    uint64_t vmin[3], vmax[3];
+    for(int j = 0; j < 3; ++j) {
+        vmin[j] = s_nOctreeKeyMask;
+        vmax[j] = 0;
+    }
+    FOREACHC(itkey, _vkeys) {
+        for(int j = 0; j < 3; ++j) {
+            uint64_t index = (*itkey>>(42-21*j))&s_nOctreeKeyMask;
+            vmin[j] = std::min(vmin[j], index);
+            vmax[j] = std::max(vmax[j], index);
+        }
+    }
+    for(int j = 0; j < 3; ++j) {
+        ab.pos[j] = ((dReal)((int64_t)vmin[j]+(int64_t)vmax[j]+1)*0.5 - s_nOctreeKeyOffset)*_resolution;
+        ab.extents[j] = (dReal)(vmax[j]-vmin[j]+1)*0.5*_resolution;
+    }
+    return ab;
+}
+
+void OctreeOccupancy::AppendTriangulation(TriMesh& trimesh) const
+{
+    dReal h = 0.5*_resolution;
+    FOREACHC(itkey, _vkeys) {
+        Vector center = _GetCenter(*itkey);
+        for(int axis = 0; axis < 3; ++axis) {
+            int shift = 42-21*axis;
+            uint64_t index = (*itkey>>shift)&s_nOctreeKeyMask;
+            for(int sign = -1; sign <= 1; sign += 2) {
+                if( (sign < 0 && index > 0) || (sign > 0 && index < s_nOctreeKeyMask) ) {
+                    uint64_t neighbor = (*itkey & ~(s_nOctreeKeyMask<<shift)) | ((index+sign)<<shift);
+                    if( std::binary_search(_vkeys.begin(), _vkeys.end(), neighbor) ) {
+                        continue; // face is inside the occupied space
+                    }
+                }
+                // corners of the face in counter-clockwise order when looking against the outward normal
+                Vector vnormal, vb, vc;
+                vnormal[axis] = sign*h;
+                vb[(axis+1)%3] = h;
+                vc[(axis+2)%3] = h;
+                if( sign < 0 ) {
+                    std::swap(vb, vc);
+                }
+                int offset = (int)trimesh.vertices.size();
+                trimesh.vertices.push_back(center+vnormal-vb-vc);
+                trimesh.vertices.push_back(center+vnormal+vb-vc);
+                trimesh.vertices.push_back(center+vnormal+vb+vc);
+                trimesh.vertices.push_back(center+vnormal-vb+vc);
+                trimesh.indices.push_back(offset); trimesh.indices.push_back(offset+1); trimesh.indices.push_back(offset+2);
+                trimesh.indices.push_back(offset); trimesh.indices.push_back(offset+2); trimesh.indices.push_back(offset+3);
+            }
+        }
+    }
+}
+
+bool OctreeOccupancy::_GetKey(const Vector& point, uint64_t& key) const
+{
+    key = 0;
+    for(int j = 0; j < 3; ++j) {
+        dReal f = point[j]/_resolution;
+        // also rejects nan and inf
+        if( !(RaveFabs(f) < (dReal)s_nOctreeKeyOffset) ) {
+            return false;
+        }
+        key = (key<<21) | (uint64_t)((int64_t)floor(f) + s_nOctreeKeyOffset);
+    }
+    return true;
+}
+
+Vector OctreeOccupancy::_GetCenter(uint64_t key) const
+{
+    Vector v;
+    for(int j = 0; j < 3; ++j) {
+        v[j] = ((dReal)((int64_t)((key>>(42-21*j))&s_nOctreeKeyMask) - s_nOctreeKeyOffset) + 0.5)*_resolution;
+    }
+    return v;
+}
+
+void OctreeOccupancy::_TrimChangeLog()
+{
+    // past this size, rebuilding from the voxels is cheaper than replaying the log
+    if( _vchangelog.size() <= 2*_vkeys.size()+4096 ) {
+        return;
+    }
+    // drop the older half, always dropping all the changes of a revision together
+    uint64_t droprevision = _vchangelog[_vchangelog.size()/2].first;
+    std::vector< std::pair<uint64_t, uint64_t> >::iterator itlast = std::upper_bound(_vchangelog.begin(), _vchangelog.end(), std::make_pair(droprevision, std::numeric_limits<uint64_t>::max()));
+    _vchangelog.erase(_vchangelog.begin(), itlast);
+    _changelogstartrevision = droprevision;
+}
+
 KinBody::GeometryInfo::GeometryInfo() : XMLReadable("geometry")
 {
     _vDiffuseColor = Vector(1,1,1);
@@ -276,6 +513,9 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
         }
         break;
     }
+    case GT_Octree:
+        _octree.AppendTriangulation(_meshcollision);
+        break;
     default:
         throw OPENRAVE_EXCEPTION_FORMAT(_("unrecognized geom type %d!"), _type, ORE_InvalidArguments);
     }
@@ -285,13 +525,21 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
 
 KinBody::Link::Geometry::Geometry(KinBody::LinkPtr parent, const KinBody::GeometryInfo& info) : _parent(parent), _info(info)
 {
+    _bCollisionMeshOutdated = false;
 }
 
 bool KinBody::Link::Geometry::InitCollisionMesh(float fTessellation)
 {
+    _bCollisionMeshOutdated = false;
     return _info.InitCollisionMesh(fTessellation);
 }
 
+void KinBody::Link::Geometry::_UpdateCollisionMesh() const
+{
+    _bCollisionMeshOutdated = false;
+    const_cast<KinBody::GeometryInfo&>(_info).InitCollisionMesh();
+}
+
 AABB KinBody::Link::Geometry::ComputeAABB(const Transform& t) const
 {
     AABB ab;
@@ -315,6 +563,14 @@ AABB KinBody::Link::Geometry::ComputeAABB(const Transform& t) const
         ab.extents.z = 0.5*(RaveFabs(tglobal.m[8])*_info._vGeomData.x + RaveFabs(tglobal.m[9])*_info._vGeomData.y + RaveFabs(tglobal.m[10])*_info._vGeomData.z);
         ab.pos = tglobal.trans + Vector(tglobal.m[2], tglobal.m[6], tglobal.m[10])*(0.5*_info._vGeomData.z);
         break;
+    case GT_Octree: {
+        AABB ablocal = _info._octree.ComputeAABB();
+        ab.extents.x = RaveFabs(tglobal.m[0])*ablocal.extents.x + RaveFabs(tglobal.m[1])*ablocal.extents.y + RaveFabs(tglobal.m[2])*ablocal.extents.z;
+        ab.extents.y = RaveFabs(tglobal.m[4])*ablocal.extents.x + RaveFabs(tglobal.m[5])*ablocal.extents.y + RaveFabs(tglobal.m[6])*ablocal.extents.z;
+        ab.extents.z = RaveFabs(tglobal.m[8])*ablocal.extents.x + RaveFabs(tglobal.m[9])*ablocal.extents.y + RaveFabs(tglobal.m[10])*ablocal.extents.z;
+        ab.pos = tglobal*ablocal.pos;
+        break;
+    }
     case GT_Sphere:
         ab.extents.x = ab.extents.y = ab.extents.z = _info._vGeomData[0];
         ab.pos = tglobal.trans;
@@ -372,6 +628,9 @@ void KinBody::Link::Geometry::serialize(std::ostream& o, int options) const
     if( _info._type == GT_TriMesh ) {
         _info._meshcollision.serialize(o,options);
     }
+    else if( _info._type == GT_Octree ) {
+        _info._octree.serialize(o,options);
+    }
     else {
         SerializeRound3(o,_info._vGeomData);
     }
@@ -385,6 +644,39 @@ void KinBody::Link::Geometry::SetCollisionMesh(const TriMesh& mesh)
     parent->_Update();
 }
 
+int KinBody::Link::Geometry::UpdateOctree(const std::vector<Vector>& vpoints, bool occupied)
+{
+    OPENRAVE_ASSERT_FORMAT0(_info._bModifiable, "geometry cannot be modified", ORE_Failed);
+    OPENRAVE_ASSERT_OP_FORMAT0(_info._type, ==, GT_Octree, "geometry is not an octree", ORE_InvalidArguments);
+    LinkPtr parent(_parent);
+    Transform tinv = (parent->GetTransform()*_info._t).inverse();
+    std::vector<Vector> vlocalpoints(vpoints.size());
+    for(size_t i = 0; i < vpoints.size(); ++i) {
+        vlocalpoints[i] = tinv*vpoints[i];
+    }
+    int numchanged = _info._octree.Update(vlocalpoints, occupied);
+    if( numchanged > 0 ) {
+        // triangulating all the voxels is expensive and checkers with native octrees never need it, so only do it on request
+        _bCollisionMeshOutdated = true;
+        parent->_bCollisionOutdated = true;
+        parent->GetParent()->_PostprocessChangedParameters(Prop_LinkOctree);
+    }
+    return numchanged;
+}
+
+void KinBody::Link::Geometry::ClearOctree()
+{
+    OPENRAVE_ASSERT_FORMAT0(_info._bModifiable, "geometry cannot be modified", ORE_Failed);
+    OPENRAVE_ASSERT_OP_FORMAT0(_info._type, ==, GT_Octree, "geometry is not an octree", ORE_InvalidArguments);
+    if( _info._octree.GetNumOccupied() > 0 ) {
+        LinkPtr parent(_parent);
+        _info._octree.Clear();
+        _bCollisionMeshOutdated = true;
+        parent->_bCollisionOutdated = true;
+        parent->GetParent()->_PostprocessChangedParameters(Prop_LinkOctree);
+    }
+}
+
 bool KinBody::Link::Geometry::SetVisible(bool visible)
 {
     if( _info._bVisible != visible ) {
@@ -26,6 +26,8 @@ KinBody::Link::Link(KinBodyPtr parent)
 {
     _parent = parent;
     _index = -1;
+    _nUpdateStampId = 0;
+    _bCollisionOutdated = false;
 }
 
 KinBody::Link::~Link()
@@ -39,7 +41,8 @@ void KinBody::Link::Enable(bool bEnable)
         KinBodyPtr parent = GetParent();
         parent->_nNonAdjacentLinkCache &= ~AO_Enabled;
         _info._bIsEnabled = bEnable;
-        GetParent()->_PostprocessChangedParameters(Prop_LinkEnable);
+        parent->_PostprocessChangedParameters(Prop_LinkEnable);
+        _nUpdateStampId = parent->_nUpdateStampId;
     }
 }
 
@@ -282,8 +285,14 @@ void KinBody::Link::SetStatic(bool bStatic)
 
 void KinBody::Link::SetTransform(const Transform& t)
 {
-    _info._t = t;
-    GetParent()->_nUpdateStampId++;
+    KinBodyPtr parent = GetParent();
+    parent->_nUpdateStampId++;
+    // only mark the link as changed if it actually moved, so checkers can skip the links that stay put
+    if( _info._t.rot.x != t.rot.x || _info._t.rot.y != t.rot.y || _info._t.rot.z != t.rot.z || _info._t.rot.w != t.rot.w || _info._t.trans.x != t.trans.x || _info._t.trans.y != t.trans.y || _info._t.trans.z != t.trans.z ) {
+        _info._t = t;
+        _nUpdateStampId = parent->_nUpdateStampId;
+    }
+    parent->_RecordChange();
 }
 
 void KinBody::Link::SetForce(const Vector& force, const Vector& pos, bool bAdd)
@@ -502,9 +511,15 @@ void KinBody::Link::_Update(bool parameterschanged)
             _collision.Append((*itgeom)->GetCollisionMesh(),(*itgeom)->GetTransform());
         }
     }
+    _bCollisionOutdated = false;
     if( parameterschanged ) {
         GetParent()->_PostprocessChangedParameters(Prop_LinkGeometry);
     }
 }
 
+void KinBody::Link::_UpdateCollisionData() const
+{
+    const_cast<KinBody::Link*>(this)->_Update(false);
+}
+
 }
@@ -481,6 +481,22 @@ public:
             _defaultviewertype = std::string(pOPENRAVE_DEFAULT_VIEWER);
         }
         
+        const char* pOPENRAVE_LOG_MODE = std::getenv("OPENRAVE_LOG_MODE");
+        if( !!pOPENRAVE_LOG_MODE && strlen(pOPENRAVE_LOG_MODE) > 0 ) {
+            std::string logmode(pOPENRAVE_LOG_MODE);
+            if( logmode == "async" ) {
+                if( !RaveSetLogMode(LM_Async) ) {
+                    RAVELOG_WARN("asynchronous logging is not supported\n");
+                }
+            }
+            else if( logmode == "direct" ) {
+                RaveSetLogMode(LM_Direct);
+            }
+            else {
+                RAVELOG_WARN_FORMAT("unknown OPENRAVE_LOG_MODE %s", logmode);
+            }
+        }
+
         _UpdateDataDirs();
         return 0;
     }
@@ -528,6 +544,7 @@ public:
         crlibm_exit(_crlibm_fpu_state);
 #endif
 
+        RaveFlushLog();
 #if OPENRAVE_LOG4CXX
         _logger = 0;
 #endif
@@ -2233,6 +2250,35 @@ void DummyXMLReader::characters(const std::string& ch)
     }
 }
 
+EnvironmentChangeJournal::EnvironmentChangeJournal() : _nStamp(0), _nFirstStamp(0)
+{
+}
+
+bool EnvironmentChangeJournal::GetChangedBodies(int& nstamp, std::vector<int>& vbodyids)
+{
+    vbodyids.resize(0);
+    bool bvalid = nstamp >= _nFirstStamp;
+    if( bvalid ) {
+        std::vector< std::pair<int, int> >::const_iterator itchange = std::lower_bound(_vchanges.begin(), _vchanges.end(), std::make_pair(nstamp, std::numeric_limits<int>::min()));
+        for(; itchange != _vchanges.end(); ++itchange) {
+            vbodyids.push_back(itchange->second);
+        }
+    }
+    ++_nStamp;
+    nstamp = _nStamp;
+    return bvalid;
+}
+
+void EnvironmentChangeJournal::RecordChange(int environmentid)
+{
+    // every body is recorded at most once per stamp, so the journal only grows between reads
+    if( _vchanges.size() >= 4096 && _vchanges.front().first < _nStamp ) {
+        _vchanges.erase(_vchanges.begin(), std::lower_bound(_vchanges.begin(), _vchanges.end(), std::make_pair(_nStamp, std::numeric_limits<int>::min())));
+        _nFirstStamp = _nStamp;
+    }
+    _vchanges.push_back(std::make_pair(_nStamp, environmentid));
+}
+
 EnvironmentBase::EnvironmentBase()
 {
     if( !RaveGlobalState() ) {
@@ -2240,6 +2286,7 @@ EnvironmentBase::EnvironmentBase()
         RaveInitialize(true);
     }
     __nUniqueId = RaveGlobal::instance()->RegisterEnvironment(this);
+    __pChangeJournal.reset(new EnvironmentChangeJournal());
 }
 
 EnvironmentBase::~EnvironmentBase()
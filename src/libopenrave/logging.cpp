@@ -0,0 +1,460 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2006-2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+#include <cstdarg>
+
+#if BOOST_VERSION >= 105300 && !OPENRAVE_LOG4CXX
+#include <boost/atomic.hpp>
+#define OPENRAVE_ASYNC_LOGGING 1
+#endif
+
+namespace OpenRAVE {
+
+static volatile int s_nLogMode = LM_Direct;
+
+#ifdef OPENRAVE_ASYNC_LOGGING
+
+static const uint32_t s_nLogRingSize = 1<<16; ///< bytes of the message buffer of every thread, power of 2
+static const uint32_t s_nLogMaxMessageSize = 8192; ///< longer messages are truncated
+static const uint32_t s_nLogMaxLocationSize = 255; ///< longer filenames and functions are truncated
+static const int s_nLogWriterPeriod = 5; ///< maximum milliseconds between the writes of the background thread
+
+/// \brief header of a message in a ring, followed by the characters of the filename, the function and the message
+///
+/// The filename and function are copied since the writer can print them after the plugin that logged them was unloaded.
+struct LogRecordHeader
+{
+    uint32_t size; ///< bytes of the record including the header, multiple of 8
+    int32_t level; ///< -1 for the unused bytes at the end of the ring
+    int32_t line;
+    uint32_t length; ///< characters of the message
+    uint64_t sequence; ///< global order of the messages of all threads
+    uint16_t filenamelength; ///< characters of the filename, 0 if there is no location
+    uint16_t functionlength; ///< characters of the function
+};
+
+/// \brief messages of one thread. Only that thread pushes and only the writer pops, so the two positions are the only shared state.
+class LogRing
+{
+public:
+    LogRing() : _bRetired(false), _head(0), _tail(0), _numdropped(0) {
+        _vbuffer.resize(s_nLogRingSize);
+    }
+
+    /// \brief copies the message into the ring, called by the owning thread
+    ///
+    /// \param bHalfFull set to true if the ring became more than half full with this message
+    /// \return false if there is not enough space
+    bool Push(int level, const char* filename, int line, const char* function, uint64_t sequence, const char* message, uint32_t length, bool& bHalfFull)
+    {
+        uint32_t filenamelength = 0, functionlength = 0;
+        if( !!filename ) {
+            filename = RaveGetSourceFilename(filename);
+            filenamelength = min((uint32_t)strlen(filename), s_nLogMaxLocationSize);
+            if( !!function ) {
+                functionlength = min((uint32_t)strlen(function), s_nLogMaxLocationSize);
+            }
+        }
+        uint32_t size = (sizeof(LogRecordHeader)+filenamelength+functionlength+length+7)&~7u;
+        uint32_t head = _head.load(boost::memory_order_relaxed);
+        uint32_t tail = _tail.load(boost::memory_order_acquire);
+        uint32_t offset = head&(s_nLogRingSize-1);
+        // records are contiguous, so skip the end of the ring if the record does not fit
+        uint32_t padding = offset+size > s_nLogRingSize ? s_nLogRingSize-offset : 0;
+        if( (head-tail)+padding+size > s_nLogRingSize ) {
+            _numdropped.store(_numdropped.load(boost::memory_order_relaxed)+1, boost::memory_order_relaxed);
+            return false;
+        }
+        if( padding >= sizeof(LogRecordHeader) ) {
+            LogRecordHeader* ppadding = reinterpret_cast<LogRecordHeader*>(&_vbuffer[offset]);
+            ppadding->size = padding;
+            ppadding->level = -1;
+        }
+        if( padding > 0 ) {
+            offset = 0;
+        }
+        LogRecordHeader* pheader = reinterpret_cast<LogRecordHeader*>(&_vbuffer[offset]);
+        pheader->size = size;
+        pheader->level = level;
+        pheader->line = line;
+        pheader->length = length;
+        pheader->sequence = sequence;
+        pheader->filenamelength = filenamelength;
+        pheader->functionlength = functionlength;
+        char* pdata = &_vbuffer[offset+sizeof(LogRecordHeader)];
+        memcpy(pdata, filename, filenamelength);
+        memcpy(pdata+filenamelength, function, functionlength);
+        if( length > 0 ) {
+            memcpy(pdata+filenamelength+functionlength, message, length);
+        }
+        _head.store(head+padding+size, boost::memory_order_release);
+        bHalfFull = (head-tail) <= s_nLogRingSize/2 && (head+padding+size-tail) > s_nLogRingSize/2;
+        return true;
+    }
+
+    /// \brief appends the records that were pushed so far, they stay valid until \ref Release
+    ///
+    /// \return the position to release
+    uint32_t Collect(std::vector<const LogRecordHeader*>& vrecords) const
+    {
+        uint32_t tail = _tail.load(boost::memory_order_relaxed);
+        uint32_t head = _head.load(boost::memory_order_acquire);
+        while(tail != head) {
+            uint32_t offset = tail&(s_nLogRingSize-1);
+            if( s_nLogRingSize-offset < sizeof(LogRecordHeader) ) {
+                tail += s_nLogRingSize-offset;
+                continue;
+            }
+            const LogRecordHeader* pheader = reinterpret_cast<const LogRecordHeader*>(&_vbuffer[offset]);
+            if( pheader->level >= 0 ) {
+                vrecords.push_back(pheader);
+            }
+            tail += pheader->size;
+        }
+        return tail;
+    }
+
+    /// \brief frees the space of the collected records
+    void Release(uint32_t tail)
+    {
+        _tail.store(tail, boost::memory_order_release);
+    }
+
+    inline bool IsEmpty() const {
+        return _head.load(boost::memory_order_acquire) == _tail.load(boost::memory_order_relaxed);
+    }
+
+    inline uint64_t GetNumDropped() const {
+        return _numdropped.load(boost::memory_order_relaxed);
+    }
+
+    boost::atomic<bool> _bRetired; ///< true if the thread exited
+
+private:
+    std::vector<char> _vbuffer;
+    boost::atomic<uint32_t> _head, _tail; ///< increase monotonically and wrap around
+    boost::atomic<uint64_t> _numdropped;
+};
+typedef boost::shared_ptr<LogRing> LogRingPtr;
+
+static bool CompareLogRecordSequence(const LogRecordHeader* pheader0, const LogRecordHeader* pheader1)
+{
+    return pheader0->sequence < pheader1->sequence;
+}
+
+static void FlushLogAtExit();
+
+/// \brief rings of all threads and the thread that prints them
+class LogRegistry
+{
+public:
+    LogRegistry() : _threadring(&LogRegistry::_RetireRing), _sequence(0), _numretireddropped(0), _numreporteddropped(0), _bStopWriter(false), _bRegisteredExit(false) {
+    }
+
+    bool SetMode(int mode)
+    {
+        boost::mutex::scoped_lock lock(_mutexMode);
+        if( mode == LM_Async ) {
+            if( !_threadWriter ) {
+                _bStopWriter = false;
+                _threadWriter.reset(new boost::thread(boost::bind(&LogRegistry::_WriterThread, this)));
+            }
+            if( !_bRegisteredExit ) {
+                // the writer thread is not joined at exit, so print the remaining messages
+                atexit(FlushLogAtExit);
+                _bRegisteredExit = true;
+            }
+            s_nLogMode = LM_Async;
+        }
+        else {
+            s_nLogMode = mode;
+            if( !!_threadWriter ) {
+                _bStopWriter = true;
+                _threadWriter->join();
+                _threadWriter.reset();
+            }
+            Flush();
+        }
+        return true;
+    }
+
+    int Push(int level, const char* filename, int line, const char* function, const char* message, uint32_t length)
+    {
+        if( length > 0 && message[length-1] == '\n' ) {
+            --length;
+        }
+        if( length > s_nLogMaxMessageSize ) {
+            length = s_nLogMaxMessageSize;
+        }
+        LogRingPtr* ppring = _threadring.get();
+        if( !ppring ) {
+            ppring = new LogRingPtr(new LogRing());
+            _threadring.reset(ppring);
+            boost::mutex::scoped_lock lock(_mutexRings);
+            _listRings.push_back(*ppring);
+        }
+        uint64_t sequence = _sequence.fetch_add(1, boost::memory_order_relaxed);
+        bool bHalfFull = false;
+        if( !(*ppring)->Push(level, filename, line, function, sequence, message, length, bHalfFull) ) {
+            return -1;
+        }
+        if( bHalfFull ) {
+            // only happens once per filling of the ring, so the writer is rarely signaled
+            _condWriter.notify_one();
+        }
+        return (int)length;
+    }
+
+    /// \brief prints all the collected messages in the order they were pushed
+    void Flush()
+    {
+        boost::mutex::scoped_lock lockwrite(_mutexWrite);
+        std::vector<LogRingPtr> vrings;
+        {
+            boost::mutex::scoped_lock lock(_mutexRings);
+            vrings.assign(_listRings.begin(), _listRings.end());
+        }
+        _vrecords.resize(0);
+        std::vector<uint32_t> vtails(vrings.size());
+        for(size_t iring = 0; iring < vrings.size(); ++iring) {
+            vtails[iring] = vrings[iring]->Collect(_vrecords);
+        }
+        std::sort(_vrecords.begin(), _vrecords.end(), CompareLogRecordSequence);
+        _output.resize(0);
+        FOREACHC(itrecord, _vrecords) {
+            _AppendRecord(**itrecord);
+        }
+        uint64_t numdropped = _numretireddropped;
+        FOREACHC(itring, vrings) {
+            numdropped += (*itring)->GetNumDropped();
+        }
+        if( numdropped > _numreporteddropped ) {
+            char buf[128];
+            int len = snprintf(buf, sizeof(buf), "dropped %u log messages because the thread buffers were full", (unsigned int)(numdropped-_numreporteddropped));
+            _numreporteddropped = numdropped;
+            _AppendMessage(Level_Warn, NULL, 0, 0, NULL, 0, buf, len);
+        }
+        if( _output.size() > 0 ) {
+            fwrite(&_output[0], 1, _output.size(), stdout);
+            fflush(stdout);
+        }
+        for(size_t iring = 0; iring < vrings.size(); ++iring) {
+            vrings[iring]->Release(vtails[iring]);
+        }
+
+        // remove the rings of the threads that exited once they are empty
+        boost::mutex::scoped_lock lock(_mutexRings);
+        std::list<LogRingPtr>::iterator itring = _listRings.begin();
+        while(itring != _listRings.end()) {
+            if( (*itring)->_bRetired.load() && (*itring)->IsEmpty() ) {
+                _numretireddropped += (*itring)->GetNumDropped();
+                itring = _listRings.erase(itring);
+            }
+            else {
+                ++itring;
+            }
+        }
+    }
+
+    uint64_t GetDropCount()
+    {
+        boost::mutex::scoped_lock lock(_mutexRings);
+        uint64_t numdropped = _numretireddropped;
+        FOREACHC(itring, _listRings) {
+            numdropped += (*itring)->GetNumDropped();
+        }
+        return numdropped;
+    }
+
+private:
+    void _WriterThread()
+    {
+        while(!_bStopWriter) {
+            {
+                boost::mutex::scoped_lock lock(_mutexWriter);
+                _condWriter.timed_wait(lock, boost::posix_time::milliseconds(s_nLogWriterPeriod));
+            }
+            Flush();
+        }
+    }
+
+    void _AppendRecord(const LogRecordHeader& header)
+    {
+        const char* pdata = reinterpret_cast<const char*>(&header+1);
+        _AppendMessage(header.level, pdata, header.filenamelength, header.line, pdata+header.filenamelength, header.functionlength, pdata+header.filenamelength+header.functionlength, header.length);
+    }
+
+    /// \brief formats the message like the RAVELOG macros do in \ref LM_Direct mode
+    ///
+    /// \param filenamelength 0 if there is no location to print
+    void _AppendMessage(int level, const char* filename, uint32_t filenamelength, int line, const char* function, uint32_t functionlength, const char* message, uint32_t length)
+    {
+        int color = -1;
+        switch(level&Level_OutputMask) {
+        case Level_Fatal: color = OPENRAVECOLOR_FATALLEVEL; break;
+        case Level_Error: color = OPENRAVECOLOR_ERRORLEVEL; break;
+        case Level_Warn: color = OPENRAVECOLOR_WARNLEVEL; break;
+        case Level_Debug: color = OPENRAVECOLOR_DEBUGLEVEL; break;
+        case Level_Verbose: color = OPENRAVECOLOR_VERBOSELEVEL; break;
+        }
+        char buf[512];
+#ifndef _WIN32
+        if( color >= 0 ) {
+            int len = snprintf(buf, sizeof(buf), "%c[0;%d;%dm", 0x1B, color+30, 8+40);
+            _output.insert(_output.end(), buf, buf+len);
+        }
+#endif
+        if( filenamelength > 0 ) {
+            int len = snprintf(buf, sizeof(buf), "[%.*s:%d %.*s] ", (int)filenamelength, filename, line, (int)functionlength, function);
+            _output.insert(_output.end(), buf, buf+min(len, (int)sizeof(buf)-1));
+        }
+        _output.insert(_output.end(), message, message+length);
+#ifndef _WIN32
+        if( color >= 0 ) {
+            int len = snprintf(buf, sizeof(buf), "%c[0;38;48m", 0x1B);
+            _output.insert(_output.end(), buf, buf+len);
+        }
+#endif
+        _output.push_back('\n');
+    }
+
+    /// \brief called when a thread exits, its ring is removed once the writer printed it
+    static void _RetireRing(LogRingPtr* ppring)
+    {
+        (*ppring)->_bRetired.store(true);
+        delete ppring;
+    }
+
+    boost::thread_specific_ptr<LogRingPtr> _threadring;
+    boost::atomic<uint64_t> _sequence;
+
+    boost::mutex _mutexRings; ///< protects _listRings and _numretireddropped
+    std::list<LogRingPtr> _listRings;
+    uint64_t _numretireddropped; ///< messages dropped by the threads whose rings were removed
+
+    boost::mutex _mutexWrite; ///< only one thread prints at a time
+    std::vector<const LogRecordHeader*> _vrecords;
+    std::vector<char> _output;
+    uint64_t _numreporteddropped;
+
+    boost::mutex _mutexMode;
+    boost::shared_ptr<boost::thread> _threadWriter;
+    boost::mutex _mutexWriter;
+    boost::condition_variable _condWriter; ///< wakes up the writer before its period when a ring is half full
+    volatile bool _bStopWriter;
+    bool _bRegisteredExit;
+};
+
+/// never destroyed so that threads logging during the static destruction can still use it
+static LogRegistry& GetLogRegistry()
+{
+    static LogRegistry* s_pregistry = new LogRegistry();
+    return *s_pregistry;
+}
+
+static void FlushLogAtExit()
+{
+    GetLogRegistry().Flush();
+}
+
+#endif
+
+bool RaveSetLogMode(int mode)
+{
+    if( mode == LM_Direct ) {
+#ifdef OPENRAVE_ASYNC_LOGGING
+        return GetLogRegistry().SetMode(mode);
+#else
+        s_nLogMode = mode;
+        return true;
+#endif
+    }
+#ifdef OPENRAVE_ASYNC_LOGGING
+    if( mode == LM_Async ) {
+        return GetLogRegistry().SetMode(mode);
+    }
+#endif
+    return false;
+}
+
+int RaveGetLogMode()
+{
+    return s_nLogMode;
+}
+
+void RaveFlushLog()
+{
+#ifdef OPENRAVE_ASYNC_LOGGING
+    GetLogRegistry().Flush();
+#endif
+    fflush(stdout);
+}
+
+uint64_t RaveGetLogDropCount()
+{
+#ifdef OPENRAVE_ASYNC_LOGGING
+    return GetLogRegistry().GetDropCount();
+#else
+    return 0;
+#endif
+}
+
+int RaveLogAsync(int level, const char* filename, int line, const char* function, const std::string& s)
+{
+#ifdef OPENRAVE_ASYNC_LOGGING
+    return GetLogRegistry().Push(level, filename, line, function, s.c_str(), s.size());
+#else
+    return RavePrintfA(s, level);
+#endif
+}
+
+int RaveLogAsync(int level, const char* filename, int line, const char* function, const char* fmt, ...)
+{
+    char buf[512];
+    va_list list;
+    va_start(list, fmt);
+    int r = vsnprintf(buf, sizeof(buf), fmt, list);
+    va_end(list);
+    if( r < 0 ) {
+        return r;
+    }
+    if( r < (int)sizeof(buf) ) {
+#ifdef OPENRAVE_ASYNC_LOGGING
+        return GetLogRegistry().Push(level, filename, line, function, buf, r);
+#else
+        return RavePrintfA(std::string(buf, r), level);
+#endif
+    }
+    std::vector<char> vbuf(r+1);
+    va_start(list, fmt);
+    r = vsnprintf(&vbuf[0], vbuf.size(), fmt, list);
+    va_end(list);
+    if( r < 0 ) {
+        return r;
+    }
+#ifdef OPENRAVE_ASYNC_LOGGING
+    return GetLogRegistry().Push(level, filename, line, function, &vbuf[0], r);
+#else
+    return RavePrintfA(std::string(&vbuf[0], r), level);
+#endif
+}
+
+}
@@ -1994,7 +1994,7 @@ void GetDHParameters(std::vector<DHParameter>& vparameters, KinBodyConstPtr pbod
     }
 }
 
-DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(0), _perturbation(0.1)
+DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(0), _perturbation(0.1), _bContinuousCollisionChecking(false), _fSegmentStateTime(0), _nSegmentStateIndex(0), _nSegmentInvalidStateIndex(0), _bBatchSegmentTorques(false), _bRecordSegmentStates(false)
 {
     BOOST_ASSERT(listCheckBodies.size()>0);
     _report.reset(new CollisionReport());
@@ -2034,6 +2034,11 @@ void DynamicsCollisionConstraint::SetPerturbation(dReal perturbation)
     _perturbation = perturbation;
 }
 
+void DynamicsCollisionConstraint::SetContinuousCollisionChecking(bool bContinuousCollisionChecking)
+{
+    _bContinuousCollisionChecking = bContinuousCollisionChecking;
+}
+
 int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
     if( params->SetStateValues(vdofvalues, 0) != 0 ) {
@@ -2042,6 +2047,14 @@ int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParameter
     if( (options & CFO_CheckTimeBasedConstraints) && !!_setvelstatefn && vdofvelocities.size() == vdofvalues.size() ) {
         (*_setvelstatefn)(vdofvelocities);
     }
+    if( _bRecordSegmentStates ) {
+        _AddSegmentTorqueState(vdofvalues, vdofvelocities, vdofaccels);
+        return 0;
+    }
+    if( _bBatchSegmentTorques && _nSegmentStateIndex++ == _nSegmentInvalidStateIndex ) {
+        // the states are set in the same order as they were recorded, so this is the state whose torques are invalid
+        return CFO_CheckTimeBasedConstraints;
+    }
     int nstateret = _CheckState(vdofvelocities, vdofaccels, options, filterreturn);
     if( nstateret != 0 ) {
         return nstateret;
@@ -2072,6 +2085,126 @@ int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParameter
     return 0;
 }
 
+void DynamicsCollisionConstraint::_GetTorqueLimits(KinBodyPtr pbody)
+{
+    _vtorquevalues.resize(0);
+    FOREACHC(itjoint, pbody->GetJoints()) {
+        for(int idof = 0; idof < (*itjoint)->GetDOF(); ++idof) {
+            // TODO use the ElectricMotorActuatorInfo if present to get the real max torque depending on the speed
+            std::pair<dReal, dReal> torquelimits;
+            if( _torquelimitmode == 1 ) {
+                torquelimits = (*itjoint)->GetInstantaneousTorqueLimits(idof);
+            }
+            else { // _torquelimitmode == 0
+                torquelimits = (*itjoint)->GetNominalTorqueLimits(idof);
+            }
+
+            if( torquelimits.first < torquelimits.second ) {
+                _vtorquevalues.push_back(make_pair((*itjoint)->GetDOFIndex()+idof,torquelimits));
+            }
+        }
+    }
+}
+
+bool DynamicsCollisionConstraint::_CanBatchSegmentTorqueLimits()
+{
+    FOREACHC(itbody, _listCheckBodies) {
+        FOREACHC(itjoint, (*itbody)->GetJoints()) {
+            ElectricMotorActuatorInfoPtr infoElectricMotor = (*itjoint)->GetInfo()._infoElectricMotor;
+            if( !!infoElectricMotor && (_torquelimitmode == 1 ? infoElectricMotor->max_speed_torque_points.size() : infoElectricMotor->nominal_speed_torque_points.size()) > 1 ) {
+                // torque limits depend on the speed of every state
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void DynamicsCollisionConstraint::_AddSegmentTorqueState(const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels)
+{
+    _vsegmenttimes.push_back(_fSegmentStateTime);
+
+    _vsegmentdofvalues.resize(_listCheckBodies.size());
+    _vsegmentdofvelocities.resize(_listCheckBodies.size());
+    _vsegmentdofaccelerations.resize(_listCheckBodies.size());
+    size_t ibody = 0;
+    FOREACHC(itbody, _listCheckBodies) {
+        KinBodyPtr pbody = *itbody;
+        int dof = pbody->GetDOF();
+        // dofs that are not part of the configuration keep their current values and velocities, so take the state that was set
+        pbody->GetDOFValues(_vcurdofvalues);
+        _vsegmentdofvalues[ibody].insert(_vsegmentdofvalues[ibody].end(), _vcurdofvalues.begin(), _vcurdofvalues.end());
+        pbody->GetDOFVelocities(_vcurdofvalues);
+        _vsegmentdofvelocities[ibody].insert(_vsegmentdofvelocities[ibody].end(), _vcurdofvalues.begin(), _vcurdofvalues.end());
+        size_t offset = _vsegmentdofaccelerations[ibody].size();
+        _vsegmentdofaccelerations[ibody].resize(offset+dof, 0);
+        if( vdofaccels.size() > 0 ) {
+            _vdofindices.resize(dof);
+            for(int i = 0; i < dof; ++i) {
+                _vdofindices[i] = i;
+            }
+            _specvel.ExtractJointValues(_vsegmentdofaccelerations[ibody].begin()+offset, vdofaccels.begin(), pbody, _vdofindices, 1);
+        }
+        ++ibody;
+    }
+}
+
+int DynamicsCollisionConstraint::_CheckSegmentTorqueLimits(size_t& iInvalidState)
+{
+    int nret = 0;
+    size_t numstates = _vsegmenttimes.size();
+    iInvalidState = numstates;
+    size_t ibody = 0;
+    FOREACHC(itbody, _listCheckBodies) {
+        KinBodyPtr pbody = *itbody;
+        const std::vector<dReal>& vdofvalues = _vsegmentdofvalues.at(ibody), &vdofvelocities = _vsegmentdofvelocities.at(ibody), &vdofaccelerations = _vsegmentdofaccelerations.at(ibody);
+        ++ibody;
+        _GetTorqueLimits(pbody);
+        if( _vtorquevalues.size() == 0 || numstates == 0 ) {
+            continue;
+        }
+        int dof = pbody->GetDOF();
+        try {
+            pbody->ComputeInverseDynamics(_vsegmentdoftorques, vdofvalues, vdofvelocities, vdofaccelerations);
+        }
+        catch(const openrave_exception& ex) {
+            if( ex.GetCode() != ORE_NotImplemented ) {
+                throw;
+            }
+            // compute the torques of every state one by one
+            RAVELOG_VERBOSE_FORMAT("cannot check torques of segment in batch: %s", ex.what());
+            KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities);
+            _vsegmentdoftorques.resize(numstates*dof);
+            for(size_t istate = 0; istate < numstates; ++istate) {
+                _vcurdofvalues.assign(vdofvalues.begin()+istate*dof, vdofvalues.begin()+(istate+1)*dof);
+                pbody->SetDOFValues(_vcurdofvalues, KinBody::CLA_Nothing);
+                _vcurdofvalues.assign(vdofvelocities.begin()+istate*dof, vdofvelocities.begin()+(istate+1)*dof);
+                pbody->SetDOFVelocities(_vcurdofvalues, KinBody::CLA_Nothing);
+                _dofaccelerations.assign(vdofaccelerations.begin()+istate*dof, vdofaccelerations.begin()+(istate+1)*dof);
+                pbody->ComputeInverseDynamics(_doftorques, _dofaccelerations);
+                std::copy(_doftorques.begin(), _doftorques.end(), _vsegmentdoftorques.begin()+istate*dof);
+            }
+        }
+
+        // only the states before the earliest violation of the previous bodies matter
+        for(size_t istate = 0; istate < iInvalidState; ++istate) {
+            const dReal* ptorques = &_vsegmentdoftorques[istate*dof];
+            FOREACHC(it, _vtorquevalues) {
+                dReal fcurtorque = ptorques[it->first];
+                if( fcurtorque < it->second.first || fcurtorque > it->second.second ) {
+                    if( IS_DEBUGLEVEL(Level_Verbose) ) {
+                        _PrintOnFailure(str(boost::format("rejected torque at time %f due to joint %s (%d): %e !< %e !< %e")%_vsegmenttimes[istate]%pbody->GetJointFromDOFIndex(it->first)->GetName()%it->first%it->second.first%fcurtorque%it->second.second));
+                    }
+                    iInvalidState = istate;
+                    nret = CFO_CheckTimeBasedConstraints;
+                    break;
+                }
+            }
+        }
+    }
+    return nret;
+}
+
 int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
     options &= _filtermask;
@@ -2083,27 +2216,11 @@ int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofveloc
             return CFO_CheckUserConstraints;
         }
     }
-    if( options & CFO_CheckTimeBasedConstraints ) {
+    if( (options & CFO_CheckTimeBasedConstraints) && !_bBatchSegmentTorques ) {
         // check dynamics
         FOREACHC(itbody, _listCheckBodies) {
             KinBodyPtr pbody = *itbody;
-            _vtorquevalues.resize(0);
-            FOREACHC(itjoint, pbody->GetJoints()) {
-                for(int idof = 0; idof < (*itjoint)->GetDOF(); ++idof) {
-                    // TODO use the ElectricMotorActuatorInfo if present to get the real max torque depending on the speed
-                    std::pair<dReal, dReal> torquelimits;
-                    if( _torquelimitmode == 1 ) {
-                        torquelimits = (*itjoint)->GetInstantaneousTorqueLimits(idof);
-                    }
-                    else { // _torquelimitmode == 0
-                        torquelimits = (*itjoint)->GetNominalTorqueLimits(idof);
-                    }
-
-                    if( torquelimits.first < torquelimits.second ) {
-                        _vtorquevalues.push_back(make_pair((*itjoint)->GetDOFIndex()+idof,torquelimits));
-                    }
-                }
-            }
+            _GetTorqueLimits(pbody);
             if( _vtorquevalues.size() > 0 && vdofaccels.size() > 0 ) {
                 _doftorques.resize(pbody->GetDOF(),0);
                 _dofaccelerations.resize(pbody->GetDOF(),0);
@@ -2167,6 +2284,104 @@ int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofveloc
     return 0;
 }
 
+int DynamicsCollisionConstraint::_CheckContinuousCollisions(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& dQ, dReal fStartTime, dReal fEndTime, int options, dReal& fTimeWhenInvalid)
+{
+    // get the DOF values of every body at both ends of the segment
+    size_t numbodies = _listCheckBodies.size();
+    _vcontinuousdofvalues.resize(2*numbodies);
+    _vcontinuoustransforms.resize(2*numbodies);
+    _vcontinuousconfig.resize(q0.size());
+    for(int iend = 0; iend < 2; ++iend) {
+        dReal ftime = iend == 0 ? fStartTime : fEndTime;
+        for(size_t idof = 0; idof < q0.size(); ++idof) {
+            _vcontinuousconfig[idof] = q0[idof] + ftime*dQ[idof];
+        }
+        if( params->SetStateValues(_vcontinuousconfig, 0) != 0 ) {
+            return CFO_StateSettingError;
+        }
+        size_t ibody = 0;
+        FOREACHC(itbody, _listCheckBodies) {
+            (*itbody)->GetDOFValues(_vcontinuousdofvalues[2*ibody+iend]);
+            _vcontinuoustransforms[2*ibody+iend] = (*itbody)->GetTransform();
+            ++ibody;
+        }
+    }
+
+    // the queries move one body while the others stay still, and keep the base transforms fixed
+    int nummovingbodies = 0;
+    size_t ibody = 0;
+    FOREACHC(itbody, _listCheckBodies) {
+        const Transform& t0 = _vcontinuoustransforms[2*ibody], &t1 = _vcontinuoustransforms[2*ibody+1];
+        if( (t0.trans-t1.trans).lengthsqr3() > g_fEpsilonLinear*g_fEpsilonLinear || RaveFabs(RaveFabs(t0.rot.dot(t1.rot))-1) > g_fEpsilonLinear ) {
+            return -1;
+        }
+        if( _vcontinuousdofvalues[2*ibody] != _vcontinuousdofvalues[2*ibody+1] ) {
+            ++nummovingbodies;
+        }
+        if( (options & CFO_CheckSelfCollisions) && (*itbody)->IsRobot() ) {
+            // the continuous self-collision query does not check the grabbed bodies against the robot
+            std::vector<KinBodyPtr> vgrabbed;
+            RaveInterfaceCast<RobotBase>(*itbody)->GetGrabbed(vgrabbed);
+            if( vgrabbed.size() > 0 ) {
+                return -1;
+            }
+        }
+        ++ibody;
+    }
+    if( nummovingbodies > 1 ) {
+        return -1;
+    }
+
+    int nret = 0;
+    CollisionCheckerBasePtr pchecker = _listCheckBodies.front()->GetEnv()->GetCollisionChecker();
+    try {
+        ibody = 0;
+        FOREACHC(itbody, _listCheckBodies) {
+            const std::vector<dReal>& vdofvalues0 = _vcontinuousdofvalues[2*ibody], &vdofvalues1 = _vcontinuousdofvalues[2*ibody+1];
+            if( (options & CFO_CheckEnvCollisions) && pchecker->CheckContinuousCollision(*itbody, vdofvalues0, vdofvalues1, fTimeWhenInvalid, _report) ) {
+                nret = CFO_CheckEnvCollisions;
+                break;
+            }
+            if( options & CFO_CheckSelfCollisions ) {
+                CollisionCheckerBasePtr pselfchecker = (*itbody)->GetSelfCollisionChecker();
+                if( !pselfchecker ) {
+                    pselfchecker = pchecker;
+                }
+                else {
+                    // same as KinBody::CheckSelfCollision
+                    pselfchecker->SetCollisionOptions(pchecker->GetCollisionOptions());
+                }
+                if( pselfchecker->CheckContinuousStandaloneSelfCollision(*itbody, vdofvalues0, vdofvalues1, fTimeWhenInvalid, _report) ) {
+                    nret = CFO_CheckSelfCollisions;
+                    break;
+                }
+            }
+            ++ibody;
+        }
+    }
+    catch(const openrave_exception& ex) {
+        if( ex.GetCode() != ORE_NotImplemented ) {
+            throw;
+        }
+        RAVELOG_WARN_FORMAT("env=%d, disabling continuous collision checking, the segments will be discretized: %s", pchecker->GetEnv()->GetId()%ex.what());
+        _bContinuousCollisionChecking = false;
+        nret = -1;
+    }
+
+    if( nret > 0 ) {
+        fTimeWhenInvalid = fStartTime + fTimeWhenInvalid*(fEndTime-fStartTime);
+    }
+
+    // the interpolation expects the state to be at the start of the segment
+    if( params->SetStateValues(q0, 0) != 0 ) {
+        return CFO_StateSettingError;
+    }
+    if( nret > 0 && IS_DEBUGLEVEL(Level_Verbose) ) {
+        _PrintOnFailure(str(boost::format("continuous collision failed at %f ")%fTimeWhenInvalid)+_report->__str__());
+    }
+    return nret;
+}
+
 void DynamicsCollisionConstraint::_PrintOnFailure(const std::string& prefix)
 {
     if( IS_DEBUGLEVEL(Level_Verbose) ) {
@@ -2209,6 +2424,53 @@ inline std::ostream& RaveSerializeValues(std::ostream& O, const std::vector<dRea
 }
 
 int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, IntervalType interval, int options, ConstraintFilterReturnPtr filterreturn)
+{
+    OPENRAVE_PROFILE_SCOPE("DynamicsCollisionConstraint::Check");
+    _bBatchSegmentTorques = false;
+    if( (options & _filtermask & CFO_CheckTimeBasedConstraints) && timeelapsed > 0 && dq0.size() == q0.size() && dq1.size() == q0.size() && _CanBatchSegmentTorqueLimits() ) {
+        // set and record the states of the segment without checking them, and compute all their torques in one batch
+        // so that a torque violation is found before any collision of the segment is checked
+        _fSegmentStateTime = 0;
+        _vsegmenttimes.resize(0);
+        FOREACH(it, _vsegmentdofvalues) {
+            it->resize(0);
+        }
+        FOREACH(it, _vsegmentdofvelocities) {
+            it->resize(0);
+        }
+        FOREACH(it, _vsegmentdofaccelerations) {
+            it->resize(0);
+        }
+        _bRecordSegmentStates = true;
+        int nrecordret;
+        try {
+            nrecordret = _CheckSegment(q0, q1, dq0, dq1, timeelapsed, interval, options&~CFO_FillCheckedConfiguration, ConstraintFilterReturnPtr());
+        }
+        catch(...) {
+            _bRecordSegmentStates = false;
+            throw;
+        }
+        _bRecordSegmentStates = false;
+        // if recording stopped early, the check below stops at the same state
+        int ntorqueret = _CheckSegmentTorqueLimits(_nSegmentInvalidStateIndex);
+        int maskoptions = options&_filtermask;
+        bool bCheckUserConstraints = (maskoptions & CFO_CheckUserConstraints) && (!!_usercheckfns[0] || !!_usercheckfns[1]);
+        if( nrecordret == 0 && ntorqueret == 0 && !bCheckUserConstraints && !(maskoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions)) && !(options & CFO_FillCheckedConfiguration) ) {
+            // only the torques had to be checked, so no need to set the states again
+            if( !!filterreturn ) {
+                filterreturn->Clear();
+            }
+            return 0;
+        }
+        _nSegmentStateIndex = 0;
+        _bBatchSegmentTorques = true;
+    }
+    int nret = _CheckSegment(q0, q1, dq0, dq1, timeelapsed, interval, options, filterreturn);
+    _bBatchSegmentTorques = false;
+    return nret;
+}
+
+int DynamicsCollisionConstraint::_CheckSegment(const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, IntervalType interval, int options, ConstraintFilterReturnPtr filterreturn)
 {
     int maskoptions = options&_filtermask;
     if( !!filterreturn ) {
@@ -2271,6 +2533,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
     }
 
     if (bCheckEnd) {
+        _fSegmentStateTime = timeelapsed > 0 ? timeelapsed : dReal(1.0);
         int nstateret = _SetAndCheckState(params, q1, dq1, _vtempaccelconfig, maskoptions, filterreturn);
         if( nstateret != 0 ) {
             if( !!filterreturn ) {
@@ -2385,6 +2648,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         }
     }
     if (start == 0 ) {
+        _fSegmentStateTime = 0;
         int nstateret = _SetAndCheckState(params, q0, dq0, _vtempaccelconfig, maskoptions, filterreturn);
         if( options & CFO_FillCheckedConfiguration ) {
             filterreturn->_configurations.insert(filterreturn->_configurations.begin(), q0.begin(), q0.end());
@@ -2412,6 +2676,39 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         return 0;
     }
 
+    if( _bContinuousCollisionChecking && numSteps > 1 && timeelapsed <= 0 && (maskoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions)) && !(maskoptions & CFO_CheckWithPerturbation) ) {
+        // validate the collisions of the whole linear segment with one query per body instead of checking every step.
+        // like the steps below, the query skips q0 and q1, which were checked above depending on the interval, so an open start never reports q0.
+        dReal fTimeWhenInvalid = 0;
+        dReal fStepTime = dReal(1)/numSteps;
+        int ncontinuousret = _CheckContinuousCollisions(params, q0, dQ, fStepTime, 1-fStepTime, maskoptions, fTimeWhenInvalid);
+        if( ncontinuousret > 0 ) {
+            if( !!filterreturn ) {
+                filterreturn->_returncode = ncontinuousret;
+                if( ncontinuousret != (int)CFO_StateSettingError ) {
+                    filterreturn->_invalidvalues.resize(q0.size());
+                    for(size_t idof = 0; idof < q0.size(); ++idof) {
+                        filterreturn->_invalidvalues[idof] = q0[idof] + fTimeWhenInvalid*dQ[idof];
+                    }
+                    filterreturn->_invalidvelocities = dq0;
+                    filterreturn->_fTimeWhenInvalid = fTimeWhenInvalid;
+                    if( options & CFO_FillCollisionReport ) {
+                        filterreturn->_report = *_report;
+                    }
+                }
+            }
+            return ncontinuousret;
+        }
+        else if( ncontinuousret == 0 ) {
+            maskoptions &= ~(CFO_CheckEnvCollisions|CFO_CheckSelfCollisions);
+            bool bCheckUserConstraints = (maskoptions & CFO_CheckUserConstraints) && (!!_usercheckfns[0] || !!_usercheckfns[1]);
+            if( !bCheckUserConstraints && !(maskoptions & CFO_CheckTimeBasedConstraints) && !(options & CFO_FillCheckedConfiguration) ) {
+                // nothing left to check at the intermediate steps
+                return 0;
+            }
+        }
+    }
+
     for (i = 0; i < params->GetDOF(); i++) {
         _vtempconfig.at(i) = q0.at(i);
     }
@@ -2467,6 +2764,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         while(istep < numSteps && prevtimestep < timeelapsed) {
             int nstateret = 0;
             if( istep >= start ) {
+                _fSegmentStateTime = timestep;
                 nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
                 if( !!params->_getstatefn ) {
                     params->_getstatefn(_vtempconfig);     // query again in order to get normalizations/joint limits
@@ -2479,6 +2777,9 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
             if( nstateret != 0 ) {
                 if( !!filterreturn ) {
                     filterreturn->_returncode = nstateret;
+                    filterreturn->_invalidvalues = _vtempconfig;
+                    filterreturn->_invalidvelocities = _vtempvelconfig;
+                    filterreturn->_fTimeWhenInvalid = timestep;
                 }
                 return nstateret;
             }
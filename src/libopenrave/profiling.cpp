@@ -0,0 +1,203 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2006-2016 Rosen Diankov <rosen.diankov@gmail.com>
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+#include <boost/thread/tss.hpp>
+
+namespace OpenRAVE {
+
+static const int s_nProfileHistogramBins = 40; ///< last bin collects all runs of 2^39ns or more
+
+/// \brief counters of one section
+struct ProfileSectionCounters
+{
+    ProfileSectionCounters() : count(0), totaltime(0), maxtime(0) {
+        std::fill(vhistogram, vhistogram+s_nProfileHistogramBins, 0);
+    }
+
+    void Add(const ProfileSectionCounters& r)
+    {
+        count += r.count;
+        totaltime += r.totaltime;
+        maxtime = std::max(maxtime, r.maxtime);
+        for(int i = 0; i < s_nProfileHistogramBins; ++i) {
+            vhistogram[i] += r.vhistogram[i];
+        }
+    }
+
+    uint64_t count, totaltime, maxtime;
+    uint64_t vhistogram[s_nProfileHistogramBins];
+};
+
+/// \brief counters written by one thread. Only that thread adds samples, the mutex is uncontended except while the statistics are read.
+class ThreadProfileData
+{
+public:
+    boost::mutex _mutex;
+    std::vector<ProfileSectionCounters> _vsections; ///< indexed by section id
+};
+typedef boost::shared_ptr<ThreadProfileData> ThreadProfileDataPtr;
+
+/// \brief global registry of the profiling sections and of the counters of every thread
+class ProfileRegistry
+{
+public:
+    ProfileRegistry() : _threaddata(&ProfileRegistry::_CleanupThreadData) {
+    }
+
+    int RegisterSection(const std::string& name)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<std::string, int>::iterator it = _mapSectionIds.find(name);
+        if( it != _mapSectionIds.end() ) {
+            return it->second;
+        }
+        int id = (int)_vSectionNames.size();
+        _vSectionNames.push_back(name);
+        _mapSectionIds[name] = id;
+        return id;
+    }
+
+    void AddSample(int sectionid, uint64_t duration)
+    {
+        ThreadProfileDataPtr* ppdata = _threaddata.get();
+        if( !ppdata ) {
+            ppdata = new ThreadProfileDataPtr(new ThreadProfileData());
+            _threaddata.reset(ppdata);
+            boost::mutex::scoped_lock lock(_mutex);
+            _listThreadData.push_back(*ppdata);
+        }
+        ThreadProfileData& data = **ppdata;
+        boost::mutex::scoped_lock lock(data._mutex);
+        if( sectionid >= (int)data._vsections.size() ) {
+            data._vsections.resize(sectionid+1);
+        }
+        ProfileSectionCounters& counters = data._vsections[sectionid];
+        counters.count += 1;
+        counters.totaltime += duration;
+        if( counters.maxtime < duration ) {
+            counters.maxtime = duration;
+        }
+        int bin = 0;
+        for(uint64_t d = duration>>1; d != 0 && bin < s_nProfileHistogramBins-1; d >>= 1) {
+            ++bin;
+        }
+        counters.vhistogram[bin] += 1;
+    }
+
+    void GetStatistics(std::vector<ProfileStatistics>& vstatistics)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::vector<ProfileSectionCounters> vsum = _vRetiredSections;
+        vsum.resize(_vSectionNames.size());
+        FOREACH(itdata, _listThreadData) {
+            boost::mutex::scoped_lock lockdata((*itdata)->_mutex);
+            for(size_t i = 0; i < (*itdata)->_vsections.size(); ++i) {
+                vsum.at(i).Add((*itdata)->_vsections[i]);
+            }
+        }
+        vstatistics.resize(0);
+        for(size_t i = 0; i < vsum.size(); ++i) {
+            if( vsum[i].count == 0 ) {
+                continue;
+            }
+            vstatistics.push_back(ProfileStatistics());
+            ProfileStatistics& stats = vstatistics.back();
+            stats.name = _vSectionNames[i];
+            stats.count = vsum[i].count;
+            stats.totaltime = vsum[i].totaltime;
+            stats.maxtime = vsum[i].maxtime;
+            int numbins = s_nProfileHistogramBins;
+            while(numbins > 0 && vsum[i].vhistogram[numbins-1] == 0) {
+                --numbins;
+            }
+            stats.vhistogram.assign(vsum[i].vhistogram, vsum[i].vhistogram+numbins);
+        }
+    }
+
+    void ResetStatistics()
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _vRetiredSections.clear();
+        FOREACH(itdata, _listThreadData) {
+            boost::mutex::scoped_lock lockdata((*itdata)->_mutex);
+            (*itdata)->_vsections.clear();
+        }
+    }
+
+private:
+    /// \brief called when a thread exits, moves its counters into _vRetiredSections
+    static void _CleanupThreadData(ThreadProfileDataPtr* ppdata);
+
+    boost::mutex _mutex; ///< protects everything except the counters inside ThreadProfileData
+    std::map<std::string, int> _mapSectionIds;
+    std::vector<std::string> _vSectionNames; ///< indexed by section id
+    std::list<ThreadProfileDataPtr> _listThreadData; ///< counters of the running threads
+    std::vector<ProfileSectionCounters> _vRetiredSections; ///< counters of the threads that exited
+    boost::thread_specific_ptr<ThreadProfileDataPtr> _threaddata;
+};
+
+/// never destroyed so that threads exiting during the static destruction can still retire their counters
+static ProfileRegistry& GetProfileRegistry()
+{
+    static ProfileRegistry* s_pregistry = new ProfileRegistry();
+    return *s_pregistry;
+}
+
+void ProfileRegistry::_CleanupThreadData(ThreadProfileDataPtr* ppdata)
+{
+    ProfileRegistry& registry = GetProfileRegistry();
+    {
+        boost::mutex::scoped_lock lock(registry._mutex);
+        registry._listThreadData.remove(*ppdata);
+        boost::mutex::scoped_lock lockdata((*ppdata)->_mutex);
+        if( registry._vRetiredSections.size() < (*ppdata)->_vsections.size() ) {
+            registry._vRetiredSections.resize((*ppdata)->_vsections.size());
+        }
+        for(size_t i = 0; i < (*ppdata)->_vsections.size(); ++i) {
+            registry._vRetiredSections[i].Add((*ppdata)->_vsections[i]);
+        }
+    }
+    delete ppdata;
+}
+
+int RaveRegisterProfileSection(const std::string& name)
+{
+    return GetProfileRegistry().RegisterSection(name);
+}
+
+void RaveAddProfileSample(int sectionid, uint64_t duration)
+{
+    GetProfileRegistry().AddSample(sectionid, duration);
+}
+
+uint64_t RaveGetProfileTime()
+{
+    return utils::GetNanoPerformanceTime();
+}
+
+void RaveGetProfileStatistics(std::vector<ProfileStatistics>& vstatistics)
+{
+    GetProfileRegistry().GetStatistics(vstatistics);
+}
+
+void RaveResetProfileStatistics()
+{
+    GetProfileRegistry().ResetStatistics();
+}
+
+}
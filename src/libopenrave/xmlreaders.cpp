@@ -222,6 +222,9 @@ GeometryInfoReader::GeometryInfoReader(KinBody::GeometryInfoPtr pgeom, const Att
     else if( _stricmp(type.c_str(), "container") == 0 ) {
         _pgeom->_type = GT_Container;
     }
+    else if( _stricmp(type.c_str(), "octree") == 0 ) {
+        _pgeom->_type = GT_Octree;
+    }
     else {
         RAVELOG_WARN(str(boost::format("type %s not supported\n")%type));
     }
@@ -282,6 +285,11 @@ BaseXMLReader::ProcessElement GeometryInfoReader::startElement(const std::string
             return PE_Support;
         }
         break;
+    case GT_Octree:
+        if(xmlname=="resolution" || xmlname=="points" ) {
+            return PE_Support;
+        }
+        break;
     default:
         break;
     }
@@ -418,6 +426,32 @@ bool GeometryInfoReader::endElement(const std::string& xmlname)
                 }
             }
             break;
+        case GT_Octree:
+            if( xmlname == "resolution" ) {
+                dReal resolution = 0;
+                _ss >> resolution;
+                if( resolution > 0 ) {
+                    _pgeom->_octree.SetResolution(resolution);
+                }
+                else {
+                    RAVELOG_WARN(str(boost::format("octree resolution %f needs to be positive, ignoring...\n")%resolution));
+                }
+            }
+            else if( xmlname == "points" ) {
+                // occupied points in the geometry coordinate system, resolution has to be set before
+                vector<dReal> values((istream_iterator<dReal>(_ss)), istream_iterator<dReal>());
+                if( (values.size()%3) ) {
+                    RAVELOG_WARN(str(boost::format("number of values specified in the points field needs to be a multiple of 3 (it is %d), ignoring...\n")%values.size()));
+                }
+                else {
+                    vector<Vector> vpoints(values.size()/3);
+                    for(size_t i = 0; i < vpoints.size(); ++i) {
+                        vpoints[i] = Vector(values[3*i], values[3*i+1], values[3*i+2]);
+                    }
+                    _pgeom->_octree.Update(vpoints, true);
+                }
+            }
+            break;
         default:
             _pcurreader.reset(new DummyXMLReader(xmlname,"geom"));
         }
@@ -239,6 +239,240 @@ class RunCollision(EnvironmentSetup):
             assert(report.plink1 == robot.GetLink('wam1'))
             assert(report.plink2 == env.GetKinBody('pole').GetLinks()[0])
 
+    def test_fcldistance(self):
+        self.log.debug('test fcl distance computation against pqp')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            fcl = RaveCreateCollisionChecker(env,'fcl_ Naive OBBRSS')
+            if fcl is None:
+                raise nose.SkipTest('fcl collision checker is not available')
+            fcl.InitEnvironment()
+            pqp = RaveCreateCollisionChecker(env,'pqp')
+            pqp.InitEnvironment()
+            assert(not RaveCreateCollisionChecker(env,'fcl_').SetCollisionOptions(CollisionOptions.Distance)) # OBB cannot compute distances
+            robot=env.GetRobots()[0]
+            manip=robot.GetActiveManipulator()
+            for broadphase in ['Naive','DynamicAABBTree']:
+                fcl.SendCommand('SetBroadphaseAlgorithm %s'%broadphase)
+                for checker in [fcl,pqp]:
+                    checker.SetCollisionOptions(CollisionOptions.Contacts|CollisionOptions.Distance)
+                fclreport = CollisionReport()
+                pqpreport = CollisionReport()
+                for body in [manip.GetEndEffector(),robot]:
+                    assert(not fcl.CheckCollision(body,report=fclreport))
+                    pqp.CheckCollision(body,report=pqpreport)
+                    assert(abs(fclreport.minDistance-pqpreport.minDistance) < 0.01)
+                    assert(fclreport.plink1 == pqpreport.plink1 and fclreport.plink2 == pqpreport.plink2)
+                    assert(len(fclreport.contacts) == 1)
+
+                fcl.CheckCollision(manip.GetEndEffector(),env.GetKinBody('pole'),report=fclreport)
+                pqp.CheckCollision(manip.GetEndEffector(),env.GetKinBody('pole'),report=pqpreport)
+                assert(abs(fclreport.minDistance-pqpreport.minDistance) < 0.01)
+                
+                fcl.CheckCollision(robot,env.GetKinBody('pole'),report=fclreport)
+                pqp.CheckCollision(robot,env.GetKinBody('pole'),report=pqpreport)
+                assert(abs(fclreport.minDistance-pqpreport.minDistance) < 0.01)
+
+                robot.CheckSelfCollision(report=fclreport,collisionchecker=fcl)
+                robot.CheckSelfCollision(report=pqpreport,collisionchecker=pqp)
+                assert(abs(fclreport.minDistance-pqpreport.minDistance) < 0.01)
+
+                # stops at the first pair closer than the threshold
+                fcl.SendCommand('SetDistanceThreshold 10')
+                fcl.CheckCollision(robot,report=fclreport)
+                pqp.CheckCollision(robot,report=pqpreport)
+                assert(fclreport.minDistance < 10 and fclreport.minDistance >= pqpreport.minDistance-0.01)
+                fcl.SendCommand('SetDistanceThreshold 0')
+
+    def test_pqpselfcollision(self):
+        self.log.debug('test pqp self-collision pair pruning against checking every non-adjacent link pair')
+        env=self.env
+        with env:
+            robot=self.LoadRobot('robots/barrettwam-dual.robot.xml')
+            pqp = RaveCreateCollisionChecker(env,'pqp')
+            pqp.InitEnvironment()
+            links = robot.GetLinks()
+            lower,upper = robot.GetDOFLimits()
+            for itry in range(10):
+                if itry == 5:
+                    # changing the enabled links changes the non-adjacent pairs
+                    links[3].Enable(False)
+                robot.SetDOFValues(random.rand(len(lower))*(upper-lower)+lower)
+                pairs = robot.GetNonAdjacentLinks(KinBody.AdjacentOptions.Enabled)
+                # link pair checks do not go through the self-collision pruning
+                unprunedcheck = any([pqp.CheckCollision(links[index1],links[index2]) for index1,index2 in pairs])
+                assert(robot.CheckSelfCollision(collisionchecker=pqp) == unprunedcheck)
+                for link in links:
+                    unprunedcheck = any([pqp.CheckCollision(links[index1],links[index2]) for index1,index2 in pairs if link.GetIndex() in (index1,index2)])
+                    assert(pqp.CheckSelfCollision(link,CollisionReport()) == unprunedcheck)
+
+    def test_fclselfcollision(self):
+        self.log.debug('test fcl self-collision pair pruning against pqp')
+        env=self.env
+        with env:
+            robot=self.LoadRobot('robots/barrettwam-dual.robot.xml')
+            fcl = RaveCreateCollisionChecker(env,'fcl_')
+            if fcl is None:
+                raise nose.SkipTest('fcl collision checker is not available')
+            fcl.InitEnvironment()
+            pqp = RaveCreateCollisionChecker(env,'pqp')
+            pqp.InitEnvironment()
+            lower,upper = robot.GetDOFLimits()
+            for itry in range(100):
+                if itry == 50:
+                    # changing the enabled links changes the non-adjacent pairs
+                    robot.GetLinks()[3].Enable(False)
+                robot.SetDOFValues(random.rand(len(lower))*(upper-lower)+lower)
+                fclcheck = robot.CheckSelfCollision(collisionchecker=fcl)
+                pqpcheck = robot.CheckSelfCollision(collisionchecker=pqp)
+                assert(fclcheck == pqpcheck)
+                for link in robot.GetLinks():
+                    assert(fcl.CheckSelfCollision(link,CollisionReport()) == pqp.CheckSelfCollision(link,CollisionReport()))
+
+    def test_fcloctree(self):
+        self.log.debug('test fcl collisions with an octree that is updated from points')
+        env=self.env
+        with env:
+            fcl = RaveCreateCollisionChecker(env,'fcl_')
+            if fcl is None:
+                raise nose.SkipTest('fcl collision checker is not available')
+            info = KinBody.Link.GeometryInfo()
+            info._type = GeometryType.Octree
+            info._fOctreeResolution = 0.1
+            info._vOctreePoints = [[0.05,0.05,0.05]]
+            octree = RaveCreateKinBody(env,'')
+            octree.InitFromGeometries([info])
+            octree.SetName('octree')
+            env.Add(octree)
+            probe = RaveCreateKinBody(env,'')
+            probe.InitFromBoxes(array([[0,0,0,0.02,0.02,0.02]]),True)
+            probe.SetName('probe')
+            env.Add(probe)
+            env.SetCollisionChecker(fcl)
+            geom = octree.GetLinks()[0].GetGeometries()[0]
+            hash0 = octree.GetKinematicsGeometryHash()
+
+            probe.SetTransform(matrixFromPose([1,0,0,0,0.05,0.05,0.05]))
+            assert(env.CheckCollision(probe,octree))
+            probe.SetTransform(matrixFromPose([1,0,0,0,0.25,0.05,0.05]))
+            assert(not env.CheckCollision(probe,octree))
+            # the new voxels are applied to the fcl octree
+            assert(geom.UpdateOctree([[0.25,0.05,0.05]]) == 1)
+            assert(env.CheckCollision(probe,octree))
+            assert(octree.GetKinematicsGeometryHash() != hash0)
+            assert(geom.UpdateOctree([[0.25,0.05,0.05]],False) == 1)
+            assert(not env.CheckCollision(probe,octree))
+            # the hash only depends on the occupied voxels
+            assert(octree.GetKinematicsGeometryHash() == hash0)
+            probe.SetTransform(matrixFromPose([1,0,0,0,0.05,0.05,0.05]))
+            assert(env.CheckCollision(probe,octree))
+            # the octree can become empty and be filled again
+            geom.ClearOctree()
+            assert(not env.CheckCollision(probe,octree))
+            assert(geom.UpdateOctree([[0.05,0.05,0.05]]) == 1)
+            assert(env.CheckCollision(probe,octree))
+
+    def test_fclcontinuous(self):
+        self.log.debug('test fcl continuous collision checking against discretized segments')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            fcl = RaveCreateCollisionChecker(env,'fcl_ Naive OBBRSS')
+            if fcl is None:
+                raise nose.SkipTest('fcl collision checker is not available')
+            env.SetCollisionChecker(fcl)
+            robot=env.GetRobots()[0]
+            manip=robot.GetActiveManipulator()
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            discreteconstraint = planningutils.DynamicsCollisionConstraint(params,[robot],0xffffffff)
+            continuousconstraint = planningutils.DynamicsCollisionConstraint(params,[robot],0xffffffff)
+            continuousconstraint.SetContinuousCollisionChecking(True)
+            options = 1|2 # CFO_CheckEnvCollisions|CFO_CheckSelfCollisions
+            lower,upper = robot.GetActiveDOFLimits()
+            q0 = robot.GetActiveDOFValues()
+            for itry in range(50):
+                q1 = q0 + (random.rand(len(q0))-0.5)*(upper-lower)*0.5
+                q1 = minimum(upper,maximum(lower,q1))
+                discreteret = discreteconstraint.Check(q0,q1,[],[],0,Interval.OpenStart,options)
+                continuousret = continuousconstraint.Check(q0,q1,[],[],0,Interval.OpenStart,options)
+                # continuous checking does not miss collisions that the steps find
+                if discreteret != 0:
+                    assert(continuousret != 0)
+                robot.SetActiveDOFValues(q0)
+            # an open start does not check q0, so segments leaving a colliding configuration never report it
+            numcollidingstarts = 0
+            for itry in range(1000):
+                qstart = lower + random.rand(len(q0))*(upper-lower)
+                robot.SetActiveDOFValues(qstart)
+                if not env.CheckCollision(robot):
+                    continue
+                numcollidingstarts += 1
+                q1 = minimum(upper,maximum(lower,qstart + (random.rand(len(q0))-0.5)*(upper-lower)*0.2))
+                filterreturn = continuousconstraint.Check(qstart,q1,[],[],0,Interval.OpenStart,options,True)
+                if filterreturn['returncode'] != 0:
+                    assert(filterreturn['fTimeWhenInvalid'] > 0 and transdist(filterreturn['invalidvalues'],qstart) > g_epsilon)
+                if numcollidingstarts >= 20:
+                    break
+            assert(numcollidingstarts > 0)
+            robot.SetActiveDOFValues(q0)
+            # the robot state is restored
+            assert(transdist(robot.GetActiveDOFValues(),q0) <= g_epsilon)
+
+    def test_distancefield(self):
+        self.log.debug('test signed distance field of the static bodies')
+        env=self.env
+        with env:
+            box=RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.2,0.3,0.4]]),True)
+            box.SetName('box')
+            env.Add(box,True)
+            module = RaveCreateModule(env,'DistanceField')
+            env.Add(module)
+            module.SendCommand('Build 0.02 0.2')
+            values = array([float(f) for f in module.SendCommand('GetDistance 0.5 0 0 0 0.35 0 0 0 0').split()]).reshape((3,4))
+            resolution = 0.02
+            assert(abs(values[0,0]-0.3) <= resolution)
+            assert(transdist(values[0,1:],[1,0,0]) <= 0.1)
+            assert(abs(values[1,0]-0.05) <= resolution)
+            assert(transdist(values[1,1:],[0,1,0]) <= 0.1)
+            assert(values[2,0] < -0.15)
+
+    def test_jitterdistancefield(self):
+        self.log.debug('jitter a colliding arm out of collision following the distance field gradient')
+        env=self.env
+        with env:
+            box=RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.2,0.3,0.4]]),True)
+            box.SetName('box')
+            env.Add(box,True)
+            box.SetTransform(matrixFromPose([1,0,0,0,0.62,0,0.6]))
+            robot=self.LoadRobot('robots/barrettwam.robot.xml')
+            module = RaveCreateModule(env,'DistanceField')
+            env.Add(module)
+            module.SendCommand('Build 0.02 0.3')
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            values = zeros(robot.GetActiveDOF())
+            values[1] = 0.5
+            values[3] = 1.0
+            robot.SetActiveDOFValues(values)
+            assert(env.CheckCollision(robot))
+            jitterer = RaveCreateSpaceSampler(env,'ConfigurationJitterer %s'%robot.GetName())
+            jitterer.SendCommand('SetMaxJitter 0.4')
+            jitterer.SendCommand('SetMaxLinkDistThresh 0')
+            assert(jitterer.SendCommand('SetDistanceField 20 0.01') is not None)
+            # the second jitter reuses the link spheres of the first
+            for i in range(2):
+                robot.SetActiveDOFValues(values)
+                samples = jitterer.SampleSequence(SampleDataType.Real,1)
+                assert(len(samples) == robot.GetActiveDOF())
+                assert(all(abs(samples-values) <= 0.4+g_epsilon))
+                robot.SetActiveDOFValues(samples)
+                assert(not env.CheckCollision(robot))
+                assert(transdist(robot.GetActiveDOFValues(),samples) <= g_epsilon)
+
     def test_multiplecontacts(self):
         env=self.env
         env.GetCollisionChecker().SetCollisionOptions(CollisionOptions.AllLinkCollisions)
@@ -259,6 +493,37 @@ class RunCollision(EnvironmentSetup):
         manip.CheckEndEffectorCollision(report)
         assert(len(report.vLinkColliding)==4)
 
+    def test_checkconfigurations(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot=env.GetRobots()[0]
+            dofindices = robot.GetActiveManipulator().GetArmIndices()
+            lower,upper = robot.GetDOFLimits(dofindices)
+            ranges = minimum(upper-lower, 2*pi)
+            orgvalues = robot.GetDOFValues()
+            numpy.random.seed(0)
+            configs = lower-0.05*ranges + numpy.random.rand(200,len(dofindices))*1.1*ranges
+            expected = zeros(len(configs),uint8)
+            for i,config in enumerate(configs):
+                if any(config<lower-1e-7) or any(config>upper+1e-7):
+                    expected[i] = Environment.ConfigurationCheckResult.OutOfLimits
+                    continue
+                robot.SetDOFValues(config,dofindices)
+                if env.CheckCollision(robot):
+                    expected[i] |= Environment.ConfigurationCheckResult.EnvironmentCollision
+                if robot.CheckSelfCollision():
+                    expected[i] |= Environment.ConfigurationCheckResult.SelfCollision
+            robot.SetDOFValues(orgvalues)
+            assert(any(expected==0) and any(expected!=0))
+            for numthreads in [1,3]:
+                results = env.CheckConfigurations(robot,dofindices,configs,numthreads=numthreads)
+                assert(all(results==expected))
+                assert(transdist(robot.GetDOFValues(),orgvalues) <= g_epsilon)
+            # only collisions
+            results = env.CheckConfigurations(robot,dofindices,configs[expected!=Environment.ConfigurationCheckResult.OutOfLimits],checkoptions=Environment.ConfigurationCheckResult.EnvironmentCollision)
+            assert(all(results==(expected[expected!=Environment.ConfigurationCheckResult.OutOfLimits]&Environment.ConfigurationCheckResult.EnvironmentCollision)))
+
 #generate_classes(RunCollision, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunCollision):
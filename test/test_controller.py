@@ -66,6 +66,32 @@ class test_ideal(RunController):
     def __init__(self):
         RunController.__init__(self, 'IdealController')
 
+    def test_precomputedsampling(self):
+        self.log.debug('runs a trajectory from the precomputed samples with rate-limited collision checks')
+        env=self.env
+        robot=self.LoadRobot('robots/schunk-lwa3.zae')
+        with env:
+            initvalues = robot.GetActiveDOFValues()
+            waypoint=array(initvalues)
+            waypoint[0] += 0.5
+            waypoint[1] += 0.5
+            traj=RaveCreateTrajectory(env, '')
+            traj.Init(robot.GetActiveConfigurationSpecification('quadratic'))
+            traj.Insert(0,r_[initvalues,waypoint])
+            ret=planningutils.RetimeActiveDOFTrajectory(traj,robot,False)
+            assert(ret==PlannerStatus.HasSolution)
+            controller=robot.GetController()
+            controller.SendCommand('SetPrecomputedSampling 0.01')
+            controller.SendCommand('SetCheckCollisions 1')
+            controller.SendCommand('SetCheckCollisionPeriod 0.05')
+            controller.SendCommand('ResetTickStatistics')
+            self.RunTrajectory(robot,traj)
+            assert(transdist(robot.GetActiveDOFValues(),waypoint) <= g_epsilon)
+            numsteps, meantime, maxtime, lasttime, numcollisionchecks = [float(f) for f in controller.SendCommand('GetTickStatistics').split()]
+            assert(numsteps >= traj.GetDuration()/0.01)
+            assert(maxtime >= meantime and meantime > 0)
+            assert(numcollisionchecks > 0 and numcollisionchecks < numsteps)
+
 # class test_bullet(RunController):
 #     def __init__(self):
 #         RunController.__init__(self, 'bullet')
@@ -262,3 +262,31 @@ class TestEnvironment(EnvironmentSetup):
         # thread is done, so should be able to lock
         assert(env.Lock(1.0))
         env.Unlock()
+
+    def test_publishedbodies(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        env.UpdatePublishedBodies()
+        states = env.GetPublishedBodies()
+        assert(len(states)==len(env.GetBodies()))
+        states, removedids, version, isdelta = env.GetPublishedBodiesChanged()
+        assert(len(states)==len(env.GetBodies()))
+        
+        # nothing changed
+        env.UpdatePublishedBodies()
+        states, removedids, newversion, isdelta = env.GetPublishedBodiesChanged(version)
+        assert(isdelta and len(states)==0 and len(removedids)==0 and newversion==version)
+        
+        body = env.GetBodies()[1]
+        with env:
+            T = body.GetTransform()
+            T[0,3] += 0.1
+            body.SetTransform(T)
+            removedbody = env.GetBodies()[2]
+            removedid = removedbody.GetEnvironmentId()
+            env.Remove(removedbody)
+            env.UpdatePublishedBodies()
+        states, removedids, version, isdelta = env.GetPublishedBodiesChanged(version)
+        assert(isdelta and len(states)==1 and removedids==[removedid])
+        assert(states[0]['body']==body and states[0]['updatestamp']==body.GetUpdateStamp())
+        assert(transdist(states[0]['linktransforms'][0],body.GetTransform()) <= g_epsilon)
@@ -13,6 +13,7 @@
 # limitations under the License.
 from common_test_openrave import *
 import imp
+import os, re, sys, tempfile, threading
 
 log=logging.getLogger('openravepytest')
 
@@ -63,3 +64,74 @@ def test_ikparam():
     
     ikparam2 = ikparam*T
     ikparam2.GetTranslationDirection5D().pos()
+
+def test_profiling():
+    env = Environment()
+    try:
+        profiler = RaveCreateModule(env,'Profiler')
+        enabled = int(profiler.SendCommand('IsEnabled'))
+        env.Load('robots/barrettwam.robot.xml')
+        robot = env.GetRobots()[0]
+        RaveResetProfileStatistics()
+        for i in range(10):
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            env.CheckCollision(robot)
+        stats = dict([(name,(count,totaltime,maxtime,histogram)) for name,count,totaltime,maxtime,histogram in RaveGetProfileStatistics()])
+        if enabled:
+            count,totaltime,maxtime,histogram = stats['KinBody::SetDOFValues']
+            assert(count >= 10 and maxtime <= totaltime and sum(histogram) == count)
+            assert('KinBody::SetDOFValues' in profiler.SendCommand('GetStatistics'))
+        else:
+            assert(len(stats) == 0)
+        RaveResetProfileStatistics()
+        assert(len(RaveGetProfileStatistics()) == 0)
+    finally:
+        env.Destroy()
+
+def test_asynclogging():
+    oldlevel = RaveGetDebugLevel()
+    RaveSetDebugLevel(DebugLevel.Debug)
+    try:
+        if not RaveSetLogMode(LogMode.Async):
+            return
+        assert(RaveGetLogMode() == LogMode.Async)
+        numdropped = RaveGetLogDropCount()
+        numthreads = 4
+        nummessages = 50
+        sequence = []
+        sequencelock = threading.Lock()
+        def LogMessages(ithread):
+            for i in range(nummessages):
+                with sequencelock:
+                    message = 'async log message %d %d'%(ithread,i)
+                    sequence.append(message)
+                    RaveLogDebug(message)
+
+        # the background thread writes directly to the stdout file descriptor
+        sys.stdout.flush()
+        RaveFlushLog()
+        oldstdout = os.dup(1)
+        with tempfile.TemporaryFile() as f:
+            os.dup2(f.fileno(), 1)
+            try:
+                threads = [threading.Thread(target=LogMessages,args=(ithread,)) for ithread in range(numthreads)]
+                for thread in threads:
+                    thread.start()
+                for thread in threads:
+                    thread.join()
+                RaveFlushLog()
+            finally:
+                os.dup2(oldstdout, 1)
+                os.close(oldstdout)
+            f.seek(0)
+            output = f.read()
+
+        # every message is printed once in the order it was logged, even if it came from another thread
+        messages = re.findall('async log message [0-9]+ [0-9]+', output)
+        assert(messages == sequence)
+        assert(len(messages) == numthreads*nummessages)
+        assert(RaveGetLogDropCount() == numdropped)
+    finally:
+        assert(RaveSetLogMode(LogMode.Direct))
+        RaveSetDebugLevel(oldlevel)
+    assert(RaveGetLogMode() == LogMode.Direct)
@@ -527,6 +527,41 @@ class TestKinematics(EnvironmentSetup):
                         assert( transdist(-torquegravity, gravitypartials) < 0.1*deltastep*len(gravitypartials))
                         assert( transdist(torquegravity, testtorque_e-testtorque_e2) <= 1e-10 )
 
+    def test_inversedynamicsofstates(self):
+        self.log.info('check that the batch inverse dynamics of many states matches the inverse dynamics of every state')
+        env=self.env
+        with env:
+            env.GetPhysicsEngine().SetGravity([0,0,-9.8])
+            for envfile in ['robots/wam7.kinbody.xml', 'robots/barrettwam.robot.xml']:
+                env.Reset()
+                self.LoadEnv(envfile)
+                body = [body for body in env.GetBodies() if body.GetDOF() > 0][0]
+                lower,upper = body.GetDOFLimits()
+                vellimits = body.GetDOFVelocityLimits()
+                numstates = 20
+                dofvalues = array([randlimits(lower,upper) for i in range(numstates)])
+                dofvelocities = array([randlimits(-vellimits,vellimits) for i in range(numstates)])
+                dofaccelerations = 10*random.rand(numstates,body.GetDOF())-5
+                # the base link keeps its velocity
+                body.SetDOFVelocities(zeros(body.GetDOF()),[0,0,0],[0,0,0])
+                origvalues = body.GetDOFValues()
+                stamp = body.GetUpdateStamp()
+                torques = body.ComputeInverseDynamicsOfStates(dofvalues,dofvelocities,dofaccelerations)
+                assert(torques.shape == (numstates,body.GetDOF()))
+                assert(body.GetUpdateStamp() == stamp)
+                assert(transdist(body.GetDOFValues(),origvalues) <= g_epsilon)
+                for values,velocities,accelerations,statetorques in izip(dofvalues,dofvelocities,dofaccelerations,torques):
+                    body.SetDOFValues(values)
+                    body.SetDOFVelocities(velocities,[0,0,0],[0,0,0])
+                    assert(transdist(body.ComputeInverseDynamics(accelerations),statetorques) <= 1e-9*(1+sum(abs(statetorques))))
+                # the number of values has to be a multiple of the dof
+                try:
+                    body.ComputeInverseDynamicsOfStates(dofvalues.flatten()[:-1],dofvelocities.flatten()[:-1],dofaccelerations.flatten()[:-1])
+                    raise ValueError('expected exception')
+
+                except openrave_exception:
+                    pass
+
     def test_hessian(self):
         self.log.info('check the jacobian and hessian computation')
         env=self.env
@@ -1057,6 +1092,33 @@ class TestKinematics(EnvironmentSetup):
                 curposes = poseFromMatrices(robot.GetLinkTransformations())
                 assert( transdist(linkposes,curposes) <= 1e-6 )
 
+    def test_octreegeometry(self):
+        env=self.env
+        with env:
+            info = KinBody.Link.GeometryInfo()
+            info._type = GeometryType.Octree
+            info._fOctreeResolution = 0.1
+            info._vOctreePoints = [[0.05,0.05,0.05]]
+            body = RaveCreateKinBody(env,'')
+            body.InitFromGeometries([info])
+            body.SetName('octree')
+            env.Add(body)
+            body.SetTransform(matrixFromPose([1,0,0,0,1,0,0]))
+            geom = body.GetLinks()[0].GetGeometries()[0]
+            assert(geom.GetType() == GeometryType.Octree)
+            assert(len(geom.GetOctreePoints()) == 1)
+            # points are in world coordinates, the voxel of the second point is already occupied
+            assert(geom.UpdateOctree([[1.15,0.05,0.05],[1.05,0.05,0.05]]) == 1)
+            ab = body.ComputeAABB()
+            assert(transdist(ab.pos(),[1.1,0.05,0.05]) <= g_epsilon)
+            assert(transdist(ab.extents(),[0.1,0.05,0.05]) <= g_epsilon)
+            # only the outer faces of the two voxels are triangulated
+            assert(len(geom.GetCollisionMesh().indices) == 20)
+            assert(geom.UpdateOctree([[1.15,0.05,0.05]],False) == 1)
+            assert(transdist(geom.GetOctreePoints(),[[0.05,0.05,0.05]]) <= g_epsilon)
+            geom.ClearOctree()
+            assert(len(geom.GetOctreePoints()) == 0)
+
     def test_custombody(self):
         env=self.env
         with env:
@@ -1122,3 +1184,129 @@ class TestKinematics(EnvironmentSetup):
         assert(robot.CheckSelfCollision())
         robot.SetNonCollidingConfiguration()
         assert(not robot.CheckSelfCollision())
+
+    def test_linkupdatestamps(self):
+        self.log.info('check that only the links that moved get new update stamps')
+        env=self.env
+        with env:
+            self.LoadEnv('robots/barrettwam.robot.xml')
+            robot=env.GetRobots()[0]
+            manip=robot.GetActiveManipulator()
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            stamps = [link.GetUpdateStamp() for link in robot.GetLinks()]
+            # move the last arm joint, only its child links move
+            lastjoint = robot.GetJointFromDOFIndex(manip.GetArmIndices()[-1])
+            robot.SetDOFValues([0.5],[lastjoint.GetDOFIndex()])
+            assert(robot.GetUpdateStamp() > max(stamps))
+            for link,stamp in izip(robot.GetLinks(),stamps):
+                if robot.DoesAffect(lastjoint.GetJointIndex(),link.GetIndex()):
+                    assert(link.GetUpdateStamp() > stamp)
+                else:
+                    assert(link.GetUpdateStamp() == stamp)
+            # enabling a link changes its stamp
+            link = robot.GetLinks()[2]
+            stamp = link.GetUpdateStamp()
+            link.Enable(False)
+            assert(link.GetUpdateStamp() > stamp and link.GetUpdateStamp() == robot.GetUpdateStamp())
+            link.Enable(True)
+
+    def test_batchlinktransformations(self):
+        self.log.info('check that batch forward kinematics match SetDOFValues and do not change the body')
+        env=self.env
+        with env:
+            for envfile in ['robots/barrettwam.robot.xml','robots/pr2-beta-static.zae']:
+                env.Reset()
+                self.LoadEnv(envfile,{'skipgeometry':'1'})
+                for body in env.GetBodies():
+                    if body.GetDOF() == 0:
+                        continue
+                    lower,upper = body.GetDOFLimits()
+                    dofvalues = array([randlimits(lower, upper) for i in range(10)])
+                    origtransforms = body.GetLinkTransformations()
+                    origvalues = body.GetDOFValues()
+                    stamp = body.GetUpdateStamp()
+                    poses = body.ComputeLinkTransformations(dofvalues)
+                    assert(poses.shape == (len(dofvalues),len(body.GetLinks()),7))
+                    assert(body.GetUpdateStamp() == stamp)
+                    assert(transdist(body.GetDOFValues(),origvalues) <= g_epsilon)
+                    assert(transdist(body.GetLinkTransformations(),origtransforms) <= g_epsilon)
+                    for values,linkposes in izip(dofvalues,poses):
+                        body.SetDOFValues(values)
+                        for link,pose in izip(body.GetLinks(),linkposes):
+                            assert(transdist(matrixFromPose(pose),link.GetTransform()) <= g_epsilon)
+                    # only a subset of the dofs
+                    dofindices = range(0,body.GetDOF(),2)
+                    body.SetDOFValues(origvalues)
+                    poses = body.ComputeLinkTransformations(dofvalues[:,dofindices],dofindices)
+                    for values,linkposes in izip(dofvalues,poses):
+                        body.SetDOFValues(values[dofindices],dofindices)
+                        for link,pose in izip(body.GetLinks(),linkposes):
+                            assert(transdist(matrixFromPose(pose),link.GetTransform()) <= g_epsilon)
+                        body.SetDOFValues(origvalues)
+                    if envfile != 'robots/barrettwam.robot.xml':
+                        # the mimic jacobians are only exact for linear mimic equations
+                        continue
+                    # the jacobians of the last link match the jacobians of every configuration
+                    linkindex = len(body.GetLinks())-1
+                    localposition = array([0.1,-0.05,0.2])
+                    for indices in [None, dofindices]:
+                        values = dofvalues if indices is None else dofvalues[:,indices]
+                        poses2,jacobians = body.ComputeLinkTransformations(values,indices,linkindex,localposition)
+                        numindices = body.GetDOF() if indices is None else len(indices)
+                        assert(jacobians.shape == (len(dofvalues),6,numindices))
+                        assert(transdist(body.GetDOFValues(),origvalues) <= g_epsilon)
+                        for configvalues,linkposes,jacobian in izip(values,poses2,jacobians):
+                            body.SetDOFValues(configvalues,indices if indices is not None else range(body.GetDOF()))
+                            Tlink = body.GetLinks()[linkindex].GetTransform()
+                            assert(transdist(matrixFromPose(linkposes[linkindex]),Tlink) <= g_epsilon)
+                            worldposition = dot(Tlink[0:3,0:3],localposition)+Tlink[0:3,3]
+                            assert(transdist(jacobian[0:3],body.ComputeJacobianTranslation(linkindex,worldposition,indices)) <= g_epsilon)
+                            assert(transdist(jacobian[3:6],body.ComputeJacobianAxisAngle(linkindex,indices)) <= g_epsilon)
+                        body.SetDOFValues(origvalues)
+
+    def test_numpyinputs(self):
+        self.log.info('check that numpy arrays of any dtype and layout are accepted where sequences are')
+        env=self.env
+        with env:
+            self.LoadEnv('robots/barrettwam.robot.xml')
+            robot=env.GetRobots()[0]
+            lower,upper = robot.GetDOFLimits()
+            values = randlimits(lower,upper)
+            robot.SetDOFValues(list(values))
+            refvalues = robot.GetDOFValues()
+            robot.SetDOFValues(values.astype(float32))
+            assert(transdist(robot.GetDOFValues(),refvalues) <= 1e-6)
+            # non-contiguous view
+            robot.SetDOFValues(vstack([values,values]).T[:,0])
+            assert(transdist(robot.GetDOFValues(),refvalues) <= g_epsilon)
+            robot.SetDOFValues(values[::2],range(0,robot.GetDOF(),2))
+            assert(transdist(robot.GetDOFValues()[::2],values[::2]) <= g_epsilon)
+            T = matrixFromAxisAngle([0.1,0.2,0.3])
+            T[0:3,3] = [0.5,-0.2,0.1]
+            for Tinput in [T, T[0:3,:], asfortranarray(T), T.astype(float32), poseFromMatrix(T), list(poseFromMatrix(T)), T.tolist()]:
+                robot.SetTransform(Tinput)
+                assert(transdist(robot.GetTransform(),T) <= 1e-6)
+            # casting floats to integer indices is unsafe and has to raise instead of truncating
+            assert_raises(TypeError,robot.SetDOFValues,values[:2],array([0.5,1.5]))
+            robot.SetDOFValues(values[:2],array([0,1],int64))
+            assert(transdist(robot.GetDOFValues()[:2],values[:2]) <= g_epsilon)
+
+    def test_linktransformationsarray(self):
+        self.log.info('check that all link transformations are returned in one array and can be set back')
+        env=self.env
+        with env:
+            self.LoadEnv('robots/barrettwam.robot.xml')
+            robot=env.GetRobots()[0]
+            lower,upper = robot.GetDOFLimits()
+            robot.SetDOFValues(randlimits(lower,upper))
+            Tlinks = robot.GetLinkTransformations()
+            assert(Tlinks.shape == (len(robot.GetLinks()),4,4))
+            for link,Tlink in izip(robot.GetLinks(),Tlinks):
+                assert(transdist(Tlink,link.GetTransform()) <= g_epsilon)
+            Tlinks,doflastvalues = robot.GetLinkTransformations(True)
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            robot.SetLinkTransformations(Tlinks,doflastvalues)
+            assert(numpy.max(abs(robot.GetLinkTransformations()-Tlinks)) <= g_epsilon)
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            robot.SetLinkTransformations(array([poseFromMatrix(T) for T in Tlinks]),doflastvalues)
+            assert(numpy.max(abs(robot.GetLinkTransformations()-Tlinks)) <= g_epsilon)
@@ -50,6 +50,140 @@ class RunPlanning(EnvironmentSetup):
             useddofindices, usedconfigindices = spec.ExtractUsedIndices(robot)
             assert(sorted(useddofindices) == sorted(manip.GetArmIndices()))
             
+    def test_lazybirrt(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/hironxtable.env.xml')
+            robot = env.GetRobots()[0]
+            manip = robot.SetActiveManipulator('leftarm_torso')
+            lmodel=databases.linkstatistics.LinkStatisticsModel(robot)
+            if not lmodel.load():
+                lmodel.autogenerate()
+            lmodel.setRobotWeights()
+            lmodel.setRobotResolutions(xyzdelta=0.002)
+            basemanip = interfaces.BaseManipulation(robot,plannername='LazyBiRRT')
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            goal = robot.GetActiveDOFValues()
+            goal[0] = -0.556
+            goal[3] = -1.86
+            traj = basemanip.MoveActiveJoints(goal=goal,maxiter=5000,steplength=0.01,maxtries=2,execute=False,outputtrajobj=True)
+            with robot:
+                parameters = Planner.PlannerParameters()
+                parameters.SetRobotActiveJoints(robot)
+                planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+            self.RunTrajectory(robot,traj)
+
+    def test_lazybirrtedgechecks(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            initial = array([0.3,0.6,0.1,1.6,0.2,0.4,0.1])
+            goal = array([1.2,1.5,0,-0.2,0,0,0])
+            # the lazy planner only checks the edges of the connecting paths, so it has to check fewer edges than BiRRT when the trees have to go around the table
+            numedgechecks = {}
+            for plannername in ['BiRRT','LazyBiRRT']:
+                numedgechecks[plannername] = 0
+                for seed in range(1,6):
+                    robot.SetActiveDOFValues(initial)
+                    parameters = Planner.PlannerParameters()
+                    parameters.SetRobotActiveJoints(robot)
+                    parameters.SetInitialConfig(initial)
+                    parameters.SetGoalConfig(goal)
+                    parameters.SetMaxIterations(5000)
+                    parameters.SetRandomGeneratorSeed(seed)
+                    planner = RaveCreatePlanner(env,plannername)
+                    assert(planner.InitPlan(robot,parameters))
+                    traj = RaveCreateTrajectory(env,'')
+                    assert(planner.PlanPath(traj) == PlannerStatus.HasSolution)
+                    with robot:
+                        planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+                    numedgechecks[plannername] += int(planner.SendCommand('GetNumEdgeChecks'))
+            assert(numedgechecks['LazyBiRRT'] < numedgechecks['BiRRT'])
+
+    def test_prm(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/hironxtable.env.xml')
+            robot = env.GetRobots()[0]
+            manip = robot.SetActiveManipulator('leftarm_torso')
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            initial = robot.GetActiveDOFValues()
+            goal = array(initial)
+            goal[0] = -0.556
+            goal[3] = -1.86
+            parameters = Planner.PlannerParameters()
+            parameters.SetRobotActiveJoints(robot)
+            parameters.SetInitialConfig(initial)
+            parameters.SetGoalConfig(goal)
+            planner = RaveCreatePlanner(env,'PRM')
+            assert(planner.InitPlan(robot,parameters))
+            planner.SendCommand('ClearRoadmap')
+            planner.SendCommand('BuildRoadmap 300 2 1')
+            numnodes,numedges,numvalid,numinvalid,numunknown = [int(s) for s in planner.SendCommand('GetRoadmapStatistics').split()]
+            assert(numnodes == 300 and numunknown == 0)
+            # the built roadmap is saved and loaded by new planners
+            planner2 = RaveCreatePlanner(env,'PRM')
+            assert(planner2.InitPlan(robot,parameters))
+            assert([int(s) for s in planner2.SendCommand('GetRoadmapStatistics').split()] == [numnodes,numedges,numvalid,numinvalid,numunknown])
+            for itry in range(2):
+                if itry == 1:
+                    # moving a body should invalidate the edges close to it
+                    table = env.GetKinBody('IkeaTable')
+                    T = table.GetTransform()
+                    T[0,3] += 0.05
+                    table.SetTransform(T)
+                    assert(planner.InitPlan(robot,parameters))
+                    numunknown = int(planner.SendCommand('GetRoadmapStatistics').split()[4])
+                    assert(numunknown > 0)
+                traj = RaveCreateTrajectory(env,'')
+                assert(planner.PlanPath(traj) == PlannerStatus.HasSolution)
+                with robot:
+                    planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+                assert(int(planner.SendCommand('GetRoadmapStatistics').split()[0]) == numnodes)
+
+    def test_rastar(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            initial = array([0.3,0.6,0.1,1.6,0.2,0.4,0.1])
+            goal = initial + array([-0.4,-0.3,0,-0.5,0,0,0])
+            robot.SetActiveDOFValues(initial)
+            parameters = Planner.PlannerParameters()
+            parameters.SetRobotActiveJoints(robot)
+            parameters.SetInitialConfig(initial)
+            parameters.SetGoalConfig(goal)
+            parameters.SetMaxIterations(2000)
+            # weigh the distance to the goal more than the path cost so that the search does not spread out
+            parameters.SetExtraParameters('<goalcoeff>10</goalcoeff>')
+            planner = RaveCreatePlanner(env,'RAStar')
+            assert(planner.InitPlan(robot,parameters))
+            traj = RaveCreateTrajectory(env,'')
+            assert(planner.PlanPath(traj) == PlannerStatus.HasSolution)
+            spec = traj.GetConfigurationSpecification()
+            assert(transdist(spec.ExtractJointValues(traj.GetWaypoint(0),robot,robot.GetActiveDOFIndices(),0),initial) <= g_epsilon)
+            assert(transdist(spec.ExtractJointValues(traj.GetWaypoint(-1),robot,robot.GetActiveDOFIndices(),0),goal) <= g_epsilon)
+            with robot:
+                planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+
+            # the goal configuration collides with an obstacle, so it can never be connected to the path
+            with robot:
+                robot.SetActiveDOFValues(goal)
+                Tgoal = robot.GetActiveManipulator().GetEndEffectorTransform()
+            obstacle = RaveCreateKinBody(env,'')
+            obstacle.SetName('obstacle')
+            obstacle.InitFromBoxes(array([r_[Tgoal[0:3,3],0.05,0.05,0.05]]),True)
+            env.Add(obstacle,True)
+            assert(not env.CheckCollision(robot))
+            parameters.SetMaxIterations(300)
+            planner = RaveCreatePlanner(env,'RAStar')
+            assert(planner.InitPlan(robot,parameters))
+            traj = RaveCreateTrajectory(env,'')
+            assert(planner.PlanPath(traj) == PlannerStatus.Failed)
+
     def test_ikplanning(self):
         env = self.env
         self.LoadEnv('data/lab1.env.xml')
@@ -242,6 +376,42 @@ class RunPlanning(EnvironmentSetup):
             traj = basemanip.MoveHandStraight(direction=array([ 0.78915764,  0.13771766,  0.59855163]),starteematrix=Tee,stepsize=0.01,minsteps=60,maxsteps=80,execute=False,outputtrajobj=True)
             self.RunTrajectory(robot,traj)
             
+    def test_movehandstraightcache(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = env.GetRobots()[0]
+            ikmodel = databases.inversekinematics.InverseKinematicsModel(robot=robot,iktype=IkParameterization.Type.Transform6D)
+            if not ikmodel.load():
+                ikmodel.autogenerate()
+            basemanip = interfaces.BaseManipulation(robot)
+            robot.SetDOFValues([0.3, 0.6, 0.1, 1.6, 0.2, 0.4, 0.1],ikmodel.manip.GetArmIndices())
+            # the second call reuses the cached ik and collision results of the first
+            traj0 = basemanip.MoveHandStraight(direction=[0,0,1],stepsize=0.005,minsteps=1,maxsteps=60,execute=False,outputtrajobj=True)
+            traj1 = basemanip.MoveHandStraight(direction=[0,0,1],stepsize=0.005,minsteps=1,maxsteps=60,execute=False,outputtrajobj=True)
+            assert(traj0.GetNumWaypoints() == traj1.GetNumWaypoints())
+            assert(transdist(traj0.GetWaypoints(0,traj0.GetNumWaypoints()),traj1.GetWaypoints(0,traj1.GetNumWaypoints())) <= g_epsilon)
+            numentries,numeehits,numeemisses,numikhits,numikmisses = [int(s) for s in basemanip.prob.SendCommand('SendWorkspacePlannerCommand GetCacheStatistics').split()]
+            assert(numentries > 0 and numeehits > 0 and numikhits > 0)
+
+            # cached ik solutions still have to pass the custom filters of the ik solver
+            def rejectall(sol,manip,ikparam):
+                return IkReturnAction.Reject
+            handle = ikmodel.manip.GetIkSolver().RegisterCustomFilter(0,rejectall)
+            assert_raises(planning_error,basemanip.MoveHandStraight,direction=[0,0,1],stepsize=0.005,minsteps=1,maxsteps=60,execute=False,outputtrajobj=True)
+            handle.close()
+            traj1 = basemanip.MoveHandStraight(direction=[0,0,1],stepsize=0.005,minsteps=1,maxsteps=60,execute=False,outputtrajobj=True)
+            assert(transdist(traj0.GetWaypoints(0,traj0.GetNumWaypoints()),traj1.GetWaypoints(0,traj1.GetNumWaypoints())) <= g_epsilon)
+
+            # block the path, the cache has to be invalidated
+            Tee = ikmodel.manip.GetTransform()
+            body = RaveCreateKinBody(env,'')
+            body.SetName('obstacle')
+            body.InitFromBoxes(array([[Tee[0,3],Tee[1,3],Tee[2,3]+0.2,0.05,0.05,0.01]]),True)
+            env.Add(body)
+            traj2 = basemanip.MoveHandStraight(direction=[0,0,1],stepsize=0.005,minsteps=1,maxsteps=60,execute=False,outputtrajobj=True)
+            assert(traj2.GetDuration() < traj0.GetDuration()-g_epsilon)
+
     def test_movetohandpositiongrab(self):
         env=self.env
         self.LoadEnv('data/hanoi_complex2.env.xml')
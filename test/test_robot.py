@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 from common_test_openrave import *
+import threading
 
 class RunRobot(EnvironmentSetup):
     def __init__(self,collisioncheckername):
@@ -379,6 +380,52 @@ class RunRobot(EnvironmentSetup):
             assert(ikmodel.manip.FindIKSolution(ikparam2,IkFilterOptions.CheckEnvCollisions) is None)
             assert(ikmodel.manip.FindIKSolution(ikparam2,IkFilterOptions.CheckEnvCollisions|IkFilterOptions.IgnoreEndEffectorCollisions) is not None)
 
+    def test_releasegil(self):
+        self.log.info('test that ik and collision calls release the GIL and do not deadlock with python threads holding the environment lock')
+        env=self.env
+        self.LoadEnv('data/katanatable.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot, iktype=IkParameterization.Type.TranslationDirection5D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+        with env:
+            robot.SetActiveDOFs(ikmodel.manip.GetArmIndices())
+            robot.SetActiveDOFValues([ 0,  0.89098841,  0.92174268, -1.32022237,  0])
+            ikparam=ikmodel.manip.GetIkParameterization(IkParameterizationType.TranslationDirection5D)
+            incollision = env.CheckCollision(robot)
+
+        def LockThread(env, robot):
+            with env:
+                time.sleep(0.5)
+                # needs the GIL while holding the environment lock
+                robot.GetDOFValues()
+        results = []
+        def IkThread(manip, ikparam):
+            results.append(manip.FindIKSolution(ikparam,IkFilterOptions.CheckEnvCollisions))
+            results.append(manip.FindIKSolutions(ikparam,IkFilterOptions.CheckEnvCollisions))
+        lockthread = threading.Thread(target=LockThread,args=(env,robot))
+        lockthread.start()
+        time.sleep(0.1)
+        ikthread = threading.Thread(target=IkThread,args=(ikmodel.manip,ikparam))
+        ikthread.daemon = True
+        ikthread.start()
+        ikthread.join(10.0)
+        assert(not ikthread.is_alive())
+        lockthread.join()
+        assert(results[0] is not None and len(results[1]) > 0)
+
+        collisionresults = []
+        def CollisionThread(env, robot, releasegil):
+            for i in range(100):
+                with env:
+                    collisionresults.append(env.CheckCollision(robot,None,releasegil))
+        threads = [threading.Thread(target=CollisionThread,args=(env,robot,ithread%2==0)) for ithread in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert(len(collisionresults) == 400 and all([result == incollision for result in collisionresults]))
+
     def test_badtrajectory(self):
         self.log.info('create a discontinuous trajectory and check if robot throws exception')
         env=self.env
@@ -56,3 +56,55 @@ class TestSampling(EnvironmentSetup):
         robot.SetActiveDOFs(range(robot.GetDOF()-4),Robot.DOFAffine.X|Robot.DOFAffine.Y|Robot.DOFAffine.RotationAxis,[0,0,1])
         values = sp.SampleSequence(SampleDataType.Real,1)
         assert(len(values[0]) == robot.GetActiveDOF())
+
+    def test_mt19937distribution(self):
+        sp=RaveCreateSpaceSampler(self.env,'MT19937')
+        sp.SetSpaceDOF(3)
+        sp.SetSeed(1234)
+        values = sp.SampleSequence(SampleDataType.Real,10000)
+        assert(values.shape == (10000,3) and all(values>=0) and all(values<=1))
+        assert(all(abs(mean(values,0)-0.5)<0.02))
+        assert(all(abs(var(values,0)-1.0/12)<0.005))
+        for idof in range(3):
+            counts = histogram(values[:,idof],10,(0,1))[0]
+            assert(all(abs(counts-1000)<150))
+        # the bulk generation has to return the same sequence as sampling one value at a time
+        sp.SetSpaceDOF(1)
+        sp.SetSeed(1234)
+        onevalues = array([sp.SampleSequenceOneReal() for i in range(30)])
+        assert(transdist(onevalues,values.flatten()[:30]) <= g_epsilon)
+        intvalues = sp.SampleSequence(SampleDataType.Uint32,10000).flatten()
+        assert(abs(mean(intvalues/4294967296.0)-0.5)<0.02)
+        assert(abs(mean(intvalues>>31)-0.5)<0.02 and abs(mean(intvalues&1)-0.5)<0.02)
+
+    def test_haltondistribution(self):
+        sp=RaveCreateSpaceSampler(self.env,'Halton')
+        sp.SetSpaceDOF(2)
+        values = sp.SampleSequence(SampleDataType.Real,1024)
+        assert(values.shape == (1024,2) and all(values>=0) and all(values<1))
+        # a low discrepancy sequence fills the bins almost evenly
+        for idof in range(2):
+            counts = histogram(values[:,idof],8,(0,1))[0]
+            assert(all(abs(counts-128)<=3))
+        counts = histogram2d(values[:,0],values[:,1],4,[[0,1],[0,1]])[0]
+        assert(all(abs(counts-64)<=3))
+
+    def test_robotdistribution(self):
+        self.LoadEnv('data/lab1.env.xml')
+        robot = self.env.GetRobots()[0]
+        robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices(),Robot.DOFAffine.Transform,[0,0,1])
+        sp=RaveCreateSpaceSampler(self.env,'RobotConfiguration %s'%robot.GetName())
+        sp.SetSeed(1)
+        values = sp.SampleSequence(SampleDataType.Real,2000)
+        assert(values.shape == (2000,robot.GetActiveDOF()))
+        lower,upper = robot.GetActiveDOFLimits()
+        # the joints and translation are uniform inside their limits
+        numdofs = robot.GetActiveDOF()-4
+        normalized = (values[:,:numdofs]-lower[:numdofs])/(upper[:numdofs]-lower[:numdofs])
+        assert(all(normalized>=0) and all(normalized<=1))
+        assert(all(abs(mean(normalized,0)-0.5)<0.03))
+        # the rotations are unit quaternions uniformly distributed on the 4D sphere
+        quats = values[:,numdofs:]
+        assert(all(abs(sum(quats**2,1)-1)<=g_epsilon))
+        assert(all(abs(mean(quats,0))<0.05))
+        assert(all(abs(mean(quats**2,0)-0.25)<0.02))
@@ -222,6 +222,38 @@ class TestTrajectory(EnvironmentSetup):
                 self.RunTrajectory(robot,traj)
                 self.RunTrajectory(robot,RaveCreateTrajectory(env,traj.GetXMLId()).deserialize(traj.serialize(0)))
                 
+    def test_smoothingparallel(self):
+        self.log.info('shortcut with several threads')
+        env = self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            initialvalues = robot.GetActiveDOFValues()
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(robot.GetActiveConfigurationSpecification('linear'))
+            numwaypoints = 20
+            for i in range(numwaypoints):
+                traj.Insert(i,initialvalues + 0.1*(-1)**i*(0.3+0.7*i/float(numwaypoints))*(-1)**arange(robot.GetActiveDOF()))
+
+            results = {}
+            for numthreads in [1,2,2]:
+                newtraj = RaveCreateTrajectory(env,'')
+                newtraj.Clone(traj,0)
+                starttime = time.time()
+                ret = planningutils.SmoothActiveDOFTrajectory(newtraj,robot,plannername='parabolicsmoother',plannerparameters='<nshortcutthreads>%d</nshortcutthreads>'%numthreads)
+                computetime = time.time()-starttime
+                assert(ret==PlannerStatus.HasSolution)
+                self.log.info('nshortcutthreads=%d: duration=%fs, compute time=%fs', numthreads, newtraj.GetDuration(), computetime)
+                self.RunTrajectory(robot,newtraj)
+                if numthreads in results:
+                    # same seed and number of threads gives the same shortcuts
+                    assert(newtraj.GetNumWaypoints() == results[numthreads].GetNumWaypoints())
+                    assert(transdist(newtraj.GetWaypoints(0,newtraj.GetNumWaypoints()),results[numthreads].GetWaypoints(0,newtraj.GetNumWaypoints())) <= g_epsilon)
+                results[numthreads] = newtraj
+            # the workers check the same number of candidates, so the shortcuts should be as good as the serial ones
+            assert(results[2].GetDuration() <= 1.1*results[1].GetDuration())
+
     def test_smoothing(self):
         env = self.env
         self.LoadEnv('data/katanatable.env.xml')
@@ -394,6 +426,60 @@ class TestTrajectory(EnvironmentSetup):
         self.RunTrajectory(robot, traj)
         assert( abs(traj.GetDuration()-1.01688888888873) < g_epsilon)
         
+    def test_toppraretiming(self):
+        env=self.env
+        robot=self.LoadRobot('robots/barrettwam.robot.xml')
+        with env:
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            robot.SetDOFAccelerationLimits(5*ones(robot.GetDOF()))
+            lower,upper = robot.GetActiveDOFLimits()
+            vmax = robot.GetActiveDOFMaxVel()
+            amax = robot.GetActiveDOFMaxAccel()
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(robot.GetActiveConfigurationSpecification())
+            numwaypoints = 50
+            for i in range(numwaypoints):
+                s = float(i)/(numwaypoints-1)
+                traj.Insert(i,0.5*(lower+upper) + 0.3*(upper-lower)*sin(2*pi*s*(1+0.3*arange(robot.GetActiveDOF()))))
+
+            durations = {}
+            retimedtrajs = {}
+            for plannername,plannerparameters in [('parabolictrajectoryretimer',''), ('toppratrajectoryretimer',''), ('toppratrajectoryretimer','<interpolation>cubic</interpolation><torquelimitmode>-1</torquelimitmode>'), ('toppratrajectoryretimer','<interpolation>cubic</interpolation><gridpoints>400</gridpoints>')]:
+                newtraj = RaveCreateTrajectory(env,'')
+                newtraj.Clone(traj,0)
+                starttime = time.time()
+                ret=planningutils.RetimeActiveDOFTrajectory(newtraj,robot,False,maxvelmult=1,maxaccelmult=1,plannername=plannername,plannerparameters=plannerparameters)
+                computetime = time.time()-starttime
+                assert(ret==PlannerStatus.HasSolution)
+                self.log.info('%s%s: duration=%fs, compute time=%fs', plannername, plannerparameters, newtraj.GetDuration(), computetime)
+                durations[plannername+plannerparameters] = newtraj.GetDuration()
+                retimedtrajs[plannername+plannerparameters] = newtraj
+                # the retimed path starts and ends at rest at the original waypoints
+                spec = robot.GetActiveConfigurationSpecification()
+                assert(transdist(newtraj.Sample(0,spec),traj.GetWaypoint(0)) <= g_epsilon)
+                assert(transdist(newtraj.Sample(newtraj.GetDuration(),spec),traj.GetWaypoint(numwaypoints-1)) <= g_epsilon)
+                assert(transdist(newtraj.Sample(newtraj.GetDuration(),spec.ConvertToVelocitySpecification()),zeros(robot.GetActiveDOF())) <= g_epsilon)
+                # the limits are only imposed on the grid points, so allow for small errors between them
+                dt = 0.002
+                positions = array([newtraj.Sample(t,spec) for t in arange(0,newtraj.GetDuration(),dt)])
+                velocities = diff(positions,axis=0)/dt
+                accelerations = diff(velocities,axis=0)/dt
+                assert(all(abs(velocities) <= 1.02*vmax))
+                assert(all(abs(accelerations) <= 1.1*amax))
+
+            # by default the retimer keeps the straight segments between the waypoints, so has to stop at every waypoint
+            newtraj = retimedtrajs['toppratrajectoryretimer']
+            positions = reshape(newtraj.GetWaypoints(0,newtraj.GetNumWaypoints(),spec),(newtraj.GetNumWaypoints(),robot.GetActiveDOF()))
+            velocities = reshape(newtraj.GetWaypoints(0,newtraj.GetNumWaypoints(),spec.ConvertToVelocitySpecification()),(newtraj.GetNumWaypoints(),robot.GetActiveDOF()))
+            for i in range(numwaypoints):
+                index = argmin(sum((positions-traj.GetWaypoint(i))**2,axis=1))
+                assert(transdist(positions[index],traj.GetWaypoint(i)) <= g_epsilon)
+                assert(transdist(velocities[index],zeros(robot.GetActiveDOF())) <= g_epsilon)
+            # the cubic spline does not stop at every waypoint, so should be much faster than the parabolic retimer
+            assert(durations['toppratrajectoryretimer<interpolation>cubic</interpolation><torquelimitmode>-1</torquelimitmode>'] < 0.8*durations['parabolictrajectoryretimer'])
+            # torque limits can only slow down the path, a finer grid makes it less conservative
+            assert(durations['toppratrajectoryretimer<interpolation>cubic</interpolation><gridpoints>400</gridpoints>'] < durations['parabolictrajectoryretimer'])
+
     def test_ikparamretiming(self):
         self.log.info('retime workspace ikparam')
         env=self.env